@@ -98,37 +98,26 @@ AdaptiveCommModel & AdaptiveCommModel::operator = (const AdaptiveCommModel & cop
 
 int AdaptiveCommModel::Init(const std::map<QString, QString> & mapParams)
 {
-	QString strValue;
-
 	if (SimpleCommModel::Init(mapParams))
 		return 1;
 
-	strValue = GetParam(mapParams, ADAPTIVECOMMMODEL_FIRSTRBXJITTER_PARAM, ADAPTIVECOMMMODEL_FIRSTRBXJITTER_PARAM_DEFAULT);
-	m_tFirstRbxJitter = MakeTime(ValidateNumber(StringToNumber(strValue), 0., HUGE_VAL));
+	m_tFirstRbxJitter = MakeTime(ValidateNumber(GetNumberParam(mapParams, ADAPTIVECOMMMODEL_FIRSTRBXJITTER_PARAM, ADAPTIVECOMMMODEL_FIRSTRBXJITTER_PARAM_DEFAULT), 0., HUGE_VAL));
 
-	strValue = GetParam(mapParams, ADAPTIVECOMMMODEL_RBXINTERVALHIGHTHRESH_PARAM, ADAPTIVECOMMMODEL_RBXINTERVALHIGHTHRESH_PARAM_DEFAULT);
-	m_fRbxThresholdHigh = ValidateNumber(StringToNumber(strValue), 0., HUGE_VAL);
+	m_fRbxThresholdHigh = ValidateNumber(GetNumberParam(mapParams, ADAPTIVECOMMMODEL_RBXINTERVALHIGHTHRESH_PARAM, ADAPTIVECOMMMODEL_RBXINTERVALHIGHTHRESH_PARAM_DEFAULT), 0., HUGE_VAL);
 
-	strValue = GetParam(mapParams, ADAPTIVECOMMMODEL_RBXINTERVALLOWTHRESH_PARAM, ADAPTIVECOMMMODEL_RBXINTERVALLOWTHRESH_PARAM_DEFAULT);
-	m_fRbxThresholdLow = ValidateNumber(StringToNumber(strValue), 0., HUGE_VAL);
+	m_fRbxThresholdLow = ValidateNumber(GetNumberParam(mapParams, ADAPTIVECOMMMODEL_RBXINTERVALLOWTHRESH_PARAM, ADAPTIVECOMMMODEL_RBXINTERVALLOWTHRESH_PARAM_DEFAULT), 0., HUGE_VAL);
 
-	strValue = GetParam(mapParams, ADAPTIVECOMMMODEL_MAXRBXINTERVAL_PARAM, ADAPTIVECOMMMODEL_MAXRBXINTERVAL_PARAM_DEFAULT);
-	m_tMaxRbxInterval = MakeTime(ValidateNumber(StringToNumber(strValue), 0., HUGE_VAL));
+	m_tMaxRbxInterval = MakeTime(ValidateNumber(GetNumberParam(mapParams, ADAPTIVECOMMMODEL_MAXRBXINTERVAL_PARAM, ADAPTIVECOMMMODEL_MAXRBXINTERVAL_PARAM_DEFAULT), 0., HUGE_VAL));
 
-	strValue = GetParam(mapParams, ADAPTIVECOMMMODEL_FASTRBXENABLE_PARAM, ADAPTIVECOMMMODEL_FASTRBXENABLE_PARAM_DEFAULT);
-	m_bFastRbx = StringToBoolean(strValue);
+	m_bFastRbx = GetBooleanParam(mapParams, ADAPTIVECOMMMODEL_FASTRBXENABLE_PARAM, ADAPTIVECOMMMODEL_FASTRBXENABLE_PARAM_DEFAULT);
 
-	strValue = GetParam(mapParams, ADAPTIVECOMMMODEL_ADAPTIVEENABLE_PARAM, ADAPTIVECOMMMODEL_ADAPTIVEENABLE_PARAM_DEFAULT);
-	m_bAdaptive = StringToBoolean(strValue);
+	m_bAdaptive = GetBooleanParam(mapParams, ADAPTIVECOMMMODEL_ADAPTIVEENABLE_PARAM, ADAPTIVECOMMMODEL_ADAPTIVEENABLE_PARAM_DEFAULT);
 
-	strValue = GetParam(mapParams, ADAPTIVECOMMMODEL_DISTBASEDENABLE_PARAM, ADAPTIVECOMMMODEL_DISTBASEDENABLE_PARAM_DEFAULT);
-	m_bDistBased = StringToBoolean(strValue);
+	m_bDistBased = GetBooleanParam(mapParams, ADAPTIVECOMMMODEL_DISTBASEDENABLE_PARAM, ADAPTIVECOMMMODEL_DISTBASEDENABLE_PARAM_DEFAULT);
 
-	strValue = GetParam(mapParams, ADAPTIVECOMMMODEL_LOCBASEDENABLE_PARAM, ADAPTIVECOMMMODEL_LOCBASEDENABLE_PARAM_DEFAULT);
-	m_bLocBased = StringToBoolean(strValue);
+	m_bLocBased = GetBooleanParam(mapParams, ADAPTIVECOMMMODEL_LOCBASEDENABLE_PARAM, ADAPTIVECOMMMODEL_LOCBASEDENABLE_PARAM_DEFAULT);
 
-	strValue = GetParam(mapParams, ADAPTIVECOMMMODEL_BACKOFFWINDOW_PARAM, ADAPTIVECOMMMODEL_BACKOFFWINDOW_PARAM_DEFAULT);
-	m_tBackoffWindow = MakeTime(ValidateNumber(StringToNumber(strValue), 0., HUGE_VAL));
+	m_tBackoffWindow = MakeTime(ValidateNumber(GetNumberParam(mapParams, ADAPTIVECOMMMODEL_BACKOFFWINDOW_PARAM, ADAPTIVECOMMMODEL_BACKOFFWINDOW_PARAM_DEFAULT), 0., HUGE_VAL));
 
 	return 0;
 }
@@ -151,7 +140,9 @@ int AdaptiveCommModel::ProcessEvent(SimEvent & event)
 	case EVENT_CARCOMMMODEL_REBROADCAST:
 	{
 		RebroadcastMessage * pRBXMsg = (RebroadcastMessage *)event.GetEventData();
-		if (pRBXMsg != NULL)
+		if (pRBXMsg != NULL && pRBXMsg->bCancelled)
+			FreeRebroadcast(pRBXMsg);
+		else if (pRBXMsg != NULL)
 		{
 			struct timeval tNext, tRelevant = event.GetTimestamp() - m_tMaxRbxInterval;
 			std::map<PacketSequence, MessageHistory>::iterator iterMsgHistory = m_mapMsgHistory.find(pRBXMsg->msg.m_ID.srcID);
@@ -181,10 +172,11 @@ int AdaptiveCommModel::ProcessEvent(SimEvent & event)
 			if (pRBXMsg->msg.m_tTime + pRBXMsg->msg.m_tLifetime <= tNext)
 			{
 				m_mapMsgHistory.erase(iterMsgHistory); // don't need it in history anymore
-				delete pRBXMsg;
+				FreeRebroadcast(pRBXMsg);
 			}
 			else
 			{
+				pRBXMsg->tNext = tNext;
 				event.SetTimestamp(tNext);
 				g_pSimulator->m_EventQueue.AddEvent(event);
 			}
@@ -229,15 +221,13 @@ void AdaptiveCommModel::AddMessageToRebroadcastQueue(const SafetyPacket & msg)
 
 	// check to see if this a message that should be rebroadcast
 
-	RebroadcastMessage * pRBXMsg = new RebroadcastMessage;
-	pRBXMsg->msg = msg;
-	pRBXMsg->tIntervalLow = msg.m_tRX;
+	RebroadcastMessage * pRBXMsg = AllocRebroadcast(msg);
 	tInterval = GetRbxInterval(msg, true);
 	pRBXMsg->tIntervalHigh = pRBXMsg->tIntervalLow + tInterval;
 	if (m_bJitter)
-		g_pSimulator->m_EventQueue.AddEvent(SimEvent(pRBXMsg->tIntervalLow + MakeTime(RandDouble(0., ToDouble(tInterval))), EVENT_PRIORITY_LOWEST, m_strModelName, m_strModelName, EVENT_CARCOMMMODEL_REBROADCAST, pRBXMsg, DestroyRebroadcastMessage));
+		ScheduleRebroadcast(pRBXMsg, pRBXMsg->tIntervalLow + MakeTime(RandDouble(0., ToDouble(tInterval))));
 	else
-		g_pSimulator->m_EventQueue.AddEvent(SimEvent(pRBXMsg->tIntervalLow + tInterval, EVENT_PRIORITY_LOWEST, m_strModelName, m_strModelName, EVENT_CARCOMMMODEL_REBROADCAST, pRBXMsg, DestroyRebroadcastMessage));
+		ScheduleRebroadcast(pRBXMsg, pRBXMsg->tIntervalLow + tInterval);
 }
 
 bool AdaptiveCommModel::DoRebroadcast(const SafetyPacket & msg, struct timeval tRelevant) const
@@ -248,7 +238,6 @@ bool AdaptiveCommModel::DoRebroadcast(const SafetyPacket & msg, struct timeval t
 	std::map<in_addr_t, CarModel *>::iterator iterCar = pCarRegistry->find(m_ipCar);
 	std::map<in_addr_t, InfrastructureNodeModel *>::iterator iterNode = pNodeRegistry->find(m_ipCar);
 	bool bRebroadcast = true;
-	unsigned int i;
 
 	if (iterCar != pCarRegistry->end() && iterCar->second != NULL)
 	{
@@ -258,14 +247,8 @@ bool AdaptiveCommModel::DoRebroadcast(const SafetyPacket & msg, struct timeval t
 			if (iterMsgHistory != m_mapMsgHistory.end())
 			{
 				float fDistance = Distance(iterCar->second->GetCurrentPosition(), msg.m_ptPosition);
-				for (i = 0; i < iterMsgHistory->second.vecMessages.size(); i++)
-				{
-					if (iterMsgHistory->second.vecMessages[i].m_tRX >= tRelevant && Distance(iterMsgHistory->second.vecMessages[i].m_ptTXPosition, msg.m_ptPosition) > fDistance)
-					{
-						bRebroadcast = false;
-						break;
-					}
-				}
+				if (iterMsgHistory->second.histMessages.GetFarthestTX(tRelevant) > fDistance)
+					bRebroadcast = false;
 			}
 		}
 	}
@@ -33,6 +33,9 @@
 #define CARFOLLOWINGMODEL_LEADER_PARAM_DEFAULT "NULL"
 #define CARFOLLOWINGMODEL_LEADER_PARAM_DESC "LEADER (model) -- The mobility model to use if this vehicle isn't following any other vehicle."
 
+// how close (in miles) the next car ahead must be before we match its speed
+#define CARFOLLOWINGMODEL_FOLLOWING_DISTANCE 0.02f
+
 CarFollowingModel::CarFollowingModel(const QString & strModelName)
 : SimMobilityModel(strModelName), m_pTripModel(NULL), m_pLeaderModel(NULL), m_iDesiredSpeed(0)
 {
@@ -116,7 +119,7 @@ bool CarFollowingModel::GetInitialConditions(unsigned int & iRecord, Coords & pt
 	return bSuccess;
 }
 
-bool CarFollowingModel::DoIteration(float fElapsed, unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane)
+bool CarFollowingModel::DoIteration(struct timeval tCurrent, float fElapsed, unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane)
 {
 	bool bMore = false;
 	bool bActive = false;
@@ -130,7 +133,7 @@ bool CarFollowingModel::DoIteration(float fElapsed, unsigned int & iRecord, Coor
 		if (m_bMultilane)
 			SwitchLanes(iRecord, m_pTripModel->GetCRShapePoint(), m_pTripModel->GetCRProgress(), iSpeed, m_pTripModel->IsGoingForwards(), iLane);
 		iOldRecord = iRecord;
-		bMore = m_pTripModel->SetProgress(fElapsed, iSpeed, iRecord);
+		bMore = m_pTripModel->SetProgress(tCurrent, fElapsed, iSpeed, iRecord);
 		bActive = (iRecord != (unsigned)-1);
 		iRecord = m_pTripModel->GetCurrentRecord();
 		if (iRecord != iOldRecord)
@@ -157,44 +160,20 @@ short CarFollowingModel::ChooseSpeed(unsigned int iRecord) const
 
 short CarFollowingModel::GetMaximumSpeed(unsigned char iLane, short iDesiredSpeed) const
 {
-//	std::map<in_addr_t, CarModel *> * pCarRegistry;
-	std::map<in_addr_t, CarModel *>::iterator iterCar;
-//	CarModel * pCar;
-	std::vector<CarModel *> vecCars;
-//	std::map<in_addr_t, Message> * pKnownVehicles;
-	std::map<in_addr_t, SafetyPacket>::iterator iterKnownVehicle;
-	unsigned int iThisRecord = m_pTripModel->GetCurrentRecord()/*, iRecord*/;
-	bool bThisForwards = m_pTripModel->IsGoingForwards();
-	unsigned short iThisShapePoint = m_pTripModel->GetCRShapePoint(), iShapePoint;
-	float fThisProgress = m_pTripModel->GetCRProgress(), fProgress;
-	short iSpeed;
-	unsigned int i;
+	unsigned int iThisRecord = m_pTripModel->GetCurrentRecord();
+	unsigned short iThisShapePoint = m_pTripModel->GetCRShapePoint();
+	float fThisProgress = m_pTripModel->GetCRProgress();
+	CarModel * pLeader;
 
-	g_pCarRegistry->acquireLock();
-	g_pCarRegistry->GetCarsOnRecord(iThisRecord, bThisForwards, vecCars);
+	if (iThisRecord == (unsigned)-1)
+		return iDesiredSpeed;
 
-	if (bThisForwards)
-	{
-		for (i = 0; i < vecCars.size(); i++)
-		{
-			iShapePoint = vecCars[i]->GetCRShapePoint();
-			fProgress = vecCars[i]->GetCRProgress();
-			iSpeed = vecCars[i]->GetCurrentSpeed();
-			if (vecCars[i]->IsActive() && (!m_bMultilane || vecCars[i]->GetLane() == iLane) && iDesiredSpeed > iSpeed && ((iShapePoint == iThisShapePoint && fProgress > fThisProgress)))
-				iDesiredSpeed = iSpeed;
-		}
-	}
-	else
-	{
-		for (i = 0; i < vecCars.size(); i++)
-		{
-			iShapePoint = vecCars[i]->GetCRShapePoint();
-			fProgress = vecCars[i]->GetCRProgress();
-			iSpeed = vecCars[i]->GetCurrentSpeed();
-			if (vecCars[i]->IsActive() && (!m_bMultilane || vecCars[i]->GetLane() == iLane) && iDesiredSpeed > iSpeed && ((iShapePoint == iThisShapePoint && fProgress < fThisProgress)))
-				iDesiredSpeed = iSpeed;
-		}
-	}
+	// don't go faster than the next car ahead of us (in our lane, if we're
+	// using lanes), once we're close enough to be following it
+	g_pCarRegistry->acquireLock();
+	pLeader = g_pCarRegistry->GetLaneLeader(iThisRecord, m_pTripModel->IsGoingForwards(), m_bMultilane ? iLane : LANEOCCUPANCY_ANY_LANE, iThisShapePoint, fThisProgress, m_ipCar, true);
+	if (pLeader != NULL && pLeader->GetCurrentSpeed() < iDesiredSpeed && g_pMapDB->DistanceAlongRecord(iThisRecord, iThisShapePoint, fThisProgress, pLeader->GetCRShapePoint(), pLeader->GetCRProgress()) < CARFOLLOWINGMODEL_FOLLOWING_DISTANCE)
+		iDesiredSpeed = pLeader->GetCurrentSpeed();
 	g_pCarRegistry->releaseLock();
 	return iDesiredSpeed;
 }
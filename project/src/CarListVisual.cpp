@@ -38,6 +38,7 @@
 #include "QMessageDialog.h"
 #include "MainWindow.h"
 #include "StringHelp.h"
+#include "Simulator.h"
 
 CarListVisual::CarListVisual(const QString & strModelName)
 : TableVisualizer(strModelName)
@@ -45,7 +46,7 @@ CarListVisual::CarListVisual(const QString & strModelName)
 }
 
 CarListVisual::CarListVisual(const CarListVisual & copy)
-: TableVisualizer(copy), m_mapObjectsToRows(copy.m_mapObjectsToRows)
+: TableVisualizer(copy), m_mapObjectsToRows(copy.m_mapObjectsToRows), m_vecRows(copy.m_vecRows)
 {
 }
 
@@ -58,85 +59,180 @@ CarListVisual & CarListVisual::operator = (const CarListVisual & copy)
 	TableVisualizer::operator =(copy);
 
 	m_mapObjectsToRows = copy.m_mapObjectsToRows;
+	m_vecRows = copy.m_vecRows;
 
 	return *this;
 }
 
+// the same text CarModel::GetCarListColumnText gives, from a snapshot
+static QString GetSnapshotColumnText(const VehicleStates & states, unsigned int iSlot, CarListColumn eColumn)
+{
+	switch (eColumn)
+	{
+	case CarListColumnName:
+		return IPAddressToString(states.vecIPs[iSlot]);
+	case CarListColumnType:
+		return states.vecTypes[iSlot];
+	case CarListColumnLongitude:
+		return DegreesToString(states.vecPositions[iSlot].m_iLong, 6);
+	case CarListColumnLatitude:
+		return DegreesToString(states.vecPositions[iSlot].m_iLat, 6);
+	case CarListColumnSpeed:
+		return QString("%1 mph").arg(states.vecSpeeds[iSlot]);
+	case CarListColumnHeading:
+		return DegreesToString((long)states.vecHeadings[iSlot] * 10000, 2);
+	default:
+		return "";
+	}
+}
+
+bool CarListVisual::FormatRow(CarListRow & row, const VehicleSnapshot * pSnapshot)
+{
+	unsigned int i;
+
+	if (pSnapshot == NULL || row.iSlot >= pSnapshot->states.GetCount() || pSnapshot->states.vecCars[row.iSlot] == NULL || pSnapshot->states.vecIPs[row.iSlot] != row.ipObject)
+		return false;
+
+	for (i = 1; i < row.vecText.size(); i++)
+		row.vecText[i] = GetSnapshotColumnText(pSnapshot->states, row.iSlot, (CarListColumn)i);
+	row.bStale = false;
+	return true;
+}
+
+void CarListVisual::RefreshRow(int iRow, const VehicleSnapshot * pSnapshot)
+{
+	CarListRow & row = m_vecRows[iRow];
+	std::vector<QString> vecOld(row.vecText);
+	QDraggingTable * pTable = ((QTableVisualizer *)m_pWidget)->m_pTable;
+	unsigned int i;
+
+	if (!FormatRow(row, pSnapshot))
+		return;
+	for (i = 1; i < row.vecText.size(); i++)
+	{
+		if (row.vecText[i] != vecOld[i])
+			pTable->updateCell(iRow, i);
+	}
+}
+
 void CarListVisual::UpdateTable()
 {
-	std::map<in_addr_t, CarModel *> * pCarRegistry;
+	const VehicleSnapshot * pSnapshot;
 	std::map<in_addr_t, InfrastructureNodeModel *> * pNodeRegistry;
-	std::map<in_addr_t, CarModel *>::iterator iterObject;
 	std::map<in_addr_t, InfrastructureNodeModel *>::iterator iterNodeObject;
-	std::map<int, MapObject *> * pMapObjects;
-	std::map<int, MapObject *>::iterator iterMapObject;
 	std::pair<std::map<in_addr_t, int>::iterator, bool> pairObjectRow;
 	std::vector<bool> vecUpdated;
-	int i;
+	unsigned int iSlot;
+	int i, iRow, iFirstVisible, iLastVisible;
 	QDraggingTable * pTable;
+	QString strText;
 
 	// unable to update
 	if (m_pWidget != NULL && (pTable = ((QTableVisualizer *)m_pWidget)->m_pTable) != NULL)
 	{
-		vecUpdated.resize(pTable->numRows());
-		for (i = 0; i < pTable->numRows(); i++)
-			vecUpdated[i] = false;
-	
-		pMapObjects = g_pMapObjects->acquireLock();
-		pCarRegistry = g_pCarRegistry->acquireLock();
-		for (iterObject = pCarRegistry->begin(); iterObject != pCarRegistry->end(); ++iterObject)
+		vecUpdated.resize(pTable->numRows(), false);
+
+		// only rows on screen are formatted now; the rest wait until painted
+		iFirstVisible = pTable->rowAt(pTable->contentsY());
+		iLastVisible = pTable->rowAt(pTable->contentsY() + pTable->visibleHeight() - 1);
+		if (iLastVisible < 0)
+			iLastVisible = pTable->numRows() - 1;
+
+		// cars come from the display snapshot, so the simulator is never held up
+		pSnapshot = g_pSimulator->m_VehicleSnapshots.Acquire();
+		for (iSlot = 0; pSnapshot != NULL && iSlot < pSnapshot->states.GetCount(); iSlot++)
 		{
-			pairObjectRow = m_mapObjectsToRows.insert(std::pair<in_addr_t, int>(iterObject->first, pTable->numRows()));
+			if (pSnapshot->states.vecCars[iSlot] == NULL)
+				continue;
+
+			pairObjectRow = m_mapObjectsToRows.insert(std::pair<in_addr_t, int>(pSnapshot->states.vecIPs[iSlot], pTable->numRows()));
+			iRow = pairObjectRow.first->second;
 			if (pairObjectRow.second)
 			{
-				pTable->insertRows(pairObjectRow.first->second);
-				pTable->setItem(pairObjectRow.first->second, 0, new QMapObjectTableItem(NULL, QTableItem::Never, iterObject->second == NULL ? -1 : iterObject->second->GetMapObjectID()));
+				CarListRow row;
+				row.ipObject = pSnapshot->states.vecIPs[iSlot];
+				row.iSlot = iSlot;
+				row.iStamp = pSnapshot->states.vecStamps[iSlot];
+				row.iMapObjectID = pSnapshot->states.vecMapObjectIDs[iSlot];
+				row.bStale = true;
+				row.vecText.resize(pTable->numCols());
+				m_vecRows.push_back(row);
+				pTable->insertRows(iRow);
+				pTable->setItem(iRow, 0, new QMapObjectTableItem(NULL, QTableItem::Never, row.iMapObjectID));
+				continue;
 			}
-			else
+
+			CarListRow & row = m_vecRows[iRow];
+			vecUpdated[iRow] = true;
+			if (row.iMapObjectID != pSnapshot->states.vecMapObjectIDs[iSlot])
 			{
-				vecUpdated[pairObjectRow.first->second] = true;
-				((QMapObjectTableItem*)pTable->item(pairObjectRow.first->second, 0))->SetID(iterObject->second == NULL ? -1 : iterObject->second->GetMapObjectID());
-				pTable->updateCell(pairObjectRow.first->second, 0);
+				row.iMapObjectID = pSnapshot->states.vecMapObjectIDs[iSlot];
+				((QMapObjectTableItem*)pTable->item(iRow, 0))->SetID(row.iMapObjectID);
+				pTable->updateCell(iRow, 0);
 			}
-	
-			// update data for this row
-			for (i = 1; i < pTable->numCols(); i++)
+			if (row.iSlot != iSlot || row.iStamp != pSnapshot->states.vecStamps[iSlot])
 			{
-				pTable->setText(pairObjectRow.first->second, i, iterObject->second == NULL ? "" : iterObject->second->GetCarListColumnText((CarListColumn)i));
+				row.iSlot = iSlot;
+				row.iStamp = pSnapshot->states.vecStamps[iSlot];
+				if (iRow >= iFirstVisible && iRow <= iLastVisible)
+					RefreshRow(iRow, pSnapshot);
+				else
+					row.bStale = true;
 			}
 		}
-		g_pCarRegistry->releaseLock();
+		g_pSimulator->m_VehicleSnapshots.Release(pSnapshot);
 	
+		// infrastructure nodes are few and rarely change, so their text is
+		// kept current here
+		g_pMapObjects->acquireLock();
 		pNodeRegistry = g_pInfrastructureNodeRegistry->acquireLock();
 		for (iterNodeObject = pNodeRegistry->begin(); iterNodeObject != pNodeRegistry->end(); ++iterNodeObject)
 		{
 			pairObjectRow = m_mapObjectsToRows.insert(std::pair<in_addr_t, int>(iterNodeObject->first, pTable->numRows()));
+			iRow = pairObjectRow.first->second;
 			if (pairObjectRow.second)
 			{
-				pTable->insertRows(pairObjectRow.first->second);
-				pTable->setItem(pairObjectRow.first->second, 0, new QMapObjectTableItem(NULL, QTableItem::Never, iterNodeObject->second == NULL ? -1 : iterNodeObject->second->GetMapObjectID()));
+				CarListRow row;
+				row.ipObject = iterNodeObject->first;
+				row.iSlot = VEHICLESTATE_NONE;
+				row.iStamp = 0;
+				row.iMapObjectID = iterNodeObject->second == NULL ? -1 : iterNodeObject->second->GetMapObjectID();
+				row.bStale = false;
+				row.vecText.resize(pTable->numCols());
+				m_vecRows.push_back(row);
+				pTable->insertRows(iRow);
+				pTable->setItem(iRow, 0, new QMapObjectTableItem(NULL, QTableItem::Never, row.iMapObjectID));
 			}
 			else
 			{
-				vecUpdated[pairObjectRow.first->second] = true;
-				((QMapObjectTableItem*)pTable->item(pairObjectRow.first->second, 0))->SetID(iterNodeObject->second == NULL ? -1 : iterNodeObject->second->GetMapObjectID());
-				pTable->updateCell(pairObjectRow.first->second, 0);
+				vecUpdated[iRow] = true;
+				m_vecRows[iRow].iMapObjectID = iterNodeObject->second == NULL ? -1 : iterNodeObject->second->GetMapObjectID();
+				((QMapObjectTableItem*)pTable->item(iRow, 0))->SetID(m_vecRows[iRow].iMapObjectID);
+				pTable->updateCell(iRow, 0);
 			}
 	
 			// update data for this row
 			for (i = 1; i < pTable->numCols(); i++)
 			{
-				pTable->setText(pairObjectRow.first->second, i, iterNodeObject->second == NULL ? "" : iterNodeObject->second->GetCarListColumnText((CarListColumn)i));
+				strText = iterNodeObject->second == NULL ? "" : iterNodeObject->second->GetCarListColumnText((CarListColumn)i);
+				if (strText != m_vecRows[iRow].vecText[i])
+				{
+					m_vecRows[iRow].vecText[i] = strText;
+					pTable->updateCell(iRow, i);
+				}
 			}
 		}
 		g_pInfrastructureNodeRegistry->releaseLock();
 		g_pMapObjects->releaseLock();
 	
-		for (i = 0; i < (signed)vecUpdated.size(); i++)
+		// remove from the bottom up, so the rows still to be checked keep
+		// their numbers
+		for (i = (signed)vecUpdated.size() - 1; i >= 0; i--)
 		{
 			if (!vecUpdated[i])
 			{
 				pTable->removeRow(i);
+				m_vecRows.erase(m_vecRows.begin() + i);
 				std::map<in_addr_t, int>::iterator iterObjectRow = m_mapObjectsToRows.begin();
 				while (iterObjectRow != m_mapObjectsToRows.end()) {
 					if (iterObjectRow->second == i)
@@ -149,12 +245,28 @@ void CarListVisual::UpdateTable()
 	
 					if (iterObjectRow->second > i)
 						iterObjectRow->second--;
+					++iterObjectRow;
 				}
 			}
 		}
 	}
 }
 
+bool CarListVisual::tableCellText(int row, int col, QString & strText)
+{
+	if (row < 0 || row >= (signed)m_vecRows.size() || col < 1 || col >= (signed)m_vecRows[row].vecText.size())
+		return false;
+
+	if (m_vecRows[row].bStale)
+	{
+		const VehicleSnapshot * pSnapshot = g_pSimulator->m_VehicleSnapshots.Acquire();
+		FormatRow(m_vecRows[row], pSnapshot);
+		g_pSimulator->m_VehicleSnapshots.Release(pSnapshot);
+	}
+	strText = m_vecRows[row].vecText[col];
+	return true;
+}
+
 int CarListVisual::Init(const std::map<QString, QString> & mapParams)
 {
 	if (TableVisualizer::Init(mapParams))
@@ -243,6 +355,7 @@ int CarListVisual::Cleanup()
 		return 1;
 
 	m_mapObjectsToRows.clear();
+	m_vecRows.clear();
 
 	return 0;
 }
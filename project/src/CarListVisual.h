@@ -32,6 +32,20 @@
 #define CARLISTVISUAL_NAME "CarListVisual"
 
 class QPopupMenu;
+struct VehicleSnapshot;
+
+// what the list knows about one of its rows; the text is formatted from the
+// display snapshot only when the row is painted or is on screen when its
+// car's change stamp moves
+typedef struct CarListRowStruct
+{
+	in_addr_t ipObject;
+	unsigned int iSlot; // slot in the vehicle state table, or none for nodes
+	unsigned int iStamp;
+	int iMapObjectID;
+	bool bStale;
+	std::vector<QString> vecText;
+} CarListRow;
 
 class CarListVisual : public TableVisualizer
 {
@@ -58,6 +72,7 @@ public:
 	virtual int Cleanup();
 
 	virtual void tableContextMenuRequested(int row, int col, const QPoint & pos);
+	virtual bool tableCellText(int row, int col, QString & strText);
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
@@ -66,6 +81,12 @@ public:
 	std::map<in_addr_t, int> m_mapObjectsToRows;
 
 protected:
+	// fill in the text of a car's row; false if the car is not in the snapshot
+	bool FormatRow(CarListRow & row, const VehicleSnapshot * pSnapshot);
+	// reformat a row and repaint the cells whose text changed
+	void RefreshRow(int iRow, const VehicleSnapshot * pSnapshot);
+
+	std::vector<CarListRow> m_vecRows;
 	QPopupMenu * m_pRightClickMenu;
 };
 
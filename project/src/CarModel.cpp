@@ -30,6 +30,7 @@
 #include "Network.h"
 #include "InfrastructureNodeRegistry.h"
 #include "CollisionPhysModel.h"
+#include "SimCheckpoint.h"
 #include "QMessageList.h"
 
 #include "StringHelp.h"
@@ -40,7 +41,7 @@ CarLinkModel::CarLinkModel(const QString & strModelName)
 }
 
 CarLinkModel::CarLinkModel(const CarLinkModel & copy)
-: Model(copy), m_ipCar(copy.m_ipCar), m_mapPackets(copy.m_mapPackets)
+: Model(copy), m_ipCar(copy.m_ipCar), m_wheelPackets(copy.m_wheelPackets)
 {
 }
 
@@ -53,7 +54,7 @@ CarLinkModel & CarLinkModel::operator =(const CarLinkModel & copy)
 	Model::operator =(copy);
 
 	m_ipCar = copy.m_ipCar;
-	m_mapPackets = copy.m_mapPackets;
+	m_wheelPackets = copy.m_wheelPackets;
 	return *this;
 }
 
@@ -61,23 +62,57 @@ int CarLinkModel::PreRun()
 {
 	if (Model::PreRun())
 		return 1;
-	m_mapPackets.clear();
+	m_wheelPackets.Clear();
 	return 0;
 }
 
-bool CarLinkModel::DoUpdate(struct timeval tCurrent)
+// the packets already received, so that copies still in flight are
+// dropped as duplicates after a resume
+int CarLinkModel::SaveState(CheckpointWriter & writer)
 {
-	std::map<PacketSequence, struct timeval>::iterator iterPacket = m_mapPackets.begin(), iterPacketTemp;
-	while (iterPacket != m_mapPackets.end())
+	PacketExpiryWheel::PacketMap::const_iterator iterPacket;
+
+	if (Model::SaveState(writer))
+		return 1;
+
+	if (writer.IsWarmStart())
+		return 0;
+	writer.WriteUInt(m_wheelPackets.GetCount());
+	for (iterPacket = m_wheelPackets.GetPackets().begin(); iterPacket != m_wheelPackets.GetPackets().end(); ++iterPacket)
 	{
-		if (iterPacket->second <= tCurrent)
-		{
-			iterPacketTemp = iterPacket;
-			++iterPacket;
-			m_mapPackets.erase(iterPacketTemp);
-		} else
-			++iterPacket;
+		writer.WriteUInt(iterPacket->first.iSeqNumber);
+		writer.WriteUInt(iterPacket->first.ipCar);
+		writer.WriteTime(iterPacket->second);
 	}
+	return 0;
+}
+
+int CarLinkModel::LoadState(CheckpointReader & reader)
+{
+	PacketSequence ID;
+	struct timeval tExpire;
+	unsigned int i, numPackets;
+
+	if (Model::LoadState(reader))
+		return 1;
+
+	if (reader.IsWarmStart())
+		return 0;
+	m_wheelPackets.Clear();
+	if (!reader.ReadUInt(numPackets))
+		return 2;
+	for (i = 0; i < numPackets; i++)
+	{
+		if (!reader.ReadUInt(ID.iSeqNumber) || !reader.ReadUInt(ID.ipCar) || !reader.ReadTime(tExpire))
+			return 2;
+		m_wheelPackets.Insert(ID, tExpire);
+	}
+	return 0;
+}
+
+bool CarLinkModel::DoUpdate(struct timeval tCurrent)
+{
+	m_wheelPackets.Expire(tCurrent);
 	return true;
 }
 
@@ -88,7 +123,7 @@ void CarLinkModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 
 bool CarLinkModel::AddReceivedPacket(const Packet * packet)
 {
-	return m_mapPackets.insert(std::pair<PacketSequence, struct timeval>(packet->m_ID.srcID, packet->GetTimestamp() + packet->GetLifetime())).second;
+	return m_wheelPackets.Insert(packet->m_ID.srcID, packet->GetTimestamp() + packet->GetLifetime());
 }
 
 CarPhysModel::CarPhysModel(const QString & strModelName)
@@ -113,6 +148,18 @@ CarPhysModel & CarPhysModel::operator = (const CarPhysModel & copy)
 	return *this;
 }
 
+unsigned int CarPhysModel::AreCarsInRange(const Coords & ptCar, const Coords * pPositions, unsigned int iCount, unsigned char * pInRange) const
+{
+	unsigned int i, iFound = 0;
+
+	for (i = 0; i < iCount; i++)
+	{
+		pInRange[i] = IsCarInRange(ptCar, pPositions[i]);
+		iFound += pInRange[i];
+	}
+	return iFound;
+}
+
 void CarPhysModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 {
 	Model::GetParams(mapParams);
@@ -151,20 +198,83 @@ int CarCommModel::PreRun()
 	return 0;
 }
 
-bool CarCommModel::DoUpdate(struct timeval tCurrent __attribute__((unused)) )
+// the copies of each message overheard so far, which decide whether and
+// when it is rebroadcast
+int CarCommModel::SaveState(CheckpointWriter & writer)
 {
 	std::map<PacketSequence, MessageHistory>::iterator iterMsgHistory;
+	PacketHistory::const_iterator iterPacket;
 	unsigned int i;
+
+	if (Model::SaveState(writer))
+		return 1;
+
+	if (writer.IsWarmStart())
+		return 0;
+	writer.WriteUInt(m_mapMsgHistory.size());
 	for (iterMsgHistory = m_mapMsgHistory.begin(); iterMsgHistory != m_mapMsgHistory.end(); ++iterMsgHistory)
 	{
-		sort(iterMsgHistory->second.vecMessages.begin(), iterMsgHistory->second.vecMessages.end(), ComparePacketsRX);
-		for (i = 0; i < iterMsgHistory->second.vecMessages.size(); i++)
+		writer.WriteUInt(iterMsgHistory->first.iSeqNumber);
+		writer.WriteUInt(iterMsgHistory->first.ipCar);
+		writer.WriteTime(iterMsgHistory->second.tRelevant);
+		writer.WriteUInt(iterMsgHistory->second.histMessages.GetCount());
+		for (iterPacket = iterMsgHistory->second.histMessages.Begin(); iterPacket != iterMsgHistory->second.histMessages.End(); ++iterPacket)
+			writer.WritePacket(*iterPacket);
+		writer.WriteUInt(iterMsgHistory->second.vecTXHistory.size());
+		for (i = 0; i < iterMsgHistory->second.vecTXHistory.size(); i++)
 		{
-			if (iterMsgHistory->second.vecMessages[i].m_tRX < iterMsgHistory->second.tRelevant)
-				break;
+			writer.WriteUInt(iterMsgHistory->second.vecTXHistory[i].first);
+			writer.WriteTime(iterMsgHistory->second.vecTXHistory[i].second);
+		}
+	}
+	return 0;
+}
+
+int CarCommModel::LoadState(CheckpointReader & reader)
+{
+	PacketSequence ID;
+	SafetyPacket msg;
+	std::pair<in_addr_t, struct timeval> txEntry;
+	unsigned int i, j, numHistories, numPackets, numTX;
+
+	if (Model::LoadState(reader))
+		return 1;
+
+	if (reader.IsWarmStart())
+		return 0;
+	m_mapMsgHistory.clear();
+	if (!reader.ReadUInt(numHistories))
+		return 2;
+	for (i = 0; i < numHistories; i++)
+	{
+		if (!reader.ReadUInt(ID.iSeqNumber) || !reader.ReadUInt(ID.ipCar))
+			return 2;
+		MessageHistory & msgHistory = m_mapMsgHistory[ID];
+		if (!reader.ReadTime(msgHistory.tRelevant) || !reader.ReadUInt(numPackets))
+			return 2;
+		for (j = 0; j < numPackets; j++)
+		{
+			if (!reader.ReadPacket(msg))
+				return 2;
+			msgHistory.histMessages.Insert(msg);
+		}
+		if (!reader.ReadUInt(numTX))
+			return 2;
+		for (j = 0; j < numTX; j++)
+		{
+			if (!reader.ReadUInt(txEntry.first) || !reader.ReadTime(txEntry.second))
+				return 2;
+			msgHistory.vecTXHistory.push_back(txEntry);
 		}
-		iterMsgHistory->second.vecMessages.resize(i);
 	}
+	return 0;
+}
+
+bool CarCommModel::DoUpdate(struct timeval tCurrent __attribute__((unused)) )
+{
+	std::map<PacketSequence, MessageHistory>::iterator iterMsgHistory;
+	for (iterMsgHistory = m_mapMsgHistory.begin(); iterMsgHistory != m_mapMsgHistory.end(); ++iterMsgHistory)
+		iterMsgHistory->second.histMessages.Evict(iterMsgHistory->second.tRelevant);
 	return true;
 }
 
@@ -181,7 +291,7 @@ void CarCommModel::AddMessageToHistory(const SafetyPacket & msg)
 		iterMsgHistory = m_mapMsgHistory.insert(std::pair<PacketSequence, MessageHistory>(msg.m_ID.srcID, msgHistory)).first;
 	}
 	if (msg.m_tRX >= iterMsgHistory->second.tRelevant)
-		iterMsgHistory->second.vecMessages.push_back(msg);
+		iterMsgHistory->second.histMessages.Insert(msg);
 
 	// add sender to TX history
 	for (i = 0; i < iterMsgHistory->second.vecTXHistory.size(); i++)
@@ -236,12 +346,12 @@ void CarCommModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 #define CARMODEL_TRACKSPEED_PARAM_DESC "TRACKSPEED (Yes/No) -- Specify \"Yes\" if you want this vehicle to record its speed history and send it to other vehicles, \"No\" otherwise."
 
 CarModel::CarModel(const QString & strModelName)
-: Model(strModelName), m_pLinkModel(NULL), m_pPhysModel(NULL), m_pCommModel(NULL), m_tDelay(timeval0), m_tTimestamp(timeval0), m_ipCar(0), m_ipOwner(CARMODEL_IPOWNER_LOCAL), m_bLogThisCar(false), m_iSpeed(0), m_iHeading(0), m_iCurrentRecord((unsigned)-1), m_bForwards(true), m_iCRShapePoint((unsigned)-1), m_fCRProgress(0.f), m_iLane(0), m_iMapObjectID(-1), m_iNextSeqNumber(0), m_iNextRXSeqNumber(0), m_bTrackSpeed(false)
+: Model(strModelName), m_pLinkModel(NULL), m_pPhysModel(NULL), m_pCommModel(NULL), m_tDelay(timeval0), m_tTimestamp(timeval0), m_ipCar(0), m_ipOwner(CARMODEL_IPOWNER_LOCAL), m_bLogThisCar(false), m_iSpeed(0), m_iHeading(0), m_iCurrentRecord((unsigned)-1), m_bForwards(true), m_iCRShapePoint((unsigned)-1), m_fCRProgress(0.f), m_iLane(0), m_iMapObjectID(-1), m_iStateSlot(VEHICLESTATE_NONE), m_iNextSeqNumber(0), m_iNextRXSeqNumber(0), m_bTrackSpeed(false)
 {
 }
 
 CarModel::CarModel(const CarModel & copy)
-: Model(copy), m_pLinkModel(copy.m_pLinkModel), m_pPhysModel(copy.m_pPhysModel), m_pCommModel(copy.m_pCommModel), m_tDelay(copy.m_tDelay), m_tTimestamp(copy.m_tTimestamp), m_ipCar(copy.m_ipCar), m_ipOwner(copy.m_ipOwner), m_bLogThisCar(copy.m_bLogThisCar), m_ptPosition(copy.m_ptPosition), m_iSpeed(copy.m_iSpeed), m_iHeading(copy.m_iHeading), m_iCurrentRecord(copy.m_iCurrentRecord), m_bForwards(copy.m_bForwards), m_iCRShapePoint(copy.m_iCRShapePoint), m_fCRProgress(copy.m_fCRProgress), m_iLane(copy.m_iLane), m_iMapObjectID(copy.m_iMapObjectID), m_mapKnownVehicles(copy.m_mapKnownVehicles), m_iNextSeqNumber(copy.m_iNextSeqNumber), m_iNextRXSeqNumber(copy.m_iNextRXSeqNumber), m_msgNeighbors(copy.m_msgNeighbors), m_bTrackSpeed(copy.m_bTrackSpeed), m_mapTracks(copy.m_mapTracks)
+: Model(copy), m_pLinkModel(copy.m_pLinkModel), m_pPhysModel(copy.m_pPhysModel), m_pCommModel(copy.m_pCommModel), m_tDelay(copy.m_tDelay), m_tTimestamp(copy.m_tTimestamp), m_ipCar(copy.m_ipCar), m_ipOwner(copy.m_ipOwner), m_bLogThisCar(copy.m_bLogThisCar), m_ptPosition(copy.m_ptPosition), m_iSpeed(copy.m_iSpeed), m_iHeading(copy.m_iHeading), m_iCurrentRecord(copy.m_iCurrentRecord), m_bForwards(copy.m_bForwards), m_iCRShapePoint(copy.m_iCRShapePoint), m_fCRProgress(copy.m_fCRProgress), m_iLane(copy.m_iLane), m_iMapObjectID(copy.m_iMapObjectID), m_iStateSlot(VEHICLESTATE_NONE), m_mapKnownVehicles(copy.m_mapKnownVehicles), m_iNextSeqNumber(copy.m_iNextSeqNumber), m_iNextRXSeqNumber(copy.m_iNextRXSeqNumber), m_msgNeighbors(copy.m_msgNeighbors), m_bTrackSpeed(copy.m_bTrackSpeed), m_mapTracks(copy.m_mapTracks)
 {
 }
 
@@ -292,15 +402,13 @@ int CarModel::Init(const std::map<QString, QString> & mapParams)
 	if (Model::Init(mapParams))
 		return 1;
 
-	strValue = GetParam(mapParams, CARMODEL_PARAM_DELAY, CARMODEL_PARAM_DELAY_DEFAULT);
-	m_tDelay = MakeTime(ValidateNumber(StringToNumber(strValue), 0., HUGE_VAL));
+	m_tDelay = MakeTime(ValidateNumber(GetNumberParam(mapParams, CARMODEL_PARAM_DELAY, CARMODEL_PARAM_DELAY_DEFAULT), 0., HUGE_VAL));
 
 	strValue = GetParam(mapParams, CARMODEL_PARAM_CARIP, CARMODEL_PARAM_CARIP_DEFAULT);
 	if (!StringToIPAddress(strValue, m_ipCar))
 		return 2;
 
-	strValue = GetParam(mapParams, CARMODEL_PARAM_LOGCAR, CARMODEL_PARAM_LOGCAR_DEFAULT);
-	m_bLogThisCar = StringToBoolean(strValue);
+	m_bLogThisCar = GetBooleanParam(mapParams, CARMODEL_PARAM_LOGCAR, CARMODEL_PARAM_LOGCAR_DEFAULT);
 
 	strValue = GetParam(mapParams, CARMODEL_LINK_PARAM, CARMODEL_LINK_PARAM_DEFAULT);
 	if (!g_pSimulator->m_ModelMgr.GetModel(strValue, pModel))
@@ -322,8 +430,7 @@ int CarModel::Init(const std::map<QString, QString> & mapParams)
 	if (m_pCommModel != NULL)
 		m_pCommModel->SetCar(m_ipCar);
 
-	strValue = GetParam(mapParams, CARMODEL_TRACKSPEED_PARAM, CARMODEL_TRACKSPEED_PARAM_DEFAULT);
-	m_bTrackSpeed = StringToBoolean(strValue);
+	m_bTrackSpeed = GetBooleanParam(mapParams, CARMODEL_TRACKSPEED_PARAM, CARMODEL_TRACKSPEED_PARAM_DEFAULT);
 
 	pObject = new MapCarObject(this);
 
@@ -375,6 +482,8 @@ int CarModel::PreRun()
 	m_fCRProgress = 0.f;
 	m_iLane = 0;
 
+	PublishState();
+
 	m_mapKnownVehicles.clear();
 	m_mapTracks.clear();
 
@@ -382,11 +491,61 @@ int CarModel::PreRun()
 	m_msgNeighbors.iAccumulatedCollisions = 0;
 	m_msgNeighbors.iAccumulatedMessages = 0;
 
-	g_pSimulator->m_EventQueue.AddEvent(SimEvent(g_pSimulator->m_tCurrent, EVENT_PRIORITY_HIGHEST, m_strModelName, m_strModelName, EVENT_CARMODEL_UPDATE));
+	ScheduleUpdate();
 
 	return 0;
 }
 
+void CarModel::ScheduleUpdate()
+{
+	g_pSimulator->m_EventQueue.AddEvent(SimEvent(g_pSimulator->m_tCurrent, EVENT_PRIORITY_HIGHEST, m_strModelName, m_strModelName, EVENT_CARMODEL_UPDATE));
+}
+
+void CarModel::PublishState()
+{
+	if (m_iStateSlot != VEHICLESTATE_NONE)
+		g_pCarRegistry->GetStateTable().Store(m_iStateSlot, this);
+}
+
+void CarModel::DoUpdate(struct timeval tCurrent)
+{
+	if (m_pPhysModel != NULL)
+		m_pPhysModel->DoUpdate(tCurrent);
+	if (m_pLinkModel != NULL)
+		m_pLinkModel->DoUpdate(tCurrent);
+	if (m_pCommModel != NULL)
+		m_pCommModel->DoUpdate(tCurrent);
+
+	std::map<in_addr_t, SafetyPacket>::iterator iterCarMessage = m_mapKnownVehicles.begin();
+	while (iterCarMessage != m_mapKnownVehicles.end())
+	{
+		if (iterCarMessage->second.m_tTime + MakeTime(NETWORK_TIMEOUT_SECS, NETWORK_TIMEOUT_USECS) < tCurrent) {
+			std::map<in_addr_t, SafetyPacket>::iterator iterCarMessageTemp = iterCarMessage;
+			++iterCarMessage;
+			m_mapKnownVehicles.erase(iterCarMessageTemp);
+		} else
+			++iterCarMessage;
+	}
+
+	if (IsActive())
+	{
+		std::vector<CarModel *> vecNeighbors;
+		g_pCarRegistry->GetCommunicatingCarsInRange(this, vecNeighbors);
+		m_msgNeighbors.tMessage = m_tTimestamp;
+		m_msgNeighbors.iNeighbors = vecNeighbors.size();
+		m_msgNeighbors.iCollisionCount = m_pPhysModel != NULL ? (m_pPhysModel->GetCollisionCount() - m_msgNeighbors.iAccumulatedCollisions) : 0;
+		m_msgNeighbors.iAccumulatedCollisions += m_msgNeighbors.iCollisionCount;
+		m_msgNeighbors.iMessages = m_pPhysModel != NULL ? (m_pPhysModel->GetMessageCount() - m_msgNeighbors.iAccumulatedMessages) : 0;
+		m_msgNeighbors.iAccumulatedMessages += m_msgNeighbors.iMessages;
+#ifdef MULTILANETEST
+		m_msgNeighbors.iLane = m_iLane;
+#endif
+
+		if (m_msgNeighbors.iCollisionCount > 0 || m_msgNeighbors.iMessages > 0 || m_msgNeighbors.iNeighbors > 0)
+			g_pLogger->WriteMessage(LOGFILE_NEIGHBORS, &m_msgNeighbors);
+	}
+}
+
 int CarModel::ProcessEvent(SimEvent & event)
 {
 	if (Model::ProcessEvent(event))
@@ -396,41 +555,7 @@ int CarModel::ProcessEvent(SimEvent & event)
 	{
 	case EVENT_CARMODEL_UPDATE:
 	{
-		if (m_pPhysModel != NULL)
-			m_pPhysModel->DoUpdate(event.GetTimestamp());
-		if (m_pLinkModel != NULL)
-			m_pLinkModel->DoUpdate(event.GetTimestamp());
-		if (m_pCommModel != NULL)
-			m_pCommModel->DoUpdate(event.GetTimestamp());
-
-		std::map<in_addr_t, SafetyPacket>::iterator iterCarMessage = m_mapKnownVehicles.begin();
-		while (iterCarMessage != m_mapKnownVehicles.end())
-		{
-			if (iterCarMessage->second.m_tTime + MakeTime(NETWORK_TIMEOUT_SECS, NETWORK_TIMEOUT_USECS) < event.GetTimestamp()) {
-				std::map<in_addr_t, SafetyPacket>::iterator iterCarMessageTemp = iterCarMessage;
-				++iterCarMessage;
-				m_mapKnownVehicles.erase(iterCarMessageTemp);
-			} else
-				++iterCarMessage;
-		}
-
-		if (IsActive())
-		{
-			std::vector<CarModel *> vecNeighbors;
-			g_pCarRegistry->GetCommunicatingCarsInRange(this, vecNeighbors);
-			m_msgNeighbors.tMessage = m_tTimestamp;
-			m_msgNeighbors.iNeighbors = vecNeighbors.size();
-			m_msgNeighbors.iCollisionCount = m_pPhysModel != NULL ? (m_pPhysModel->GetCollisionCount() - m_msgNeighbors.iAccumulatedCollisions) : 0;
-			m_msgNeighbors.iAccumulatedCollisions += m_msgNeighbors.iCollisionCount;
-			m_msgNeighbors.iMessages = m_pPhysModel != NULL ? (m_pPhysModel->GetMessageCount() - m_msgNeighbors.iAccumulatedMessages) : 0;
-			m_msgNeighbors.iAccumulatedMessages += m_msgNeighbors.iMessages;
-#ifdef MULTILANETEST
-			m_msgNeighbors.iLane = m_iLane;
-#endif
-	
-			if (m_msgNeighbors.iCollisionCount > 0 || m_msgNeighbors.iMessages > 0 || m_msgNeighbors.iNeighbors > 0)
-				g_pLogger->WriteMessage(LOGFILE_NEIGHBORS, &m_msgNeighbors);
-		}
+		DoUpdate(event.GetTimestamp());
 		event.SetTimestamp(event.GetTimestamp() + m_tDelay);
 		g_pSimulator->m_EventQueue.AddEvent(event);
 		break;
@@ -495,6 +620,13 @@ int CarModel::ProcessEvent(SimEvent & event)
 				g_pSimulator->m_mutexEvent1Log.unlock();
 				break;
 			}
+			case ptSquelch:
+			{
+				SquelchPacket * pMsg = (SquelchPacket *)pPacket;
+				if (m_pCommModel)
+					m_pCommModel->ReceiveSquelch(*pMsg);
+				break;
+			}
 			default:
 				break;
 			}
@@ -546,6 +678,48 @@ int CarModel::Save(std::map<QString, QString> & mapParams)
 	return 0;
 }
 
+// the neighbor counts carried from one log entry to the next go with the
+// physical model's counters, which a warm start leaves behind
+int CarModel::SaveState(CheckpointWriter & writer)
+{
+	if (Model::SaveState(writer))
+		return 1;
+
+	writer.WriteTime(m_tTimestamp);
+	writer.WriteCoords(m_ptPosition);
+	writer.WriteShort(m_iSpeed);
+	writer.WriteShort(m_iHeading);
+	writer.WriteUInt(m_iCurrentRecord);
+	writer.WriteBool(m_bForwards);
+	writer.WriteUInt(m_iCRShapePoint);
+	writer.WriteFloat(m_fCRProgress);
+	writer.WriteUInt(m_iLane);
+	writer.WriteUInt(m_iNextSeqNumber);
+	writer.WriteUInt(m_iNextRXSeqNumber);
+	if (!writer.IsWarmStart())
+	{
+		writer.WriteUInt(m_msgNeighbors.iAccumulatedCollisions);
+		writer.WriteUInt(m_msgNeighbors.iAccumulatedMessages);
+	}
+	return 0;
+}
+
+int CarModel::LoadState(CheckpointReader & reader)
+{
+	unsigned int iCRShapePoint, iLane;
+
+	if (Model::LoadState(reader))
+		return 1;
+
+	if (!reader.ReadTime(m_tTimestamp) || !reader.ReadCoords(m_ptPosition) || !reader.ReadShort(m_iSpeed) || !reader.ReadShort(m_iHeading) || !reader.ReadUInt(m_iCurrentRecord) || !reader.ReadBool(m_bForwards) || !reader.ReadUInt(iCRShapePoint) || !reader.ReadFloat(m_fCRProgress) || !reader.ReadUInt(iLane) || !reader.ReadUInt(m_iNextSeqNumber) || !reader.ReadUInt(m_iNextRXSeqNumber))
+		return 2;
+	m_iCRShapePoint = iCRShapePoint;
+	m_iLane = iLane;
+	if (!reader.IsWarmStart() && (!reader.ReadUInt(m_msgNeighbors.iAccumulatedCollisions) || !reader.ReadUInt(m_msgNeighbors.iAccumulatedMessages)))
+		return 2;
+	return 0;
+}
+
 void CarModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 {
 	Model::GetParams(mapParams);
@@ -609,6 +783,8 @@ QString CarModel::GetCarListColumnText(CarListColumn eColumn) const
 	{
 	case CarListColumnName:
 		return IPAddressToString(m_ipCar);
+	case CarListColumnType:
+		return GetCarListType();
 	case CarListColumnLongitude:
 		return DegreesToString(m_ptPosition.m_iLong, 6);
 	case CarListColumnLatitude:
@@ -797,6 +973,7 @@ MapCarObject & MapCarObject::operator = (const MapCarObject & copy)
 
 void MapCarObject::DrawObject(const QRect & rBox, QPainter * pDC, MapObjectState eState) const
 {
+	Coords ptPosition;
 	short iHeading;
 	float cos0, sin0;
 	QPoint ptCenter;
@@ -805,9 +982,8 @@ void MapCarObject::DrawObject(const QRect & rBox, QPainter * pDC, MapObjectState
 	if (m_pCar == NULL)
 		return;
 
-	m_pCar->m_mutexUpdate.lock();
-	iHeading = m_pCar->GetCurrentDirection();
-	m_pCar->m_mutexUpdate.unlock();
+	if (!GetPose(ptPosition, iHeading))
+		return;
 
 	ptCenter = rBox.center();
 	cos0 = cosf(iHeading * RADIANSPERCENTIDEGREE);
@@ -842,10 +1018,8 @@ void MapCarObject::DrawObject(MapDrawingSettings * pSettings, MapObjectState eSt
 	if (m_pCar == NULL)
 		return;
 
-	m_pCar->m_mutexUpdate.lock();
-	ptPosition = m_pCar->GetCurrentPosition();
-	iHeading = m_pCar->GetCurrentDirection();
-	m_pCar->m_mutexUpdate.unlock();
+	if (!GetPose(ptPosition, iHeading))
+		return;
 
 	pts[0] = MapLongLatToScreen(pSettings, ptPosition);
 	cos0 = cosf(iHeading * RADIANSPERCENTIDEGREE);
@@ -880,10 +1054,8 @@ QRect MapCarObject::RectVisible(MapDrawingSettings * pSettings) const
 	if (m_pCar == NULL)
 		return r;
 
-	m_pCar->m_mutexUpdate.lock();
-	ptPosition = m_pCar->GetCurrentPosition();
-	iHeading = m_pCar->GetCurrentDirection();
-	m_pCar->m_mutexUpdate.unlock();
+	if (!GetPose(ptPosition, iHeading))
+		return r;
 
 	ptAt = MapLongLatToScreen(pSettings, ptPosition);
 	cos0 = cosf(iHeading * RADIANSPERCENTIDEGREE);
@@ -913,6 +1085,15 @@ bool MapCarObject::isActive() const
 		return false;
 }
 
+// read from the display snapshot, so drawing never waits on the simulator
+bool MapCarObject::GetPose(Coords & ptPosition, short & iHeading) const
+{
+	const VehicleSnapshot * pSnapshot = g_pSimulator->m_VehicleSnapshots.Acquire();
+	bool bFound = pSnapshot != NULL && pSnapshot->GetPose(m_pCar, ptPosition, iHeading);
+	g_pSimulator->m_VehicleSnapshots.Release(pSnapshot);
+	return bFound;
+}
+
 bool MapCarObject::hasReceivedCurrentMsg() const
 {
 	return m_pCar != NULL && (m_pCar->GetIPAddress() == g_pSimulator->m_msgCurrentTrack.ipCar || m_pCar->HasMessage(g_pSimulator->m_msgCurrentTrack));
@@ -28,6 +28,8 @@
 #include "Model.h"
 #include "MapObjects.h"
 #include "Network.h"
+#include "PacketExpiryWheel.h"
+#include "PacketHistory.h"
 
 #include <arpa/inet.h>
 
@@ -71,6 +73,8 @@ public:
 	virtual CarLinkModel & operator = (const CarLinkModel & copy);
 
 	virtual int PreRun();
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 	virtual bool DoUpdate(struct timeval tCurrent);
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
@@ -85,7 +89,7 @@ public:
 	}
 	inline virtual bool HasReceivedPacket(const PacketSequence & ID) const
 	{
-		return m_mapPackets.find(ID) != m_mapPackets.end();
+		return m_wheelPackets.Contains(ID);
 	}
 
 	virtual bool ReceivePacket(Packet * packet) = 0;
@@ -95,7 +99,7 @@ public:
 
 protected:
 	in_addr_t m_ipCar;
-	std::map<PacketSequence, struct timeval> m_mapPackets; // make sure we don't have duplicates
+	PacketExpiryWheel m_wheelPackets; // make sure we don't have duplicates
 };
 
 #define CARPHYSMODEL_NAME "CarPhysModel"
@@ -139,6 +143,9 @@ public:
 	virtual bool ReceivePacket(Packet * packet) = 0;
 	virtual float GetRXRange(const Packet * packet) const = 0;
 	virtual bool IsCarInRange(const Coords & ptCar, const Coords & ptPosition) const = 0;
+	// IsCarInRange for iCount positions at once: pInRange[i] is set to 1 if
+	// pPositions[i] is in range of ptCar, else 0; returns how many are
+	virtual unsigned int AreCarsInRange(const Coords & ptCar, const Coords * pPositions, unsigned int iCount, unsigned char * pInRange) const;
 	inline virtual unsigned int GetCollisionCount() const
 	{
 		return 0; // doesn't track collisions by default
@@ -163,7 +170,9 @@ class CarCommModel : public Model
 public:
 	typedef struct MessageHistoryStruct
 	{
-		std::vector<SafetyPacket> vecMessages;
+		// ordered by reception time; every copy shares the message's origin, so
+		// GetFarthestTX can be compared with a distance from that origin
+		PacketHistory histMessages;
 		std::vector<std::pair<in_addr_t, struct timeval> > vecTXHistory;
 		struct timeval tRelevant;
 	} MessageHistory;
@@ -184,11 +193,21 @@ public:
 	virtual CarCommModel & operator = (const CarCommModel & copy);
 
 	virtual int PreRun();
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 	virtual bool DoUpdate(struct timeval tCurrent);
 
 	virtual bool TransmitMessage(Packet * msg) = 0;
 	virtual void AddMessageToRebroadcastQueue(const SafetyPacket & msg) = 0;
 	virtual void AddMessageToHistory(const SafetyPacket & msg);
+	// a squelch carries the origin ID of the message it stops
+	inline virtual void ReceiveSquelch(const SquelchPacket & msg __attribute__((unused)) )
+	{
+	}
+	// forget every pending rebroadcast, once no event refers to them
+	inline virtual void ClearRebroadcasts()
+	{
+	}
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
@@ -246,6 +265,8 @@ public:
 	virtual int ProcessEvent(SimEvent & event);
 	virtual int PostRun();
 	virtual int Save(std::map<QString, QString> & mapParams);
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 	virtual int Cleanup();
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
@@ -314,12 +335,31 @@ public:
 	{
 		return m_iMapObjectID;
 	}
+	inline unsigned int GetStateSlot() const
+	{
+		return m_iStateSlot;
+	}
+	inline void SetStateSlot(unsigned int iStateSlot)
+	{
+		m_iStateSlot = iStateSlot;
+	}
+	// copy the current kinematic state into the registry's state table;
+	// call after any change to position, speed, heading, record or lane
+	void PublishState();
 	virtual QString GetCarListColumnText(CarListColumn eColumn) const;
+	// the type column's text; a literal, so the display can show it without
+	// sharing a QString with the simulator thread
+	inline virtual const char * GetCarListType() const
+	{
+		return "";
+	}
 	virtual bool IsActive() const = 0;
 	virtual void CreateMessage(Packet * msg);
 	virtual void TransmitPacket(const Packet * packet);
 	virtual bool ReceivePacket(Packet * packet);
 	virtual unsigned int GetNextSequenceNumber();
+	// update the link-layer models and neighbor bookkeeping for this tick
+	virtual void DoUpdate(struct timeval tCurrent);
 	virtual unsigned int GetNextRXSequenceNumber();
 
 	inline virtual std::map<in_addr_t, SafetyPacket> * GetKnownVehicles(bool bWait = true)
@@ -345,6 +385,9 @@ public:
 	CarCommModel * m_pCommModel;
 
 protected:
+	// arrange for the periodic EVENT_CARMODEL_UPDATE, called from PreRun
+	virtual void ScheduleUpdate();
+
 	struct timeval m_tDelay;
 	struct timeval m_tTimestamp;
 	in_addr_t m_ipCar;
@@ -360,6 +403,7 @@ protected:
 	unsigned char m_iLane;
 
 	int m_iMapObjectID;
+	unsigned int m_iStateSlot;
 
 	std::map<in_addr_t, SafetyPacket> m_mapKnownVehicles;
 	QMutex m_mutexMessages;
@@ -418,6 +462,8 @@ public:
 	}
 	virtual bool isActive() const;
 	virtual bool hasReceivedCurrentMsg() const;
+	// the car's position and heading as of the last display snapshot
+	bool GetPose(Coords & ptPosition, short & iHeading) const;
 
 //protected:
 	CarModel * m_pCar;
@@ -35,103 +35,140 @@ CarRegistry::~CarRegistry()
 
 bool CarRegistry::GetCarsOnRecord(unsigned int iRecord, std::vector<CarModel *> & vecCars)
 {
-	std::map<in_addr_t, CarModel *>::iterator iterCar;
+	const VehicleStates * pStates = m_tableStates.acquireLock();
+	unsigned int i, iCount = pStates->GetCount();
 	bool bFound = false;
 
-	for (iterCar = m_mapRegistry.begin(); iterCar != m_mapRegistry.end(); ++iterCar)
+	for (i = 0; i < iCount; i++)
 	{
-		if (iterCar->second != NULL && iterCar->second->GetCurrentRecord() == iRecord)
+		if (pStates->vecRecords[i] == iRecord && pStates->vecCars[i] != NULL)
 		{
-			vecCars.push_back(iterCar->second);
+			vecCars.push_back(pStates->vecCars[i]);
 			bFound = true;
 		}
 	}
 
+	m_tableStates.releaseLock();
 	return bFound;
 }
 
 bool CarRegistry::GetCarsOnRecord(unsigned int iRecord, bool bForwards, std::vector<CarModel *> & vecCars)
 {
-	std::map<in_addr_t, CarModel *>::iterator iterCar;
+	const VehicleStates * pStates = m_tableStates.acquireLock();
+	unsigned int i, iCount = pStates->GetCount();
 	bool bFound = false;
 
-	for (iterCar = m_mapRegistry.begin(); iterCar != m_mapRegistry.end(); ++iterCar)
+	for (i = 0; i < iCount; i++)
 	{
-		if (iterCar->second != NULL && iterCar->second->GetCurrentRecord() == iRecord && iterCar->second->IsGoingForwards() == bForwards)
+		if (pStates->vecRecords[i] == iRecord && pStates->vecForwards[i] == bForwards && pStates->vecCars[i] != NULL)
 		{
-			vecCars.push_back(iterCar->second);
+			vecCars.push_back(pStates->vecCars[i]);
 			bFound = true;
 		}
 	}
 
+	m_tableStates.releaseLock();
 	return bFound;
 }
 
 bool CarRegistry::GetCarsOnRecords(const std::set<unsigned int> & setRecords, std::vector<CarModel *> & vecCars)
 {
-	std::map<in_addr_t, CarModel *>::iterator iterCar;
+	const VehicleStates * pStates = m_tableStates.acquireLock();
+	unsigned int i, iCount = pStates->GetCount();
 	bool bFound = false;
 
-	for (iterCar = m_mapRegistry.begin(); iterCar != m_mapRegistry.end(); ++iterCar)
+	for (i = 0; i < iCount; i++)
 	{
-		if (iterCar->second != NULL && setRecords.find(iterCar->second->GetCurrentRecord()) != setRecords.end())
+		if (pStates->vecCars[i] != NULL && setRecords.find(pStates->vecRecords[i]) != setRecords.end())
 		{
-			vecCars.push_back(iterCar->second);
+			vecCars.push_back(pStates->vecCars[i]);
 			bFound = true;
 		}
 	}
 
+	m_tableStates.releaseLock();
 	return bFound;
 }
 
 bool CarRegistry::GetCarsOnRecords(const std::set<unsigned int> & setRecords, bool bForwards, std::vector<CarModel *> & vecCars)
 {
-	std::map<in_addr_t, CarModel *>::iterator iterCar;
+	const VehicleStates * pStates = m_tableStates.acquireLock();
+	unsigned int i, iCount = pStates->GetCount();
 	bool bFound = false;
 
-	for (iterCar = m_mapRegistry.begin(); iterCar != m_mapRegistry.end(); ++iterCar)
+	for (i = 0; i < iCount; i++)
 	{
-		if (iterCar->second != NULL && setRecords.find(iterCar->second->GetCurrentRecord()) != setRecords.end() && iterCar->second->IsGoingForwards() == bForwards)
+		if (pStates->vecCars[i] != NULL && pStates->vecForwards[i] == bForwards && setRecords.find(pStates->vecRecords[i]) != setRecords.end())
 		{
-			vecCars.push_back(iterCar->second);
+			vecCars.push_back(pStates->vecCars[i]);
 			bFound = true;
 		}
 	}
 
+	m_tableStates.releaseLock();
 	return bFound;
 }
 
 bool CarRegistry::GetCarsInRange(const CarModel * pCar, std::vector<CarModel *> & vecCars)
 {
-	std::map<in_addr_t, CarModel *>::iterator iterCar;
+	if (pCar->m_pPhysModel == NULL)
+		return false;
+
+	const VehicleStates * pStates = m_tableStates.acquireLock();
+	unsigned int i, iCount = pStates->GetCount();
+	Coords ptCar = pCar->GetCurrentPosition();
 	bool bFound = false;
 
-	for (iterCar = m_mapRegistry.begin(); iterCar != m_mapRegistry.end(); ++iterCar)
+	// test every position in one pass, then pick out the cars
+	m_vecInRange.resize(iCount);
+	if (iCount == 0 || pCar->m_pPhysModel->AreCarsInRange(ptCar, &pStates->vecPositions[0], iCount, &m_vecInRange[0]) == 0)
+	{
+		m_tableStates.releaseLock();
+		return false;
+	}
+
+	for (i = 0; i < iCount; i++)
 	{
-		if (iterCar->second != NULL && iterCar->first != pCar->GetIPAddress() && pCar->m_pPhysModel != NULL && pCar->m_pPhysModel->IsCarInRange(pCar->GetCurrentPosition(), iterCar->second->GetCurrentPosition()))
+		if (m_vecInRange[i] && pStates->vecCars[i] != NULL && pStates->vecCars[i] != pCar)
 		{
-			vecCars.push_back(iterCar->second);
+			vecCars.push_back(pStates->vecCars[i]);
 			bFound = true;
 		}
 	}
 
+	m_tableStates.releaseLock();
 	return bFound;
 }
 
 bool CarRegistry::GetCommunicatingCarsInRange(const CarModel * pCar, std::vector<CarModel *> & vecCars)
 {
-	std::map<in_addr_t, CarModel *>::iterator iterCar;
+	if (pCar->m_pPhysModel == NULL)
+		return false;
+
+	const VehicleStates * pStates = m_tableStates.acquireLock();
+	unsigned int i, iCount = pStates->GetCount();
+	Coords ptCar = pCar->GetCurrentPosition();
+	CarModel * pOther;
 	bool bFound = false;
 
-	for (iterCar = m_mapRegistry.begin(); iterCar != m_mapRegistry.end(); ++iterCar)
+	m_vecInRange.resize(iCount);
+	if (iCount == 0 || pCar->m_pPhysModel->AreCarsInRange(ptCar, &pStates->vecPositions[0], iCount, &m_vecInRange[0]) == 0)
 	{
-		if (iterCar->second != NULL && iterCar->first != pCar->GetIPAddress() && iterCar->second->IsActive() && iterCar->second->m_pCommModel != NULL && pCar->m_pPhysModel != NULL && pCar->m_pPhysModel->IsCarInRange(pCar->GetCurrentPosition(), iterCar->second->GetCurrentPosition()))
+		m_tableStates.releaseLock();
+		return false;
+	}
+
+	for (i = 0; i < iCount; i++)
+	{
+		pOther = pStates->vecCars[i];
+		if (m_vecInRange[i] && pOther != NULL && pOther != pCar && pOther->m_pCommModel != NULL && pOther->IsActive())
 		{
-			vecCars.push_back(iterCar->second);
+			vecCars.push_back(pOther);
 			bFound = true;
 		}
 	}
 
+	m_tableStates.releaseLock();
 	return bFound;
 }
 
@@ -168,3 +205,41 @@ bool CarRegistry::GetNetworkCars(std::vector<CarModel *> & vecCars)
 
 	return bFound;
 }
+
+CarModel * CarRegistry::GetLaneLeader(unsigned int iRecord, bool bForwards, unsigned int iLane, unsigned short iShapePoint, float fProgress, in_addr_t ipCar, bool bActiveOnly)
+{
+	return GetLaneNeighbor(iRecord, bForwards, iLane, iShapePoint, fProgress, ipCar, bActiveOnly, true);
+}
+
+CarModel * CarRegistry::GetLaneFollower(unsigned int iRecord, bool bForwards, unsigned int iLane, unsigned short iShapePoint, float fProgress, in_addr_t ipCar, bool bActiveOnly)
+{
+	return GetLaneNeighbor(iRecord, bForwards, iLane, iShapePoint, fProgress, ipCar, bActiveOnly, false);
+}
+
+CarModel * CarRegistry::GetLaneNeighbor(unsigned int iRecord, bool bForwards, unsigned int iLane, unsigned short iShapePoint, float fProgress, in_addr_t ipCar, bool bActiveOnly, bool bLeader)
+{
+	std::map<in_addr_t, CarModel *>::iterator iterCar = m_mapRegistry.find(ipCar);
+	unsigned int iSlot, iOwnSlot = (iterCar != m_mapRegistry.end() && iterCar->second != NULL) ? iterCar->second->GetStateSlot() : VEHICLESTATE_NONE;
+	const VehicleStates * pStates = m_tableStates.acquireLock();
+	const LaneOccupancy & occupancy = m_tableStates.GetLaneOccupancy();
+	LanePosition pos(iShapePoint, fProgress, iOwnSlot);
+	CarModel * pCar;
+
+	iSlot = bLeader ? occupancy.GetLeader(iRecord, bForwards, iLane, pos) : occupancy.GetFollower(iRecord, bForwards, iLane, pos);
+	while (iSlot != VEHICLESTATE_NONE)
+	{
+		pCar = pStates->vecCars[iSlot];
+		if (iSlot != iOwnSlot && pCar != NULL && (!bActiveOnly || pCar->IsActive()))
+		{
+			m_tableStates.releaseLock();
+			return pCar;
+		}
+
+		// keep going past this one
+		pos = LanePosition(pStates->vecShapePoints[iSlot], pStates->vecProgress[iSlot], iSlot);
+		iSlot = bLeader ? occupancy.GetLeader(iRecord, bForwards, iLane, pos) : occupancy.GetFollower(iRecord, bForwards, iLane, pos);
+	}
+
+	m_tableStates.releaseLock();
+	return NULL;
+}
@@ -26,6 +26,7 @@
 #define _CARREGISTRY_H
 
 #include "CarModel.h"
+#include "VehicleStateTable.h"
 
 class CarRegistry
 {
@@ -53,17 +54,32 @@ public:
 	inline void addCar(CarModel * pCar)
 	{
 		m_mutexRegistry.lock();
-		m_mapRegistry.insert(std::pair<in_addr_t, CarModel *>(pCar->GetIPAddress(), pCar));
+		if (m_mapRegistry.insert(std::pair<in_addr_t, CarModel *>(pCar->GetIPAddress(), pCar)).second)
+			pCar->SetStateSlot(m_tableStates.Add(pCar));
 		m_mutexRegistry.unlock();
 	}
 	inline bool removeCar(in_addr_t ipCar)
 	{
-		bool bRemoved;
+		bool bRemoved = false;
 		m_mutexRegistry.lock();
-		bRemoved = m_mapRegistry.erase(ipCar) > 0;
+		std::map<in_addr_t, CarModel *>::iterator iterCar = m_mapRegistry.find(ipCar);
+		if (iterCar != m_mapRegistry.end())
+		{
+			if (iterCar->second != NULL)
+			{
+				m_tableStates.Remove(iterCar->second->GetStateSlot());
+				iterCar->second->SetStateSlot(VEHICLESTATE_NONE);
+			}
+			m_mapRegistry.erase(iterCar);
+			bRemoved = true;
+		}
 		m_mutexRegistry.unlock();
 		return bRemoved;
 	}
+	inline VehicleStateTable & GetStateTable()
+	{
+		return m_tableStates;
+	}
 
 	bool GetCarsOnRecord(unsigned int iRecord, std::vector<CarModel *> & vecCars);
 	bool GetCarsOnRecord(unsigned int iRecord, bool bForwards, std::vector<CarModel *> & vecCars);
@@ -73,10 +89,20 @@ public:
 	bool GetCommunicatingCarsInRange(const CarModel * pCar, std::vector<CarModel *> & vecCars);
 	bool GetLocalCars(std::vector<CarModel *> & vecCars);
 	bool GetNetworkCars(std::vector<CarModel *> & vecCars);
+	// the nearest car ahead of (leader) or behind (follower) a position in one
+	// lane of a record, or in any lane given LANEOCCUPANCY_ANY_LANE, passing
+	// over the car ipCar itself and, if bActiveOnly, any inactive cars
+	CarModel * GetLaneLeader(unsigned int iRecord, bool bForwards, unsigned int iLane, unsigned short iShapePoint, float fProgress, in_addr_t ipCar, bool bActiveOnly = false);
+	CarModel * GetLaneFollower(unsigned int iRecord, bool bForwards, unsigned int iLane, unsigned short iShapePoint, float fProgress, in_addr_t ipCar, bool bActiveOnly = false);
 
 protected:
+	CarModel * GetLaneNeighbor(unsigned int iRecord, bool bForwards, unsigned int iLane, unsigned short iShapePoint, float fProgress, in_addr_t ipCar, bool bActiveOnly, bool bLeader);
+
 	std::map<in_addr_t, CarModel *> m_mapRegistry;
 	QMutex m_mutexRegistry;
+	VehicleStateTable m_tableStates;
+	// scratch for the range scans, used while the state table is locked
+	std::vector<unsigned char> m_vecInRange;
 
 private:
 	inline CarRegistry(const CarRegistry & copy __attribute__ ((unused)) ) {}
@@ -25,6 +25,8 @@
 #include "CollisionPhysModel.h"
 #include "CarRegistry.h"
 #include "StringHelp.h"
+#include "Network.h"
+#include "SimCheckpoint.h"
 
 bool CompareMessageStartTimes(const std::pair<RXPacketSequence, TimeInterval> & x, const std::pair<RXPacketSequence, TimeInterval> & y)
 {
@@ -34,6 +36,7 @@ bool CompareMessageStartTimes(const std::pair<RXPacketSequence, TimeInterval> &
 CollisionPhysModel::CollisionPhysModel(const QString & strModelName)
 : SimplePhysModel(strModelName), m_iCollisions(0)
 {
+	FindUncollided();
 }
 
 CollisionPhysModel::CollisionPhysModel(const CollisionPhysModel & copy)
@@ -41,7 +44,8 @@ CollisionPhysModel::CollisionPhysModel(const CollisionPhysModel & copy)
 {
 	unsigned int i;
 	for (i = 0; i < PACKETMESSAGE_TYPENUM; i++)
-		m_mapMessages[i] = copy.m_mapMessages[i];
+		m_mapReceptions[i] = copy.m_mapReceptions[i];
+	FindUncollided();
 }
 
 CollisionPhysModel::~CollisionPhysModel()
@@ -55,7 +59,8 @@ CollisionPhysModel & CollisionPhysModel::operator = (const CollisionPhysModel &
 	SimplePhysModel::operator =(copy);
 
 	for (i = 0; i < PACKETMESSAGE_TYPENUM; i++)
-		m_mapMessages[i] = copy.m_mapMessages[i];
+		m_mapReceptions[i] = copy.m_mapReceptions[i];
+	FindUncollided();
 	m_iCollisions = copy.m_iCollisions;
 	return *this;
 }
@@ -69,31 +74,93 @@ int CollisionPhysModel::PreRun()
 
 //	m_vecMessageRXTimes.clear();
 	for (i = 0; i < PACKETMESSAGE_TYPENUM; i++)
-		m_mapMessages[i].clear();
+		m_mapReceptions[i].clear();
+	FindUncollided();
 	m_iCollisions = 0;
 	return 0;
 }
 
+// the receptions still on the air, which packets in flight may yet collide
+// with
+int CollisionPhysModel::SaveState(CheckpointWriter & writer)
+{
+	CollisionRXMap::iterator iterReception;
+	unsigned int i;
+
+	if (SimplePhysModel::SaveState(writer))
+		return 1;
+
+	if (writer.IsWarmStart())
+		return 0;
+	writer.WriteUInt(m_iCollisions);
+	for (i = 0; i < PACKETMESSAGE_TYPENUM; i++)
+	{
+		writer.WriteUInt(m_mapReceptions[i].size());
+		for (iterReception = m_mapReceptions[i].begin(); iterReception != m_mapReceptions[i].end(); ++iterReception)
+		{
+			writer.WriteTime(iterReception->first);
+			writer.WriteUInt(iterReception->second.ID.srcID.iSeqNumber);
+			writer.WriteUInt(iterReception->second.ID.srcID.ipCar);
+			writer.WriteUInt(iterReception->second.ID.iRXSeqNumber);
+			writer.WriteBool(iterReception->second.bCollided);
+		}
+	}
+	return 0;
+}
+
+int CollisionPhysModel::LoadState(CheckpointReader & reader)
+{
+	CollisionRX reception;
+	struct timeval tEnd;
+	unsigned int i, j, numReceptions;
+	bool bSuccess = true;
+
+	if (SimplePhysModel::LoadState(reader))
+		return 1;
+
+	if (reader.IsWarmStart())
+		return 0;
+	for (i = 0; i < PACKETMESSAGE_TYPENUM; i++)
+		m_mapReceptions[i].clear();
+	bSuccess = reader.ReadUInt(m_iCollisions);
+	for (i = 0; bSuccess && i < PACKETMESSAGE_TYPENUM; i++)
+	{
+		bSuccess = reader.ReadUInt(numReceptions);
+		for (j = 0; bSuccess && j < numReceptions; j++)
+		{
+			bSuccess = reader.ReadTime(tEnd) && reader.ReadUInt(reception.ID.srcID.iSeqNumber) && reader.ReadUInt(reception.ID.srcID.ipCar) && reader.ReadUInt(reception.ID.iRXSeqNumber) && reader.ReadBool(reception.bCollided);
+			if (bSuccess)
+				m_mapReceptions[i].insert(std::pair<struct timeval, CollisionRX>(tEnd, reception));
+		}
+	}
+	FindUncollided();
+	return bSuccess ? 0 : 2;
+}
+
 bool CollisionPhysModel::EndProcessPacket(Packet * packet)
 {
-	std::map<RXPacketSequence, bool>::iterator iterMessage;
+	CollisionRXMap::iterator iterReception, iterLast;
 	bool bValid = SimplePhysModel::EndProcessPacket(packet);
 
 	if (bValid)
 	{
 		unsigned int iChannel = m_bMultichannel ? GetMessageChannel(packet) : 0;
-		iterMessage = m_mapMessages[iChannel].find(packet->m_ID);
-		bValid = iterMessage != m_mapMessages[iChannel].end();
+		ReclaimReceptions(iChannel, packet->m_tRX);
+		iterReception = m_mapReceptions[iChannel].lower_bound(packet->m_tRX);
+		for (iterLast = m_mapReceptions[iChannel].upper_bound(packet->m_tRX); iterReception != iterLast && !(iterReception->second.ID == packet->m_ID); ++iterReception);
+		bValid = iterReception != iterLast;
 		if (bValid)
 		{
-			bValid = !iterMessage->second;
+			bValid = !iterReception->second.bCollided;
 			//no m_eType -MH
 			/*
 			if (!bValid && (!m_bMultichannel || packet->m_ePacketType == PacketTypeMessage && (((Message *)packet)->m_eType == Message::MessageTypeEmergency || ((Message *)packet)->m_eType == Message::MessageTypeWarning)))
 			*/
 			if (!bValid && (!m_bMultichannel || packet->m_ePacketType == ptSafety))
 				m_iCollisions++;
-			m_mapMessages[iChannel].erase(iterMessage);
+			if (iterReception == m_iterUncollided[iChannel])
+				m_iterUncollided[iChannel] = m_mapReceptions[iChannel].end();
+			m_mapReceptions[iChannel].erase(iterReception);
 		}
 	}
 	return bValid;
@@ -101,19 +168,56 @@ bool CollisionPhysModel::EndProcessPacket(Packet * packet)
 
 bool CollisionPhysModel::BeginProcessPacket(Packet * packet)
 {
-	std::map<RXPacketSequence, bool>::iterator iterMessage;
+	CollisionRX reception;
 
 	SimplePhysModel::BeginProcessPacket(packet);
 
 	unsigned int iChannel = m_bMultichannel ? GetMessageChannel(packet) : 0;
-	iterMessage = m_mapMessages[iChannel].begin();
-	if (m_mapMessages[iChannel].size() == 1)
-		iterMessage->second = true;
-	m_mapMessages[iChannel].insert(std::pair<RXPacketSequence, bool>(packet->m_ID, iterMessage != m_mapMessages[iChannel].end()));
+	unsigned int iBytesPerSec = GetTXRate();
+	// receptions that ended before this one started don't overlap it, even if
+	// nothing processed their end (the link layer may have dropped them)
+	ReclaimReceptions(iChannel, iBytesPerSec > 0 ? packet->m_tRX - MakeTime((double)packet->GetLength() / iBytesPerSec) : packet->m_tRX);
+	// any reception still in progress overlaps this one, so both collide
+	reception.ID = packet->m_ID;
+	reception.bCollided = !m_mapReceptions[iChannel].empty();
+	if (m_iterUncollided[iChannel] != m_mapReceptions[iChannel].end())
+	{
+		m_iterUncollided[iChannel]->second.bCollided = true;
+		m_iterUncollided[iChannel] = m_mapReceptions[iChannel].end();
+	}
+	if (reception.bCollided)
+		m_mapReceptions[iChannel].insert(std::pair<struct timeval, CollisionRX>(packet->m_tRX, reception));
+	else
+		m_iterUncollided[iChannel] = m_mapReceptions[iChannel].insert(std::pair<struct timeval, CollisionRX>(packet->m_tRX, reception));
 
 	return true;
 }
 
+// events run in time order, so by time tEnd every reception that ended
+// earlier has been processed; any that are left never will be (e.g. the link
+// layer dropped them), so drop them in bulk before they can cause phantom
+// collisions
+void CollisionPhysModel::ReclaimReceptions(unsigned int iChannel, const struct timeval & tEnd)
+{
+	CollisionRXMap::iterator iterStale = m_mapReceptions[iChannel].lower_bound(tEnd);
+
+	if (m_iterUncollided[iChannel] != m_mapReceptions[iChannel].end() && m_iterUncollided[iChannel]->first < tEnd)
+		m_iterUncollided[iChannel] = m_mapReceptions[iChannel].end();
+	m_mapReceptions[iChannel].erase(m_mapReceptions[iChannel].begin(), iterStale);
+}
+
+void CollisionPhysModel::FindUncollided()
+{
+	CollisionRXMap::iterator iterReception;
+	unsigned int i;
+
+	for (i = 0; i < PACKETMESSAGE_TYPENUM; i++)
+	{
+		for (iterReception = m_mapReceptions[i].begin(); iterReception != m_mapReceptions[i].end() && iterReception->second.bCollided; ++iterReception);
+		m_iterUncollided[i] = iterReception;
+	}
+}
+
 void CollisionPhysModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 {
 	SimplePhysModel::GetParams(mapParams);
@@ -31,6 +31,17 @@
 
 typedef std::pair<struct timeval, struct timeval> TimeInterval;
 
+// a reception in progress on one channel
+typedef struct CollisionRXStruct
+{
+	RXPacketSequence ID;
+	bool bCollided;
+} CollisionRX;
+
+// receptions in progress, keyed by the end of their airtime (the packet's
+// m_tRX)
+typedef std::multimap<struct timeval, CollisionRX> CollisionRXMap;
+
 class CollisionPhysModel : public SimplePhysModel
 {
 public:
@@ -50,6 +61,8 @@ public:
 	virtual CollisionPhysModel & operator = (const CollisionPhysModel & copy);
 
 	virtual int PreRun();
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
@@ -61,7 +74,13 @@ public:
 	}
 
 protected:
-	std::map<RXPacketSequence, bool> m_mapMessages[PACKETMESSAGE_TYPENUM];
+	void ReclaimReceptions(unsigned int iChannel, const struct timeval & tEnd);
+	void FindUncollided();
+
+	CollisionRXMap m_mapReceptions[PACKETMESSAGE_TYPENUM];
+	// a reception collides as soon as it overlaps another one, so at most one
+	// reception per channel is uncollided: this one (or end() if none)
+	CollisionRXMap::iterator m_iterUncollided[PACKETMESSAGE_TYPENUM];
 	unsigned int m_iCollisions;
 };
 
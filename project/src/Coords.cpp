@@ -91,6 +91,46 @@ float Distance(const Coords & pt1, const Coords & pt2)
 	return EARTHRADIUS * c;
 }
 
+LocalFrame::LocalFrame(const Coords & ptOrigin)
+: m_ptOrigin(ptOrigin)
+{
+	// coordinates are in millionths of a degree
+	m_fNorthScale = EARTHRADIUS * METERSPERMILE * M_PI / 180000000;
+	m_fEastScale = m_fNorthScale * cos(ptOrigin.m_iLat * M_PI / 180000000);
+}
+
+#ifdef DEBUG
+void LocalFrame::CheckDistance(const Coords & pt, double fDistance) const
+{
+	double fHaversine = ::Distance(m_ptOrigin, pt) * METERSPERMILE;
+
+	if (fHaversine <= LOCALFRAME_MAX_ERROR_RANGE && labs(m_ptOrigin.m_iLat) <= LOCALFRAME_MAX_ERROR_LATITUDE)
+		Q_ASSERT(fabs(fDistance - fHaversine) <= LOCALFRAME_MAX_ERROR * fHaversine);
+}
+#endif
+
+unsigned int LocalFrame::InRange(const Coords * pPoints, unsigned int iCount, double fRange, unsigned char * pInRange) const
+{
+	const double fRangeSquared = fRange * fRange;
+	const long iLong = m_ptOrigin.m_iLong, iLat = m_ptOrigin.m_iLat;
+	const double fEastScale = m_fEastScale, fNorthScale = m_fNorthScale;
+	unsigned int i, iFound = 0;
+	double fEast, fNorth;
+
+	// coordinate differences always fit in an int, and converting those
+	// (rather than longs) lets the first loop vectorize; the count is kept
+	// out of it for the same reason
+	for (i = 0; i < iCount; i++)
+	{
+		fEast = (int)(pPoints[i].m_iLong - iLong) * fEastScale;
+		fNorth = (int)(pPoints[i].m_iLat - iLat) * fNorthScale;
+		pInRange[i] = fEast * fEast + fNorth * fNorth < fRangeSquared;
+	}
+	for (i = 0; i < iCount; i++)
+		iFound += pInRange[i];
+	return iFound;
+}
+
 
 Rect::Rect()
 : m_iLeft(0), m_iTop(0), m_iRight(0), m_iBottom(0)
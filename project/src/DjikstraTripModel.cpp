@@ -23,6 +23,8 @@
  ***************************************************************************/
 
 #include "DjikstraTripModel.h"
+#include "SimCheckpoint.h"
+#include "Simulator.h"
 
 #define DJIKSTRATRIPMODEL_FINISH_PARAM "FINISH"
 #define DJIKSTRATRIPMODEL_FINISH_PARAM_DEFAULT ""
@@ -33,14 +35,15 @@
 #define DJIKSTRATRIPMODEL_WAYPOINTS_PARAM_DESC "WAYPOINTS (addresses) -- A semicolon-delimited list of waypoints for this vehicle to visit on its trip."
 
 DjikstraTripModel::DjikstraTripModel(const QString & strModelName)
-: RandomWalkModel(strModelName), m_iEndShapePoint((unsigned)-1), m_fEndProgress(1.f)
+: RandomWalkModel(strModelName), m_iEndShapePoint((unsigned)-1), m_fEndProgress(1.f), m_bCheckpointForwards(true), m_bCheckpoint(false)
 {
 }
 
 DjikstraTripModel::DjikstraTripModel(const DjikstraTripModel & copy)
-: RandomWalkModel(copy), m_iEndShapePoint(copy.m_iEndShapePoint), m_fEndProgress(copy.m_fEndProgress), m_sFinishAddress(copy.m_sFinishAddress), m_strFinishAddress(copy.m_strFinishAddress), m_strWaypoints(copy.m_strWaypoints)
+: RandomWalkModel(copy), m_iEndShapePoint(copy.m_iEndShapePoint), m_fEndProgress(copy.m_fEndProgress), m_bCheckpointForwards(copy.m_bCheckpointForwards), m_bCheckpoint(copy.m_bCheckpoint), m_sFinishAddress(copy.m_sFinishAddress), m_strFinishAddress(copy.m_strFinishAddress), m_strWaypoints(copy.m_strWaypoints)
 {
 	m_listPathRecords = copy.m_listPathRecords;
+	m_listCheckpointPath = copy.m_listCheckpointPath;
 	m_listWaypoints = copy.m_listWaypoints;
 }
 
@@ -55,6 +58,9 @@ DjikstraTripModel & DjikstraTripModel::operator = (const DjikstraTripModel & cop
 	m_iEndShapePoint = copy.m_iEndShapePoint;
 	m_fEndProgress = copy.m_fEndProgress;
 	m_listPathRecords = copy.m_listPathRecords;
+	m_listCheckpointPath = copy.m_listCheckpointPath;
+	m_bCheckpointForwards = copy.m_bCheckpointForwards;
+	m_bCheckpoint = copy.m_bCheckpoint;
 	m_listWaypoints = copy.m_listWaypoints;
 	m_sFinishAddress = copy.m_sFinishAddress;
 	m_strFinishAddress = copy.m_strFinishAddress;
@@ -63,126 +69,86 @@ DjikstraTripModel & DjikstraTripModel::operator = (const DjikstraTripModel & cop
 	return *this;
 }
 
-bool DjikstraTripModel::SetProgress(float & fTime, short iSpeed, unsigned int & iNextRecord)
+bool DjikstraTripModel::SetProgress(struct timeval tCurrent, float & fTime, short iSpeed, unsigned int & iNextRecord)
 {
 	if (m_iCurrentRecord == (unsigned)-1 || m_iCRShapePoint == (unsigned)-1)
 		return false;
 
-	// find distance to next shape point
+	// move along the record, up to its end (or the end of the trip)
 	MapRecord * pRecord = g_pMapDB->GetRecord(m_iCurrentRecord);
-	float fRemaining = 0.f, fPart = 0.f, fDistance = (fTime * iSpeed) / SECSPERHOUR;
+	float fRemaining, fEnd, fDistance = (fTime * iSpeed) / SECSPERHOUR;
 
-	if ((signed)m_iCRShapePoint < pRecord->nShapePoints - 1)
-	{
-		Coords c0 = pRecord->pShapePoints[m_iCRShapePoint], c1 = pRecord->pShapePoints[m_iCRShapePoint + 1];
-
-		fPart = Distance(c0, c1);
-		if (m_listPathRecords.empty() && m_iCRShapePoint == m_iEndShapePoint)
-		{
-			if (m_bForwards)
-				fRemaining = fPart * (m_fEndProgress - m_fCRProgress);
-			else
-				fRemaining = fPart * (m_fCRProgress - m_fEndProgress);
-		}
-		else
-		{
-			if (m_bForwards)
-				fRemaining = fPart * (1 - m_fCRProgress);
-			else
-				fRemaining = fPart * m_fCRProgress;
-		}
-	}
+	// without a finish (PreRun found no route), drive to the end of the record
+	if (m_listPathRecords.empty() && m_iEndShapePoint != (unsigned)-1)
+		fEnd = g_pMapDB->DistanceAlongRecord(m_iCurrentRecord, m_iEndShapePoint, m_fEndProgress);
+	else
+		fEnd = m_bForwards ? g_pMapDB->GetRecordLength(m_iCurrentRecord) : 0.f;
+	fRemaining = AdvanceAlongRecord(fDistance, fEnd);
 
-	if (fDistance < fRemaining && fPart > 0.f)
+	if (fDistance < fRemaining)
 	{
-		// we're still on the same part of the record
-		if (m_bForwards)
-			m_fCRProgress += fDistance / fPart;
-		else
-			m_fCRProgress -= fDistance / fPart;
+		// we're still on the same record
 		fTime = 0.f;
 	}
 	else
 	{
-		// we've passed the end of this shape point
+		// we've passed the end of this record
 		if (iSpeed > 0)
 			fTime -= (fRemaining * SECSPERHOUR) / iSpeed;
 		else
 			fTime = 0.f;
 		if (m_bForwards) {
-			if ((signed)m_iCRShapePoint < (m_listPathRecords.empty() ? (signed)m_iEndShapePoint : (pRecord->nShapePoints - 1)))
+			// check to see if we're stopped for a traffic light
+			if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[pRecord->nVertices - 1]), m_iCurrentRecord, tCurrent))
 			{
-				m_iCRShapePoint++;
-				m_fCRProgress = 0.f;
-//				return SetProgress(fTime, iSpeed, iNextRecord);
-				return true;
-			}
-			else
-			{
-				// check to see if we're stopped for a traffic light
-				if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[pRecord->nVertices - 1]), m_iCurrentRecord))
+				// go to next record and return with the unused time
+				iNextRecord = GetNextRecord(pRecord->pVertices[pRecord->nVertices - 1], m_iCurrentRecord);
+				if (iNextRecord != (unsigned)-1)
 				{
-					// go to next record and return with the unused time
-					iNextRecord = GetNextRecord(pRecord->pVertices[pRecord->nVertices - 1], m_iCurrentRecord);
-					if (iNextRecord != (unsigned)-1)
-					{
-						m_iCurrentRecord = iNextRecord;
-						if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[pRecord->nVertices - 1]) {
-							m_bForwards = true;
-							m_iCRShapePoint = 0;
-							m_fCRProgress = 0.f;
-						} else {
-							m_bForwards = false;
-							m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
-							m_fCRProgress = 0.f;
-						}
-						return true;
+					m_iCurrentRecord = iNextRecord;
+					if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[pRecord->nVertices - 1]) {
+						m_bForwards = true;
+						m_iCRShapePoint = 0;
+						m_fCRProgress = 0.f;
+					} else {
+						m_bForwards = false;
+						m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
+						m_fCRProgress = 0.f;
 					}
-				}
-				else
-				{
-					// we're stopped here!
-					fTime = 0.f;
-					m_fCRProgress = 1.f;
+					return true;
 				}
 			}
-		} else {
-			if (m_iCRShapePoint > (m_listPathRecords.empty() ? m_iEndShapePoint : 0))
+			else
 			{
-				m_iCRShapePoint--;
-				m_fCRProgress = 1.f;
-//				return SetProgress(fTime, iSpeed, iNextRecord);
-				return true;
+				// we're stopped here!
+				fTime = 0.f;
 			}
-			else
+		} else {
+			// check to see if we're stopped for a traffic light
+			if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[0]), m_iCurrentRecord, tCurrent))
 			{
-				// check to see if we're stopped for a traffic light
-				if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[0]), m_iCurrentRecord))
+				// go to next record
+				iNextRecord = GetNextRecord(pRecord->pVertices[0], m_iCurrentRecord);
+				if (iNextRecord != (unsigned)-1)
 				{
-					// go to next record
-					iNextRecord = GetNextRecord(pRecord->pVertices[0], m_iCurrentRecord);
-					if (iNextRecord != (unsigned)-1)
-					{
-						m_iCurrentRecord = iNextRecord;
-						if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[0]) {
-							m_bForwards = true;
-							m_iCRShapePoint = 0;
-							m_fCRProgress = 0.f;
-						} else {
-							m_bForwards = false;
-							m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
-							m_fCRProgress = 0.f;
-						}
-						return true;
+					m_iCurrentRecord = iNextRecord;
+					if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[0]) {
+						m_bForwards = true;
+						m_iCRShapePoint = 0;
+						m_fCRProgress = 0.f;
+					} else {
+						m_bForwards = false;
+						m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
+						m_fCRProgress = 0.f;
 					}
-				}
-				else
-				{
-					// we're stopped here!
-					fTime = 0.f;
-					m_fCRProgress = 0.f;
+					return true;
 				}
 			}
+			else
+			{
+				// we're stopped here!
+				fTime = 0.f;
+			}
 		}
 	}
 	return false;
@@ -211,6 +177,7 @@ int DjikstraTripModel::Init(const std::map<QString, QString> & mapParams)
 	if (RandomWalkModel::Init(mapParams))
 		return 1;
 
+	m_bCheckpoint = false;
 	m_strFinishAddress = GetParam(mapParams, DJIKSTRATRIPMODEL_FINISH_PARAM, DJIKSTRATRIPMODEL_FINISH_PARAM_DEFAULT);
 	if (!StringToAddress(m_strFinishAddress, &m_sFinishAddress))
 		m_sFinishAddress.iRecord = m_sFinishAddress.iVertex = (unsigned)-1; // signal random walk
@@ -278,6 +245,32 @@ int DjikstraTripModel::PreRun()
 	return bStartSet ? 0 : 2;
 }
 
+int DjikstraTripModel::Checkpoint()
+{
+	if (RandomWalkModel::Checkpoint())
+		return 1;
+
+	m_listCheckpointPath = m_listPathRecords;
+	m_bCheckpointForwards = m_bForwards;
+	m_bCheckpoint = true;
+	return 0;
+}
+
+// the route only depends on the start, waypoints and finish, so later trials
+// take it from the checkpoint rather than searching the map again
+int DjikstraTripModel::Restore()
+{
+	if (!m_bCheckpoint)
+		return PreRun();
+
+	if (RandomWalkModel::PreRun())
+		return 1;
+
+	m_listPathRecords = m_listCheckpointPath;
+	m_bForwards = m_bCheckpointForwards;
+	return 0;
+}
+
 int DjikstraTripModel::Save(std::map<QString, QString> & mapParams)
 {
 	if (RandomWalkModel::Save(mapParams))
@@ -289,6 +282,38 @@ int DjikstraTripModel::Save(std::map<QString, QString> & mapParams)
 	return 0;
 }
 
+int DjikstraTripModel::SaveState(CheckpointWriter & writer)
+{
+	std::list<unsigned int>::iterator iterRecord;
+
+	if (RandomWalkModel::SaveState(writer))
+		return 1;
+
+	writer.WriteUInt(m_listPathRecords.size());
+	for (iterRecord = m_listPathRecords.begin(); iterRecord != m_listPathRecords.end(); ++iterRecord)
+		writer.WriteUInt(*iterRecord);
+	return 0;
+}
+
+int DjikstraTripModel::LoadState(CheckpointReader & reader)
+{
+	unsigned int i, numRecords, iRecord;
+
+	if (RandomWalkModel::LoadState(reader))
+		return 1;
+
+	m_listPathRecords.clear();
+	if (!reader.ReadUInt(numRecords))
+		return 2;
+	for (i = 0; i < numRecords; i++)
+	{
+		if (!reader.ReadUInt(iRecord))
+			return 2;
+		m_listPathRecords.push_back(iRecord);
+	}
+	return 0;
+}
+
 void DjikstraTripModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 {
 	RandomWalkModel::GetParams(mapParams);
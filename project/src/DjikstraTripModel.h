@@ -51,11 +51,15 @@ public:
 
 	virtual int Init(const std::map<QString, QString> & mapParams);
 	virtual int PreRun();
+	virtual int Checkpoint();
+	virtual int Restore();
 	virtual int Save(std::map<QString, QString> & mapParams);
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
-	virtual bool SetProgress(float & fTime, short iSpeed, unsigned int & iNextRecord);
+	virtual bool SetProgress(struct timeval tCurrent, float & fTime, short iSpeed, unsigned int & iNextRecord);
 
 protected:
 	virtual unsigned int GetNextRecord(unsigned int iVertex, unsigned int iPrevRecord);
@@ -63,6 +67,9 @@ protected:
 	unsigned int m_iEndShapePoint;
 	float m_fEndProgress;
 	std::list<unsigned int> m_listPathRecords;
+	// the route found by PreRun, kept for later Monte Carlo trials
+	std::list<unsigned int> m_listCheckpointPath;
+	bool m_bCheckpointForwards, m_bCheckpoint;
 	std::list<Address> m_listWaypoints;
 	Address m_sFinishAddress;
 	QString m_strFinishAddress, m_strWaypoints;
@@ -110,7 +110,7 @@ bool FixedMobilityModel::GetInitialConditions(unsigned int & iRecord, Coords & p
 	return iRecord != (unsigned)-1;
 }
 
-bool FixedMobilityModel::DoIteration(float fElapsed __attribute__((unused)) , unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane)
+bool FixedMobilityModel::DoIteration(struct timeval tCurrent __attribute__((unused)) , float fElapsed __attribute__((unused)) , unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane)
 {
 	bool bActive = false;
 
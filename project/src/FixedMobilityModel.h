@@ -53,7 +53,7 @@ public:
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
 	virtual bool GetInitialConditions(unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane);
-	virtual bool DoIteration(float fElapsed, unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane);
+	virtual bool DoIteration(struct timeval tCurrent, float fElapsed, unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane);
 	inline virtual short ChooseSpeed(unsigned int iRecord __attribute__((unused)) ) const
 	{
 		return 0; // fixed = doesn't move
@@ -91,17 +91,6 @@ GPSModel & GPSModel::operator = (const GPSModel & copy)
 	return *this;
 }
 
-QString GPSModel::GetCarListColumnText(CarListColumn eColumn) const
-{
-	switch (eColumn)
-	{
-	case CarListColumnType:
-		return "Local/GPS";
-	default:
-		return CarModel::GetCarListColumnText(eColumn);
-	}
-}
-
 bool GPSModel::IsActive() const
 {
 	return m_tTimestamp + MakeTime(GPSMODEL_TIMEOUT_SECS, GPSMODEL_TIMEOUT_USECS) >= GetLastEventTime();
@@ -170,6 +159,7 @@ int GPSModel::ProcessEvent(SimEvent & event)
 		if (bUpdated) {
 			g_pMapDB->CoordsToRecord(m_ptPosition, m_iCurrentRecord, m_iCRShapePoint, m_fCRProgress);
 			m_bForwards = m_iCurrentRecord == (unsigned)-1 || IsVehicleGoingForwards(m_iCRShapePoint, m_iHeading, g_pMapDB->GetRecord(m_iCurrentRecord));
+			PublishState();
 		}
 		if (IsActive())
 		{
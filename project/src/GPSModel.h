@@ -110,7 +110,10 @@ public:
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
-	virtual QString GetCarListColumnText(CarListColumn eColumn) const;
+	inline virtual const char * GetCarListType() const
+	{
+		return "Local/GPS";
+	}
 	virtual bool IsActive() const;
 
 protected:
@@ -26,10 +26,15 @@
 #include <cstdlib>
 
 #include <sys/time.h>
+#include <qmutex.h>
 
 #define RAND_MAX_BITS 31
 
 static bool g_bSimulated = false;
+static unsigned int g_iRandomState = 1;
+// the simulation and the scenario generator (in the GUI thread) draw from
+// the same generator
+static QMutex g_mutexRandom;
 static struct timeval g_tCurrent = timeval0, g_tIncrement = timeval0;
 
 static struct timeval GetCurrentTimeInternal()
@@ -107,9 +112,37 @@ struct timeval operator * (const struct timeval & t, const double fScale)
 	return MakeTime(ToDouble(t)*fScale);
 }
 
+void SeedRandom(unsigned int iSeed)
+{
+	g_mutexRandom.lock();
+	g_iRandomState = iSeed;
+	g_mutexRandom.unlock();
+}
+
+unsigned int GetRandomState()
+{
+	unsigned int iState;
+
+	g_mutexRandom.lock();
+	iState = g_iRandomState;
+	g_mutexRandom.unlock();
+	return iState;
+}
+
+void SetRandomState(unsigned int iState)
+{
+	g_mutexRandom.lock();
+	g_iRandomState = iState;
+	g_mutexRandom.unlock();
+}
+
 signed int RandInt(const signed int min, const signed int max)
 {
-	signed int ret = rand();
+	signed int ret;
+
+	g_mutexRandom.lock();
+	ret = rand_r(&g_iRandomState);
+	g_mutexRandom.unlock();
 	if (max > min)
 		return (ret % (max - min)) + min;
 	else
@@ -120,8 +153,11 @@ unsigned int RandUInt(const unsigned int min, const unsigned int max)
 {
 	unsigned int ret = 0;
 	unsigned int bits;
+
+	g_mutexRandom.lock();
 	for (bits = 0; bits < (sizeof(unsigned int) << 3); bits += RAND_MAX_BITS)
-		ret = (ret << RAND_MAX_BITS) | rand();
+		ret = (ret << RAND_MAX_BITS) | rand_r(&g_iRandomState);
+	g_mutexRandom.unlock();
 	if (max > min)
 		return (ret % (max - min)) + min;
 	else
@@ -130,7 +166,11 @@ unsigned int RandUInt(const unsigned int min, const unsigned int max)
 
 double RandDouble(const double min, const double max)
 {
-	double ret = ((double)rand()) / RAND_MAX;
+	double ret;
+
+	g_mutexRandom.lock();
+	ret = ((double)rand_r(&g_iRandomState)) / RAND_MAX;
+	g_mutexRandom.unlock();
 	if (max > min)
 		return (ret * (max - min)) + min;
 	else
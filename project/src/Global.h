@@ -106,6 +106,11 @@ inline double normangle(double theta)
 signed int RandInt(const signed int min, const signed int max);
 unsigned int RandUInt(const unsigned int min, const unsigned int max);
 double RandDouble(const double min, const double max);
+// the generator behind the Rand functions keeps its whole state in one
+// value, so a simulation checkpoint can save and restore it
+void SeedRandom(unsigned int iSeed);
+unsigned int GetRandomState();
+void SetRandomState(unsigned int iState);
 
 // get current time in milliseconds
 const struct timeval timeval0 = {0, 0};
@@ -27,6 +27,7 @@
 #include "InfrastructureNodeRegistry.h"
 #include "StringHelp.h"
 #include "Simulator.h"
+#include "SimCheckpoint.h"
 
 #define GROOVECOMMMODEL_FIRSTRBXJITTER_PARAM "FIRSTRBXJITTER"
 #define GROOVECOMMMODEL_FIRSTRBXJITTER_PARAM_DEFAULT "500u"
@@ -63,16 +64,12 @@ GrooveCommModel & GrooveCommModel::operator = (const GrooveCommModel & copy)
 
 int GrooveCommModel::Init(const std::map<QString, QString> & mapParams)
 {
-	QString strValue;
-
 	if (SimpleCommModel::Init(mapParams))
 		return 1;
 
-	strValue = GetParam(mapParams, GROOVECOMMMODEL_FIRSTRBXJITTER_PARAM, GROOVECOMMMODEL_FIRSTRBXJITTER_PARAM_DEFAULT);
-	m_tFirstRbxJitter = MakeTime(ValidateNumber(StringToNumber(strValue), 0., HUGE_VAL));
+	m_tFirstRbxJitter = MakeTime(ValidateNumber(GetNumberParam(mapParams, GROOVECOMMMODEL_FIRSTRBXJITTER_PARAM, GROOVECOMMMODEL_FIRSTRBXJITTER_PARAM_DEFAULT), 0., HUGE_VAL));
 
-	strValue = GetParam(mapParams, GROOVECOMMMODEL_FASTRBXENABLE_PARAM, GROOVECOMMMODEL_FASTRBXENABLE_PARAM_DEFAULT);
-	m_bFastRbx = StringToBoolean(strValue);
+	m_bFastRbx = GetBooleanParam(mapParams, GROOVECOMMMODEL_FASTRBXENABLE_PARAM, GROOVECOMMMODEL_FASTRBXENABLE_PARAM_DEFAULT);
 
 	return 0;
 }
@@ -82,6 +79,7 @@ int GrooveCommModel::PreRun()
 	if (SimpleCommModel::PreRun())
 		return 1;
 
+	m_mapSquelchMsgs.clear();
 	return 0;
 }
 
@@ -95,7 +93,9 @@ int GrooveCommModel::ProcessEvent(SimEvent & event)
 	case EVENT_CARCOMMMODEL_REBROADCAST:
 	{
 		RebroadcastMessage * pRBXMsg = (RebroadcastMessage *)event.GetEventData();
-		if (pRBXMsg != NULL)
+		if (pRBXMsg != NULL && pRBXMsg->bCancelled)
+			FreeRebroadcast(pRBXMsg);
+		else if (pRBXMsg != NULL)
 		{
 			struct timeval tNext, tRelevant = event.GetTimestamp() - m_tRebroadcastInterval;
 			std::map<PacketSequence, MessageHistory>::iterator iterMsgHistory = m_mapMsgHistory.find(pRBXMsg->msg.m_ID.srcID);
@@ -125,10 +125,11 @@ int GrooveCommModel::ProcessEvent(SimEvent & event)
 			if (pRBXMsg->msg.m_tTime + pRBXMsg->msg.m_tLifetime <= tNext)
 			{
 				m_mapMsgHistory.erase(iterMsgHistory); // don't need it in history anymore
-				delete pRBXMsg;
+				FreeRebroadcast(pRBXMsg);
 			}
 			else
 			{
+				pRBXMsg->tNext = tNext;
 				event.SetTimestamp(tNext);
 				g_pSimulator->m_EventQueue.AddEvent(event);
 			}
@@ -144,6 +145,18 @@ int GrooveCommModel::ProcessEvent(SimEvent & event)
 
 bool GrooveCommModel::DoUpdate(struct timeval tCurrent)
 {
+	std::map<PacketSequence, SquelchPacket>::iterator iterSquelch = m_mapSquelchMsgs.begin();
+	while (iterSquelch != m_mapSquelchMsgs.end())
+	{
+		if (iterSquelch->second.m_tTime + iterSquelch->second.m_tLifetime <= tCurrent)
+		{
+			// its cancelled rebroadcasts never got to drop the history
+			m_mapMsgHistory.erase(iterSquelch->first);
+			m_mapSquelchMsgs.erase(iterSquelch++);
+		}
+		else
+			++iterSquelch;
+	}
 	return CarCommModel::DoUpdate(tCurrent);
 }
 
@@ -165,16 +178,68 @@ void GrooveCommModel::AddMessageToRebroadcastQueue(const SafetyPacket & msg)
 		return;
 
 	// check to see if this a message that should be rebroadcast
+	if (m_mapSquelchMsgs.find(msg.m_ID.srcID) != m_mapSquelchMsgs.end())
+		return;
 
-	RebroadcastMessage * pRBXMsg = new RebroadcastMessage;
-	pRBXMsg->msg = msg;
-	pRBXMsg->tIntervalLow = msg.m_tRX;
+	RebroadcastMessage * pRBXMsg = AllocRebroadcast(msg);
 	tInterval = GetRbxInterval(msg, true);
 	pRBXMsg->tIntervalHigh = pRBXMsg->tIntervalLow + tInterval;
 	if (m_bJitter)
-		g_pSimulator->m_EventQueue.AddEvent(SimEvent(pRBXMsg->tIntervalLow + MakeTime(RandDouble(0., ToDouble(tInterval))), EVENT_PRIORITY_LOWEST, m_strModelName, m_strModelName, EVENT_CARCOMMMODEL_REBROADCAST, pRBXMsg, DestroyRebroadcastMessage));
+		ScheduleRebroadcast(pRBXMsg, pRBXMsg->tIntervalLow + MakeTime(RandDouble(0., ToDouble(tInterval))));
 	else
-		g_pSimulator->m_EventQueue.AddEvent(SimEvent(pRBXMsg->tIntervalLow + tInterval, EVENT_PRIORITY_LOWEST, m_strModelName, m_strModelName, EVENT_CARCOMMMODEL_REBROADCAST, pRBXMsg, DestroyRebroadcastMessage));
+		ScheduleRebroadcast(pRBXMsg, pRBXMsg->tIntervalLow + tInterval);
+}
+
+int GrooveCommModel::SaveState(CheckpointWriter & writer)
+{
+	std::map<PacketSequence, SquelchPacket>::iterator iterSquelch;
+
+	if (SimpleCommModel::SaveState(writer))
+		return 1;
+
+	if (writer.IsWarmStart())
+		return 0;
+	writer.WriteUInt(m_mapSquelchMsgs.size());
+	for (iterSquelch = m_mapSquelchMsgs.begin(); iterSquelch != m_mapSquelchMsgs.end(); ++iterSquelch)
+		writer.WritePacket(iterSquelch->second);
+	return 0;
+}
+
+int GrooveCommModel::LoadState(CheckpointReader & reader)
+{
+	SquelchPacket msg;
+	unsigned int i, numSquelches;
+
+	if (SimpleCommModel::LoadState(reader))
+		return 1;
+
+	if (reader.IsWarmStart())
+		return 0;
+	m_mapSquelchMsgs.clear();
+	if (!reader.ReadUInt(numSquelches))
+		return 2;
+	for (i = 0; i < numSquelches; i++)
+	{
+		if (!reader.ReadPacket(msg))
+			return 2;
+		m_mapSquelchMsgs[msg.m_ID.srcID] = msg;
+	}
+	return 0;
+}
+
+// a squelched message is neither rebroadcast again nor requeued when
+// another copy arrives, until the squelch expires
+void GrooveCommModel::ReceiveSquelch(const SquelchPacket & msg)
+{
+	if (msg.m_tTime + msg.m_tLifetime <= msg.m_tRX)
+		return;
+
+	std::map<PacketSequence, SquelchPacket>::iterator iterSquelch = m_mapSquelchMsgs.find(msg.m_ID.srcID);
+	if (iterSquelch == m_mapSquelchMsgs.end())
+		m_mapSquelchMsgs.insert(std::pair<PacketSequence, SquelchPacket>(msg.m_ID.srcID, msg));
+	else if (iterSquelch->second.m_tTime + iterSquelch->second.m_tLifetime < msg.m_tTime + msg.m_tLifetime)
+		iterSquelch->second = msg;
+	CancelRebroadcast(msg.m_ID.srcID);
 }
 
 bool GrooveCommModel::DoRebroadcast(const SafetyPacket & msg, struct timeval tRelevant) const
@@ -185,7 +250,6 @@ bool GrooveCommModel::DoRebroadcast(const SafetyPacket & msg, struct timeval tRe
 	std::map<in_addr_t, CarModel *>::iterator iterCar = pCarRegistry->find(m_ipCar);
 	std::map<in_addr_t, InfrastructureNodeModel *>::iterator iterNode = pNodeRegistry->find(m_ipCar);
 	bool bRebroadcast = true;
-	unsigned int i;
 
 	if (iterCar != pCarRegistry->end() && iterCar->second != NULL)
 	{
@@ -193,14 +257,8 @@ bool GrooveCommModel::DoRebroadcast(const SafetyPacket & msg, struct timeval tRe
 		if (iterMsgHistory != m_mapMsgHistory.end())
 		{
 			float fDistance = Distance(iterCar->second->GetCurrentPosition(), msg.m_ptPosition);
-			for (i = 0; i < iterMsgHistory->second.vecMessages.size(); i++)
-			{
-				if (iterMsgHistory->second.vecMessages[i].m_tRX >= tRelevant && Distance(iterMsgHistory->second.vecMessages[i].m_ptTXPosition, msg.m_ptPosition) > fDistance)
-				{
-					bRebroadcast = false;
-					break;
-				}
-			}
+			if (iterMsgHistory->second.histMessages.GetFarthestTX(tRelevant) > fDistance)
+				bRebroadcast = false;
 		}
 
 
@@ -210,14 +268,8 @@ bool GrooveCommModel::DoRebroadcast(const SafetyPacket & msg, struct timeval tRe
 			if (iterMsgHistory != m_mapMsgHistory.end())
 			{
 				float fDistance = Distance(iterCar->second->GetCurrentPosition(), msg.m_ptPosition);
-				for (i = 0; i < iterMsgHistory->second.vecMessages.size(); i++)
-				{
-					if (iterMsgHistory->second.vecMessages[i].m_tRX >= tRelevant && Distance(iterMsgHistory->second.vecMessages[i].m_ptTXPosition, msg.m_ptPosition) > fDistance)
-					{
-						bRebroadcast = false;
-						break;
-					}
-				}
+				if (iterMsgHistory->second.histMessages.GetFarthestTX(tRelevant) > fDistance)
+					bRebroadcast = false;
 			}
 		}
 */	}
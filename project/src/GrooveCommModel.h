@@ -51,10 +51,13 @@ public:
 	virtual int PreRun();
 	virtual int ProcessEvent(SimEvent & event);
 	virtual int Save(std::map<QString, QString> & mapParams);
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 
 	virtual bool DoUpdate(struct timeval tCurrent);
 
 	virtual void AddMessageToRebroadcastQueue(const SafetyPacket & msg);
+	virtual void ReceiveSquelch(const SquelchPacket & msg);
 	virtual struct timeval GetRbxInterval(const SafetyPacket & msg, bool bFirst) const;
 	virtual bool DoRebroadcast(const SafetyPacket & msg, struct timeval tRelevant) const;
 
@@ -62,6 +65,7 @@ public:
 
 protected:
 	struct timeval m_tFirstRbxJitter;
+	// squelches still in force, by the origin ID of the message they stop
 	std::map<PacketSequence, SquelchPacket> m_mapSquelchMsgs;
 	bool m_bFastRbx;
 };
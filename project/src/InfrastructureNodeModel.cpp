@@ -102,8 +102,7 @@ int InfrastructureNodeModel::Init(const std::map<QString, QString> & mapParams)
 	if (Model::Init(mapParams))
 		return 1;
 
-	strValue = GetParam(mapParams, INFRASTRUCTURENODEMODEL_PARAM_DELAY, INFRASTRUCTURENODEMODEL_PARAM_DELAY_DEFAULT);
-	m_tDelay = MakeTime(ValidateNumber(StringToNumber(strValue), 0., HUGE_VAL));
+	m_tDelay = MakeTime(ValidateNumber(GetNumberParam(mapParams, INFRASTRUCTURENODEMODEL_PARAM_DELAY, INFRASTRUCTURENODEMODEL_PARAM_DELAY_DEFAULT), 0., HUGE_VAL));
 
 	strValue = GetParam(mapParams, INFRASTRUCTURENODEMODEL_PARAM_NODEIP, INFRASTRUCTURENODEMODEL_PARAM_NODEIP_DEFAULT);
 	if (!StringToIPAddress(strValue, m_ipNode))
@@ -0,0 +1,107 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "LaneOccupancy.h"
+#include "VehicleStateTable.h"
+
+LaneOccupancy::LaneOccupancy()
+{
+}
+
+void LaneOccupancy::Insert(const LaneKey & key, const LanePosition & pos)
+{
+	m_mapLanes[key].insert(pos);
+}
+
+void LaneOccupancy::Erase(const LaneKey & key, const LanePosition & pos)
+{
+	std::map<LaneKey, LaneVehicles>::iterator iterLane = m_mapLanes.find(key);
+
+	if (iterLane != m_mapLanes.end())
+	{
+		iterLane->second.erase(pos);
+		// drop empty lanes, so the map only holds occupied ones
+		if (iterLane->second.empty())
+			m_mapLanes.erase(iterLane);
+	}
+}
+
+void LaneOccupancy::Clear()
+{
+	m_mapLanes.clear();
+}
+
+unsigned int LaneOccupancy::GetLeader(unsigned int iRecord, bool bForwards, unsigned int iLane, const LanePosition & pos) const
+{
+	// ahead is further along the record going forwards, and back towards
+	// its start going backwards
+	return GetNearest(iRecord, bForwards, iLane, pos, bForwards);
+}
+
+unsigned int LaneOccupancy::GetFollower(unsigned int iRecord, bool bForwards, unsigned int iLane, const LanePosition & pos) const
+{
+	return GetNearest(iRecord, bForwards, iLane, pos, !bForwards);
+}
+
+const LanePosition * LaneOccupancy::GetNext(const LaneVehicles & setVehicles, const LanePosition & pos, bool bAfter)
+{
+	LaneVehicles::const_iterator iterVehicle;
+
+	if (bAfter)
+	{
+		iterVehicle = setVehicles.upper_bound(pos);
+		return iterVehicle == setVehicles.end() ? NULL : &*iterVehicle;
+	}
+	else
+	{
+		iterVehicle = setVehicles.lower_bound(pos);
+		return iterVehicle == setVehicles.begin() ? NULL : &*(--iterVehicle);
+	}
+}
+
+unsigned int LaneOccupancy::GetNearest(unsigned int iRecord, bool bForwards, unsigned int iLane, const LanePosition & pos, bool bAfter) const
+{
+	std::map<LaneKey, LaneVehicles>::const_iterator iterLane, iterEnd;
+	const LanePosition * pNext, * pNearest = NULL;
+
+	if (iLane != LANEOCCUPANCY_ANY_LANE)
+	{
+		iterLane = m_mapLanes.find(LaneKey(iRecord, bForwards, (unsigned char)iLane));
+		if (iterLane == m_mapLanes.end())
+			return VEHICLESTATE_NONE;
+		pNearest = GetNext(iterLane->second, pos, bAfter);
+		return pNearest == NULL ? VEHICLESTATE_NONE : pNearest->iSlot;
+	}
+
+	// the lanes of one direction of a record are next to each other in the map
+	iterLane = m_mapLanes.lower_bound(LaneKey(iRecord, bForwards, 0));
+	iterEnd = m_mapLanes.upper_bound(LaneKey(iRecord, bForwards, (unsigned char)-1));
+	for (; iterLane != iterEnd; ++iterLane)
+	{
+		pNext = GetNext(iterLane->second, pos, bAfter);
+		if (pNext != NULL && (pNearest == NULL || (bAfter ? *pNext < *pNearest : *pNearest < *pNext)))
+			pNearest = pNext;
+	}
+	return pNearest == NULL ? VEHICLESTATE_NONE : pNearest->iSlot;
+}
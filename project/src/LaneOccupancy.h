@@ -0,0 +1,112 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/* LaneOccupancy.h -- which vehicles are in each lane of each record, in
+ * order along the record. The vehicle state table keeps it up to date as
+ * vehicles publish their state, moving an entry only when its record,
+ * direction, lane or position changes, so that the car-following and
+ * lane-changing models can find the nearest vehicle ahead or behind in
+ * a lane without scanning every vehicle on the record.
+ */
+
+#ifndef _LANEOCCUPANCY_H
+#define _LANEOCCUPANCY_H
+
+#include <map>
+#include <set>
+
+#define LANEOCCUPANCY_ANY_LANE ((unsigned)-1)
+
+// a position along a record, ordered by shape point and then progress; the
+// slot breaks ties between vehicles at the same position
+struct LanePosition
+{
+	unsigned short iShapePoint;
+	float fProgress;
+	unsigned int iSlot;
+
+	inline LanePosition(unsigned short iShapePointInit, float fProgressInit, unsigned int iSlotInit)
+	: iShapePoint(iShapePointInit), fProgress(fProgressInit), iSlot(iSlotInit)
+	{
+	}
+	inline bool operator < (const LanePosition & pos) const
+	{
+		if (iShapePoint != pos.iShapePoint)
+			return iShapePoint < pos.iShapePoint;
+		if (fProgress != pos.fProgress)
+			return fProgress < pos.fProgress;
+		return iSlot < pos.iSlot;
+	}
+};
+
+// one direction of one lane of a record
+struct LaneKey
+{
+	unsigned int iRecord;
+	bool bForwards;
+	unsigned char iLane;
+
+	inline LaneKey(unsigned int iRecordInit, bool bForwardsInit, unsigned char iLaneInit)
+	: iRecord(iRecordInit), bForwards(bForwardsInit), iLane(iLaneInit)
+	{
+	}
+	inline bool operator < (const LaneKey & key) const
+	{
+		if (iRecord != key.iRecord)
+			return iRecord < key.iRecord;
+		if (bForwards != key.bForwards)
+			return bForwards < key.bForwards;
+		return iLane < key.iLane;
+	}
+};
+
+class LaneOccupancy
+{
+public:
+	LaneOccupancy();
+
+	void Insert(const LaneKey & key, const LanePosition & pos);
+	void Erase(const LaneKey & key, const LanePosition & pos);
+	void Clear();
+
+	// the slot of the nearest vehicle ahead of (leader) or behind (follower)
+	// pos in the direction of travel, or VEHICLESTATE_NONE if there is none;
+	// iLane may be LANEOCCUPANCY_ANY_LANE to look across every lane
+	unsigned int GetLeader(unsigned int iRecord, bool bForwards, unsigned int iLane, const LanePosition & pos) const;
+	unsigned int GetFollower(unsigned int iRecord, bool bForwards, unsigned int iLane, const LanePosition & pos) const;
+
+protected:
+	typedef std::set<LanePosition> LaneVehicles;
+
+	// the next entry after (bAfter) or before pos in one lane, or NULL
+	static const LanePosition * GetNext(const LaneVehicles & setVehicles, const LanePosition & pos, bool bAfter);
+	unsigned int GetNearest(unsigned int iRecord, bool bForwards, unsigned int iLane, const LanePosition & pos, bool bAfter) const;
+
+	std::map<LaneKey, LaneVehicles> m_mapLanes;
+
+private:
+	inline LaneOccupancy(const LaneOccupancy & copy __attribute__ ((unused)) ) {}
+	inline LaneOccupancy & operator = (const LaneOccupancy & copy __attribute__ ((unused)) ) {return *this;}
+};
+
+#endif
@@ -173,8 +173,11 @@ void Logger::LogError(const QString & strTitle, const QString & strError, const
 		m_mutexLogDebug.unlock();
 	}
 
-	// display message box
-	QMessageBox::critical(NULL, strTitle, strError, bFatal ? QMessageBox::Abort : QMessageBox::Ok, QMessageBox::NoButton, QMessageBox::NoButton);
+	// display message box, unless running without a display (batch mode)
+	if (qApp != NULL && qApp->type() != QApplication::Tty)
+		QMessageBox::critical(NULL, strTitle, strError, bFatal ? QMessageBox::Abort : QMessageBox::Ok, QMessageBox::NoButton, QMessageBox::NoButton);
+	else
+		fprintf(stderr, "%s: %s\n", (const char *)strTitle, (const char *)strError);
 	// if fatal error, terminate application
 	if (bFatal)
 	{
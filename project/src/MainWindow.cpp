@@ -209,7 +209,7 @@ void MainWindow::OnFileOpen()
 {
 	QString strSimFile;
 
-	strSimFile = QFileDialog::getOpenFileName(QString::null, "Simulation Files (*.sim)", g_pMainWindow, "choose simulator dialog", "Open Simulation Configuration File...");
+	strSimFile = QFileDialog::getOpenFileName(QString::null, "Simulation Files (*.sim *.simb)", g_pMainWindow, "choose simulator dialog", "Open Simulation Configuration File...");
 	if (!strSimFile.isEmpty())
 	{
 		qApp->setOverrideCursor(QCursor(Qt::WaitCursor));
@@ -232,7 +232,7 @@ void MainWindow::OnFileSave()
 			return;
 	}
 
-	strSimFile = QFileDialog::getSaveFileName(QString::null, "Simulation Files (*.sim);;All Files (*)", g_pMainWindow, "write simulator dialog", "Save Simulation Configuration File...");
+	strSimFile = QFileDialog::getSaveFileName(QString::null, "Simulation Files (*.sim);;Binary Simulation Files (*.simb);;All Files (*)", g_pMainWindow, "write simulator dialog", "Save Simulation Configuration File...");
 	if (!strSimFile.isEmpty())
 	{
 		qApp->setOverrideCursor(QCursor(Qt::WaitCursor));
@@ -24,6 +24,7 @@
 
 #include "MapDB.h"
 #include "TIGERProcessor.h"
+#include "RecordTree.h"
 #include "Global.h"
 #include "Settings.h"
 #include "StringHelp.h"
@@ -33,6 +34,7 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <algorithm>
 #include <qfileinfo.h>
 #include <qdir.h>
 #include <qapplication.h>
@@ -44,6 +46,9 @@
 #define SQUARES_PER_COUNTY_SIDE 10.0
 #define SQUARES_PER_STATE_SIDE 40.0
 
+// records per block in the record # -> county table (log 2)
+#define RECORD_BLOCK_BITS 8
+
 #define TIGER_BASE_URL "http://www2.census.gov/geo/tiger/tiger2003/"
 #define COUNTIES_URL "http://www.census.gov/geo/tigerline/app_a03.txt"
 
@@ -576,31 +581,6 @@ bool IsVehicleGoingForwards(unsigned short iShapePoint, short iHeading, const Ma
 	return (sx*ax+sy*ay)/(sx*sx+sy*sy) >= 0.f;
 }
 
-float DistanceAlongRecord(const MapRecord * pRecord, unsigned short iStartShapePoint, float fStartProgress, unsigned short iEndShapePoint, float fEndProgress)
-{
-	unsigned short i;
-	float fDistance = 0.f;
-
-	// swap to ensure that start <= end
-	if (iStartShapePoint > iEndShapePoint || iStartShapePoint == iEndShapePoint && fStartProgress > fEndProgress)
-	{
-		unsigned short iTemp = iStartShapePoint;
-		float fTemp = fStartProgress;
-		iStartShapePoint = iEndShapePoint;
-		fStartProgress = fEndProgress;
-		iEndShapePoint = iTemp;
-		fEndProgress = fTemp;
-	}
-
-	for (i = iStartShapePoint; i < iEndShapePoint; i++)
-		fDistance += Distance(pRecord->pShapePoints[i], pRecord->pShapePoints[i+1]);
-	if (iEndShapePoint < pRecord->nShapePoints - 1)
-		fDistance += Distance(pRecord->pShapePoints[iEndShapePoint], pRecord->pShapePoints[iEndShapePoint+1]) * fEndProgress;
-	if (iStartShapePoint < pRecord->nShapePoints - 1)
-		fDistance -= Distance(pRecord->pShapePoints[iStartShapePoint], pRecord->pShapePoints[iStartShapePoint+1]) * fStartProgress;
-	return fDistance;
-}
-
 void InitMapDrawingSettings(MapDrawingSettings * pSettings)
 {
 	pSettings->rUpdate.setCoords(0, 0, -1, -1);
@@ -1253,7 +1233,7 @@ void DrawRotatedText(QPainter * dc, const QString & str, const QPoint & p, const
 	dc->setPen(oldPen);
 }
 
-void AddRecordToVertex(Vertex * pVertex, const MapRecord * pRecordSet, unsigned int iRecord, unsigned int iPreviousVertex)
+void AddRecordToVertex(TIGERVertex * pVertex, const MapRecord * pRecordSet, unsigned int iRecord, unsigned int iPreviousVertex)
 {
 	unsigned int i;
 	pVertex->mapEdges.insert(std::pair<unsigned int, unsigned>(iRecord, iPreviousVertex));
@@ -1270,14 +1250,91 @@ void AddRecordToVertex(Vertex * pVertex, const MapRecord * pRecordSet, unsigned
 	}
 }
 
-bool CanCarGoThrough(const Vertex & vertex, unsigned int iRecord)
+unsigned int GetPermittedRoad(const Vertex & vertex, const struct timeval & tCurrent)
+{
+	double fElapsed;
+
+	if (vertex.fSignalPhase <= 0.f || vertex.vecRoads.size() < 2 || tCurrent < g_pMapDB->GetTrafficLightsStart())
+		return 0;
+
+	// the light changes at the offset and once every phase after that
+	fElapsed = ToDouble(tCurrent - g_pMapDB->GetTrafficLightsStart()) - vertex.fSignalOffset;
+	if (fElapsed < 0.)
+		return 0;
+	return (unsigned int)fmod(floor(fElapsed / vertex.fSignalPhase) + 1., (double)vertex.vecRoads.size());
+}
+
+bool CanCarGoThrough(const Vertex & vertex, unsigned int iRecord, const struct timeval & tCurrent)
+{
+	return IsSameRoad(g_pMapDB->GetRecord(iRecord), g_pMapDB->GetRecord(vertex.vecRoads[GetPermittedRoad(vertex, tCurrent)]));
+}
+
+CoordsIndex::CoordsIndex(const std::vector<Coords> * pCoords)
+: m_pCoords(pCoords), m_iMask(0), m_nEntries(0)
+{
+}
+
+void CoordsIndex::Clear()
+{
+	std::vector<unsigned int>().swap(m_vecSlots);
+	m_iMask = 0;
+	m_nEntries = 0;
+}
+
+void CoordsIndex::Reserve(unsigned int nEntries)
+{
+	unsigned int nSlots = 16;
+
+	// keep the table at most half full
+	while (nSlots < 2 * nEntries)
+		nSlots <<= 1;
+	if (nSlots > m_vecSlots.size())
+		Rehash(nSlots);
+}
+
+unsigned int CoordsIndex::Find(const Coords & pt) const
+{
+	unsigned int iSlot, iVertex;
+
+	if (m_vecSlots.empty())
+		return (unsigned)-1;
+	for (iSlot = Hash(pt) & m_iMask; (iVertex = m_vecSlots[iSlot]) != (unsigned)-1; iSlot = (iSlot + 1) & m_iMask)
+	{
+		if ((*m_pCoords)[iVertex] == pt)
+			return iVertex;
+	}
+	return (unsigned)-1;
+}
+
+void CoordsIndex::Insert(unsigned int iVertex)
+{
+	unsigned int iSlot;
+
+	Reserve(m_nEntries + 1);
+	for (iSlot = Hash((*m_pCoords)[iVertex]) & m_iMask; m_vecSlots[iSlot] != (unsigned)-1; iSlot = (iSlot + 1) & m_iMask);
+	m_vecSlots[iSlot] = iVertex;
+	m_nEntries++;
+}
+
+void CoordsIndex::Rehash(unsigned int nSlots)
 {
-	return IsSameRoad(g_pMapDB->GetRecord(iRecord), g_pMapDB->GetRecord(vertex.vecRoads[vertex.iRoadPermitted]));
+	std::vector<unsigned int> vecOldSlots(nSlots, (unsigned)-1);
+	unsigned int i, iSlot;
+
+	m_vecSlots.swap(vecOldSlots);
+	m_iMask = nSlots - 1;
+	for (i = 0; i < vecOldSlots.size(); i++)
+	{
+		if (vecOldSlots[i] == (unsigned)-1)
+			continue;
+		for (iSlot = Hash((*m_pCoords)[vecOldSlots[i]]) & m_iMask; m_vecSlots[iSlot] != (unsigned)-1; iSlot = (iSlot + 1) & m_iMask);
+		m_vecSlots[iSlot] = vecOldSlots[i];
+	}
 }
 
 
 MapDB::MapDB()
-: m_pRecords(NULL), m_nRecords(0), m_bTrafficLights(false)
+: m_pRecords(NULL), m_nRecords(0), m_bTrafficLights(false), m_tTrafficLightsStart(timeval0), m_indexCoordinateToVertex(&m_vecVertexCoords)
 {
 	m_tLastChange = GetCurrentTime();
 }
@@ -1290,6 +1347,7 @@ MapDB::~MapDB()
 void MapDB::Clear()
 {
 	unsigned int iRec;
+	std::map<unsigned short, RecordTree *>::iterator iterTree;
 
 	m_Mutex.lock();
 	for (iRec = 0; iRec < m_nRecords; iRec++)
@@ -1309,7 +1367,14 @@ void MapDB::Clear()
 	m_vecStringRoads.clear();
 	m_vecStrings.clear();
 	m_vecRoute.clear();
-	m_mapCoordinateToVertex.clear();
+	m_indexCoordinateToVertex.Clear();
+	m_vecVertexCoords.clear();
+	m_vecVertexEdgeOffsets.clear();
+	m_vecVertexEdges.clear();
+	m_vecRecordGeometryOffsets.clear();
+	m_vecShapePointDistances.clear();
+	m_vecSegmentLengths.clear();
+	m_vecSegmentHeadings.clear();
 	m_mapTLIDtoRecord.clear();
 	m_mapPolyIDtoRecord.clear();
 	m_mapPolyIDtoSide.clear();
@@ -1317,19 +1382,43 @@ void MapDB::Clear()
 	m_mapAdditionalNameIDtoRecords.clear();
 	m_mapStringsToIndex.clear();
 	m_mapCountyCodeToRecords.clear();
+	m_vecLoadedCountyCodes.clear();
+	m_vecLoadedCountyRecords.clear();
+	m_vecRecordBlockCounty.clear();
+	m_vecCountyCodeToLoaded.clear();
 	m_mapCountyCodeToBoundingRect.clear();
 	m_mapCountyCodeToRegions.clear();
+	for (iterTree = m_mapCountyCodeToRecordTree.begin(); iterTree != m_mapCountyCodeToRecordTree.end(); ++iterTree)
+		delete iterTree->second;
+	m_mapCountyCodeToRecordTree.clear();
 	m_vecVerticesHeapLookup.clear();
 
 	m_Mutex.unlock();
 }
 
+void MapDB::SetTrafficLights(const struct timeval & tStart, const struct timeval & tPhase, unsigned int iGroups)
+{
+	unsigned int i;
+	float fPhase = ToFloat(tPhase);
+
+	m_tTrafficLightsStart = tStart;
+	for (i = 0; i < m_vecVertices.size(); i++)
+	{
+		m_vecVertices[i].fSignalOffset = fPhase * (i % iGroups) / iGroups;
+		m_vecVertices[i].fSignalPhase = fPhase;
+	}
+}
+
 void MapDB::ResetTrafficLights()
 {
 	unsigned int i;
 
+	m_tTrafficLightsStart = timeval0;
 	for (i = 0; i < m_vecVertices.size(); i++)
-		m_vecVertices[i].iRoadPermitted = 0;
+	{
+		m_vecVertices[i].fSignalOffset = 0.f;
+		m_vecVertices[i].fSignalPhase = 0.f;
+	}
 }
 
 void MapDB::GetStreetsByName(const QString & strStreetName, const QString & strStreetType, std::set<unsigned int> & setMatching)
@@ -1391,13 +1480,13 @@ bool MapDB::IsVertex(unsigned int iVertex, const std::set<StreetNameAndType> & s
 	std::set<StreetNameAndType> setFound;
 	std::set<StreetNameAndType>::iterator iterStreet;
 	StreetNameAndType pairNameAndType;
-	std::map<unsigned int, unsigned int>::iterator iterSeg;
+	const VertexEdge * pEdge, * pEdgesEnd;
 	unsigned int i;
 
-	for (iterSeg = m_vecVertices[iVertex].mapEdges.begin(); iterSeg != m_vecVertices[iVertex].mapEdges.end(); ++iterSeg)
+	for (pEdge = GetVertexEdgesBegin(iVertex), pEdgesEnd = GetVertexEdgesEnd(iVertex); pEdge != pEdgesEnd; ++pEdge)
 	{
 		iterStreet = setStreets.end();
-		MapRecord * pRecord = m_pRecords + iterSeg->first;
+		MapRecord * pRecord = m_pRecords + pEdge->iRecord;
 		if (!IsRoad(pRecord) || pRecord->nFeatureNames == 0)
 			continue;
 
@@ -1421,7 +1510,7 @@ bool MapDB::IsVertex(unsigned int iVertex, const std::set<StreetNameAndType> & s
 
 bool MapDB::GetVertex(unsigned int iVertex, Address * pAddress)
 {
-	std::map<unsigned int, unsigned int>::iterator iterSeg;
+	const VertexEdge * pEdge, * pEdgesEnd;
 	QString strName, strRoadName;
 	Coords ptCenter;
 	std::set<QString> setRoadNames;
@@ -1431,14 +1520,14 @@ bool MapDB::GetVertex(unsigned int iVertex, Address * pAddress)
 	pAddress->iStreetNumber = 0;
 	pAddress->szStreetType = "";
 
-	for (iterSeg = m_vecVertices[iVertex].mapEdges.begin(); iterSeg != m_vecVertices[iVertex].mapEdges.end(); ++iterSeg)
+	for (pEdge = GetVertexEdgesBegin(iVertex), pEdgesEnd = GetVertexEdgesEnd(iVertex); pEdge != pEdgesEnd; ++pEdge)
 	{
-		if (IsRoad(m_pRecords + iterSeg->first))
+		if (IsRoad(m_pRecords + pEdge->iRecord))
 		{
 			if (pAddress->iRecord == (unsigned)-1)
-				pAddress->iRecord = iterSeg->first;
+				pAddress->iRecord = pEdge->iRecord;
 
-			strRoadName = GetNameAndType(iterSeg->first);
+			strRoadName = GetNameAndType(pEdge->iRecord);
 			if (!strRoadName.isEmpty() && setRoadNames.insert(strRoadName).second)
 			{
 				if (strName.isEmpty())
@@ -1668,25 +1757,62 @@ void MapDB::DrawRecordHighlights(MapDrawingSettings * pSettings, const std::set<
 	}
 }
 
+static bool VertexEdgeLess(const std::pair<unsigned int, VertexEdge> & edge1, const std::pair<unsigned int, VertexEdge> & edge2)
+{
+	return edge1.first < edge2.first || (edge1.first == edge2.first && edge1.second.iRecord < edge2.second.iRecord);
+}
+
+// adds the (vertex, edge) pairs read from a map file to the adjacency array
+// a vertex keeps only the first edge for a given record, and the records of a
+// newly loaded county are numbered after all existing records, so each
+// vertex's new edges simply go after its existing ones
+void MapDB::AddVertexEdges(std::vector<std::pair<unsigned int, VertexEdge> > & vecEdges)
+{
+	std::vector<unsigned int> vecOffsets(m_vecVertices.size() + 1, 0);
+	std::vector<VertexEdge> vecAllEdges;
+	unsigned int i, iVertex, nOldVertices = m_vecVertexEdgeOffsets.empty() ? 0 : m_vecVertexEdgeOffsets.size() - 1;
+	std::vector<std::pair<unsigned int, VertexEdge> >::iterator iterEdge, iterEdgesEnd;
+
+	std::stable_sort(vecEdges.begin(), vecEdges.end(), VertexEdgeLess);
+	iterEdge = vecEdges.begin();
+	iterEdgesEnd = vecEdges.end();
+	vecAllEdges.reserve(m_vecVertexEdges.size() + vecEdges.size());
+	for (iVertex = 0; iVertex < m_vecVertices.size(); iVertex++)
+	{
+		vecOffsets[iVertex] = vecAllEdges.size();
+		if (iVertex < nOldVertices)
+			vecAllEdges.insert(vecAllEdges.end(), m_vecVertexEdges.begin() + m_vecVertexEdgeOffsets[iVertex], m_vecVertexEdges.begin() + m_vecVertexEdgeOffsets[iVertex + 1]);
+		for (i = vecAllEdges.size(); iterEdge != iterEdgesEnd && iterEdge->first == iVertex; ++iterEdge)
+		{
+			if (vecAllEdges.size() == i || vecAllEdges.back().iRecord != iterEdge->second.iRecord)
+				vecAllEdges.push_back(iterEdge->second);
+		}
+	}
+	vecOffsets[m_vecVertices.size()] = vecAllEdges.size();
+
+	m_vecVertexEdgeOffsets.swap(vecOffsets);
+	m_vecVertexEdges.swap(vecAllEdges);
+}
+
 bool MapDB::LoadMap(const QString & strBaseName)
 {
 	printf("Loading Map in MapDB\r\n");
 	std::vector<unsigned int> vecStrings; // maps string codes to record set string codes
 	std::vector<unsigned int> vecVertices; // maps file vertex codes to record set vertex codes
-	std::vector<Vertex> vertexInfo; // for each vertex index, stores a list of edges (records)...
+	std::vector<std::pair<unsigned int, VertexEdge> > vecEdges; // (file vertex code, edge) for each edge read
+	std::pair<unsigned int, VertexEdge> edge;
 	std::map<unsigned short, CountySquares>::iterator iterSquares;
 	std::map<unsigned short, Rect>::iterator iterBoundary;
 	std::map<unsigned short, WaterPolygons>::iterator polys;
 	MapRecord * newRecordBuffer = NULL;
+	RecordTree * pRecordTree;
 	unsigned char * buffer, * startBuffer;
 	unsigned short countyCode;
 	Rect boundingRect;
 	Coords vertexCoords;
-	unsigned int i, j, numStrings, numVertices, neighborVertex, neighborRecord, numRecords, vertexMapIndex, numPolys, numPoints;
+	unsigned int i, j, numStrings, numVertices, numRecords, numPolys, numPoints;
 	unsigned char recordType;
 	unsigned short numNeighbors;
-	std::map<Coords, unsigned int>::iterator vertexCoordsIter;
-	std::map<unsigned int, unsigned int>::iterator vertexNeighborIter;
 	char szString[256]; // no string longer than this...
 	bool bSuccess = false;
 	struct stat fileInfo;
@@ -1730,46 +1856,48 @@ bool MapDB::LoadMap(const QString & strBaseName)
 	memcpy(&numVertices, buffer, sizeof(unsigned int));
 	buffer += sizeof(unsigned int);
 	vecVertices.resize(numVertices);
-	vertexInfo.resize(numVertices);
 	m_vecVertices.reserve(m_vecVertices.size() + vecVertices.size());
+	m_vecVertexCoords.reserve(m_vecVertexCoords.size() + vecVertices.size());
+	m_indexCoordinateToVertex.Reserve(m_indexCoordinateToVertex.GetCount() + numVertices);
 	for (i = 0; i < numVertices; i++) {
 		memcpy(&vertexCoords.m_iLong, buffer, sizeof(long));
 		memcpy(&vertexCoords.m_iLat, (buffer += sizeof(long)), sizeof(long));
-		vertexCoordsIter = m_mapCoordinateToVertex.find(vertexCoords);
-		if (vertexCoordsIter == m_mapCoordinateToVertex.end()) {
-			vertexCoordsIter = m_mapCoordinateToVertex.insert(std::pair<Coords, unsigned int>(vertexCoords, m_vecVertices.size())).first;
+		if ((vecVertices[i] = m_indexCoordinateToVertex.Find(vertexCoords)) == (unsigned)-1) {
+			vecVertices[i] = m_vecVertices.size();
 			m_vecVertices.push_back(Vertex());
-			m_vecVertices.back().iRoadPermitted = 0;
+			m_vecVertices.back().fSignalOffset = 0.f;
+			m_vecVertices.back().fSignalPhase = 0.f;
+			m_vecVertexCoords.push_back(vertexCoords);
+			m_indexCoordinateToVertex.Insert(vecVertices[i]);
 		}
-		vecVertices[i] = vertexCoordsIter->second;
 		memcpy(&numNeighbors, buffer += sizeof(long), sizeof(unsigned short));
 		buffer += sizeof(unsigned short);
+		edge.first = i;
 		for (j = 0; j < numNeighbors; j++)
 		{
-			memcpy(&neighborVertex, buffer, sizeof(unsigned int));
-			memcpy(&neighborRecord, (buffer += sizeof(unsigned int)), sizeof(unsigned int));
+			memcpy(&edge.second.iVertex, buffer, sizeof(unsigned int));
+			memcpy(&edge.second.iRecord, (buffer += sizeof(unsigned int)), sizeof(unsigned int));
 			buffer += sizeof(unsigned int);
-			neighborRecord += m_nRecords;
-			vertexInfo[i].mapEdges.insert(std::pair<unsigned int, unsigned int>(neighborRecord, neighborVertex));
+			edge.second.iRecord += m_nRecords;
+			vecEdges.push_back(edge);
 		}
 		memcpy(&numNeighbors, buffer, sizeof(unsigned short));
 		buffer += sizeof(unsigned short);
-		vertexInfo[i].vecRoads.resize(numNeighbors);
-		for (j = 0; j < numNeighbors; j++)
+		Vertex & vertex = m_vecVertices[vecVertices[i]];
+		vertex.vecRoads.resize(vertex.vecRoads.size() + numNeighbors);
+		for (j = vertex.vecRoads.size() - numNeighbors; j < vertex.vecRoads.size(); j++)
 		{
-			memcpy(&vertexInfo[i].vecRoads[j], buffer, sizeof(unsigned int));
-			vertexInfo[i].vecRoads[j] += m_nRecords;
+			memcpy(&vertex.vecRoads[j], buffer, sizeof(unsigned int));
+			vertex.vecRoads[j] += m_nRecords;
 			buffer += sizeof(unsigned int);
 		}
 	}
 	// postprocessing step... (realign vertex indexes within record set)
-	for (i = 0; i < numVertices; i++) {
-		for (vertexNeighborIter = vertexInfo[i].mapEdges.begin(); vertexNeighborIter != vertexInfo[i].mapEdges.end(); ++vertexNeighborIter) {
-			vertexMapIndex = vecVertices[vertexNeighborIter->second];
-			m_vecVertices[vecVertices[i]].mapEdges.insert(std::pair<unsigned int, unsigned int>(vertexNeighborIter->first, vertexMapIndex));
-		}
-		m_vecVertices[vecVertices[i]].vecRoads.insert(m_vecVertices[vecVertices[i]].vecRoads.end(), vertexInfo[i].vecRoads.begin(), vertexInfo[i].vecRoads.end());
+	for (i = 0; i < vecEdges.size(); i++) {
+		vecEdges[i].first = vecVertices[vecEdges[i].first];
+		vecEdges[i].second.iVertex = vecVertices[vecEdges[i].second.iVertex];
 	}
+	AddVertexEdges(vecEdges);
 
 	// read records
 	memcpy(&numRecords, buffer, sizeof(unsigned int));
@@ -1857,8 +1985,13 @@ bool MapDB::LoadMap(const QString & strBaseName)
 		}
 	}
 	m_mapCountyCodeToRecords.insert(std::pair<unsigned short, std::pair<unsigned int, unsigned int> >(countyCode, std::pair<unsigned int, unsigned int>(m_nRecords, m_nRecords + numRecords)));
+	AddCountyRecords(countyCode, m_nRecords, m_nRecords + numRecords);
+	AddRecordGeometry(m_nRecords, m_nRecords + numRecords);
 	iterSquares = m_mapCountyCodeToRegions.insert(std::pair<unsigned short, std::vector<std::vector<unsigned int> > >(countyCode, std::vector<std::vector<unsigned int> >(SQUARES_PER_COUNTY))).first;
 	AddRecordsToRegionSquares(m_nRecords, m_nRecords + numRecords, &iterSquares->second, iterBoundary->second);
+	pRecordTree = new RecordTree();
+	pRecordTree->Build(m_pRecords, m_nRecords, m_nRecords + numRecords);
+	m_mapCountyCodeToRecordTree.insert(std::pair<unsigned short, RecordTree *>(countyCode, pRecordTree));
 	m_nRecords += numRecords;
 	qApp->processEvents();
 	bSuccess = true;
@@ -1891,7 +2024,7 @@ bool MapDB::FindAddress(Address * pAddress, int iSearchNumber, const QString & s
 	{
 		vecToString[iterString->second] = iterString->first;
 	}
-	std::map<unsigned int, unsigned int>::iterator edgeItr;
+	const VertexEdge * pEdge, * pEdgesEnd;
 	if (!strSearchStreet.isEmpty() && (iterStringID = m_mapStringsToIndex.find(strSearchStreet)) != m_mapStringsToIndex.end())
 		iStreetName = iterStringID->second;
 
@@ -1942,9 +2075,9 @@ bool MapDB::FindAddress(Address * pAddress, int iSearchNumber, const QString & s
 				int houseNumber = iSearchNumber % 100;
 				for(int iVerCnt = 0; iVerCnt < pRec->nVertices; iVerCnt++)
 				{
-					for(edgeItr = m_vecVertices[pRec->pVertices[iVerCnt]].mapEdges.begin(); edgeItr != m_vecVertices[pRec->pVertices[iVerCnt]].mapEdges.end(); ++edgeItr)
+					for (pEdge = GetVertexEdgesBegin(pRec->pVertices[iVerCnt]), pEdgesEnd = GetVertexEdgesEnd(pRec->pVertices[iVerCnt]); pEdge != pEdgesEnd; ++pEdge)
 					{
-// 						if(vecToString[GetRecord(edgeItr->first)->pFeatureNames[0]].toInt() == streetNumber);
+// 						if(vecToString[GetRecord(pEdge->iRecord)->pFeatureNames[0]].toInt() == streetNumber);
 					}
 				}
 				
@@ -2341,36 +2474,21 @@ bool MapDB::GetRandomAddress(Address * pAddress, const Rect & rRect)
 
 bool MapDB::GetRecordsInRegion(std::vector<unsigned int> & vecRecords, const Rect & rRect)
 {
-	std::map<unsigned short, CountySquares>::iterator iterCountySquares;
-	std::map<unsigned short, Rect>::iterator iterCountyRect;
-	unsigned int x1, x2, y1, y2, i, j, k;
+	std::map<unsigned short, RecordTree *>::iterator iterCountyTree;
+	std::vector<unsigned int> vecCandidates;
+	unsigned int i;
 	MapRecord * pRecord;
 
 	// construct a list of records in the rectangle
-	for (iterCountySquares = m_mapCountyCodeToRegions.begin(); iterCountySquares != m_mapCountyCodeToRegions.end(); ++iterCountySquares)
+	for (iterCountyTree = m_mapCountyCodeToRecordTree.begin(); iterCountyTree != m_mapCountyCodeToRecordTree.end(); ++iterCountyTree)
 	{
-		// first, see if we are really in this county
-		iterCountyRect = m_mapCountyCodeToBoundingRect.find(iterCountySquares->first);
-		if (iterCountyRect == m_mapCountyCodeToBoundingRect.end() || !iterCountyRect->second.intersectRect(rRect))
-			continue;
-
-		x1 = (unsigned int)ValidateNumber(floor((SQUARES_PER_COUNTY_SIDE * (rRect.m_iLeft - iterCountyRect->second.m_iLeft)) / (iterCountyRect->second.m_iRight - iterCountyRect->second.m_iLeft)), 0, SQUARES_PER_COUNTY_SIDE - 1);
-		y1 = (unsigned int)ValidateNumber(floor((SQUARES_PER_COUNTY_SIDE * (iterCountyRect->second.m_iTop - rRect.m_iTop)) / (iterCountyRect->second.m_iTop - iterCountyRect->second.m_iBottom)), 0, SQUARES_PER_COUNTY_SIDE - 1);
-		x2 = (unsigned int)ValidateNumber(ceil((SQUARES_PER_COUNTY_SIDE * (rRect.m_iRight - iterCountyRect->second.m_iLeft)) / (iterCountyRect->second.m_iRight - iterCountyRect->second.m_iLeft)), 0, SQUARES_PER_COUNTY_SIDE - 1);
-		y2 = (unsigned int)ValidateNumber(ceil((SQUARES_PER_COUNTY_SIDE * (iterCountyRect->second.m_iTop - rRect.m_iBottom)) / (iterCountyRect->second.m_iTop - iterCountyRect->second.m_iBottom)), 0, SQUARES_PER_COUNTY_SIDE - 1);
-
-		for (i = y1; i <= y2; i++)
+		vecCandidates.clear();
+		iterCountyTree->second->Search(rRect, vecCandidates);
+		for (i = 0; i < vecCandidates.size(); i++)
 		{
-			for (j = x1; j <= x2; j++)
-			{
-				CountySquare & regionRecords = iterCountySquares->second[(int)(j+i*SQUARES_PER_COUNTY_SIDE)];
-				for (k = 0; k < regionRecords.size(); k++)
-				{
-					pRecord = GetRecord(regionRecords[k]);
-					if (IsRoad(pRecord) && pRecord->nShapePoints >= 2 && pRecord->nFeatureNames > 0 && !m_vecStrings[pRecord->pFeatureNames[0]].isEmpty() && !m_vecStrings[pRecord->pFeatureTypes[0]].isEmpty() && pRecord->nAddressRanges > 0 && rRect.intersectRect(pRecord->rBounds) && IsRecordVisible(pRecord->pShapePoints, pRecord->nShapePoints, Coords(rRect.m_iLeft, rRect.m_iTop), Coords(rRect.m_iRight, rRect.m_iBottom)))
-						vecRecords.push_back(regionRecords[k]);
-				}
-			}
+			pRecord = GetRecord(vecCandidates[i]);
+			if (IsRoad(pRecord) && pRecord->nFeatureNames > 0 && !m_vecStrings[pRecord->pFeatureNames[0]].isEmpty() && !m_vecStrings[pRecord->pFeatureTypes[0]].isEmpty() && pRecord->nAddressRanges > 0 && IsRecordVisible(pRecord->pShapePoints, pRecord->nShapePoints, Coords(rRect.m_iLeft, rRect.m_iTop), Coords(rRect.m_iRight, rRect.m_iBottom)))
+				vecRecords.push_back(vecCandidates[i]);
 		}
 	}
 	return !vecRecords.empty();
@@ -2379,9 +2497,8 @@ bool MapDB::GetRecordsInRegion(std::vector<unsigned int> & vecRecords, const Rec
 bool MapDB::AddressFromRecord(Address * pAddress, unsigned int iRecord, unsigned int iShapePoint, float fProgress)
 {
 	MapRecord * pRecord = GetRecord(iRecord);
-	float fRecordDistance = RecordDistance(pRecord);
-	float fFractionDistance = 0.;
-	int i, iPoint = (signed)iShapePoint, iStart, iEnd, iStep;
+	float fRecordDistance = GetRecordLength(iRecord);
+	int iPoint = (signed)iShapePoint, iStart, iEnd, iStep;
 
 	pAddress->iRecord = iRecord;
 	pAddress->iVertex = (unsigned)-1;
@@ -2406,12 +2523,9 @@ bool MapDB::AddressFromRecord(Address * pAddress, unsigned int iRecord, unsigned
 			iPoint = pRecord->nShapePoints - 2;
 			fProgress = 1.f;
 		}
-		for (i = 0; i < iPoint; i++)
-			fFractionDistance += Distance(pRecord->pShapePoints[i], pRecord->pShapePoints[i+1]);
 		if (iPoint >= 0) {
-			fFractionDistance += fProgress * Distance(pRecord->pShapePoints[iPoint], pRecord->pShapePoints[iPoint+1]);
 			pAddress->ptCoordinates = pRecord->pShapePoints[iPoint] * (1 - fProgress) + pRecord->pShapePoints[iPoint+1] * fProgress;
-			fProgress = fFractionDistance / fRecordDistance;
+			fProgress = DistanceAlongRecord(iRecord, iPoint, fProgress) / fRecordDistance;
 			iStart = pRecord->pAddressRanges[0].iFromAddr;
 			iEnd = pRecord->pAddressRanges[0].iToAddr;
 			iStep = (iStart % 2 == iEnd % 2) ? 2 : 1;
@@ -2444,7 +2558,7 @@ std::list<unsigned int> MapDB::ShortestPath(Address * pStart, Address * pEnd, bo
 	std::list<unsigned int> rPath1, rPath2, rPath;
 	FibonacciHeap<double, DijkstraVertex> heap;
 	FibonacciHeapNode<double, DijkstraVertex> * minNode;
-	std::map<unsigned int, unsigned int>::iterator iterAdj;
+	const VertexEdge * pAdj, * pAdjEnd;
 	std::list<FibonacciHeapNode<double, DijkstraVertex> *> visitedNodes;
 	std::list<FibonacciHeapNode<double, DijkstraVertex> *>::iterator iterVisitedNode;
 	DijkstraVertex v;
@@ -2515,12 +2629,12 @@ std::list<unsigned int> MapDB::ShortestPath(Address * pStart, Address * pEnd, bo
 		if (minNode->m_Data.vertex == endVertex2) bFoundEnd2 = true;
 		if (bFoundEnd1 && bFoundEnd2) break; // we've found our route(s) - stop searching
 		// update adjacent vertices
-		for (iterAdj = m_vecVertices[minNode->m_Data.vertex].mapEdges.begin(); iterAdj != m_vecVertices[minNode->m_Data.vertex].mapEdges.end(); ++iterAdj) {
-			newDistance = m_pRecords[iterAdj->first].fCost + minNode->getKey();
-			if (newDistance < m_vecVerticesHeapLookup[iterAdj->second]->getKey()) { // key will decrease - update
-				heap.DecreaseKey(m_vecVerticesHeapLookup[iterAdj->second], newDistance);
-				m_vecVerticesHeapLookup[iterAdj->second]->m_Data.predecessor = minNode->m_Data.vertex; // the vertex previous to this one
-				m_vecVerticesHeapLookup[iterAdj->second]->m_Data.record = iterAdj->first; // record to take from previous vertex to this one
+		for (pAdj = GetVertexEdgesBegin(minNode->m_Data.vertex), pAdjEnd = GetVertexEdgesEnd(minNode->m_Data.vertex); pAdj != pAdjEnd; ++pAdj) {
+			newDistance = m_pRecords[pAdj->iRecord].fCost + minNode->getKey();
+			if (newDistance < m_vecVerticesHeapLookup[pAdj->iVertex]->getKey()) { // key will decrease - update
+				heap.DecreaseKey(m_vecVerticesHeapLookup[pAdj->iVertex], newDistance);
+				m_vecVerticesHeapLookup[pAdj->iVertex]->m_Data.predecessor = minNode->m_Data.vertex; // the vertex previous to this one
+				m_vecVerticesHeapLookup[pAdj->iVertex]->m_Data.record = pAdj->iRecord; // record to take from previous vertex to this one
 			}
 		}
 	}
@@ -2643,11 +2757,10 @@ std::list<unsigned int> MapDB::ShortestPath(unsigned int iStartVertex, unsigned
 	std::list<unsigned int> rPath1, rPath2, rPath;
 	FibonacciHeap<double, DijkstraVertex> heap;
 	FibonacciHeapNode<double, DijkstraVertex> * minNode;
-	std::map<unsigned int, unsigned int>::iterator iterAdj;
+	const VertexEdge * pAdj, * pAdjEnd;
 	std::list<FibonacciHeapNode<double, DijkstraVertex> *> visitedNodes;
 	std::list<FibonacciHeapNode<double, DijkstraVertex> *>::iterator iterVisitedNode;
 	DijkstraVertex v;
-	unsigned short i;
 
 	// initialize heap
 	v.predecessor = (unsigned)-1;
@@ -2664,15 +2777,7 @@ std::list<unsigned int> MapDB::ShortestPath(unsigned int iStartVertex, unsigned
 		startVertex1 = pStartRec->pVertices[0];
 		startVertex2 = pStartRec->pVertices[pStartRec->nVertices-1];
 
-		double fTotalDistance = RecordDistance(pStartRec), fFracDistance = 0.;
-		if (iStartShapePoint == pStartRec->nShapePoints - 1)
-		{
-			iStartShapePoint--;
-			fStartProgress = 1.f;
-		}
-		for (i = 0; i < iStartShapePoint; i++)
-			fFracDistance += Distance(pStartRec->pShapePoints[i], pStartRec->pShapePoints[i+1]);
-		fFracDistance += Distance(pStartRec->pShapePoints[iStartShapePoint], pStartRec->pShapePoints[iStartShapePoint+1]) * fStartProgress;
+		double fTotalDistance = GetRecordLength(iStartRecord), fFracDistance = DistanceAlongRecord(iStartRecord, iStartShapePoint, fStartProgress);
 		startDistance = pStartRec->fCost * (fFracDistance / fTotalDistance);
 
 		if (startDistance == 0.0 || !IsOneWay(pStartRec))
@@ -2690,15 +2795,7 @@ std::list<unsigned int> MapDB::ShortestPath(unsigned int iStartVertex, unsigned
 		endVertex1 = pEndRec->pVertices[0];
 		endVertex2 = pEndRec->pVertices[pEndRec->nVertices-1];
 
-		double fTotalDistance = RecordDistance(pEndRec), fFracDistance = 0.;
-		if (iEndShapePoint == pEndRec->nShapePoints - 1)
-		{
-			iEndShapePoint--;
-			fEndProgress = 1.f;
-		}
-		for (i = 0; i < iEndShapePoint; i++)
-			fFracDistance += Distance(pEndRec->pShapePoints[i], pEndRec->pShapePoints[i+1]);
-		fFracDistance += Distance(pEndRec->pShapePoints[iEndShapePoint], pEndRec->pShapePoints[iEndShapePoint+1]) * fEndProgress;
+		double fTotalDistance = GetRecordLength(iEndRecord), fFracDistance = DistanceAlongRecord(iEndRecord, iEndShapePoint, fEndProgress);
 		endDistance = pEndRec->fCost * (fFracDistance / fTotalDistance);
 		bNeedEnd2 = !IsOneWay(pEndRec);
 	}
@@ -2713,12 +2810,12 @@ std::list<unsigned int> MapDB::ShortestPath(unsigned int iStartVertex, unsigned
 		if (minNode->m_Data.vertex == endVertex2) bFoundEnd2 = true;
 		if (bFoundEnd1 && bFoundEnd2) break; // we've found our route(s) - stop searching
 		// update adjacent vertices
-		for (iterAdj = m_vecVertices[minNode->m_Data.vertex].mapEdges.begin(); iterAdj != m_vecVertices[minNode->m_Data.vertex].mapEdges.end(); ++iterAdj) {
-			newDistance = m_pRecords[iterAdj->first].fCost + minNode->getKey();
-			if (newDistance < m_vecVerticesHeapLookup[iterAdj->second]->getKey()) { // key will decrease - update
-				heap.DecreaseKey(m_vecVerticesHeapLookup[iterAdj->second], newDistance);
-				m_vecVerticesHeapLookup[iterAdj->second]->m_Data.predecessor = minNode->m_Data.vertex; // the vertex previous to this one
-				m_vecVerticesHeapLookup[iterAdj->second]->m_Data.record = iterAdj->first; // record to take from previous vertex to this one
+		for (pAdj = GetVertexEdgesBegin(minNode->m_Data.vertex), pAdjEnd = GetVertexEdgesEnd(minNode->m_Data.vertex); pAdj != pAdjEnd; ++pAdj) {
+			newDistance = m_pRecords[pAdj->iRecord].fCost + minNode->getKey();
+			if (newDistance < m_vecVerticesHeapLookup[pAdj->iVertex]->getKey()) { // key will decrease - update
+				heap.DecreaseKey(m_vecVerticesHeapLookup[pAdj->iVertex], newDistance);
+				m_vecVerticesHeapLookup[pAdj->iVertex]->m_Data.predecessor = minNode->m_Data.vertex; // the vertex previous to this one
+				m_vecVerticesHeapLookup[pAdj->iVertex]->m_Data.record = pAdj->iRecord; // record to take from previous vertex to this one
 			}
 		}
 	}
@@ -2879,21 +2976,7 @@ bool MapDB::AddressToPosition(Address * pAddress, unsigned int & iRecord, unsign
 		iShapePoint = pRecord->nShapePoints - 1;
 		fProgress = 0.f;
 
-		float fRecordDistance = RecordDistance(pRecord) * fFraction;
-
-		for (i = 0; i < pRecord->nShapePoints - 1; i++)
-		{
-			float fDistance = Distance(pRecord->pShapePoints[i], pRecord->pShapePoints[i+1]);
-
-			if (fDistance > fRecordDistance)
-			{
-				iShapePoint = i;
-				fProgress = fRecordDistance / fDistance;
-				break;
-			}
-			else
-				fRecordDistance -= fDistance;
-		}
+		DistanceToPosition(iRecord, GetRecordLength(iRecord) * fFraction, iShapePoint, fProgress);
 	}
 	else
 	{
@@ -2914,17 +2997,17 @@ bool MapDB::AddressToPosition(Address * pAddress, unsigned int & iRecord, unsign
 
 bool MapDB::GetNextPossibleRecords(std::vector<unsigned int> & vecRecords, unsigned int iVertex, unsigned int iPrevRecord)
 {
-	std::map<unsigned int, unsigned int>::iterator iterVertices;
+	const VertexEdge * pEdge, * pEdgesEnd;
 	bool bAdded = false, bPrevFound = false;
-	for (iterVertices = m_vecVertices[iVertex].mapEdges.begin(); iterVertices != m_vecVertices[iVertex].mapEdges.end(); ++iterVertices)
+	for (pEdge = GetVertexEdgesBegin(iVertex), pEdgesEnd = GetVertexEdgesEnd(iVertex); pEdge != pEdgesEnd; ++pEdge)
 	{
-		if (!IsRoad(GetRecord(iterVertices->first)))
+		if (!IsRoad(GetRecord(pEdge->iRecord)))
 			continue; // can't travel on this record
 
-		if (iterVertices->first == iPrevRecord) // should be done at most once!
+		if (pEdge->iRecord == iPrevRecord) // should be done at most once!
 			bPrevFound = true;
 		else
-			vecRecords.push_back(iterVertices->first);
+			vecRecords.push_back(pEdge->iRecord);
 		bAdded = true;
 	}
 	if (bPrevFound)
@@ -2938,9 +3021,7 @@ bool MapDB::CoordsToRecord(const Coords & ptPosition, unsigned int & iRecordClos
 	unsigned int iRecordGuess = iRecordClosest;
 	unsigned short iShapePoint;
 	MapRecord * pRecord;
-	std::map<unsigned short, CountySquares>::iterator iterCountySquares;
-	std::map<unsigned short, Rect>::iterator iterCountyRect;
-	int x, y;
+	std::map<unsigned short, RecordTree *>::iterator iterCountyTree;
 	unsigned int i;
 
 	iRecordClosest = (unsigned)-1;
@@ -2948,15 +3029,15 @@ bool MapDB::CoordsToRecord(const Coords & ptPosition, unsigned int & iRecordClos
 	{
 		std::set<unsigned int> setRecords;
 		std::set<unsigned int>::iterator iterRecord;
-		std::map<unsigned int, unsigned int>::iterator iterVertex;
+		const VertexEdge * pEdge, * pEdgesEnd;
 
 		// we made a guess
 		pRecord = GetRecord(iRecordGuess);
 		// see about this and connecting roads
 		for (i = 0; i < pRecord->nVertices; i++)
 		{
-			for (iterVertex = m_vecVertices[pRecord->pVertices[i]].mapEdges.begin(); iterVertex != m_vecVertices[pRecord->pVertices[i]].mapEdges.end(); ++iterVertex)
-				setRecords.insert(iterVertex->first);
+			for (pEdge = GetVertexEdgesBegin(pRecord->pVertices[i]), pEdgesEnd = GetVertexEdgesEnd(pRecord->pVertices[i]); pEdge != pEdgesEnd; ++pEdge)
+				setRecords.insert(pEdge->iRecord);
 		}
 
 		for (iterRecord = setRecords.begin(); iterRecord != setRecords.end(); ++iterRecord)
@@ -2977,72 +3058,138 @@ bool MapDB::CoordsToRecord(const Coords & ptPosition, unsigned int & iRecordClos
 			return true;
 	}
 
-	// for each county, if we're in the county, search it
-	for (iterCountySquares = m_mapCountyCodeToRegions.begin(); iterCountySquares != m_mapCountyCodeToRegions.end(); ++iterCountySquares)
-	{
-		// first, see if we are really in this county
-		iterCountyRect = m_mapCountyCodeToBoundingRect.find(iterCountySquares->first);
-		if (iterCountyRect == m_mapCountyCodeToBoundingRect.end() || !iterCountyRect->second.contains(ptPosition))
-			continue;
-
-		x = (int)((SQUARES_PER_COUNTY_SIDE * (ptPosition.m_iLong - iterCountyRect->second.m_iLeft)) / (iterCountyRect->second.m_iRight - iterCountyRect->second.m_iLeft));
-		y = (int)((SQUARES_PER_COUNTY_SIDE * (iterCountyRect->second.m_iTop - ptPosition.m_iLat)) / (iterCountyRect->second.m_iTop - iterCountyRect->second.m_iBottom));
-
-		CountySquare & regionRecords = iterCountySquares->second[(int)(x+y*SQUARES_PER_COUNTY_SIDE)];
-		for (i = 0; i < regionRecords.size(); i++)
-		{
-			pRecord = GetRecord(regionRecords[i]);
-
-			fDistance = PointRecordDistance(ptPosition, pRecord, iShapePoint, fProgress);
-			if (fDistance < fDistanceClosest)
-			{
-				iRecordClosest = regionRecords[i];
-				fDistanceClosest = fDistance;
-				iShapePointClosest = iShapePoint;
-				fProgressClosest = fProgress;
-			}
-		}
-	}
+	// search each county's tree; counties too far away to hold a closer
+	// record are pruned at the root
+	for (iterCountyTree = m_mapCountyCodeToRecordTree.begin(); iterCountyTree != m_mapCountyCodeToRecordTree.end(); ++iterCountyTree)
+		iterCountyTree->second->Nearest(m_pRecords, ptPosition, iRecordClosest, iShapePointClosest, fProgressClosest, fDistanceClosest);
 
 	return iRecordClosest != (unsigned)-1;
 }
 
 bool MapDB::GetRelativeRecord(unsigned int & iRecord, unsigned short & iCountyCode)
 {
-	std::map<unsigned short, RecordRange>::const_iterator iterCounty;
+	unsigned int iCounty;
 
-	iCountyCode = (unsigned)-1;
-
-	for (iterCounty = m_mapCountyCodeToRecords.begin(); iterCounty != m_mapCountyCodeToRecords.end(); ++iterCounty)
+	if (iRecord >= m_nRecords || m_vecRecordBlockCounty.empty())
 	{
-		if (iRecord >= iterCounty->second.first && iRecord < iterCounty->second.second)
-		{
-			iCountyCode = iterCounty->first;
-			iRecord -= iterCounty->second.first;
-			return true;
-		}
+		iCountyCode = (unsigned)-1;
+		iRecord = (unsigned)-1;
+		return false;
 	}
 
-	iRecord = (unsigned)-1;
-	return false;
+	// the block table gives the county of the block's first record; a block
+	// only spans several counties when a county has fewer records than a block
+	iCounty = m_vecRecordBlockCounty[iRecord >> RECORD_BLOCK_BITS];
+	while (iRecord >= m_vecLoadedCountyRecords[iCounty].second)
+		iCounty++;
+
+	iCountyCode = m_vecLoadedCountyCodes[iCounty];
+	iRecord -= m_vecLoadedCountyRecords[iCounty].first;
+	return true;
 }
 
 bool MapDB::GetAbsoluteRecord(unsigned int & iRecord, unsigned short iCountyCode)
 {
-	std::map<unsigned short, RecordRange>::const_iterator iterCounty;
+	unsigned int iCounty = iCountyCode < m_vecCountyCodeToLoaded.size() ? m_vecCountyCodeToLoaded[iCountyCode] : 0;
 
-	iterCounty = m_mapCountyCodeToRecords.find(iCountyCode);
-	if (iterCounty == m_mapCountyCodeToRecords.end())
+	if (iCounty == 0)
 		iRecord = (unsigned)-1;
 	else
 	{
-		iRecord += iterCounty->second.first;
-		if (iRecord >= iterCounty->second.second)
+		iRecord += m_vecLoadedCountyRecords[iCounty - 1].first;
+		if (iRecord >= m_vecLoadedCountyRecords[iCounty - 1].second)
 			iRecord = (unsigned)-1;
 	}
 	return iRecord != (unsigned)-1;
 }
 
+// adds a newly loaded county's records [iBegin, iEnd) to the record # <->
+// county lookup tables
+void MapDB::AddCountyRecords(unsigned short iCountyCode, unsigned int iBegin, unsigned int iEnd)
+{
+	unsigned short iCounty = m_vecLoadedCountyCodes.size();
+
+	m_vecLoadedCountyCodes.push_back(iCountyCode);
+	m_vecLoadedCountyRecords.push_back(RecordRange(iBegin, iEnd));
+	if (iCountyCode >= m_vecCountyCodeToLoaded.size())
+		m_vecCountyCodeToLoaded.resize(iCountyCode + 1, 0);
+	m_vecCountyCodeToLoaded[iCountyCode] = iCounty + 1;
+
+	// every block that starts within the new range starts in this county
+	while ((m_vecRecordBlockCounty.size() << RECORD_BLOCK_BITS) < iEnd)
+		m_vecRecordBlockCounty.push_back(iCounty);
+}
+
+void MapDB::AddRecordGeometry(unsigned int iBegin, unsigned int iEnd)
+{
+	unsigned int iRec, iIndex;
+	unsigned short i;
+	float fDistance, fLength;
+	MapRecord * psRec;
+
+	if (m_vecRecordGeometryOffsets.empty())
+		m_vecRecordGeometryOffsets.push_back(0);
+	m_vecRecordGeometryOffsets.resize(iEnd + 1);
+	for (iRec = iBegin; iRec < iEnd; iRec++)
+		m_vecRecordGeometryOffsets[iRec + 1] = m_vecRecordGeometryOffsets[iRec] + m_pRecords[iRec].nShapePoints;
+	m_vecShapePointDistances.resize(m_vecRecordGeometryOffsets[iEnd]);
+	m_vecSegmentLengths.resize(m_vecRecordGeometryOffsets[iEnd]);
+	m_vecSegmentHeadings.resize(m_vecRecordGeometryOffsets[iEnd]);
+
+	for (iRec = iBegin; iRec < iEnd; iRec++)
+	{
+		psRec = m_pRecords + iRec;
+		iIndex = m_vecRecordGeometryOffsets[iRec];
+		fDistance = 0.f;
+		for (i = 0; i < psRec->nShapePoints; i++, iIndex++)
+		{
+			m_vecShapePointDistances[iIndex] = fDistance;
+			if (i + 1 < psRec->nShapePoints)
+			{
+				const Coords & c0 = psRec->pShapePoints[i], & c1 = psRec->pShapePoints[i + 1];
+
+				fLength = Distance(c0, c1);
+				m_vecSegmentLengths[iIndex] = fLength;
+				m_vecSegmentHeadings[iIndex] = (short)round(atan2(c1.m_iLong - c0.m_iLong, c1.m_iLat - c0.m_iLat) * CENTIDEGREESPERRADIAN);
+				fDistance += fLength;
+			}
+			else
+			{
+				m_vecSegmentLengths[iIndex] = 0.f;
+				m_vecSegmentHeadings[iIndex] = 0;
+			}
+		}
+	}
+}
+
+void MapDB::DistanceToPosition(unsigned int iRec, float fDistance, unsigned int & iShapePoint, float & fProgress) const
+{
+	std::vector<float>::const_iterator iterBegin = m_vecShapePointDistances.begin() + m_vecRecordGeometryOffsets[iRec];
+	std::vector<float>::const_iterator iterEnd = m_vecShapePointDistances.begin() + m_vecRecordGeometryOffsets[iRec + 1];
+	unsigned int iIndex;
+
+	// past either end, snap to the end point
+	if (fDistance <= 0.f)
+	{
+		iShapePoint = 0;
+		fProgress = 0.f;
+		return;
+	}
+	if (fDistance >= *(iterEnd - 1))
+	{
+		iShapePoint = (iterEnd - iterBegin) - 1;
+		fProgress = 0.f;
+		return;
+	}
+
+	// the segment we're on starts at the last point at or before the distance
+	iShapePoint = (std::upper_bound(iterBegin, iterEnd, fDistance) - iterBegin) - 1;
+	iIndex = m_vecRecordGeometryOffsets[iRec] + iShapePoint;
+	fProgress = m_vecSegmentLengths[iIndex] > 0.f ? (fDistance - m_vecShapePointDistances[iIndex]) / m_vecSegmentLengths[iIndex] : 0.f;
+	if (fProgress > 1.f)
+		fProgress = 1.f;
+}
+
 void MapDB::AddRecordsToRegionSquares(unsigned int begin, unsigned int end, CountySquares * squares, const Rect & totalBounds)
 {
 	unsigned int i;
@@ -3089,8 +3236,7 @@ void MapDB::Routing(Address * add1, Address * add2)
 
 
 	bool bTemp1 = false, bTemp2 = false;
-	std::vector<Coords> vecVerticesToCoords;
-	std::map<Coords, unsigned int>::iterator iterCoords;
+	const std::vector<Coords> & vecVerticesToCoords = m_vecVertexCoords;
 	Coords endPoint, curPoint, prevPoint;
 	curPoint = add1->ptCoordinates;
 	endPoint = add2->ptCoordinates;
@@ -3099,16 +3245,9 @@ void MapDB::Routing(Address * add1, Address * add2)
 	float fMinDistance = INFINITY;
 	std::list<unsigned int> l_route;
 	std::list<unsigned int>::iterator lrouteItr;
-	std::map<unsigned int, unsigned, int>::iterator edgeItr;
-	vecVerticesToCoords.resize(m_vecVertices.size());
 	l_route = ShortestPath(add1,add2,bTemp1,bTemp2);
 	printf("route size: %d\r\n",l_route.size());
 
-	for(iterCoords = m_mapCoordinateToVertex.begin(); iterCoords != m_mapCoordinateToVertex.end();++iterCoords)
-	{	
-
-		vecVerticesToCoords[iterCoords->second] = iterCoords->first;
-	}
 
 
 
@@ -173,7 +173,6 @@ float TimeFactor(const MapRecord * pRecord);
 float RecordDistance(const MapRecord * pRecord);
 float PointRecordDistance(const Coords & pt, const MapRecord * pRecord, unsigned short & iShapePoint, float & fProgress);
 bool IsVehicleGoingForwards(unsigned short iShapePoint, short iHeading, const MapRecord * pRecord);
-float DistanceAlongRecord(const MapRecord * pRecord, unsigned short iStartShapePoint, float fStartProgress, unsigned short iEndShapePoint, float fEndProgress);
 
 typedef struct DijkstraVertexStruct {
 	unsigned int vertex;
@@ -255,15 +254,80 @@ bool IsRecordVisible(const std::vector<Coords> & coords, const Coords & ptTopLef
 void DrawLine(QPainter * dc, int sx, int sy, int dx, int dy, int iWidth, const QColor & clrColor, int iStyle);
 void DrawRotatedText(QPainter * dc, const QString & str, const QPoint & p, const QSize & sz, double angle, const QColor & clrText);
 
+// a vertex (intersection) in the map database
+// the edges leaving each vertex are kept by MapDB in one shared adjacency
+// array (see MapDB::GetVertexEdgesBegin), not in the vertex itself
+// with traffic lights, the signal at a vertex gives each of its roads in turn
+// a green light fSignalPhase seconds long; the first change comes
+// fSignalOffset seconds after the signal plan starts (MapDB::SetTrafficLights)
+// and a phase of 0 means the vertex has no signal
 typedef struct VertexStruct
 {
-	std::map<unsigned int, unsigned int> mapEdges;
 	std::vector<unsigned int> vecRoads;
-	unsigned int iRoadPermitted;
+	float fSignalOffset;
+	float fSignalPhase;
 } Vertex;
 
-void AddRecordToVertex(Vertex * pVertex, const MapRecord * pRecordSet, unsigned int iRecord, unsigned int iPreviousVertex);
-bool CanCarGoThrough(const Vertex & vertex, unsigned int iRecord);
+// an edge leaving a vertex: the record followed and the vertex at its other
+// end
+typedef struct VertexEdgeStruct
+{
+	unsigned int iRecord;
+	unsigned int iVertex;
+} VertexEdge;
+
+// a vertex while a map file is being built by the TIGER/OSM processor
+// (record -> vertex at the other end)
+typedef struct TIGERVertexStruct
+{
+	std::map<unsigned int, unsigned int> mapEdges;
+	std::vector<unsigned int> vecRoads;
+} TIGERVertex;
+
+void AddRecordToVertex(TIGERVertex * pVertex, const MapRecord * pRecordSet, unsigned int iRecord, unsigned int iPreviousVertex);
+// the road of the vertex with the green light at time tCurrent
+unsigned int GetPermittedRoad(const Vertex & vertex, const struct timeval & tCurrent);
+bool CanCarGoThrough(const Vertex & vertex, unsigned int iRecord, const struct timeval & tCurrent);
+
+// open-addressed (linear probing) hash index from coordinates to vertex
+// numbers
+// only vertex numbers are stored in the table; the coordinates are looked up
+// in the vertex coordinate array the index is attached to, so the index
+// costs a few bytes per vertex and a lookup touches one or two cache lines
+// lookups do not modify the index, so it can be queried from any thread once
+// the map is loaded
+class CoordsIndex
+{
+public:
+	CoordsIndex(const std::vector<Coords> * pCoords);
+
+	void Clear();
+	void Reserve(unsigned int nEntries);
+	// returns the vertex at pt, or (unsigned)-1 if there isn't one
+	unsigned int Find(const Coords & pt) const;
+	// adds iVertex, which must not be in the index already
+	void Insert(unsigned int iVertex);
+
+	inline unsigned int GetCount() const
+	{
+		return m_nEntries;
+	}
+
+protected:
+	static inline unsigned int Hash(const Coords & pt)
+	{
+		unsigned int iHash = ((unsigned int)pt.m_iLong * 0x9e3779b1u) ^ ((unsigned int)pt.m_iLat * 0x85ebca6bu);
+		return iHash ^ (iHash >> 15);
+	}
+	void Rehash(unsigned int nSlots);
+
+	const std::vector<Coords> * m_pCoords;
+	std::vector<unsigned int> m_vecSlots;
+	unsigned int m_iMask;
+	unsigned int m_nEntries;
+};
+
+class RecordTree;
 
 typedef std::pair<unsigned int, unsigned int> RecordRange;
 typedef std::vector<unsigned int> CountySquare;
@@ -278,7 +342,15 @@ public:
 	~MapDB();
 
 	void Clear();
+	// start the signal plan at tStart: every signal has the same phase length,
+	// and vertex i starts (i % iGroups) / iGroups of a phase late
+	void SetTrafficLights(const struct timeval & tStart, const struct timeval & tPhase, unsigned int iGroups);
 	void ResetTrafficLights();
+	// move the start of the signal plan, keeping each vertex's offset
+	inline void RestartTrafficLights(const struct timeval & tStart)
+	{
+		m_tTrafficLightsStart = tStart;
+	}
 
 	bool IsCountyLoaded(unsigned short iFIPSCode);
 	bool DownloadCounties(const std::set<unsigned short> & setFIPSCodes);
@@ -294,6 +366,10 @@ public:
 	{
 		m_bTrafficLights = bTrafficLights;
 	}
+	inline const struct timeval & GetTrafficLightsStart() const
+	{
+		return m_tTrafficLightsStart;
+	}
 	inline struct timeval GetLastChange() const
 	{
 		return m_tLastChange;
@@ -310,6 +386,42 @@ public:
 	{
 		return m_pRecords + iRec;
 	}
+	inline float GetShapePointDistance(unsigned int iRec, unsigned int iShapePoint) const
+	{
+		return m_vecShapePointDistances[GetGeometryIndex(iRec, iShapePoint)];
+	}
+	inline float GetSegmentLength(unsigned int iRec, unsigned int iShapePoint) const
+	{
+		return m_vecSegmentLengths[GetGeometryIndex(iRec, iShapePoint)];
+	}
+	inline float GetRecordLength(unsigned int iRec) const
+	{
+#ifdef DEBUG
+		Q_ASSERT(iRec + 1 < m_vecRecordGeometryOffsets.size());
+#endif
+		return m_vecShapePointDistances[m_vecRecordGeometryOffsets[iRec + 1] - 1];
+	}
+	inline short GetSegmentHeading(unsigned int iRec, unsigned int iShapePoint, bool bForwards) const
+	{
+		unsigned int iIndex = GetGeometryIndex(iRec, iShapePoint);
+		short iHeading = m_vecSegmentHeadings[iIndex];
+
+		// the heading backwards is the opposite direction, except on empty segments
+		if (bForwards || m_vecSegmentLengths[iIndex] <= 0.f)
+			return iHeading;
+		else
+			return iHeading > 0 ? iHeading - 18000 : iHeading + 18000;
+	}
+	inline float DistanceAlongRecord(unsigned int iRec, unsigned int iShapePoint, float fProgress) const
+	{
+		unsigned int iIndex = GetGeometryIndex(iRec, iShapePoint);
+		return m_vecShapePointDistances[iIndex] + m_vecSegmentLengths[iIndex] * fProgress;
+	}
+	inline float DistanceAlongRecord(unsigned int iRec, unsigned int iStartShapePoint, float fStartProgress, unsigned int iEndShapePoint, float fEndProgress) const
+	{
+		return fabsf(DistanceAlongRecord(iRec, iEndShapePoint, fEndProgress) - DistanceAlongRecord(iRec, iStartShapePoint, fStartProgress));
+	}
+	void DistanceToPosition(unsigned int iRec, float fDistance, unsigned int & iShapePoint, float & fProgress) const;
 	inline const Vertex & GetVertex(unsigned int iVertex) const
 	{
 		return m_vecVertices[iVertex];
@@ -322,6 +434,27 @@ public:
 	{
 		return m_vecVertices.size();
 	}
+	inline const Coords & GetVertexCoords(unsigned int iVertex) const
+	{
+		return m_vecVertexCoords[iVertex];
+	}
+	inline unsigned int FindVertex(const Coords & pt) const
+	{
+		return m_indexCoordinateToVertex.Find(pt);
+	}
+	// the edges leaving a vertex, in record order
+	inline const VertexEdge * GetVertexEdgesBegin(unsigned int iVertex) const
+	{
+		return m_vecVertexEdges.empty() ? NULL : &m_vecVertexEdges[0] + m_vecVertexEdgeOffsets[iVertex];
+	}
+	inline const VertexEdge * GetVertexEdgesEnd(unsigned int iVertex) const
+	{
+		return m_vecVertexEdges.empty() ? NULL : &m_vecVertexEdges[0] + m_vecVertexEdgeOffsets[iVertex + 1];
+	}
+	inline unsigned int GetVertexEdgeCount(unsigned int iVertex) const
+	{
+		return m_vecVertexEdgeOffsets[iVertex + 1] - m_vecVertexEdgeOffsets[iVertex];
+	}
 	inline const QString & GetString(unsigned int i) const
 	{
 		return m_vecStrings[i];
@@ -360,6 +493,9 @@ public:
 	
 protected:
 	bool LoadMap(const QString & strBaseName);
+	void AddCountyRecords(unsigned short iCountyCode, unsigned int iBegin, unsigned int iEnd);
+	void AddRecordGeometry(unsigned int iBegin, unsigned int iEnd);
+	void AddVertexEdges(std::vector<std::pair<unsigned int, VertexEdge> > & vecEdges);
 	void AddRecordsToRegionSquares(unsigned int begin, unsigned int end, CountySquares * squares, const Rect & totalBounds);
 	unsigned int AddString(const QString & str);
 	void DrawMapFeatures(MapDrawingSettings * pSettings);
@@ -374,16 +510,54 @@ protected:
 	unsigned int m_nRecords;
 	std::vector<Vertex> m_vecVertices;
 	bool m_bTrafficLights;
+	struct timeval m_tTrafficLightsStart;
 
 	std::vector<QString> m_vecStrings;
 	std::vector<std::vector<unsigned int> > m_vecStringRoads;
 
 	std::map<unsigned short, RecordRange > m_mapCountyCodeToRecords;
+
+	// record # <-> county lookup, used for every packet sent or received
+	// each county's records are one range, and ranges are in load order
+	std::vector<unsigned short> m_vecLoadedCountyCodes;
+	std::vector<RecordRange> m_vecLoadedCountyRecords;
+	// for each block of records, the county (index into the vectors above)
+	// of the block's first record
+	std::vector<unsigned short> m_vecRecordBlockCounty;
+	// county code -> 1 + index into the vectors above, or 0 if not loaded
+	std::vector<unsigned short> m_vecCountyCodeToLoaded;
 	std::map<unsigned short, Rect> m_mapCountyCodeToBoundingRect;
 	std::map<unsigned short, CountySquares > m_mapCountyCodeToRegions;
+	std::map<unsigned short, RecordTree *> m_mapCountyCodeToRecordTree;
 	std::map<unsigned short, WaterPolygons > m_mapCountyCodeToWaterPolys;
 
-	std::map<Coords, unsigned int> m_mapCoordinateToVertex;
+	// vertex # -> coordinates, and the reverse lookup
+	std::vector<Coords> m_vecVertexCoords;
+	CoordsIndex m_indexCoordinateToVertex;
+
+	// adjacency array: the edges leaving vertex i are
+	// m_vecVertexEdges[m_vecVertexEdgeOffsets[i]] up to (but not including)
+	// m_vecVertexEdges[m_vecVertexEdgeOffsets[i+1]], sorted by record
+	std::vector<unsigned int> m_vecVertexEdgeOffsets;
+	std::vector<VertexEdge> m_vecVertexEdges;
+
+	// per-record geometry, built once as records are loaded: for each shape
+	// point i of record r, at m_vecRecordGeometryOffsets[r] + i, the distance
+	// (in miles) along the record to the point, and the length and forwards
+	// heading (in centidegrees) of the segment from point i to point i+1
+	// (the last point of each record has a length and heading of 0)
+	std::vector<unsigned int> m_vecRecordGeometryOffsets;
+	std::vector<float> m_vecShapePointDistances;
+	std::vector<float> m_vecSegmentLengths;
+	std::vector<short> m_vecSegmentHeadings;
+
+	inline unsigned int GetGeometryIndex(unsigned int iRec, unsigned int iShapePoint) const
+	{
+#ifdef DEBUG
+		Q_ASSERT(iRec + 1 < m_vecRecordGeometryOffsets.size() && iShapePoint < m_vecRecordGeometryOffsets[iRec + 1] - m_vecRecordGeometryOffsets[iRec]);
+#endif
+		return m_vecRecordGeometryOffsets[iRec] + iShapePoint;
+	}
 
 	std::vector<FibonacciHeapNode<double, DijkstraVertex> * > m_vecVerticesHeapLookup;
 
@@ -0,0 +1,98 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "MobilityTick.h"
+#include "Simulator.h"
+
+MobilityTicker::MobilityTicker()
+{
+}
+
+MobilityTicker::~MobilityTicker()
+{
+	Clear();
+}
+
+void MobilityTicker::Clear()
+{
+	unsigned int i;
+
+	for (i = 0; i < m_vecGroups.size(); i++)
+		delete m_vecGroups[i];
+	m_vecGroups.clear();
+}
+
+void MobilityTicker::AddCar(SimModel * pCar, struct timeval tPeriod)
+{
+	MobilityTickGroup * pGroup = NULL;
+	unsigned int i;
+
+	for (i = 0; i < m_vecGroups.size(); i++)
+	{
+		if (m_vecGroups[i]->tPeriod == tPeriod)
+		{
+			pGroup = m_vecGroups[i];
+			break;
+		}
+	}
+
+	if (pGroup == NULL)
+	{
+		pGroup = new MobilityTickGroup;
+		pGroup->tPeriod = tPeriod;
+		m_vecGroups.push_back(pGroup);
+		// the group belongs to the ticker, so the event gets no destroy function
+		g_pSimulator->m_EventQueue.AddEvent(SimEvent(g_pSimulator->m_tCurrent, EVENT_PRIORITY_HIGHEST, QString::null, QString::null, EVENT_MOBILITYTICK, pGroup));
+	}
+
+	pGroup->vecCars.push_back(pCar);
+	pGroup->vecStates.resize(pGroup->vecCars.size());
+}
+
+void MobilityTicker::ProcessEvent(SimEvent & event)
+{
+	MobilityTickGroup * pGroup = (MobilityTickGroup *)event.GetEventData();
+	struct timeval tCurrent = event.GetTimestamp();
+	unsigned int i;
+
+	if (pGroup == NULL)
+		return;
+
+	for (i = 0; i < pGroup->vecCars.size(); i++)
+	{
+		pGroup->vecCars[i]->DoUpdate(tCurrent);
+		pGroup->vecCars[i]->LoadMobilityState(tCurrent, pGroup->vecStates[i]);
+	}
+
+	// one car at a time: mobility models advance their car's trip model and
+	// look up other cars through the car registry
+	for (i = 0; i < pGroup->vecCars.size(); i++)
+		pGroup->vecCars[i]->AdvanceMobility(pGroup->vecStates[i]);
+
+	for (i = 0; i < pGroup->vecCars.size(); i++)
+		pGroup->vecCars[i]->StoreMobilityState(tCurrent, pGroup->vecStates[i]);
+
+	event.SetTimestamp(tCurrent + pGroup->tPeriod);
+	g_pSimulator->m_EventQueue.AddEvent(event);
+}
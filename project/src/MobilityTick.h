@@ -0,0 +1,66 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/* MobilityTick.h -- synchronous-tick mode for simulated cars. Instead of
+ * every car scheduling its own EVENT_CARMODEL_UPDATE, cars that share an
+ * update period are put in one group with a single event per tick. On each
+ * tick the group's cars update their link-layer models, copy their motion
+ * state into one contiguous array, are all moved in one pass over that
+ * array, and then store the result and transmit, in that order.
+ */
+
+#ifndef _MOBILITYTICK_H
+#define _MOBILITYTICK_H
+
+#include "SimModel.h"
+
+#include <vector>
+
+#define EVENT_MOBILITYTICK 6640117
+
+class MobilityTicker
+{
+public:
+	MobilityTicker();
+	~MobilityTicker();
+
+	// forget every group, before models are pre-run for a new trial
+	void Clear();
+	// add a car to the group for its update period, starting the group's
+	// events if this is its first car
+	void AddCar(SimModel * pCar, struct timeval tPeriod);
+	// handle an EVENT_MOBILITYTICK and schedule the group's next tick
+	void ProcessEvent(SimEvent & event);
+
+protected:
+	typedef struct MobilityTickGroupStruct
+	{
+		struct timeval tPeriod;
+		std::vector<SimModel *> vecCars;
+		std::vector<MobilityState> vecStates; // parallel to vecCars
+	} MobilityTickGroup;
+
+	std::vector<MobilityTickGroup *> m_vecGroups;
+};
+
+#endif
@@ -24,17 +24,19 @@
 
 #include "Model.h"
 #include "StringHelp.h"
+#include "ParamSchema.h"
+#include "SimCheckpoint.h"
 
 //#define MODEL_PARAM_DELAY "DELAY"
 //#define MODEL_PARAM_DELAY_DEFAULT "0.2"
 
 Model::Model(const QString & strModelName)
-: /*m_tDelay(timeval0), */m_strModelName(strModelName), m_tLastEvent(timeval0)
+: /*m_tDelay(timeval0), */m_strModelName(strModelName), m_tLastEvent(timeval0), m_pParamBlock(NULL)
 {
 }
 
 Model::Model(const Model & copy)
-: /*m_tDelay(copy.m_tDelay), */m_strModelName(copy.m_strModelName), m_tLastEvent(copy.m_tLastEvent)
+: /*m_tDelay(copy.m_tDelay), */m_strModelName(copy.m_strModelName), m_tLastEvent(copy.m_tLastEvent), m_pParamBlock(copy.m_pParamBlock)
 {
 }
 
@@ -48,6 +50,7 @@ Model & Model::operator =(const Model & copy)
 
 	m_strModelName = copy.m_strModelName;
 	m_tLastEvent = copy.m_tLastEvent;
+	m_pParamBlock = copy.m_pParamBlock;
 	return *this;
 }
 
@@ -68,6 +71,17 @@ int Model::Save(std::map<QString, QString> & mapParams)
 	return 0; // successful
 }
 
+int Model::SaveState(CheckpointWriter & writer)
+{
+	writer.WriteTime(m_tLastEvent);
+	return 0;
+}
+
+int Model::LoadState(CheckpointReader & reader)
+{
+	return reader.ReadTime(m_tLastEvent) ? 0 : 1;
+}
+
 void Model::GetParams(std::map<QString, ModelParameter> & mapParams)
 {
 //	mapParams[MODEL_PARAM_DELAY].strValue = MODEL_PARAM_DELAY_DEFAULT;
@@ -75,3 +89,14 @@ void Model::GetParams(std::map<QString, ModelParameter> & mapParams)
 //	mapParams[MODEL_PARAM_DELAY].strAuxData = QString("%1:").arg(5e-2);
 }
 
+double Model::GetNumberParam(const std::map<QString, QString> & mapParams, const QString & strKey, const QString & strDefault) const
+{
+	const ParamValue * pValue = m_pParamBlock == NULL ? NULL : m_pParamBlock->GetValue(strKey);
+	return pValue == NULL ? StringToNumber(GetParam(mapParams, strKey, strDefault)) : pValue->fNumber;
+}
+
+bool Model::GetBooleanParam(const std::map<QString, QString> & mapParams, const QString & strKey, const QString & strDefault) const
+{
+	const ParamValue * pValue = m_pParamBlock == NULL ? NULL : m_pParamBlock->GetValue(strKey);
+	return pValue == NULL ? StringToBoolean(GetParam(mapParams, strKey, strDefault)) : pValue->bBoolean;
+}
@@ -65,7 +65,9 @@ typedef struct ModelParameterStruct
 	ModelParameterType eType;
 } ModelParameter;
 
-
+class ParamBlock;
+class CheckpointWriter;
+class CheckpointReader;
 
 class Model{
 public:
@@ -90,6 +92,18 @@ public:
 		m_tLastEvent = timeval0;
 		return 0;
 	}
+	// between Monte Carlo trials, a model can keep what PreRun derived that
+	// stays the same from trial to trial (Checkpoint, after the first
+	// trial's PreRun) and bring it back instead of deriving it again
+	// (Restore, in place of PreRun for later trials)
+	inline virtual int Checkpoint()
+	{
+		return 0;
+	}
+	inline virtual int Restore()
+	{
+		return PreRun();
+	}
 	inline virtual int ProcessEvent(SimEvent & event)
 	{
 		m_tLastEvent = event.GetTimestamp();
@@ -109,6 +123,10 @@ public:
 		return 0;
 	}
 	virtual int Save(std::map<QString, QString> & mapParams);
+	// the state a running model has built up, for a simulation checkpoint
+	// (SimCheckpoint.h); LoadState is called after PreRun when resuming
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 	inline virtual int Cleanup()
 	{
 		return 0;
@@ -136,15 +154,29 @@ public:
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
+	// parameters parsed by the model manager before Init; NULL if the model
+	// was made some other way
+	inline void SetParamBlock(const ParamBlock * pParamBlock)
+	{
+		m_pParamBlock = pParamBlock;
+	}
+
 	QMutex m_mutexUpdate;
 
 protected:
+	// a parameter given to Init, as a number or a boolean; uses the parsed
+	// block when there is one and parses the string otherwise
+	double GetNumberParam(const std::map<QString, QString> & mapParams, const QString & strKey, const QString & strDefault) const;
+	bool GetBooleanParam(const std::map<QString, QString> & mapParams, const QString & strKey, const QString & strDefault) const;
+
+
 	// initialized parameters
 //	struct timeval m_tDelay;
 
 	// attributes
 	QString m_strModelName;
 	struct timeval m_tLastEvent;
+	const ParamBlock * m_pParamBlock;
 };
 
 typedef Model * (*ModelCreator) (const QString &);
@@ -359,6 +359,7 @@ int ModelMgr::AddModel(const QString & strModelName, const QString & strModelTyp
 	std::map<QString, Model *>::iterator iterModel;
 	ModelCreator pfnModelCreator;
 	Model * pModel;
+	const ParamBlock * pBlock;
 
 	if (m_mapModels.find(strModelName) == m_mapModels.end())
 	{
@@ -368,6 +369,11 @@ int ModelMgr::AddModel(const QString & strModelName, const QString & strModelTyp
 			if (pfnModelCreator)
 			{
 				pModel = (*pfnModelCreator)(strModelName);
+				// parameters are matched against the type's schema once here,
+				// and Init reads the parsed values
+				pBlock = pModel == NULL ? NULL : m_ParamSchemas.Parse(strModelType, mapParams);
+				if (pModel)
+					pModel->SetParamBlock(pBlock);
 				if (pModel && pModel->Init(mapParams) == 0)
 				{
 					if (g_pSimulator->running())
@@ -474,6 +480,7 @@ void ModelMgr::DestroyAllModels()
 	}
 
 	m_mapModels.clear();
+	m_ParamSchemas.Clear();
 	m_modelsMutex.unlock();
 }
 
@@ -26,6 +26,7 @@
 #define _MODELMGR_H
 
 #include "Model.h"
+#include "ParamSchema.h"
 
 #include <vector>
 #include <list>
@@ -88,6 +89,7 @@ protected:
 
 	// model registry
 	std::map<QString, Model *> m_mapModels;
+	ParamSchemas m_ParamSchemas;
 	ModelTreeNode * m_pModelTreeNodes;
 	unsigned int m_nModelTreeNodes;
 	QMutex m_modelsMutex;
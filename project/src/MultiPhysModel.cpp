@@ -28,6 +28,9 @@
 #include "StringHelp.h"
 #include "Simulator.h"
 
+#include <algorithm>
+#include <string.h>
+
 #define MULTIPHYSMODEL_PARAM_V2VMODEL "V2V"
 #define MULTIPHYSMODEL_PARAM_V2VMODEL_DEFAULT "NULL"
 #define MULTIPHYSMODEL_PARAM_V2VMODEL_DESC "V2V (model) -- The physical layer model to emulate for packets from another vehicle."
@@ -38,11 +41,13 @@
 MultiPhysModel::MultiPhysModel(const QString & strModelName)
 : CarPhysModel(strModelName)
 {
+	BindModels();
 }
 
 MultiPhysModel::MultiPhysModel(const MultiPhysModel & copy)
-: CarPhysModel(copy), m_mapPhysModels(copy.m_mapPhysModels), m_mapPhysModelNames(copy.m_mapPhysModelNames)
+: CarPhysModel(copy), m_mapPhysModels(copy.m_mapPhysModels), m_mapPhysModelNames(copy.m_mapPhysModelNames), m_vecInfrastructureNodes(copy.m_vecInfrastructureNodes)
 {
+	BindModels();
 }
 
 MultiPhysModel::~MultiPhysModel()
@@ -55,6 +60,8 @@ MultiPhysModel & MultiPhysModel::operator = (const MultiPhysModel & copy)
 
 	m_mapPhysModels = copy.m_mapPhysModels;
 	m_mapPhysModelNames = copy.m_mapPhysModelNames;
+	m_vecInfrastructureNodes = copy.m_vecInfrastructureNodes;
+	BindModels();
 	return *this;
 }
 
@@ -78,6 +85,17 @@ int MultiPhysModel::Init(const std::map<QString, QString> & mapParams)
 		return 3;
 	m_mapPhysModels.insert(std::pair<QString, CarPhysModel *>(MULTIPHYSMODEL_PARAM_INFRASTRUCTUREMODEL, (CarPhysModel *)pModel));
 
+	BindModels();
+	return 0;
+}
+
+int MultiPhysModel::PreRun()
+{
+	if (CarPhysModel::PreRun())
+		return 1;
+
+	BindModels();
+	LoadInfrastructureNodes();
 	return 0;
 }
 
@@ -148,8 +166,17 @@ float MultiPhysModel::GetRXRange(const Packet * packet) const
 
 bool MultiPhysModel::IsCarInRange(const Coords & ptCar, const Coords & ptPosition) const
 {
-	std::map<QString, CarPhysModel *>::const_iterator iterModel = m_mapPhysModels.find(MULTIPHYSMODEL_PARAM_V2VMODEL);
-	return iterModel != m_mapPhysModels.end() && iterModel->second != NULL && iterModel->second->IsCarInRange(ptCar, ptPosition);
+	CarPhysModel * pModel = m_pPhysModelBySource[MultiPhysModelSourceV2V];
+	return pModel != NULL && pModel->IsCarInRange(ptCar, ptPosition);
+}
+
+unsigned int MultiPhysModel::AreCarsInRange(const Coords & ptCar, const Coords * pPositions, unsigned int iCount, unsigned char * pInRange) const
+{
+	CarPhysModel * pModel = m_pPhysModelBySource[MultiPhysModelSourceV2V];
+	if (pModel != NULL)
+		return pModel->AreCarsInRange(ptCar, pPositions, iCount, pInRange);
+	memset(pInRange, 0, iCount);
+	return 0;
 }
 
 unsigned int MultiPhysModel::GetCollisionCount() const
@@ -203,52 +230,39 @@ void MultiPhysModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 
 CarPhysModel * MultiPhysModel::GetRelevantModel(const Packet * packet)
 {
-	// get relevant model depending on source of message
-	std::map<in_addr_t, CarModel *> * pCarRegistry = g_pCarRegistry->acquireLock();
-	std::map<in_addr_t, InfrastructureNodeModel *> * pNodeRegistry = g_pInfrastructureNodeRegistry->acquireLock();
-	std::map<in_addr_t, CarModel *>::iterator iterTXCar = pCarRegistry->find(packet->m_ipTX);
-	std::map<in_addr_t, InfrastructureNodeModel *>::iterator iterTXNode = pNodeRegistry->find(packet->m_ipTX);
-	std::map<QString, CarPhysModel *>::iterator iterModel;
-	CarPhysModel * pModel = NULL;
-	if (iterTXNode != pNodeRegistry->end() && iterTXNode->second != NULL)
-	{
-		iterModel = m_mapPhysModels.find(MULTIPHYSMODEL_PARAM_INFRASTRUCTUREMODEL);
-		if (iterModel != m_mapPhysModels.end())
-			pModel = iterModel->second;
-	}
-	else
-	{
-		iterModel = m_mapPhysModels.find(MULTIPHYSMODEL_PARAM_V2VMODEL);
-		if (iterModel != m_mapPhysModels.end())
-			pModel = iterModel->second;
-	}
-	g_pInfrastructureNodeRegistry->releaseLock();
-	g_pCarRegistry->releaseLock();
-	return pModel;
+	return ((const MultiPhysModel *)this)->GetRelevantModel(packet);
 }
 
 CarPhysModel * MultiPhysModel::GetRelevantModel(const Packet * packet) const
 {
 	// get relevant model depending on source of message
-	std::map<in_addr_t, CarModel *> * pCarRegistry = g_pCarRegistry->acquireLock();
-	std::map<in_addr_t, InfrastructureNodeModel *> * pNodeRegistry = g_pInfrastructureNodeRegistry->acquireLock();
-	std::map<in_addr_t, CarModel *>::iterator iterTXCar = pCarRegistry->find(packet->m_ipTX);
-	std::map<in_addr_t, InfrastructureNodeModel *>::iterator iterTXNode = pNodeRegistry->find(packet->m_ipTX);
-	std::map<QString, CarPhysModel *>::const_iterator iterModel;
-	CarPhysModel * pModel = NULL;
-	if (iterTXNode != pNodeRegistry->end() && iterTXNode->second != NULL)
-	{
-		iterModel = m_mapPhysModels.find(MULTIPHYSMODEL_PARAM_INFRASTRUCTUREMODEL);
-		if (iterModel != m_mapPhysModels.end())
-			pModel = iterModel->second;
-	}
+	if (std::binary_search(m_vecInfrastructureNodes.begin(), m_vecInfrastructureNodes.end(), packet->m_ipTX))
+		return m_pPhysModelBySource[MultiPhysModelSourceInfrastructure];
 	else
+		return m_pPhysModelBySource[MultiPhysModelSourceV2V];
+}
+
+void MultiPhysModel::BindModels()
+{
+	std::map<QString, CarPhysModel *>::const_iterator iterModel;
+
+	iterModel = m_mapPhysModels.find(MULTIPHYSMODEL_PARAM_V2VMODEL);
+	m_pPhysModelBySource[MultiPhysModelSourceV2V] = iterModel == m_mapPhysModels.end() ? NULL : iterModel->second;
+	iterModel = m_mapPhysModels.find(MULTIPHYSMODEL_PARAM_INFRASTRUCTUREMODEL);
+	m_pPhysModelBySource[MultiPhysModelSourceInfrastructure] = iterModel == m_mapPhysModels.end() ? NULL : iterModel->second;
+}
+
+void MultiPhysModel::LoadInfrastructureNodes()
+{
+	std::map<in_addr_t, InfrastructureNodeModel *> * pNodeRegistry;
+	std::map<in_addr_t, InfrastructureNodeModel *>::iterator iterNode;
+
+	pNodeRegistry = g_pInfrastructureNodeRegistry->acquireLock();
+	m_vecInfrastructureNodes.clear();
+	for (iterNode = pNodeRegistry->begin(); iterNode != pNodeRegistry->end(); ++iterNode)
 	{
-		iterModel = m_mapPhysModels.find(MULTIPHYSMODEL_PARAM_V2VMODEL);
-		if (iterModel != m_mapPhysModels.end())
-			pModel = iterModel->second;
+		if (iterNode->second != NULL)
+			m_vecInfrastructureNodes.push_back(iterNode->first);
 	}
 	g_pInfrastructureNodeRegistry->releaseLock();
-	g_pCarRegistry->releaseLock();
-	return pModel;
 }
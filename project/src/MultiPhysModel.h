@@ -29,6 +29,14 @@
 
 #define MULTIPHYSMODEL_NAME "MultiPhysModel"
 
+// the kinds of transmitters MultiPhysModel picks a physical model for
+typedef enum MultiPhysModelSourceEnum
+{
+	MultiPhysModelSourceV2V = 0,
+	MultiPhysModelSourceInfrastructure,
+	MultiPhysModelSourceNum
+} MultiPhysModelSource;
+
 class MultiPhysModel : public CarPhysModel
 {
 public:
@@ -50,6 +58,8 @@ public:
 
 	virtual MultiPhysModel & operator = (const MultiPhysModel & copy);
 
+	virtual int PreRun();
+
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 	virtual bool DoUpdate(struct timeval tCurrent);
 
@@ -60,15 +70,26 @@ public:
 	virtual bool ReceivePacket(Packet * packet);
 	virtual float GetRXRange(const Packet * packet) const;
 	virtual bool IsCarInRange(const Coords & ptCar, const Coords & ptPosition) const;
+	virtual unsigned int AreCarsInRange(const Coords & ptCar, const Coords * pPositions, unsigned int iCount, unsigned char * pInRange) const;
 	virtual unsigned int GetMessageCount() const;
 	virtual unsigned int GetCollisionCount() const;
 
 protected:
 	virtual CarPhysModel * GetRelevantModel(const Packet * packet);
 	virtual CarPhysModel * GetRelevantModel(const Packet * packet) const;
+	void BindModels();
+	void LoadInfrastructureNodes();
 
 	std::map<QString, CarPhysModel *> m_mapPhysModels;
 	std::map<QString, QString> m_mapPhysModelNames;
+
+	// m_mapPhysModels, resolved once (at Init and PreRun) by transmitter kind
+	CarPhysModel * m_pPhysModelBySource[MultiPhysModelSourceNum];
+	// sorted addresses of the infrastructure nodes, copied from the registry
+	// at PreRun and read-only while running, so packets are classified
+	// without locking; nodes added after PreRun count as vehicles until the
+	// next trial
+	std::vector<in_addr_t> m_vecInfrastructureNodes;
 };
 
 inline Model * MultiPhysModelCreator(const QString & strModelName)
@@ -48,17 +48,6 @@ NetModel & NetModel::operator = (const NetModel & copy)
 	return *this;
 }
 
-QString NetModel::GetCarListColumnText(CarListColumn eColumn) const
-{
-	switch (eColumn)
-	{
-	case CarListColumnType:
-		return "Network";
-	default:
-		return CarModel::GetCarListColumnText(eColumn);
-	}
-}
-
 bool NetModel::IsActive() const
 {
 	return m_tTimestamp + MakeTime(NETWORK_TIMEOUT_SECS, NETWORK_TIMEOUT_USECS) >= GetLastEventTime();
@@ -171,6 +160,8 @@ int NetModel::ProcessEvent(SimEvent & event)
 			}
 		}
 		GetServer()->releaseLock();
+		if (bUpdated)
+			PublishState();
 	}
 	default:
 		return 0;
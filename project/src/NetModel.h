@@ -47,7 +47,10 @@ public:
 
 	virtual NetModel & operator = (const NetModel & copy);
 
-	virtual QString GetCarListColumnText(CarListColumn eColumn) const;
+	inline virtual const char * GetCarListType() const
+	{
+		return "Network";
+	}
 	virtual bool IsActive() const;
 
 	virtual int Init(const std::map<QString, QString> & mapParams);
@@ -0,0 +1,503 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "OSMParser.h"
+
+#include <algorithm>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define OSMPARSER_MAX_ATTRIBUTES 16
+
+typedef struct OSMAttributeStruct
+{
+	const char * pName;
+	unsigned int iNameLength;
+	const char * pValue;
+	unsigned int iValueLength;
+} OSMAttribute;
+
+static inline bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// returns the closing '>' of the tag whose name starts at p, skipping over
+// quoted attribute values, or NULL if the tag is not terminated
+static const char * FindTagEnd(const char * p, const char * pEnd)
+{
+	char cQuote = 0;
+	for (; p < pEnd; ++p)
+	{
+		if (cQuote) {
+			if (*p == cQuote)
+				cQuote = 0;
+		} else if (*p == '"' || *p == '\'')
+			cQuote = *p;
+		else if (*p == '>')
+			return p;
+	}
+	return NULL;
+}
+
+// returns true if the tag name starting at p is exactly szName
+static inline bool IsTag(const char * p, const char * pTagEnd, const char * szName, unsigned int iLength)
+{
+	return p + iLength <= pTagEnd && memcmp(p, szName, iLength) == 0 && (p + iLength == pTagEnd || IsSpace(p[iLength]) || p[iLength] == '/');
+}
+
+static inline bool IsSelfClosing(const char * pTagEnd)
+{
+	return pTagEnd[-1] == '/';
+}
+
+static inline bool Equals(const char * p, unsigned int iLength, const char * szText)
+{
+	return strlen(szText) == iLength && memcmp(p, szText, iLength) == 0;
+}
+
+static inline bool StartsWith(const char * p, unsigned int iLength, const char * szText)
+{
+	unsigned int iTextLength = strlen(szText);
+	return iTextLength <= iLength && memcmp(p, szText, iTextLength) == 0;
+}
+
+// fills pAttributes with the name="value" pairs between p and the end of the
+// tag, returns the number found
+static unsigned int ParseAttributes(const char * p, const char * pTagEnd, OSMAttribute * pAttributes, unsigned int nMax)
+{
+	unsigned int nAttributes = 0;
+	const char * pName;
+	char cQuote;
+
+	// skip the tag name
+	while (p < pTagEnd && !IsSpace(*p))
+		p++;
+	while (p < pTagEnd && nAttributes < nMax)
+	{
+		while (p < pTagEnd && IsSpace(*p))
+			p++;
+		pName = p;
+		while (p < pTagEnd && *p != '=' && !IsSpace(*p))
+			p++;
+		if (p == pName)
+			break;
+		pAttributes[nAttributes].pName = pName;
+		pAttributes[nAttributes].iNameLength = p - pName;
+		while (p < pTagEnd && *p != '"' && *p != '\'')
+			p++;
+		if (p == pTagEnd)
+			break;
+		cQuote = *p++;
+		pAttributes[nAttributes].pValue = p;
+		while (p < pTagEnd && *p != cQuote)
+			p++;
+		pAttributes[nAttributes].iValueLength = p - pAttributes[nAttributes].pValue;
+		nAttributes++;
+		if (p < pTagEnd)
+			p++;
+	}
+	return nAttributes;
+}
+
+static const OSMAttribute * FindAttribute(const OSMAttribute * pAttributes, unsigned int nAttributes, const char * szName)
+{
+	unsigned int i;
+	for (i = 0; i < nAttributes; i++)
+		if (Equals(pAttributes[i].pName, pAttributes[i].iNameLength, szName))
+			return pAttributes + i;
+	return NULL;
+}
+
+static unsigned long ParseID(const OSMAttribute * pAttribute)
+{
+	unsigned long iID = 0;
+	unsigned int i;
+	for (i = 0; i < pAttribute->iValueLength && IsDigit(pAttribute->pValue[i]); i++)
+		iID = iID * 10 + (pAttribute->pValue[i] - '0');
+	return iID;
+}
+
+// converts decimal degrees to TIGER coordinates (millionths of a degree),
+// truncating any further digits
+static long ParseCoordinate(const OSMAttribute * pAttribute)
+{
+	const char * p = pAttribute->pValue, * pEnd = p + pAttribute->iValueLength;
+	long iWhole = 0, iFraction = 0;
+	int nDigits = 0;
+	bool bNegative = false;
+
+	if (p < pEnd && (*p == '-' || *p == '+'))
+		bNegative = *p++ == '-';
+	for (; p < pEnd && IsDigit(*p); p++)
+		iWhole = iWhole * 10 + (*p - '0');
+	if (p < pEnd && *p == '.')
+	{
+		for (p++; p < pEnd && IsDigit(*p); p++)
+		{
+			if (nDigits < 6) {
+				iFraction = iFraction * 10 + (*p - '0');
+				nDigits++;
+			}
+		}
+	}
+	for (; nDigits < 6; nDigits++)
+		iFraction *= 10;
+	iWhole = iWhole * 1000000 + iFraction;
+	return bNegative ? -iWhole : iWhole;
+}
+
+// copies an attribute value, expanding the predefined XML entities
+static std::string DecodeValue(const OSMAttribute * pAttribute)
+{
+	static const char * const szEntities[] = {"&amp;", "&apos;", "&quot;", "&lt;", "&gt;"};
+	static const char cEntities[] = {'&', '\'', '"', '<', '>'};
+	const char * p = pAttribute->pValue, * pEnd = p + pAttribute->iValueLength;
+	std::string strValue;
+	unsigned int i;
+
+	strValue.reserve(pAttribute->iValueLength);
+	while (p < pEnd)
+	{
+		if (*p == '&') {
+			for (i = 0; i < sizeof(cEntities); i++)
+			{
+				if (StartsWith(p, pEnd - p, szEntities[i])) {
+					strValue += cEntities[i];
+					p += strlen(szEntities[i]);
+					break;
+				}
+			}
+			if (i < sizeof(cEntities))
+				continue;
+		}
+		strValue += *p++;
+	}
+	return strValue;
+}
+
+// applies one <tag k="..." v="..."/> of a way; tags are applied in document
+// order, so e.g. oneway only affects a highway type that precedes it
+static void ApplyWayTag(OSMWay * pWay, const OSMAttribute * pKey, const OSMAttribute * pValue)
+{
+	const char * pK = pKey->pValue, * pV = pValue->pValue;
+	unsigned int iKLength = pKey->iValueLength, iVLength = pValue->iValueLength;
+
+	if (StartsWith(pK, iKLength, "tiger:name_base"))
+		pWay->vecNames.push_back(DecodeValue(pValue));
+	else if (StartsWith(pK, iKLength, "tiger:name_type"))
+		pWay->vecTypes.push_back(DecodeValue(pValue));
+	else if (StartsWith(pK, iKLength, "tiger:zip_left"))
+		pWay->vecZips.push_back(std::pair<int, bool>(atoi(DecodeValue(pValue).c_str()), true));
+	else if (StartsWith(pK, iKLength, "tiger:zip_right"))
+		pWay->vecZips.push_back(std::pair<int, bool>(atoi(DecodeValue(pValue).c_str()), false));
+	else if (StartsWith(pK, iKLength, "highway"))
+	{
+		std::string strValue(pV, iVLength);
+		pWay->eRecordType = RecordTypeTwoWaySmallRoad;
+		if (strstr(strValue.c_str(), "residential") || strstr(strValue.c_str(), "trunk") || strstr(strValue.c_str(), "service") || strstr(strValue.c_str(), "tertiary"))
+			pWay->eRecordType = RecordTypeTwoWaySmallRoad;
+		else if (strstr(strValue.c_str(), "motorway"))
+			pWay->eRecordType = RecordTypeTwoWayHighway;
+		else if (strstr(strValue.c_str(), "primary"))
+			pWay->eRecordType = RecordTypeTwoWayPrimary;
+		else if (strstr(strValue.c_str(), "secondary"))
+			pWay->eRecordType = RecordTypeTwoWayLargeRoad;
+		else if (strstr(strValue.c_str(), "pedestrian") || strstr(strValue.c_str(), "living_street") || strstr(strValue.c_str(), "footway"))
+			pWay->eRecordType = RecordTypePedestrian;
+	}
+	else if (Equals(pK, iKLength, "oneway") && Equals(pV, iVLength, "yes"))
+	{
+		switch (pWay->eRecordType)
+		{
+			case RecordTypeTwoWaySmallRoad:
+				pWay->eRecordType = RecordTypeOneWaySmallRoad;
+				break;
+			case RecordTypeTwoWayHighway:
+				pWay->eRecordType = RecordTypeOneWayHighway;
+				break;
+			case RecordTypeTwoWayPrimary:
+				pWay->eRecordType = RecordTypeOneWayPrimary;
+				break;
+			case RecordTypeTwoWayLargeRoad:
+				pWay->eRecordType = RecordTypeOneWayLargeRoad;
+				break;
+			default:
+				break;
+		}
+	}
+	else if (StartsWith(pK, iKLength, "waterway"))
+		pWay->eRecordType = RecordTypeWater;
+	else if (StartsWith(pK, iKLength, "railway"))
+		pWay->bRail = true;
+	else if (StartsWith(pK, iKLength, "boundary"))
+		pWay->eRecordType = RecordTypeInvisibleLandBoundary;
+}
+
+// returns the '<' of the first <node>, <way> or <relation> element at or
+// after p, or pEnd if there is none
+static const char * FindElementStart(const char * p, const char * pEnd)
+{
+	while (p < pEnd && (p = (const char *)memchr(p, '<', pEnd - p)) != NULL)
+	{
+		if (IsTag(p + 1, pEnd, "node", 4) || IsTag(p + 1, pEnd, "way", 3) || IsTag(p + 1, pEnd, "relation", 8))
+			return p;
+		p++;
+	}
+	return pEnd;
+}
+
+OSMChunk::OSMChunk(const char * pBegin, const char * pEnd)
+: QThread(), m_pBegin(pBegin), m_pEnd(pEnd), m_pNodes(NULL)
+{
+}
+
+OSMChunk::~OSMChunk()
+{
+}
+
+void OSMChunk::run()
+{
+	Process();
+}
+
+void OSMChunk::Process()
+{
+	if (m_pNodes == NULL)
+		Parse();
+	else
+		ResolveRefs();
+}
+
+void OSMChunk::Parse()
+{
+	const char * p = m_pBegin, * pTagEnd;
+	OSMAttribute sAttributes[OSMPARSER_MAX_ATTRIBUTES];
+	const OSMAttribute * pID, * pLat, * pLong, * pKey, * pValue;
+	unsigned int nAttributes;
+	OSMWay * pWay = NULL;
+	OSMNode sNode;
+
+	while (p < m_pEnd && (p = (const char *)memchr(p, '<', m_pEnd - p)) != NULL)
+	{
+		p++;
+		pTagEnd = FindTagEnd(p, m_pEnd);
+		if (pTagEnd == NULL)
+			break;
+
+		if (IsTag(p, pTagEnd, "node", 4))
+		{
+			pWay = NULL;
+			nAttributes = ParseAttributes(p, pTagEnd, sAttributes, OSMPARSER_MAX_ATTRIBUTES);
+			pID = FindAttribute(sAttributes, nAttributes, "id");
+			pLat = FindAttribute(sAttributes, nAttributes, "lat");
+			pLong = FindAttribute(sAttributes, nAttributes, "lon");
+			if (pID != NULL && pLat != NULL && pLong != NULL) {
+				sNode.iID = ParseID(pID);
+				sNode.iLat = ParseCoordinate(pLat);
+				sNode.iLong = ParseCoordinate(pLong);
+				m_vecNodes.push_back(sNode);
+			}
+		}
+		else if (IsTag(p, pTagEnd, "way", 3))
+		{
+			pWay = NULL;
+			if (!IsSelfClosing(pTagEnd)) {
+				m_vecWays.push_back(OSMWay());
+				pWay = &m_vecWays.back();
+				pWay->iFirstRef = m_vecRefs.size();
+				pWay->nRefs = 0;
+				pWay->eRecordType = RecordTypeDefault;
+				pWay->bRail = false;
+			}
+		}
+		else if (IsTag(p, pTagEnd, "relation", 8) || IsTag(p, pTagEnd, "/way", 4))
+			pWay = NULL;
+		else if (pWay != NULL)
+		{
+			if (IsTag(p, pTagEnd, "nd", 2)) {
+				nAttributes = ParseAttributes(p, pTagEnd, sAttributes, OSMPARSER_MAX_ATTRIBUTES);
+				pID = FindAttribute(sAttributes, nAttributes, "ref");
+				if (pID != NULL) {
+					m_vecRefs.push_back(ParseID(pID));
+					pWay->nRefs++;
+				}
+			} else if (IsTag(p, pTagEnd, "tag", 3)) {
+				nAttributes = ParseAttributes(p, pTagEnd, sAttributes, OSMPARSER_MAX_ATTRIBUTES);
+				pKey = FindAttribute(sAttributes, nAttributes, "k");
+				pValue = FindAttribute(sAttributes, nAttributes, "v");
+				if (pKey != NULL && pValue != NULL)
+					ApplyWayTag(pWay, pKey, pValue);
+			}
+		}
+		p = pTagEnd + 1;
+	}
+}
+
+void OSMChunk::ResolveRefs()
+{
+	std::vector<OSMNode>::const_iterator iterNode;
+	unsigned int i;
+	OSMNode sKey;
+
+	for (i = 0; i < m_vecRefs.size(); i++)
+	{
+		sKey.iID = m_vecRefs[i];
+		iterNode = std::lower_bound(m_pNodes->begin(), m_pNodes->end(), sKey);
+		if (iterNode != m_pNodes->end() && iterNode->iID == sKey.iID)
+			m_vecRefs[i] = iterNode - m_pNodes->begin();
+		else
+			m_vecRefs[i] = OSMPARSER_INVALID_REF;
+	}
+}
+
+OSMParser::OSMParser()
+{
+}
+
+OSMParser::~OSMParser()
+{
+	Clear();
+}
+
+void OSMParser::Clear()
+{
+	unsigned int i;
+	for (i = 0; i < m_vecChunks.size(); i++)
+		delete m_vecChunks[i];
+	m_vecChunks.clear();
+	std::vector<OSMNode>().swap(m_vecNodes);
+	std::vector<unsigned int>().swap(m_vecRefCounts);
+}
+
+void OSMParser::RunChunks()
+{
+	unsigned int i;
+
+	for (i = 1; i < m_vecChunks.size(); i++)
+		m_vecChunks[i]->start();
+	if (!m_vecChunks.empty())
+		m_vecChunks[0]->Process();
+	for (i = 1; i < m_vecChunks.size(); i++)
+		m_vecChunks[i]->wait();
+}
+
+bool OSMParser::Load(const char * szFilename, unsigned int nThreads)
+{
+	int hFile;
+	struct stat sInfo;
+	const char * pData, * pChunkBegin, * pChunkEnd;
+	size_t iSize;
+	unsigned int nChunks, i, j;
+	long nProcessors;
+	bool bSorted;
+
+	Clear();
+
+	hFile = open(szFilename, O_RDONLY);
+	if (hFile == -1)
+		return true;
+	if (fstat(hFile, &sInfo) != 0) {
+		close(hFile);
+		return true;
+	}
+	iSize = sInfo.st_size;
+	if (iSize == 0) {
+		close(hFile);
+		return false;
+	}
+	pData = (const char *)mmap(NULL, iSize, PROT_READ, MAP_PRIVATE, hFile, 0);
+	if (pData == (const char *)MAP_FAILED) {
+		close(hFile);
+		return true;
+	}
+	madvise((void *)pData, iSize, MADV_SEQUENTIAL);
+
+	if (nThreads == 0) {
+		nProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+		nThreads = nProcessors > 0 ? (unsigned int)nProcessors : 1;
+	}
+	if (nThreads > OSMPARSER_MAX_THREADS)
+		nThreads = OSMPARSER_MAX_THREADS;
+	nChunks = iSize / OSMPARSER_CHUNK_MIN_SIZE;
+	if (nChunks > nThreads)
+		nChunks = nThreads;
+	if (nChunks < 1)
+		nChunks = 1;
+
+	// split at element boundaries so that no <way> straddles two chunks
+	pChunkBegin = pData;
+	for (i = 1; i <= nChunks; i++)
+	{
+		if (i == nChunks)
+			pChunkEnd = pData + iSize;
+		else
+			pChunkEnd = FindElementStart(std::max(pChunkBegin, pData + (size_t)((double)iSize * i / nChunks)), pData + iSize);
+		m_vecChunks.push_back(new OSMChunk(pChunkBegin, pChunkEnd));
+		pChunkBegin = pChunkEnd;
+	}
+	RunChunks();
+
+	munmap((void *)pData, iSize);
+	close(hFile);
+
+	// gather the nodes into one table sorted by ID; extracts are normally
+	// already sorted, so the sort is usually skipped
+	iSize = 0;
+	for (i = 0; i < m_vecChunks.size(); i++)
+		iSize += m_vecChunks[i]->GetNodes().size();
+	m_vecNodes.reserve(iSize);
+	for (i = 0; i < m_vecChunks.size(); i++)
+	{
+		m_vecNodes.insert(m_vecNodes.end(), m_vecChunks[i]->GetNodes().begin(), m_vecChunks[i]->GetNodes().end());
+		std::vector<OSMNode>().swap(m_vecChunks[i]->GetNodes());
+	}
+	bSorted = true;
+	for (i = 1; i < m_vecNodes.size() && bSorted; i++)
+		bSorted = !(m_vecNodes[i] < m_vecNodes[i - 1]);
+	if (!bSorted)
+		std::sort(m_vecNodes.begin(), m_vecNodes.end());
+
+	for (i = 0; i < m_vecChunks.size(); i++)
+		m_vecChunks[i]->SetNodeTable(&m_vecNodes);
+	RunChunks();
+
+	m_vecRefCounts.resize(m_vecNodes.size(), 0);
+	for (i = 0; i < m_vecChunks.size(); i++)
+	{
+		const std::vector<unsigned long> & vecRefs = m_vecChunks[i]->GetRefs();
+		for (j = 0; j < vecRefs.size(); j++)
+			if (vecRefs[j] != OSMPARSER_INVALID_REF)
+				m_vecRefCounts[vecRefs[j]]++;
+	}
+	return false;
+}
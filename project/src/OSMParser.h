@@ -0,0 +1,161 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* OSMParser.h -- streaming reader for OpenStreetMap XML extracts. The file is
+ * memory-mapped once and split at element boundaries into chunks, which are
+ * parsed in parallel. Nodes are kept in a dense table sorted by node ID, and
+ * way node references are resolved against it by binary search, so the whole
+ * import never builds a per-node map.
+ */
+
+#ifndef _OSMPARSER_H
+#define _OSMPARSER_H
+
+#include "MapDB.h"
+
+#include <string>
+#include <vector>
+
+#include <qthread.h>
+
+// files are only split across threads when each chunk would be at least this
+// large (in bytes)
+#define OSMPARSER_CHUNK_MIN_SIZE (8 << 20)
+#define OSMPARSER_MAX_THREADS 16
+// node reference that did not match any node in the file
+#define OSMPARSER_INVALID_REF ((unsigned long)-1)
+
+typedef struct OSMNodeStruct
+{
+	unsigned long iID;
+	long iLong; // TIGER coordinates (millionths of a degree)
+	long iLat;
+} OSMNode;
+
+inline bool operator < (const OSMNode & x, const OSMNode & y)
+{
+	return x.iID < y.iID;
+}
+
+// this data structure holds everything the TIGER processor needs from one
+// <way> element; its node references live in the owning chunk's reference
+// array, starting at iFirstRef
+typedef struct OSMWayStruct
+{
+	std::vector<std::string> vecNames; // tiger:name_base values
+	std::vector<std::string> vecTypes; // tiger:name_type values
+	std::vector<std::pair<int, bool> > vecZips; // ZIP code, true if on left
+	unsigned int iFirstRef;
+	unsigned int nRefs;
+	RecordTypes eRecordType;
+	bool bRail;
+} OSMWay;
+
+class OSMChunk : public QThread
+{
+public:
+	OSMChunk(const char * pBegin, const char * pEnd);
+	virtual ~OSMChunk();
+
+	/*	Parse the chunk, or resolve its node references if a node table is set */
+	void Process();
+	/*	Switch the chunk to resolving references against the given node table */
+	inline void SetNodeTable(const std::vector<OSMNode> * pNodes)
+	{
+		m_pNodes = pNodes;
+	}
+
+	inline std::vector<OSMNode> & GetNodes()
+	{
+		return m_vecNodes;
+	}
+	inline const std::vector<OSMWay> & GetWays() const
+	{
+		return m_vecWays;
+	}
+	inline const std::vector<unsigned long> & GetRefs() const
+	{
+		return m_vecRefs;
+	}
+
+protected:
+	virtual void run();
+
+	void Parse();
+	void ResolveRefs();
+
+	const char * m_pBegin, * m_pEnd;
+	const std::vector<OSMNode> * m_pNodes;
+
+	std::vector<OSMNode> m_vecNodes;
+	std::vector<OSMWay> m_vecWays;
+	// node IDs referenced by the ways, replaced by node table indices (or
+	// OSMPARSER_INVALID_REF) once resolved
+	std::vector<unsigned long> m_vecRefs;
+};
+
+class OSMParser
+{
+public:
+	OSMParser();
+	~OSMParser();
+
+	/*	Free chunks and node table */
+	void Clear();
+
+	/*	Parse an OSM XML file using up to nThreads threads (0 = one per
+		processor), return true on error */
+	bool Load(const char * szFilename, unsigned int nThreads = 0);
+
+	inline unsigned int GetChunkCount() const
+	{
+		return m_vecChunks.size();
+	}
+	inline const OSMChunk * GetChunk(unsigned int iChunk) const
+	{
+		return m_vecChunks[iChunk];
+	}
+	inline unsigned int GetNodeCount() const
+	{
+		return m_vecNodes.size();
+	}
+	inline const OSMNode & GetNode(unsigned long iNode) const
+	{
+		return m_vecNodes[iNode];
+	}
+	/*	Number of way references to the node at index iNode */
+	inline unsigned int GetRefCount(unsigned long iNode) const
+	{
+		return m_vecRefCounts[iNode];
+	}
+
+protected:
+	void RunChunks();
+
+	std::vector<OSMChunk *> m_vecChunks;
+	std::vector<OSMNode> m_vecNodes; // sorted by node ID
+	std::vector<unsigned int> m_vecRefCounts;
+};
+
+#endif
@@ -0,0 +1,184 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "PacketExpiryWheel.h"
+
+PacketExpiryWheel::PacketExpiryWheel()
+: m_iTick(0)
+{
+	unsigned int iLevel;
+
+	for (iLevel = 0; iLevel < PACKETEXPIRYWHEEL_LEVELS; iLevel++)
+		m_iLevelCounts[iLevel] = 0;
+}
+
+PacketExpiryWheel::PacketExpiryWheel(const PacketExpiryWheel & copy)
+: m_mapPackets(copy.m_mapPackets), m_iTick(copy.m_iTick)
+{
+	Rebuild();
+}
+
+PacketExpiryWheel & PacketExpiryWheel::operator = (const PacketExpiryWheel & copy)
+{
+	if (&copy == this)
+		return *this;
+
+	m_mapPackets = copy.m_mapPackets;
+	m_iTick = copy.m_iTick;
+	Rebuild();
+	return *this;
+}
+
+void PacketExpiryWheel::Clear()
+{
+	unsigned int iLevel, iSlot;
+
+	for (iLevel = 0; iLevel < PACKETEXPIRYWHEEL_LEVELS; iLevel++)
+	{
+		for (iSlot = 0; iSlot < PACKETEXPIRYWHEEL_SLOTS; iSlot++)
+			m_vecSlots[iLevel][iSlot].clear();
+		m_iLevelCounts[iLevel] = 0;
+	}
+	m_mapPackets.clear();
+	m_iTick = 0;
+}
+
+bool PacketExpiryWheel::Insert(const PacketSequence & ID, const struct timeval & tExpire)
+{
+	std::pair<PacketMap::iterator, bool> result;
+
+	// an empty wheel may have been left behind by the clock, so bring it
+	// up to date before placing anything relative to it
+	if (m_mapPackets.empty())
+		m_iTick = ToTick(GetCurrentTime());
+
+	result = m_mapPackets.insert(std::pair<PacketSequence, struct timeval>(ID, tExpire));
+	if (result.second)
+		Schedule(result.first);
+	return result.second;
+}
+
+void PacketExpiryWheel::Expire(const struct timeval & tCurrent)
+{
+	unsigned int iTick = ToTick(tCurrent), iLevel, iSpan, iNext, i;
+
+	while ((int)(iTick - m_iTick) > 0)
+	{
+		if (m_iLevelCounts[0] > 0)
+		{
+			// everything in this slot expires before the current tick
+			PacketSlot & vecSlot = m_vecSlots[0][m_iTick & PACKETEXPIRYWHEEL_MASK];
+			for (i = 0; i < vecSlot.size(); i++)
+				m_mapPackets.erase(vecSlot[i]);
+			m_iLevelCounts[0] -= vecSlot.size();
+			vecSlot.clear();
+			m_iTick++;
+		}
+		else
+		{
+			// the lower levels are empty, so skip ahead to the next time the
+			// lowest occupied level has a slot to cascade
+			for (iLevel = 1; iLevel < PACKETEXPIRYWHEEL_LEVELS && m_iLevelCounts[iLevel] == 0; iLevel++);
+			if (iLevel == PACKETEXPIRYWHEEL_LEVELS)
+			{
+				m_iTick = iTick;
+				break;
+			}
+			iSpan = 1 << (PACKETEXPIRYWHEEL_BITS * iLevel);
+			iNext = (m_iTick | (iSpan - 1)) + 1;
+			if ((int)(iNext - iTick) > 0)
+			{
+				m_iTick = iTick;
+				break;
+			}
+			m_iTick = iNext;
+		}
+
+		// at the start of each turn, move the next slot of the level above down
+		for (iLevel = 1; iLevel < PACKETEXPIRYWHEEL_LEVELS && (m_iTick & ((1 << (PACKETEXPIRYWHEEL_BITS * iLevel)) - 1)) == 0; iLevel++)
+			Cascade(iLevel);
+	}
+
+	// the current slot is only partly over, so check each packet in it
+	PacketSlot & vecSlot = m_vecSlots[0][m_iTick & PACKETEXPIRYWHEEL_MASK];
+	i = 0;
+	while (i < vecSlot.size())
+	{
+		if (vecSlot[i]->second <= tCurrent)
+		{
+			m_mapPackets.erase(vecSlot[i]);
+			vecSlot[i] = vecSlot.back();
+			vecSlot.pop_back();
+			m_iLevelCounts[0]--;
+		}
+		else
+			i++;
+	}
+}
+
+void PacketExpiryWheel::Schedule(PacketMap::iterator iterPacket)
+{
+	unsigned int iTick = ToTick(iterPacket->second), iDelta, iLevel;
+
+	// packets already past due go in the current slot
+	if ((int)(iTick - m_iTick) < 0)
+		iTick = m_iTick;
+	iDelta = iTick - m_iTick;
+
+	for (iLevel = 0; iLevel < PACKETEXPIRYWHEEL_LEVELS - 1 && iDelta >= (1u << (PACKETEXPIRYWHEEL_BITS * (iLevel + 1))); iLevel++);
+	// packets beyond the reach of the top level wait in its furthest slot,
+	// and are placed again when that slot is cascaded
+	if (iDelta >= (1u << (PACKETEXPIRYWHEEL_BITS * PACKETEXPIRYWHEEL_LEVELS)))
+		iTick = m_iTick + (1u << (PACKETEXPIRYWHEEL_BITS * PACKETEXPIRYWHEEL_LEVELS)) - 1;
+
+	m_vecSlots[iLevel][(iTick >> (PACKETEXPIRYWHEEL_BITS * iLevel)) & PACKETEXPIRYWHEEL_MASK].push_back(iterPacket);
+	m_iLevelCounts[iLevel]++;
+}
+
+void PacketExpiryWheel::Cascade(unsigned int iLevel)
+{
+	PacketSlot vecSlot;
+	unsigned int i;
+
+	vecSlot.swap(m_vecSlots[iLevel][(m_iTick >> (PACKETEXPIRYWHEEL_BITS * iLevel)) & PACKETEXPIRYWHEEL_MASK]);
+	m_iLevelCounts[iLevel] -= vecSlot.size();
+	for (i = 0; i < vecSlot.size(); i++)
+		Schedule(vecSlot[i]);
+}
+
+// place every packet in the map, after the map has been copied
+void PacketExpiryWheel::Rebuild()
+{
+	PacketMap::iterator iterPacket;
+	unsigned int iLevel, iSlot;
+
+	for (iLevel = 0; iLevel < PACKETEXPIRYWHEEL_LEVELS; iLevel++)
+	{
+		for (iSlot = 0; iSlot < PACKETEXPIRYWHEEL_SLOTS; iSlot++)
+			m_vecSlots[iLevel][iSlot].clear();
+		m_iLevelCounts[iLevel] = 0;
+	}
+	for (iterPacket = m_mapPackets.begin(); iterPacket != m_mapPackets.end(); ++iterPacket)
+		Schedule(iterPacket);
+}
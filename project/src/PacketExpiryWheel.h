@@ -0,0 +1,98 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/* PacketExpiryWheel.h -- the set of packets a link model has already
+ * received, each kept until its lifetime runs out. Besides the lookup by
+ * sequence number, every packet sits in a hierarchical timing wheel slot
+ * chosen by its expiry time, so expiring packets only touches the slots the
+ * clock has moved past instead of every packet still being tracked.
+ */
+
+#ifndef _PACKETEXPIRYWHEEL_H
+#define _PACKETEXPIRYWHEEL_H
+
+#include "Global.h"
+#include "Message.h"
+
+#include <map>
+#include <vector>
+
+// the wheel ticks once per millisecond; each level has 2^PACKETEXPIRYWHEEL_BITS
+// slots and each slot of level n covers a whole turn of level n-1
+#define PACKETEXPIRYWHEEL_LEVELS 4
+#define PACKETEXPIRYWHEEL_BITS 6
+#define PACKETEXPIRYWHEEL_SLOTS (1 << PACKETEXPIRYWHEEL_BITS)
+#define PACKETEXPIRYWHEEL_MASK (PACKETEXPIRYWHEEL_SLOTS - 1)
+
+class PacketExpiryWheel
+{
+public:
+	typedef std::map<PacketSequence, struct timeval> PacketMap;
+
+	PacketExpiryWheel();
+	PacketExpiryWheel(const PacketExpiryWheel & copy);
+
+	PacketExpiryWheel & operator = (const PacketExpiryWheel & copy);
+
+	void Clear();
+	// add a packet that expires at tExpire
+	// returns false if the packet is already present
+	bool Insert(const PacketSequence & ID, const struct timeval & tExpire);
+	// remove every packet whose expiry is no later than tCurrent
+	void Expire(const struct timeval & tCurrent);
+
+	inline bool Contains(const PacketSequence & ID) const
+	{
+		return m_mapPackets.find(ID) != m_mapPackets.end();
+	}
+	inline unsigned int GetCount() const
+	{
+		return m_mapPackets.size();
+	}
+	// each packet's expiry, by sequence number
+	inline const PacketMap & GetPackets() const
+	{
+		return m_mapPackets;
+	}
+
+protected:
+	typedef std::vector<PacketMap::iterator> PacketSlot;
+
+	// ticks wrap around, so they are only ever compared by difference
+	static inline unsigned int ToTick(const struct timeval & t)
+	{
+		return (unsigned int)t.tv_sec * 1000 + (unsigned int)(t.tv_usec / 1000);
+	}
+
+	void Schedule(PacketMap::iterator iterPacket);
+	void Cascade(unsigned int iLevel);
+	void Rebuild();
+
+	PacketMap m_mapPackets;
+	PacketSlot m_vecSlots[PACKETEXPIRYWHEEL_LEVELS][PACKETEXPIRYWHEEL_SLOTS];
+	unsigned int m_iLevelCounts[PACKETEXPIRYWHEEL_LEVELS];
+	// the tick the clock is on; packets in its level 0 slot may still be live
+	unsigned int m_iTick;
+};
+
+#endif
@@ -0,0 +1,133 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "PacketHistory.h"
+
+#include <algorithm>
+
+static inline bool ComparePacketTimeRX(const SafetyPacket & x, const struct timeval & t)
+{
+	return x.m_tRX < t;
+}
+
+static inline bool CompareTimePacketRX(const struct timeval & t, const SafetyPacket & x)
+{
+	return t < x.m_tRX;
+}
+
+PacketHistory::PacketHistory()
+: m_iFirst(0)
+{
+}
+
+void PacketHistory::Clear()
+{
+	m_deqPackets.clear();
+	m_deqTXDistances.clear();
+	m_deqFarthest.clear();
+	m_iFirst = 0;
+}
+
+void PacketHistory::Insert(const SafetyPacket & msg)
+{
+	float fDistance = Distance(msg.m_ptTXPosition, msg.m_ptPosition);
+
+	// the common case is a message newer than everything else
+	if (m_deqPackets.empty() || !(msg.m_tRX < m_deqPackets.back().m_tRX))
+	{
+		m_deqPackets.push_back(msg);
+		m_deqTXDistances.push_back(fDistance);
+		PushFarthest(m_iFirst + m_deqPackets.size() - 1);
+	}
+	else
+	{
+		std::deque<SafetyPacket>::iterator iterPacket = std::upper_bound(m_deqPackets.begin(), m_deqPackets.end(), msg.m_tRX, CompareTimePacketRX);
+		unsigned int iPacket = m_iFirst + (iterPacket - m_deqPackets.begin());
+		m_deqTXDistances.insert(m_deqTXDistances.begin() + (iPacket - m_iFirst), fDistance);
+		m_deqPackets.insert(iterPacket, msg);
+		InsertFarthest(iPacket);
+	}
+}
+
+void PacketHistory::Evict(const struct timeval & tRelevant)
+{
+	while (!m_deqPackets.empty() && m_deqPackets.front().m_tRX < tRelevant)
+	{
+		m_deqPackets.pop_front();
+		m_deqTXDistances.pop_front();
+		if (!m_deqFarthest.empty() && m_deqFarthest.front() == m_iFirst)
+			m_deqFarthest.pop_front();
+		m_iFirst++;
+	}
+}
+
+PacketHistory::const_iterator PacketHistory::LowerBound(const struct timeval & tFrom) const
+{
+	return std::lower_bound(m_deqPackets.begin(), m_deqPackets.end(), tFrom, ComparePacketTimeRX);
+}
+
+float PacketHistory::GetFarthestTX(const struct timeval & tFrom) const
+{
+	unsigned int iPacket = m_iFirst + (LowerBound(tFrom) - m_deqPackets.begin());
+	std::deque<unsigned int>::const_iterator iterFarthest = std::lower_bound(m_deqFarthest.begin(), m_deqFarthest.end(), iPacket);
+
+	// the first stack entry in range is the farthest of all messages in range
+	if (iterFarthest == m_deqFarthest.end())
+		return -1.f;
+	else
+		return m_deqTXDistances[*iterFarthest - m_iFirst];
+}
+
+void PacketHistory::PushFarthest(unsigned int iPacket)
+{
+	float fDistance = m_deqTXDistances[iPacket - m_iFirst];
+
+	// messages no farther than this one can never be the farthest again
+	while (!m_deqFarthest.empty() && m_deqTXDistances[m_deqFarthest.back() - m_iFirst] <= fDistance)
+		m_deqFarthest.pop_back();
+	m_deqFarthest.push_back(iPacket);
+}
+
+// a message received out of order at iPacket shifts the ones after it, so
+// only the stack entries from there on are touched
+void PacketHistory::InsertFarthest(unsigned int iPacket)
+{
+	float fDistance = m_deqTXDistances[iPacket - m_iFirst];
+	std::deque<unsigned int>::iterator iterFarthest = std::lower_bound(m_deqFarthest.begin(), m_deqFarthest.end(), iPacket), iterBegin;
+
+	for (iterBegin = iterFarthest; iterBegin != m_deqFarthest.end(); ++iterBegin)
+		(*iterBegin)++;
+
+	// the first later entry is the farthest of the later messages, and the
+	// new one stays only if it is farther still
+	if (iterFarthest != m_deqFarthest.end() && m_deqTXDistances[*iterFarthest - m_iFirst] >= fDistance)
+		return;
+
+	// earlier messages no farther than this one can never be the farthest again
+	iterBegin = iterFarthest;
+	while (iterBegin != m_deqFarthest.begin() && m_deqTXDistances[*(iterBegin - 1) - m_iFirst] <= fDistance)
+		--iterBegin;
+	iterFarthest = m_deqFarthest.erase(iterBegin, iterFarthest);
+	m_deqFarthest.insert(iterFarthest, iPacket);
+}
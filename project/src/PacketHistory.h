@@ -0,0 +1,93 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/* PacketHistory.h -- the copies of one message a communication model has
+ * overheard, kept in order of reception time. Messages nearly always arrive
+ * in order, so insertion is usually an append, and a late message only moves
+ * the ones received after it; old messages are dropped from the front, and
+ * lookups by time are a binary search. For location-based suppression, the
+ * history also
+ * keeps, for each message, how far its transmitter was from where the
+ * message originated, with a stack of the messages that are the farthest
+ * from there among all later ones, so the farthest rebroadcast since any
+ * time is one binary search away.
+ */
+
+#ifndef _PACKETHISTORY_H
+#define _PACKETHISTORY_H
+
+#include "Message.h"
+
+#include <deque>
+
+class PacketHistory
+{
+public:
+	typedef std::deque<SafetyPacket>::const_iterator const_iterator;
+
+	PacketHistory();
+
+	void Clear();
+	inline unsigned int GetCount() const
+	{
+		return m_deqPackets.size();
+	}
+	inline bool IsEmpty() const
+	{
+		return m_deqPackets.empty();
+	}
+
+	// add a message, keeping the history ordered by reception time
+	void Insert(const SafetyPacket & msg);
+	// drop every message received before tRelevant
+	void Evict(const struct timeval & tRelevant);
+
+	inline const_iterator Begin() const
+	{
+		return m_deqPackets.begin();
+	}
+	inline const_iterator End() const
+	{
+		return m_deqPackets.end();
+	}
+	// the first message received at or after tFrom
+	const_iterator LowerBound(const struct timeval & tFrom) const;
+	// the greatest distance between a message's transmitter and its origin,
+	// over the messages received at or after tFrom, or -1 if there are none
+	float GetFarthestTX(const struct timeval & tFrom) const;
+
+protected:
+	void PushFarthest(unsigned int iPacket);
+	void InsertFarthest(unsigned int iPacket);
+
+	std::deque<SafetyPacket> m_deqPackets;
+	// distance from transmitter to origin, parallel to m_deqPackets
+	std::deque<float> m_deqTXDistances;
+	// the messages farther than every message after them, oldest first, by
+	// position counted from the first message ever inserted
+	std::deque<unsigned int> m_deqFarthest;
+	// the position of m_deqPackets.front() in that count
+	unsigned int m_iFirst;
+};
+
+#endif
@@ -0,0 +1,243 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "ParamSchema.h"
+#include "Simulator.h"
+#include "StringHelp.h"
+#include "SimpleLinkModel.h"
+#include "SimplePhysModel.h"
+#include "CollisionPhysModel.h"
+#include "MultiPhysModel.h"
+#include "SimpleCommModel.h"
+#include "AdaptiveCommModel.h"
+#include "GrooveCommModel.h"
+#include "GPSModel.h"
+#include "SimModel.h"
+#include "TrafficLightModel.h"
+#include "MapVisual.h"
+#include "CarListVisual.h"
+#include "FixedMobilityModel.h"
+#include "StreetSpeedModel.h"
+#include "UniformSpeedModel.h"
+#include "CarFollowingModel.h"
+#include "RandomWalkModel.h"
+#include "DjikstraTripModel.h"
+#include "SightseeingModel.h"
+#include "SimUnconstrainedModel.h"
+#include "RandomWaypointModel.h"
+#include "InfrastructureNodeModel.h"
+
+void GetAllModelParams(std::map<QString, std::map<QString, ModelParameter> > & mapModelParams, std::vector<QString> & vecModelTypes)
+{
+	std::map<QString, std::map<QString, ModelParameter> >::iterator iterModelParam;
+
+	SimpleLinkModel::GetParams(mapModelParams[SIMPLELINKMODEL_NAME]);
+	vecModelTypes.push_back(SIMPLELINKMODEL_NAME);
+	SimplePhysModel::GetParams(mapModelParams[SIMPLEPHYSMODEL_NAME]);
+	vecModelTypes.push_back(SIMPLEPHYSMODEL_NAME);
+	CollisionPhysModel::GetParams(mapModelParams[COLLISIONPHYSMODEL_NAME]);
+	vecModelTypes.push_back(COLLISIONPHYSMODEL_NAME);
+	MultiPhysModel::GetParams(mapModelParams[MULTIPHYSMODEL_NAME]);
+	vecModelTypes.push_back(MULTIPHYSMODEL_NAME);
+	SimpleCommModel::GetParams(mapModelParams[SIMPLECOMMMODEL_NAME]);
+	vecModelTypes.push_back(SIMPLECOMMMODEL_NAME);
+	AdaptiveCommModel::GetParams(mapModelParams[ADAPTIVECOMMMODEL_NAME]);
+	vecModelTypes.push_back(ADAPTIVECOMMMODEL_NAME);
+	GrooveCommModel::GetParams(mapModelParams[GROOVECOMMMODEL_NAME]);
+	vecModelTypes.push_back(GROOVECOMMMODEL_NAME);
+	GPSModel::GetParams(mapModelParams[GPSMODEL_NAME]);
+	vecModelTypes.push_back(GPSMODEL_NAME);
+	SimModel::GetParams(mapModelParams[SIMMODEL_NAME]);
+	vecModelTypes.push_back(SIMMODEL_NAME);
+	FixedMobilityModel::GetParams(mapModelParams[FIXEDMOBILITYMODEL_NAME]);
+	vecModelTypes.push_back(FIXEDMOBILITYMODEL_NAME);
+	StreetSpeedModel::GetParams(mapModelParams[STREETSPEEDMODEL_NAME]);
+	vecModelTypes.push_back(STREETSPEEDMODEL_NAME);
+	UniformSpeedModel::GetParams(mapModelParams[UNIFORMSPEEDMODEL_NAME]);
+	vecModelTypes.push_back(UNIFORMSPEEDMODEL_NAME);
+	CarFollowingModel::GetParams(mapModelParams[CARFOLLOWINGMODEL_NAME]);
+	vecModelTypes.push_back(CARFOLLOWINGMODEL_NAME);
+	RandomWalkModel::GetParams(mapModelParams[RANDOMWALKMODEL_NAME]);
+	vecModelTypes.push_back(RANDOMWALKMODEL_NAME);
+	DjikstraTripModel::GetParams(mapModelParams[DJIKSTRATRIPMODEL_NAME]);
+	vecModelTypes.push_back(DJIKSTRATRIPMODEL_NAME);
+	SightseeingModel::GetParams(mapModelParams[SIGHTSEEINGMODEL_NAME]);
+	vecModelTypes.push_back(SIGHTSEEINGMODEL_NAME);
+	SimUnconstrainedModel::GetParams(mapModelParams[SIMUNCONSTRAINEDMODEL_NAME]);
+	vecModelTypes.push_back(SIMUNCONSTRAINEDMODEL_NAME);
+	RandomWaypointModel::GetParams(mapModelParams[RANDOMWAYPOINTMODEL_NAME]);
+	vecModelTypes.push_back(RANDOMWAYPOINTMODEL_NAME);
+	InfrastructureNodeModel::GetParams(mapModelParams[INFRASTRUCTURENODEMODEL_NAME]);
+	vecModelTypes.push_back(INFRASTRUCTURENODEMODEL_NAME);
+	TrafficLightModel::GetParams(mapModelParams[TRAFFICLIGHTMODEL_NAME]);
+	vecModelTypes.push_back(TRAFFICLIGHTMODEL_NAME);
+	MapVisual::GetParams(mapModelParams[MAPVISUAL_NAME]);
+	vecModelTypes.push_back(MAPVISUAL_NAME);
+	CarListVisual::GetParams(mapModelParams[CARLISTVISUAL_NAME]);
+	vecModelTypes.push_back(CARLISTVISUAL_NAME);
+
+	for (iterModelParam = mapModelParams.begin(); iterModelParam != mapModelParams.end(); ++iterModelParam) {
+		iterModelParam->second[PARAM_DEPENDS].strValue = "";
+		iterModelParam->second[PARAM_DEPENDS].strDesc = "DEPENDS (models) -- A semicolon-delimited list of models upon which this model depends. This is important only for initialization and cleanup, since the event-driven simulator does not resolve dependencies.";
+		iterModelParam->second[PARAM_DEPENDS].eType = ModelParameterTypeModels;
+	}
+}
+
+const ParamValue * ParamBlock::GetValue(const QString & strKey) const
+{
+	unsigned int iIndex = m_pSchema->GetIndex(strKey);
+	return iIndex < m_vecValues.size() ? m_vecValues[iIndex] : NULL;
+}
+
+ParamSchema::ParamSchema(const std::map<QString, ModelParameter> & mapParams)
+{
+	std::map<QString, ModelParameter>::const_iterator iterParam;
+
+	for (iterParam = mapParams.begin(); iterParam != mapParams.end(); ++iterParam)
+	{
+		switch (iterParam->second.eType & ~ModelParameterFixed)
+		{
+			case ModelParameterTypeInt:
+			case ModelParameterTypeFloat:
+			case ModelParameterTypeBool:
+			case ModelParameterTypeYesNo:
+				break;
+			default:
+				// names, addresses and the like are per instance
+				continue;
+		}
+		m_mapIndexes.insert(std::pair<QString, unsigned int>(iterParam->first, m_vecKeys.size()));
+		m_vecKeys.push_back(iterParam->first);
+	}
+	m_vecValues.resize(m_vecKeys.size());
+}
+
+ParamSchema::~ParamSchema()
+{
+	Clear();
+}
+
+unsigned int ParamSchema::GetIndex(const QString & strKey) const
+{
+	std::map<QString, unsigned int>::const_iterator iterIndex = m_mapIndexes.find(strKey);
+	return iterIndex == m_mapIndexes.end() ? (unsigned)-1 : iterIndex->second;
+}
+
+const ParamBlock * ParamSchema::Parse(const std::map<QString, QString> & mapParams)
+{
+	std::map<QString, QString>::const_iterator iterParam;
+	std::map<QString, ParamValue>::iterator iterValue;
+	std::map<std::vector<const ParamValue *>, ParamBlock *>::iterator iterBlock;
+	std::vector<const ParamValue *> vecValues(m_vecKeys.size(), (const ParamValue *)NULL);
+	ParamBlock * pBlock;
+	ParamValue value;
+	unsigned int iIndex;
+
+	for (iterParam = mapParams.begin(); iterParam != mapParams.end(); ++iterParam)
+	{
+		// keys outside the schema are left to the model's own map
+		iIndex = GetIndex(iterParam->first);
+		if (iIndex == (unsigned)-1)
+			continue;
+		iterValue = m_vecValues[iIndex].find(iterParam->second);
+		if (iterValue == m_vecValues[iIndex].end())
+		{
+			value.strValue = iterParam->second;
+			value.fNumber = StringToNumber(value.strValue);
+			value.bBoolean = StringToBoolean(value.strValue);
+			iterValue = m_vecValues[iIndex].insert(std::pair<QString, ParamValue>(iterParam->second, value)).first;
+		}
+		vecValues[iIndex] = &iterValue->second;
+	}
+
+	iterBlock = m_mapBlocks.find(vecValues);
+	if (iterBlock != m_mapBlocks.end())
+		return iterBlock->second;
+
+	pBlock = new ParamBlock;
+	pBlock->m_pSchema = this;
+	pBlock->m_vecValues = vecValues;
+	m_mapBlocks.insert(std::pair<std::vector<const ParamValue *>, ParamBlock *>(vecValues, pBlock));
+	return pBlock;
+}
+
+void ParamSchema::Clear()
+{
+	std::map<std::vector<const ParamValue *>, ParamBlock *>::iterator iterBlock;
+	unsigned int i;
+
+	for (iterBlock = m_mapBlocks.begin(); iterBlock != m_mapBlocks.end(); ++iterBlock)
+		delete iterBlock->second;
+	m_mapBlocks.clear();
+	for (i = 0; i < m_vecValues.size(); i++)
+		m_vecValues[i].clear();
+}
+
+ParamSchemas::ParamSchemas()
+: m_bLoaded(false)
+{
+}
+
+ParamSchemas::~ParamSchemas()
+{
+	std::map<QString, ParamSchema *>::iterator iterSchema;
+
+	for (iterSchema = m_mapSchemas.begin(); iterSchema != m_mapSchemas.end(); ++iterSchema)
+		delete iterSchema->second;
+}
+
+const ParamBlock * ParamSchemas::Parse(const QString & strType, const std::map<QString, QString> & mapParams)
+{
+	std::map<QString, ParamSchema *>::iterator iterSchema;
+	const ParamBlock * pBlock = NULL;
+
+	m_mutexSchemas.lock();
+	if (!m_bLoaded)
+	{
+		// schemas are made for the types listed by the simulation editor
+		std::map<QString, std::map<QString, ModelParameter> > mapModelParams;
+		std::map<QString, std::map<QString, ModelParameter> >::iterator iterModelParams;
+		std::vector<QString> vecModelTypes;
+
+		GetAllModelParams(mapModelParams, vecModelTypes);
+		for (iterModelParams = mapModelParams.begin(); iterModelParams != mapModelParams.end(); ++iterModelParams)
+			m_mapSchemas.insert(std::pair<QString, ParamSchema *>(iterModelParams->first, new ParamSchema(iterModelParams->second)));
+		m_bLoaded = true;
+	}
+	iterSchema = m_mapSchemas.find(strType);
+	if (iterSchema != m_mapSchemas.end())
+		pBlock = iterSchema->second->Parse(mapParams);
+	m_mutexSchemas.unlock();
+	return pBlock;
+}
+
+void ParamSchemas::Clear()
+{
+	std::map<QString, ParamSchema *>::iterator iterSchema;
+
+	m_mutexSchemas.lock();
+	for (iterSchema = m_mapSchemas.begin(); iterSchema != m_mapSchemas.end(); ++iterSchema)
+		iterSchema->second->Clear();
+	m_mutexSchemas.unlock();
+}
@@ -0,0 +1,117 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/* ParamSchema.h -- parsed model parameters. The parameters a model type
+ * declares in its static GetParams form its schema; only the numeric and
+ * boolean ones are part of it. When a model is created, its parameters are
+ * matched against the schema once: every distinct value of a parameter is
+ * parsed to a number and a boolean only the first time it is seen, and
+ * models whose schema parameters are all the same (the sub-models of
+ * identical vehicles, for example) share a single block of parsed values.
+ * TYPE, DEPENDS, model names, addresses and the like differ per instance,
+ * so they stay in the model's own parameter map and do not stop sharing.
+ */
+
+#ifndef _PARAMSCHEMA_H
+#define _PARAMSCHEMA_H
+
+#include "Model.h"
+
+#include <vector>
+#include <qmutex.h>
+
+// fill mapModelParams with the parameters of every model type that can be
+// put in a simulation, and vecModelTypes with the type names in menu order
+void GetAllModelParams(std::map<QString, std::map<QString, ModelParameter> > & mapModelParams, std::vector<QString> & vecModelTypes);
+
+typedef struct ParamValueStruct
+{
+	QString strValue;
+	double fNumber; // as StringToNumber would give it
+	bool bBoolean; // as StringToBoolean would give it
+} ParamValue;
+
+class ParamSchema;
+
+class ParamBlock
+{
+public:
+	// the parsed value of strKey, or NULL if it was not given or is not in
+	// the schema
+	const ParamValue * GetValue(const QString & strKey) const;
+
+protected:
+	const ParamSchema * m_pSchema;
+	std::vector<const ParamValue *> m_vecValues; // by schema index
+
+	friend class ParamSchema;
+};
+
+class ParamSchema
+{
+public:
+	// the schema holds the numeric and boolean parameters of mapParams
+	ParamSchema(const std::map<QString, ModelParameter> & mapParams);
+	~ParamSchema();
+
+	// index of strKey in this schema, or (unsigned)-1
+	unsigned int GetIndex(const QString & strKey) const;
+	const ParamBlock * Parse(const std::map<QString, QString> & mapParams);
+	// forget all values and blocks; blocks already handed out become invalid
+	void Clear();
+
+protected:
+	std::map<QString, unsigned int> m_mapIndexes;
+	std::vector<QString> m_vecKeys;
+	std::vector<std::map<QString, ParamValue> > m_vecValues; // distinct values of each key
+	std::map<std::vector<const ParamValue *>, ParamBlock *> m_mapBlocks;
+
+private:
+	inline ParamSchema(const ParamSchema & copy __attribute__ ((unused)) ) {}
+	inline ParamSchema & operator = (const ParamSchema & copy __attribute__ ((unused)) ) {return *this;}
+};
+
+class ParamSchemas
+{
+public:
+	ParamSchemas();
+	~ParamSchemas();
+
+	// parsed parameters for a new model of type strType, or NULL if the type
+	// has no schema; models given the same schema parameters get the same
+	// block
+	const ParamBlock * Parse(const QString & strType, const std::map<QString, QString> & mapParams);
+	// call once no model uses its block any more
+	void Clear();
+
+protected:
+	std::map<QString, ParamSchema *> m_mapSchemas;
+	bool m_bLoaded;
+	QMutex m_mutexSchemas;
+
+private:
+	inline ParamSchemas(const ParamSchemas & copy __attribute__ ((unused)) ) {}
+	inline ParamSchemas & operator = (const ParamSchemas & copy __attribute__ ((unused)) ) {return *this;}
+};
+
+#endif
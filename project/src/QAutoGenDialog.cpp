@@ -36,6 +36,7 @@
 
 #include "QAutoGenModelDialog.h"
 #include "QFileTableItem.h"
+#include "ScenarioGenerator.h"
 #include "Simulator.h"
 #include "SimModel.h"
 #include "StringHelp.h"
@@ -672,109 +673,16 @@ QString QAutoGenDialog::GetAssocModel(const QString & strParam, const QString &
 
 QString QAutoGenDialog::GetRandomParameter(const QString & strParam, const QString & strValue, const ModelParameter & param)
 {
-	QString strRet;
-	QStringList listRandom = QStringList::split(';', strValue);
-	unsigned int iRandom = RandUInt(0, listRandom.size());
-	int iSep = strValue.find(':');
-	switch (param.eType & 0xF)
-	{
-	case ModelParameterTypeInt:
-		if (iSep > -1)
-			strRet = QString("%1").arg(RandInt((long)StringToNumber(strValue.left(iSep)), (long)StringToNumber(strValue.mid(iSep+1))));
-		else if (!listRandom.empty())
-			strRet = listRandom[iRandom];
-		break;
-	case ModelParameterTypeFloat:
-		if (iSep > -1)
-			strRet = QString("%1").arg(RandDouble(StringToNumber(strValue.left(iSep)), StringToNumber(strValue.mid(iSep+1))));
-		else if (!listRandom.empty())
-			strRet = listRandom[iRandom];
-		break;
-	case ModelParameterTypeAddress:
-		strRet = GetRandomAddress(strParam);
-		break;
-	case ModelParameterTypeAddresses: // TODO: generate random address list
-		if (!listRandom.empty())
-			strRet = listRandom[iRandom];
-		break;
-	case ModelParameterTypeCoords:
-		if (iSep > -1)
-		{
-			Coords ptMin, ptMax;
-			ptMin.FromString(strValue.left(iSep));
-			ptMax.FromString(strValue.mid(iSep+1));
-			strRet = Coords(RandInt(ptMin.m_iLong, ptMax.m_iLong), RandInt(ptMin.m_iLat, ptMax.m_iLat)).ToString();
-		}
-		else if (!listRandom.empty())
-			strRet = listRandom[iRandom];
-		else
-			strRet = GetRandomPosition(strParam);
-		break;
-	default:
-		if (!listRandom.empty())
-			strRet = listRandom[iRandom];
-		break;
-	}
-	return strRet;
-}
-
-QString QAutoGenDialog::GetRandomAddress(const QString & strParam)
-{
-	QString strAddress;
-	Address sAddress;
 	std::map<QString, std::vector<unsigned int> >::iterator iterRecords = m_mapRandomRecords.find(strParam);
 	std::map<QString, Rect>::iterator iterMapSelection = m_mapMapSelections.find(strParam);
-	unsigned int i, iMaxRetries = 3, iRecord, iShapePoint;
-	float fProgress;
-	MapRecord * pRecord;
 
+	// parameters without a region of their own use the shared one
 	if (iterRecords == m_mapRandomRecords.end())
-	{
 		iterRecords = m_mapRandomRecords.find(OTHERADDRESSES);
-		iterMapSelection = m_mapMapSelections.find(OTHERADDRESSES);
-		if (iterRecords == m_mapRandomRecords.end())
-			return strAddress;
-	}
-
-	// choose a random location in this region
-	if (iterRecords->second.empty())
-		return strAddress;
-
-	for (i = 0; i < iMaxRetries; i++)
-	{
-		iRecord = RandUInt(0, iterRecords->second.size());
-		pRecord = g_pMapDB->GetRecord(iterRecords->second[iRecord]);
-		if (pRecord->nShapePoints > 1)
-		{
-			iShapePoint = RandUInt(0, pRecord->nShapePoints - 1);
-			fProgress = (float)RandDouble(0., 1.);
-			if (g_pMapDB->AddressFromRecord(&sAddress, iterRecords->second[iRecord], iShapePoint, fProgress))
-			{
-				strAddress = AddressToString(&sAddress);
-				if (StringToAddress(strAddress, &sAddress) && sAddress.iRecord != (unsigned)-1 && iterMapSelection->second.intersectRect(pRecord->rBounds))
-					break;
-			}
-		}
-	}
-	return strAddress;
-}
-
-QString QAutoGenDialog::GetRandomPosition(const QString & strParam)
-{
-	QString strAddress;
-	Address sAddress;
-	std::map<QString, Rect>::iterator iterMapSelection = m_mapMapSelections.find(strParam);
-
-
-	// choose a random location in this region
 	if (iterMapSelection == m_mapMapSelections.end())
-	{
 		iterMapSelection = m_mapMapSelections.find(OTHERADDRESSES);
-		if (iterMapSelection == m_mapMapSelections.end())
-			return "";
-	}
 
-	return Coords(RandInt(iterMapSelection->second.m_iLeft, iterMapSelection->second.m_iRight), RandInt(iterMapSelection->second.m_iBottom, iterMapSelection->second.m_iTop)).ToString();
+	return ScenarioGenerator::GetRandomParameter(strValue, param, iterRecords == m_mapRandomRecords.end() ? NULL : &iterRecords->second, iterMapSelection == m_mapMapSelections.end() ? NULL : &iterMapSelection->second);
 }
 
 QString QAutoGenDialog::GetFileParameter(const QString & strParam, const QString & strFilename, unsigned int iVehicle)
@@ -90,8 +90,6 @@ protected:
 	QString GetAssocModel(const QString & strParam, const QString & strType, std::map<QString, QString> & mapAssocModels, const std::map<QString, QString> & mapAssocModelTypes, std::map<QString, std::map<QString, AutoGenParameter> > & mapAssocParams, unsigned int iVehicle);
 	QString GetRandomParameter(const QString & strParam, const QString & strValue, const ModelParameter & param);
 	QString GetFileParameter(const QString & strParam, const QString & strFilename, unsigned int iVehicle);
-	QString GetRandomAddress(const QString & strParam);
-	QString GetRandomPosition(const QString & strParam);
 
 	QMapWidget * m_pMap;
 	QLabel * m_labelRegionInfo;
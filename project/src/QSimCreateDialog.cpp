@@ -37,29 +37,10 @@
 
 #include "QSimCreateDialog.h"
 #include "QAutoGenDialog.h"
+#include "ParamSchema.h"
 #include "Simulator.h"
 #include "StringHelp.h"
-#include "SimpleLinkModel.h"
-#include "SimplePhysModel.h"
-#include "CollisionPhysModel.h"
-#include "MultiPhysModel.h"
-#include "SimpleCommModel.h"
-#include "AdaptiveCommModel.h"
-#include "GrooveCommModel.h"
-#include "GPSModel.h"
-#include "SimModel.h"
-#include "TrafficLightModel.h"
-#include "MapVisual.h"
-#include "CarListVisual.h"
-#include "FixedMobilityModel.h"
-#include "StreetSpeedModel.h"
-#include "UniformSpeedModel.h"
-#include "CarFollowingModel.h"
-#include "RandomWalkModel.h"
-#include "DjikstraTripModel.h"
-#include "SightseeingModel.h"
-#include "SimUnconstrainedModel.h"
-#include "RandomWaypointModel.h"
+#include "CarModel.h"
 #include "InfrastructureNodeModel.h"
 
 #include <qlayout.h>
@@ -71,7 +52,6 @@ QSimCreateDialog::QSimCreateDialog(QWidget * parent, const char * name, bool mod
 : QDialog(parent, name, modal, f)
 {
 	unsigned int i;
-	std::map<QString, std::map<QString, ModelParameter> >::iterator iterModelParam;
 
 	QWidget * pButtonBox = new QWidget(this);
 	QWidget * pTabVehicles = new QWidget(this);
@@ -117,56 +97,7 @@ QSimCreateDialog::QSimCreateDialog(QWidget * parent, const char * name, bool mod
 	QHBoxLayout * pModelButtonsLayout = new QHBoxLayout(pModelButtons, 0, 8);
 	QHBoxLayout * pButtonBoxLayout = new QHBoxLayout(pButtonBox, 0, 8);
 
-	SimpleLinkModel::GetParams(m_mapModelParams[SIMPLELINKMODEL_NAME]);
-	m_vecModelTypes.push_back(SIMPLELINKMODEL_NAME);
-	SimplePhysModel::GetParams(m_mapModelParams[SIMPLEPHYSMODEL_NAME]);
-	m_vecModelTypes.push_back(SIMPLEPHYSMODEL_NAME);
-	CollisionPhysModel::GetParams(m_mapModelParams[COLLISIONPHYSMODEL_NAME]);
-	m_vecModelTypes.push_back(COLLISIONPHYSMODEL_NAME);
-	MultiPhysModel::GetParams(m_mapModelParams[MULTIPHYSMODEL_NAME]);
-	m_vecModelTypes.push_back(MULTIPHYSMODEL_NAME);
-	SimpleCommModel::GetParams(m_mapModelParams[SIMPLECOMMMODEL_NAME]);
-	m_vecModelTypes.push_back(SIMPLECOMMMODEL_NAME);
-	AdaptiveCommModel::GetParams(m_mapModelParams[ADAPTIVECOMMMODEL_NAME]);
-	m_vecModelTypes.push_back(ADAPTIVECOMMMODEL_NAME);
-	GrooveCommModel::GetParams(m_mapModelParams[GROOVECOMMMODEL_NAME]);
-	m_vecModelTypes.push_back(GROOVECOMMMODEL_NAME);
-	GPSModel::GetParams(m_mapModelParams[GPSMODEL_NAME]);
-	m_vecModelTypes.push_back(GPSMODEL_NAME);
-	SimModel::GetParams(m_mapModelParams[SIMMODEL_NAME]);
-	m_vecModelTypes.push_back(SIMMODEL_NAME);
-	FixedMobilityModel::GetParams(m_mapModelParams[FIXEDMOBILITYMODEL_NAME]);
-	m_vecModelTypes.push_back(FIXEDMOBILITYMODEL_NAME);
-	StreetSpeedModel::GetParams(m_mapModelParams[STREETSPEEDMODEL_NAME]);
-	m_vecModelTypes.push_back(STREETSPEEDMODEL_NAME);
-	UniformSpeedModel::GetParams(m_mapModelParams[UNIFORMSPEEDMODEL_NAME]);
-	m_vecModelTypes.push_back(UNIFORMSPEEDMODEL_NAME);
-	CarFollowingModel::GetParams(m_mapModelParams[CARFOLLOWINGMODEL_NAME]);
-	m_vecModelTypes.push_back(CARFOLLOWINGMODEL_NAME);
-	RandomWalkModel::GetParams(m_mapModelParams[RANDOMWALKMODEL_NAME]);
-	m_vecModelTypes.push_back(RANDOMWALKMODEL_NAME);
-	DjikstraTripModel::GetParams(m_mapModelParams[DJIKSTRATRIPMODEL_NAME]);
-	m_vecModelTypes.push_back(DJIKSTRATRIPMODEL_NAME);
-	SightseeingModel::GetParams(m_mapModelParams[SIGHTSEEINGMODEL_NAME]);
-	m_vecModelTypes.push_back(SIGHTSEEINGMODEL_NAME);
-	SimUnconstrainedModel::GetParams(m_mapModelParams[SIMUNCONSTRAINEDMODEL_NAME]);
-	m_vecModelTypes.push_back(SIMUNCONSTRAINEDMODEL_NAME);
-	RandomWaypointModel::GetParams(m_mapModelParams[RANDOMWAYPOINTMODEL_NAME]);
-	m_vecModelTypes.push_back(RANDOMWAYPOINTMODEL_NAME);
-	InfrastructureNodeModel::GetParams(m_mapModelParams[INFRASTRUCTURENODEMODEL_NAME]);
-	m_vecModelTypes.push_back(INFRASTRUCTURENODEMODEL_NAME);
-	TrafficLightModel::GetParams(m_mapModelParams[TRAFFICLIGHTMODEL_NAME]);
-	m_vecModelTypes.push_back(TRAFFICLIGHTMODEL_NAME);
-	MapVisual::GetParams(m_mapModelParams[MAPVISUAL_NAME]);
-	m_vecModelTypes.push_back(MAPVISUAL_NAME);
-	CarListVisual::GetParams(m_mapModelParams[CARLISTVISUAL_NAME]);
-	m_vecModelTypes.push_back(CARLISTVISUAL_NAME);
-
-	for (iterModelParam = m_mapModelParams.begin(); iterModelParam != m_mapModelParams.end(); ++iterModelParam) {
-		iterModelParam->second[PARAM_DEPENDS].strValue = "";
-		iterModelParam->second[PARAM_DEPENDS].strDesc = "DEPENDS (models) -- A semicolon-delimited list of models upon which this model depends. This is important only for initialization and cleanup, since the event-driven simulator does not resolve dependencies.";
-		iterModelParam->second[PARAM_DEPENDS].eType = ModelParameterTypeModels;
-	}
+	GetAllModelParams(m_mapModelParams, m_vecModelTypes);
 
 	setCaption("GrooveNet - Create New Simulation...");
 	setIcon(app16x16_xpm);
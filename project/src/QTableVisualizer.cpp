@@ -22,6 +22,8 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <qpainter.h>
+
 #include "QTableVisualizer.h"
 
 QDraggingTable::QDraggingTable(QWidget * parent, const char * name)
@@ -38,6 +40,27 @@ QDraggingTable::~QDraggingTable()
 {
 }
 
+void QDraggingTable::paintCell(QPainter * p, int row, int col, const QRect & cr, bool selected, const QColorGroup & cg)
+{
+	QString strText;
+
+	QTable::paintCell(p, row, col, cr, selected, cg);
+	if (m_pTableVisualizer != NULL && m_pTableVisualizer->tableCellText(row, col, strText))
+	{
+		p->setPen(selected ? cg.highlightedText() : cg.text());
+		p->drawText(2, 0, cr.width() - 4, cr.height(), Qt::AlignLeft | Qt::AlignVCenter, strText);
+	}
+}
+
+QString QDraggingTable::text(int row, int col) const
+{
+	QString strText;
+
+	if (m_pTableVisualizer != NULL && m_pTableVisualizer->tableCellText(row, col, strText))
+		return strText;
+	return QTable::text(row, col);
+}
+
 
 QTableVisualizer::QTableVisualizer(TableVisualizer * pVisualizer, QWidget * parent, const char * name, Qt::WFlags f)
 : QVisualizer(pVisualizer, parent, name, f)
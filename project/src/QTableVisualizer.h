@@ -53,6 +53,9 @@ public:
 		return m_pfnDragObjectCreator;
 	}
 
+	virtual void paintCell(QPainter * p, int row, int col, const QRect & cr, bool selected, const QColorGroup & cg);
+	virtual QString text(int row, int col) const;
+
 protected:
 	inline virtual QDragObject * dragObject()
 	{
@@ -23,6 +23,8 @@
  ***************************************************************************/
 
 #include "RandomWalkModel.h"
+#include "SimCheckpoint.h"
+#include "Simulator.h"
 
 #define RANDOMWALKMODEL_START_PARAM "START"
 #define RANDOMWALKMODEL_START_PARAM_DEFAULT ""
@@ -98,136 +100,106 @@ short RandomWalkModel::GetCurrentDirection() const
 	if (m_iCurrentRecord == (unsigned)-1 || m_iCRShapePoint == (unsigned)-1)
 		return 0;
 
-	MapRecord * pRecord = g_pMapDB->GetRecord(m_iCurrentRecord);
-
-	if ((signed)m_iCRShapePoint < pRecord->nShapePoints - 1)
-	{
-		Coords c0 = pRecord->pShapePoints[m_iCRShapePoint], c1 = pRecord->pShapePoints[m_iCRShapePoint + 1];
-
-		if (m_bForwards)
-			return (short)round(atan2(c1.m_iLong - c0.m_iLong, c1.m_iLat - c0.m_iLat) * CENTIDEGREESPERRADIAN);
-		else
-			return (short)round(atan2(c0.m_iLong - c1.m_iLong, c0.m_iLat - c1.m_iLat) * CENTIDEGREESPERRADIAN);
-	}
-	else
-		return 0;
+	return g_pMapDB->GetSegmentHeading(m_iCurrentRecord, m_iCRShapePoint, m_bForwards);
 }
 
-bool RandomWalkModel::SetProgress(float & fTime, short iSpeed, unsigned int & iNextRecord)
+bool RandomWalkModel::SetProgress(struct timeval tCurrent, float & fTime, short iSpeed, unsigned int & iNextRecord)
 {
 	if (m_iCurrentRecord == (unsigned)-1 || m_iCRShapePoint == (unsigned)-1)
 		return false;
 
-	// find distance to next shape point
+	// move along the record, up to its end
 	MapRecord * pRecord = g_pMapDB->GetRecord(m_iCurrentRecord);
-	float fRemaining = 0.f, fPart = 0.f, fDistance = (fTime * iSpeed) / SECSPERHOUR;
-
-	if ((signed)m_iCRShapePoint < pRecord->nShapePoints - 1)
-	{
-		Coords c0 = pRecord->pShapePoints[m_iCRShapePoint], c1 = pRecord->pShapePoints[m_iCRShapePoint + 1];
+	float fRemaining, fDistance = (fTime * iSpeed) / SECSPERHOUR;
 
-		fPart = Distance(c0, c1);
-		if (m_bForwards)
-			fRemaining = fPart * (1 - m_fCRProgress);
-		else
-			fRemaining = fPart * m_fCRProgress;
-	}
+	fRemaining = AdvanceAlongRecord(fDistance, m_bForwards ? g_pMapDB->GetRecordLength(m_iCurrentRecord) : 0.f);
 
-	if (fDistance < fRemaining && fPart > 0.f)
+	if (fDistance < fRemaining)
 	{
-		// we're still on the same part of the record
-		if (m_bForwards)
-			m_fCRProgress += fDistance / fPart;
-		else
-			m_fCRProgress -= fDistance / fPart;
+		// we're still on the same record
 		fTime = 0.f;
 	}
 	else
 	{
-		// we've passed the end of this shape point
+		// we've passed the end of this record
 		if (iSpeed > 0)
 			fTime -= (fRemaining * SECSPERHOUR) / iSpeed;
 		else
 			fTime = 0.f;
 		if (m_bForwards) {
-			if ((signed)m_iCRShapePoint < pRecord->nShapePoints - 1)
-			{
-				m_iCRShapePoint++;
-				m_fCRProgress = 0.f;
-//				return SetProgress(fTime, iSpeed, iNextRecord);
-				return true;
-			}
-			else
+			// check to see if we're stopped for a traffic light
+			if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[pRecord->nVertices - 1]), m_iCurrentRecord, tCurrent))
 			{
-				// check to see if we're stopped for a traffic light
-				if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[pRecord->nVertices - 1]), m_iCurrentRecord))
+				// go to next record and return with the unused time
+				iNextRecord = GetNextRecord(pRecord->pVertices[pRecord->nVertices - 1], m_iCurrentRecord);
+				if (iNextRecord != (unsigned)-1)
 				{
-					// go to next record and return with the unused time
-					iNextRecord = GetNextRecord(pRecord->pVertices[pRecord->nVertices - 1], m_iCurrentRecord);
-					if (iNextRecord != (unsigned)-1)
-					{
-						m_iCurrentRecord = iNextRecord;
-						if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[pRecord->nVertices - 1]) {
-							m_bForwards = true;
-							m_iCRShapePoint = 0;
-							m_fCRProgress = 0.f;
-						} else {
-							m_bForwards = false;
-							m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
-							m_fCRProgress = 0.f;
-						}
-						return true;
+					m_iCurrentRecord = iNextRecord;
+					if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[pRecord->nVertices - 1]) {
+						m_bForwards = true;
+						m_iCRShapePoint = 0;
+						m_fCRProgress = 0.f;
+					} else {
+						m_bForwards = false;
+						m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
+						m_fCRProgress = 0.f;
 					}
-				}
-				else
-				{
-					// we're stopped here!
-					fTime = 0.f;
-					m_fCRProgress = 1.f;
+					return true;
 				}
 			}
-		} else {
-			if (m_iCRShapePoint > 0)
+			else
 			{
-				m_iCRShapePoint--;
-				m_fCRProgress = 1.f;
-//				return SetProgress(fTime, iSpeed, iNextRecord);
-				return true;
+				// we're stopped here!
+				fTime = 0.f;
 			}
-			else
+		} else {
+			// check to see if we're stopped for a traffic light
+			if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[0]), m_iCurrentRecord, tCurrent))
 			{
-				// check to see if we're stopped for a traffic light
-				if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[0]), m_iCurrentRecord))
+				// go to next record
+				iNextRecord = GetNextRecord(pRecord->pVertices[0], m_iCurrentRecord);
+				if (iNextRecord != (unsigned)-1)
 				{
-					// go to next record
-					iNextRecord = GetNextRecord(pRecord->pVertices[0], m_iCurrentRecord);
-					if (iNextRecord != (unsigned)-1)
-					{
-						m_iCurrentRecord = iNextRecord;
-						if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[0]) {
-							m_bForwards = true;
-							m_iCRShapePoint = 0;
-							m_fCRProgress = 0.f;
-						} else {
-							m_bForwards = false;
-							m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
-							m_fCRProgress = 0.f;
-						}
-						return true;
+					m_iCurrentRecord = iNextRecord;
+					if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[0]) {
+						m_bForwards = true;
+						m_iCRShapePoint = 0;
+						m_fCRProgress = 0.f;
+					} else {
+						m_bForwards = false;
+						m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
+						m_fCRProgress = 0.f;
 					}
+					return true;
 				}
-				else
-				{
-					// we're stopped here!
-					fTime = 0.f;
-					m_fCRProgress = 0.f;
-				}
+			}
+			else
+			{
+				// we're stopped here!
+				fTime = 0.f;
 			}
 		}
 	}
 	return false;
 }
 
+float RandomWalkModel::AdvanceAlongRecord(float fDistance, float fEnd)
+{
+	// moves up to fDistance towards fEnd (a distance along the current record),
+	// and returns how far away fEnd was
+	float fPosition = g_pMapDB->DistanceAlongRecord(m_iCurrentRecord, m_iCRShapePoint, m_fCRProgress);
+	float fRemaining = m_bForwards ? fEnd - fPosition : fPosition - fEnd;
+
+	if (fRemaining < 0.f)
+		fRemaining = 0.f;
+	if (fDistance < fRemaining)
+		fPosition += m_bForwards ? fDistance : -fDistance;
+	else
+		fPosition = fEnd;
+	g_pMapDB->DistanceToPosition(m_iCurrentRecord, fPosition, m_iCRShapePoint, m_fCRProgress);
+	return fRemaining;
+}
+
 unsigned int RandomWalkModel::GetNextRecord(unsigned int iVertex, unsigned int iPrevRecord)
 {
 	std::vector<unsigned int> vecRecords;
@@ -288,6 +260,28 @@ int RandomWalkModel::Save(std::map<QString, QString> & mapParams)
 	return 0;
 }
 
+int RandomWalkModel::SaveState(CheckpointWriter & writer)
+{
+	if (SimTripModel::SaveState(writer))
+		return 1;
+
+	writer.WriteUInt(m_iCurrentRecord);
+	writer.WriteUInt(m_iCRShapePoint);
+	writer.WriteFloat(m_fCRProgress);
+	writer.WriteBool(m_bForwards);
+	return 0;
+}
+
+int RandomWalkModel::LoadState(CheckpointReader & reader)
+{
+	if (SimTripModel::LoadState(reader))
+		return 1;
+
+	if (!reader.ReadUInt(m_iCurrentRecord) || !reader.ReadUInt(m_iCRShapePoint) || !reader.ReadFloat(m_fCRProgress) || !reader.ReadBool(m_bForwards))
+		return 2;
+	return 0;
+}
+
 void RandomWalkModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 {
 	SimTripModel::GetParams(mapParams);
@@ -54,6 +54,8 @@ public:
 	virtual int Init(const std::map<QString, QString> & mapParams);
 	virtual int PreRun();
 	virtual int Save(std::map<QString, QString> & mapParams);
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 	virtual int Cleanup();
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
@@ -65,11 +67,12 @@ public:
 	virtual Coords GetCurrentPosition() const;
 	virtual short GetCurrentDirection() const;
 
-	virtual bool SetProgress(float & fTime, short iSpeed, unsigned int & iNextRecord);
+	virtual bool SetProgress(struct timeval tCurrent, float & fTime, short iSpeed, unsigned int & iNextRecord);
 
 protected:
 	virtual unsigned int GetNextRecord(unsigned int iVertex, unsigned int iPrevRecord);
 	virtual unsigned int ChooseRandomRecord(const std::vector<unsigned int> & vecRecords, unsigned int iPrevRecord);
+	float AdvanceAlongRecord(float fDistance, float fEnd);
 
 	unsigned int m_iCurrentRecord;
 	unsigned int m_iCRShapePoint;
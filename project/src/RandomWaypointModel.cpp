@@ -23,6 +23,7 @@
  ***************************************************************************/
 
 #include "RandomWaypointModel.h"
+#include "SimCheckpoint.h"
 #include "StringHelp.h"
 
 #define RANDOMWAYPOINTMODEL_START_PARAM "START"
@@ -78,14 +79,11 @@ int RandomWaypointModel::Init(const std::map<QString, QString> & mapParams)
 		return 2;
 	}
 
-	strValue = GetParam(mapParams, RANDOMWAYPOINTMODEL_LOWSPEED_PARAM, RANDOMWAYPOINTMODEL_LOWSPEED_PARAM_DEFAULT);
-	m_iLowSpeed = (short)ValidateNumber(StringToNumber(strValue), 0, 1000);
+	m_iLowSpeed = (short)ValidateNumber(GetNumberParam(mapParams, RANDOMWAYPOINTMODEL_LOWSPEED_PARAM, RANDOMWAYPOINTMODEL_LOWSPEED_PARAM_DEFAULT), 0, 1000);
 
-	strValue = GetParam(mapParams, RANDOMWAYPOINTMODEL_HIGHSPEED_PARAM, RANDOMWAYPOINTMODEL_HIGHSPEED_PARAM_DEFAULT);
-	m_iHighSpeed = (short)ValidateNumber(StringToNumber(strValue), m_iLowSpeed, 1000);
+	m_iHighSpeed = (short)ValidateNumber(GetNumberParam(mapParams, RANDOMWAYPOINTMODEL_HIGHSPEED_PARAM, RANDOMWAYPOINTMODEL_HIGHSPEED_PARAM_DEFAULT), m_iLowSpeed, 1000);
 
-	strValue = GetParam(mapParams, RANDOMWAYPOINTMODEL_INTERVAL_PARAM, RANDOMWAYPOINTMODEL_INTERVAL_PARAM_DEFAULT);
-	m_tInterval = MakeTime(ValidateNumber(StringToNumber(strValue), 0, 1000));
+	m_tInterval = MakeTime(ValidateNumber(GetNumberParam(mapParams, RANDOMWAYPOINTMODEL_INTERVAL_PARAM, RANDOMWAYPOINTMODEL_INTERVAL_PARAM_DEFAULT), 0, 1000));
 	return 0;
 }
 
@@ -103,6 +101,25 @@ int RandomWaypointModel::Save(std::map<QString, QString> & mapParams)
 	return 0;
 }
 
+int RandomWaypointModel::SaveState(CheckpointWriter & writer)
+{
+	if (SimUnconstrainedMobilityModel::SaveState(writer))
+		return 1;
+
+	writer.WriteFloat(m_fProgress);
+	return 0;
+}
+
+int RandomWaypointModel::LoadState(CheckpointReader & reader)
+{
+	if (SimUnconstrainedMobilityModel::LoadState(reader))
+		return 1;
+
+	if (!reader.ReadFloat(m_fProgress))
+		return 2;
+	return 0;
+}
+
 void RandomWaypointModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 {
 	SimUnconstrainedMobilityModel::GetParams(mapParams);
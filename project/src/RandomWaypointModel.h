@@ -54,6 +54,8 @@ public:
 	virtual int Init(const std::map<QString, QString> & mapParams);
 	virtual int PreRun();
 	virtual int Save(std::map<QString, QString> & mapParams);
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
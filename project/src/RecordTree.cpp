@@ -0,0 +1,247 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "RecordTree.h"
+
+#include <math.h>
+#include <algorithm>
+#include <queue>
+
+// Coords::Flatten works in single precision, so flattened coordinates can be
+// off by a few tens of TIGER units; lower bounds are loosened by this much
+#define RECORDTREE_FLATTEN_SLACK 64.
+
+// position of (x, y) along a Hilbert curve through a 65536 x 65536 grid
+static unsigned int HilbertIndex(unsigned int x, unsigned int y)
+{
+	unsigned int rx, ry, s, t, d = 0;
+
+	for (s = 1 << 15; s > 0; s >>= 1)
+	{
+		rx = (x & s) ? 1 : 0;
+		ry = (y & s) ? 1 : 0;
+		d += s * s * ((3 * rx) ^ ry);
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				x = 0xffff - x;
+				y = 0xffff - y;
+			}
+			t = x;
+			x = y;
+			y = t;
+		}
+	}
+	return d;
+}
+
+// a lower bound on PointRecordDistance from pt (flattened as ptFlat) to any
+// record inside r
+static float BoundDistance(const Coords & pt, const Coords & ptFlat, const Rect & r)
+{
+	double fCosTop = cos(r.m_iTop * RADIANSPERTIGERDEGREE), fCosBottom = cos(r.m_iBottom * RADIANSPERTIGERDEGREE);
+	double fCosMin = fCosTop < fCosBottom ? fCosTop : fCosBottom;
+	double fCosMax = r.m_iBottom <= 0 && r.m_iTop >= 0 ? 1. : (fCosTop > fCosBottom ? fCosTop : fCosBottom);
+	double fLeft, fRight, dx = 0., dy = 0.;
+
+	// the flattened longitudes of points in r lie between these
+	fLeft = r.m_iLeft < 0 ? r.m_iLeft * fCosMax : r.m_iLeft * fCosMin;
+	fRight = r.m_iRight < 0 ? r.m_iRight * fCosMin : r.m_iRight * fCosMax;
+
+	if (ptFlat.m_iLong < fLeft)
+		dx = fLeft - ptFlat.m_iLong;
+	else if (ptFlat.m_iLong > fRight)
+		dx = ptFlat.m_iLong - fRight;
+	dx = dx > RECORDTREE_FLATTEN_SLACK ? dx - RECORDTREE_FLATTEN_SLACK : 0.;
+
+	if (pt.m_iLat < r.m_iBottom)
+		dy = r.m_iBottom - pt.m_iLat;
+	else if (pt.m_iLat > r.m_iTop)
+		dy = pt.m_iLat - r.m_iTop;
+
+	return (float)(dx * dx + dy * dy);
+}
+
+typedef struct RecordTreeQueueEntryStruct
+{
+	float fBound;
+	unsigned int iLevel;
+	unsigned int iNode;
+} RecordTreeQueueEntry;
+
+inline bool operator > (const RecordTreeQueueEntry & x, const RecordTreeQueueEntry & y)
+{
+	return x.fBound > y.fBound;
+}
+
+RecordTree::RecordTree()
+: m_rBounds(0, 0, 0, 0)
+{
+}
+
+void RecordTree::Clear()
+{
+	std::vector<Rect>().swap(m_vecBounds);
+	std::vector<unsigned int>().swap(m_vecLevelOffsets);
+	std::vector<unsigned int>().swap(m_vecRecords);
+	m_rBounds = Rect(0, 0, 0, 0);
+}
+
+void RecordTree::Build(const MapRecord * pRecords, unsigned int iBegin, unsigned int iEnd)
+{
+	std::vector<std::pair<unsigned int, unsigned int> > vecOrder;
+	unsigned int i, iLevel, iChild, nChildren, nNodes;
+	double fWidth, fHeight;
+	long x, y;
+
+	Clear();
+
+	// records without a segment can never be the closest record, and have
+	// no meaningful bounds, so they are left out
+	for (i = iBegin; i < iEnd; i++)
+	{
+		if (pRecords[i].nShapePoints < 2)
+			continue;
+		m_rBounds = vecOrder.empty() ? pRecords[i].rBounds : m_rBounds.unionRect(pRecords[i].rBounds);
+		vecOrder.push_back(std::pair<unsigned int, unsigned int>(0, i));
+	}
+	if (vecOrder.empty())
+		return;
+	fWidth = (double)m_rBounds.m_iRight - m_rBounds.m_iLeft + 1;
+	fHeight = (double)m_rBounds.m_iTop - m_rBounds.m_iBottom + 1;
+
+	// order the records along a Hilbert curve through their centers
+	for (i = 0; i < vecOrder.size(); i++)
+	{
+		const Rect & rRecord = pRecords[vecOrder[i].second].rBounds;
+		x = (rRecord.m_iLeft + rRecord.m_iRight) / 2 - m_rBounds.m_iLeft;
+		y = (rRecord.m_iBottom + rRecord.m_iTop) / 2 - m_rBounds.m_iBottom;
+		vecOrder[i].first = HilbertIndex((unsigned int)(x * 65536. / fWidth), (unsigned int)(y * 65536. / fHeight));
+	}
+	std::sort(vecOrder.begin(), vecOrder.end());
+
+	nNodes = vecOrder.size();
+	m_vecRecords.resize(nNodes);
+	m_vecBounds.reserve(nNodes + nNodes / (RECORDTREE_NODE_SIZE - 1) + 1);
+	for (i = 0; i < nNodes; i++)
+	{
+		m_vecRecords[i] = vecOrder[i].second;
+		m_vecBounds.push_back(pRecords[vecOrder[i].second].rBounds);
+	}
+	m_vecLevelOffsets.push_back(0);
+	m_vecLevelOffsets.push_back(nNodes);
+
+	// pack each level into full nodes until only the root is left
+	for (iLevel = 0; LevelSize(iLevel) > 1; iLevel++)
+	{
+		nChildren = LevelSize(iLevel);
+		for (iChild = 0; iChild < nChildren; iChild += RECORDTREE_NODE_SIZE)
+		{
+			Rect rNode = NodeBounds(iLevel, iChild);
+			for (i = iChild + 1; i < iChild + RECORDTREE_NODE_SIZE && i < nChildren; i++)
+				rNode = rNode.unionRect(NodeBounds(iLevel, i));
+			m_vecBounds.push_back(rNode);
+		}
+		m_vecLevelOffsets.push_back(m_vecBounds.size());
+	}
+}
+
+void RecordTree::Search(const Rect & rRect, std::vector<unsigned int> & vecRecords) const
+{
+	std::vector<std::pair<unsigned int, unsigned int> > vecStack;
+	unsigned int iLevel, iNode, i, iLast;
+
+	if (m_vecRecords.empty())
+		return;
+
+	vecStack.push_back(std::pair<unsigned int, unsigned int>(m_vecLevelOffsets.size() - 2, 0));
+	while (!vecStack.empty())
+	{
+		iLevel = vecStack.back().first;
+		iNode = vecStack.back().second;
+		vecStack.pop_back();
+		if (!rRect.intersectRect(NodeBounds(iLevel, iNode)))
+			continue;
+		if (iLevel == 0)
+		{
+			vecRecords.push_back(m_vecRecords[iNode]);
+			continue;
+		}
+		iLast = std::min((iNode + 1) * RECORDTREE_NODE_SIZE, LevelSize(iLevel - 1));
+		for (i = iNode * RECORDTREE_NODE_SIZE; i < iLast; i++)
+			vecStack.push_back(std::pair<unsigned int, unsigned int>(iLevel - 1, i));
+	}
+}
+
+bool RecordTree::Nearest(const MapRecord * pRecords, const Coords & pt, unsigned int & iRecordClosest, unsigned short & iShapePointClosest, float & fProgressClosest, float & fDistanceClosest) const
+{
+	std::priority_queue<RecordTreeQueueEntry, std::vector<RecordTreeQueueEntry>, std::greater<RecordTreeQueueEntry> > queueNodes;
+	RecordTreeQueueEntry entry, child;
+	Coords ptFlat(pt.Flatten());
+	unsigned int i, iLast;
+	unsigned short iShapePoint;
+	float fDistance, fProgress;
+	bool bFound = false;
+
+	if (m_vecRecords.empty())
+		return false;
+
+	// best-first search: visit nodes in order of their distance lower bound,
+	// and stop once no remaining node can beat the closest record found
+	entry.iLevel = m_vecLevelOffsets.size() - 2;
+	entry.iNode = 0;
+	entry.fBound = BoundDistance(pt, ptFlat, m_rBounds);
+	queueNodes.push(entry);
+	while (!queueNodes.empty())
+	{
+		entry = queueNodes.top();
+		queueNodes.pop();
+		if (!(entry.fBound < fDistanceClosest))
+			break;
+		if (entry.iLevel == 0)
+		{
+			fDistance = PointRecordDistance(pt, pRecords + m_vecRecords[entry.iNode], iShapePoint, fProgress);
+			if (fDistance < fDistanceClosest)
+			{
+				iRecordClosest = m_vecRecords[entry.iNode];
+				fDistanceClosest = fDistance;
+				iShapePointClosest = iShapePoint;
+				fProgressClosest = fProgress;
+				bFound = true;
+			}
+			continue;
+		}
+		child.iLevel = entry.iLevel - 1;
+		iLast = std::min((entry.iNode + 1) * RECORDTREE_NODE_SIZE, LevelSize(child.iLevel));
+		for (i = entry.iNode * RECORDTREE_NODE_SIZE; i < iLast; i++)
+		{
+			child.iNode = i;
+			child.fBound = BoundDistance(pt, ptFlat, NodeBounds(child.iLevel, i));
+			if (child.fBound < fDistanceClosest)
+				queueNodes.push(child);
+		}
+	}
+	return bFound;
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* RecordTree.h -- a static R-tree over the bounding rectangles of map
+ * records. The tree is bulk-loaded once per county, when the county's map is
+ * loaded: records are sorted along a Hilbert curve through their centers and
+ * packed into full nodes, level by level, so the tree has no per-node
+ * pointers and adapts to however densely the records are packed. It answers
+ * rectangle queries and nearest-record queries (by the same distance that
+ * PointRecordDistance computes).
+ */
+
+#ifndef _RECORDTREE_H
+#define _RECORDTREE_H
+
+#include "MapDB.h"
+
+#include <vector>
+
+// the number of children of each tree node
+#define RECORDTREE_NODE_SIZE 16
+
+class RecordTree
+{
+public:
+	RecordTree();
+
+	void Clear();
+	// build the tree over records [iBegin, iEnd) of pRecords that have at
+	// least two shape points; their bounding rectangles must already be set
+	void Build(const MapRecord * pRecords, unsigned int iBegin, unsigned int iEnd);
+
+	// append the records whose bounding rectangles intersect rRect
+	void Search(const Rect & rRect, std::vector<unsigned int> & vecRecords) const;
+	// find the record closest to pt, if it is closer than fDistanceClosest
+	// returns true and updates the other arguments if one is found
+	bool Nearest(const MapRecord * pRecords, const Coords & pt, unsigned int & iRecordClosest, unsigned short & iShapePointClosest, float & fProgressClosest, float & fDistanceClosest) const;
+
+	inline const Rect & GetBounds() const
+	{
+		return m_rBounds;
+	}
+	inline unsigned int GetCount() const
+	{
+		return m_vecRecords.size();
+	}
+
+protected:
+	// the number of nodes on a level (level 0 holds the records themselves)
+	inline unsigned int LevelSize(unsigned int iLevel) const
+	{
+		return m_vecLevelOffsets[iLevel + 1] - m_vecLevelOffsets[iLevel];
+	}
+	// the bounding rectangle of node iNode on level iLevel
+	inline const Rect & NodeBounds(unsigned int iLevel, unsigned int iNode) const
+	{
+		return m_vecBounds[m_vecLevelOffsets[iLevel] + iNode];
+	}
+
+	// all levels' bounding rectangles, leaves (records) first, root last; the
+	// children of node i on level l > 0 are nodes i * RECORDTREE_NODE_SIZE to
+	// (i + 1) * RECORDTREE_NODE_SIZE - 1 on level l - 1
+	std::vector<Rect> m_vecBounds;
+	std::vector<unsigned int> m_vecLevelOffsets;
+	std::vector<unsigned int> m_vecRecords; // record index of each leaf
+	Rect m_rBounds;
+};
+
+#endif
@@ -0,0 +1,372 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "ScenarioFile.h"
+#include "Simulator.h"
+#include "StringHelp.h"
+
+#include <qfile.h>
+#include <qtextstream.h>
+#include <qstringlist.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SCENARIOFILE_WRITE_BUFFER_SIZE (1 << 20)
+
+// numbers are 32 bits, little-endian, whatever the host's order
+static void WriteUInt(unsigned int iValue, FILE * hFile)
+{
+	unsigned char pBytes[4];
+
+	pBytes[0] = (unsigned char)iValue;
+	pBytes[1] = (unsigned char)(iValue >> 8);
+	pBytes[2] = (unsigned char)(iValue >> 16);
+	pBytes[3] = (unsigned char)(iValue >> 24);
+	fwrite(pBytes, 1, 4, hFile);
+}
+
+static inline unsigned int DecodeUInt(const unsigned char * pBytes)
+{
+	return pBytes[0] | (pBytes[1] << 8) | (pBytes[2] << 16) | ((unsigned int)pBytes[3] << 24);
+}
+
+static bool ReadUInt(const unsigned char * & pBuffer, const unsigned char * pEnd, unsigned int & iValue)
+{
+	if (pEnd - pBuffer < 4)
+		return false;
+	iValue = DecodeUInt(pBuffer);
+	pBuffer += 4;
+	return true;
+}
+
+// index of strValue in the string table, adding it if it is new
+static unsigned int InternString(const QString & strValue, std::map<QString, unsigned int> & mapStrings, std::vector<QString> & vecStrings)
+{
+	std::map<QString, unsigned int>::iterator iterString = mapStrings.find(strValue);
+	if (iterString == mapStrings.end())
+	{
+		iterString = mapStrings.insert(std::pair<QString, unsigned int>(strValue, vecStrings.size())).first;
+		vecStrings.push_back(strValue);
+	}
+	return iterString->second;
+}
+
+bool ReadScenario(const QString & strFilename, std::vector<ScenarioModel> & vecModels)
+{
+	if (IsBinaryScenario(strFilename))
+		return ReadBinaryScenario(strFilename, vecModels);
+	else
+		return ReadTextScenario(strFilename, vecModels);
+}
+
+bool IsBinaryScenario(const QString & strFilename)
+{
+	FILE * hFile = fopen(strFilename, "rb");
+	unsigned char pMagic[4];
+	bool bBinary;
+
+	if (hFile == NULL)
+		return false;
+	bBinary = fread(pMagic, 1, 4, hFile) == 4 && DecodeUInt(pMagic) == SCENARIOFILE_BINARY_MAGIC;
+	fclose(hFile);
+	return bBinary;
+}
+
+bool ReadTextScenario(const QString & strFilename, std::vector<ScenarioModel> & vecModels)
+{
+	QFile file(strFilename);
+	QTextStream reader;
+	QString line, strComment;
+	std::vector<std::pair<QString, QString> > vecPairs;
+	ScenarioModel model;
+	unsigned int i;
+	bool bModel = false, bType = false;
+
+	if (!file.open(IO_ReadOnly | IO_Translate))
+		return false;
+
+	reader.setDevice(&file);
+
+	// a model starts at each MODEL pair, and is kept only if a TYPE
+	// follows before the next one
+	while (!(line = reader.readLine()).isNull())
+	{
+		if (line.isEmpty())
+			continue;
+		if (line[0] == '%')
+		{
+			// kept for the next model
+			strComment += line.mid(1) + "\n";
+			continue;
+		}
+
+		/* extract each line's parameters */
+		vecPairs.clear();
+		if (!ExtractParams(line, vecPairs))
+		{
+			/* malformed file? */
+			reader.unsetDevice();
+			file.close();
+			return false;
+		}
+
+		for (i = 0; i < vecPairs.size(); i++)
+		{
+			if (!vecPairs[i].first.upper().compare(PARAM_MODEL))
+			{
+				if (bType)
+					vecModels.push_back(model);
+				model.strName = vecPairs[i].second;
+				model.strType = model.strDepends = QString::null;
+				model.strComment = strComment;
+				strComment = QString::null;
+				model.mapParams.clear();
+				bModel = true;
+				bType = false;
+			}
+			else if (!bModel)
+				continue;
+			else if (!vecPairs[i].first.upper().compare(PARAM_TYPE))
+			{
+				if (!bType)
+				{
+					model.strType = vecPairs[i].second;
+					model.mapParams[vecPairs[i].first] = vecPairs[i].second;
+					bType = true;
+				}
+			}
+			else
+			{
+				if (!vecPairs[i].first.upper().compare(PARAM_DEPENDS))
+					model.strDepends = vecPairs[i].second;
+				model.mapParams[vecPairs[i].first] = vecPairs[i].second;
+			}
+		}
+	}
+	if (bType)
+		vecModels.push_back(model);
+
+	reader.unsetDevice();
+	file.close();
+	return true;
+}
+
+bool ReadBinaryScenario(const QString & strFilename, std::vector<ScenarioModel> & vecModels)
+{
+	std::vector<QString> vecStrings;
+	const unsigned char * pBuffer, * pEnd;
+	unsigned char * pStart;
+	unsigned int i, j, iValue, iLength, iKey, iVersion, numStrings, numModels, numParams;
+	struct stat fileInfo;
+	bool bSuccess = false;
+
+	int handle = open(strFilename, O_RDONLY);
+	if (handle == -1)
+		return false;
+	if (fstat(handle, &fileInfo) != 0 || fileInfo.st_size == 0) {
+		close(handle);
+		return false;
+	}
+	pStart = (unsigned char *)mmap(0, fileInfo.st_size, PROT_READ, MAP_PRIVATE, handle, 0);
+	close(handle);
+	if (pStart == MAP_FAILED)
+		return false;
+	pBuffer = pStart;
+	pEnd = pStart + fileInfo.st_size;
+
+	// read header
+	if (!ReadUInt(pBuffer, pEnd, iValue) || iValue != SCENARIOFILE_BINARY_MAGIC)
+		goto SCENARIOFILE_LOAD_ERROR;
+	if (!ReadUInt(pBuffer, pEnd, iVersion) || iVersion < 1 || iVersion > SCENARIOFILE_BINARY_VERSION)
+		goto SCENARIOFILE_LOAD_ERROR;
+
+	// read strings; each one is decoded once here and then shared
+	if (!ReadUInt(pBuffer, pEnd, numStrings))
+		goto SCENARIOFILE_LOAD_ERROR;
+	vecStrings.resize(numStrings);
+	for (i = 0; i < numStrings; i++) {
+		if (!ReadUInt(pBuffer, pEnd, iLength) || (unsigned long)(pEnd - pBuffer) < iLength)
+			goto SCENARIOFILE_LOAD_ERROR;
+		vecStrings[i] = QString::fromUtf8((const char *)pBuffer, iLength);
+		pBuffer += iLength;
+	}
+
+	// read models
+	if (!ReadUInt(pBuffer, pEnd, numModels))
+		goto SCENARIOFILE_LOAD_ERROR;
+	vecModels.reserve(vecModels.size() + numModels);
+	for (i = 0; i < numModels; i++) {
+		vecModels.push_back(ScenarioModel());
+		ScenarioModel & model = vecModels.back();
+		if (!ReadUInt(pBuffer, pEnd, iValue) || iValue >= numStrings)
+			goto SCENARIOFILE_LOAD_ERROR;
+		model.strName = vecStrings[iValue];
+		if (!ReadUInt(pBuffer, pEnd, iValue) || iValue >= numStrings)
+			goto SCENARIOFILE_LOAD_ERROR;
+		model.strType = vecStrings[iValue];
+		if (!ReadUInt(pBuffer, pEnd, iValue) || (iValue >= numStrings && iValue != (unsigned)-1))
+			goto SCENARIOFILE_LOAD_ERROR;
+		if (iValue != (unsigned)-1)
+			model.strDepends = vecStrings[iValue];
+		if (iVersion >= 2)
+		{
+			if (!ReadUInt(pBuffer, pEnd, iValue) || (iValue >= numStrings && iValue != (unsigned)-1))
+				goto SCENARIOFILE_LOAD_ERROR;
+			if (iValue != (unsigned)-1)
+				model.strComment = vecStrings[iValue];
+		}
+		if (!ReadUInt(pBuffer, pEnd, numParams))
+			goto SCENARIOFILE_LOAD_ERROR;
+		for (j = 0; j < numParams; j++) {
+			if (!ReadUInt(pBuffer, pEnd, iKey) || iKey >= numStrings || !ReadUInt(pBuffer, pEnd, iValue) || iValue >= numStrings)
+				goto SCENARIOFILE_LOAD_ERROR;
+			model.mapParams.insert(model.mapParams.end(), std::pair<QString, QString>(vecStrings[iKey], vecStrings[iValue]));
+		}
+	}
+	bSuccess = true;
+
+SCENARIOFILE_LOAD_ERROR:
+	munmap(pStart, fileInfo.st_size);
+	return bSuccess;
+}
+
+bool WriteScenario(const QString & strFilename, const std::vector<ScenarioModel> & vecModels, const QString & strComment)
+{
+	if (strFilename.endsWith("." SCENARIOFILE_BINARY_EXTENSION))
+		return WriteBinaryScenario(strFilename, vecModels);
+	else
+		return WriteTextScenario(strFilename, vecModels, strComment);
+}
+
+bool WriteTextScenario(const QString & strFilename, const std::vector<ScenarioModel> & vecModels, const QString & strComment)
+{
+	QFile file(strFilename);
+	QTextStream writer;
+	std::map<QString, QString>::const_iterator iterParam;
+	QString strWrite;
+	QStringList listComment;
+	QStringList::const_iterator iterComment;
+	unsigned int i;
+
+	if (!file.open(IO_WriteOnly | IO_Truncate))
+		return false;
+
+	writer.setDevice(&file);
+
+	if (!strComment.isEmpty())
+	{
+		writer << "% " << strComment << endl;
+		writer << endl;
+	}
+
+	for (i = 0; i < vecModels.size(); i++)
+	{
+		// write the comments that came before it; each line ends in a newline
+		if (!vecModels[i].strComment.isEmpty())
+		{
+			listComment = QStringList::split('\n', vecModels[i].strComment.left(vecModels[i].strComment.length() - 1), true);
+			for (iterComment = listComment.begin(); iterComment != listComment.end(); ++iterComment)
+				writer << "%" << *iterComment << endl;
+		}
+
+		// write model name, type, and dependencies
+		if (vecModels[i].strDepends.isEmpty() && vecModels[i].mapParams.find(PARAM_DEPENDS) == vecModels[i].mapParams.end())
+			strWrite = QString("MODEL=\"%1\" TYPE=\"%2\"").arg(vecModels[i].strName).arg(vecModels[i].strType);
+		else
+			strWrite = QString("MODEL=\"%1\" TYPE=\"%2\" DEPENDS=\"%3\"").arg(vecModels[i].strName).arg(vecModels[i].strType).arg(vecModels[i].strDepends);
+		writer << strWrite << endl;
+
+		// write parameters
+		strWrite = QString::null;
+		for (iterParam = vecModels[i].mapParams.begin(); iterParam != vecModels[i].mapParams.end(); ++iterParam)
+		{
+			if (!iterParam->first.upper().compare(PARAM_TYPE) || !iterParam->first.upper().compare(PARAM_DEPENDS))
+				continue;
+			if (strWrite.isEmpty())
+				strWrite = QString("%1=\"%2\"").arg(iterParam->first).arg(iterParam->second);
+			else
+				strWrite += QString(" %1=\"%2\"").arg(iterParam->first).arg(iterParam->second);
+		}
+		if (!strWrite.isEmpty())
+			writer << strWrite << endl;
+		writer << endl;
+	}
+
+	writer.unsetDevice();
+	file.close();
+	return true;
+}
+
+bool WriteBinaryScenario(const QString & strFilename, const std::vector<ScenarioModel> & vecModels)
+{
+	std::map<QString, unsigned int> mapStrings;
+	std::vector<QString> vecStrings;
+	std::vector<unsigned int> vecIndexes;
+	std::map<QString, QString>::const_iterator iterParam;
+	QCString strUtf8;
+	unsigned int i, j;
+	bool bSuccess;
+
+	// the string table has to be complete before the models that refer to
+	// it, so intern everything first
+	for (i = 0; i < vecModels.size(); i++)
+	{
+		vecIndexes.push_back(InternString(vecModels[i].strName, mapStrings, vecStrings));
+		vecIndexes.push_back(InternString(vecModels[i].strType, mapStrings, vecStrings));
+		vecIndexes.push_back(vecModels[i].strDepends.isEmpty() ? (unsigned)-1 : InternString(vecModels[i].strDepends, mapStrings, vecStrings));
+		vecIndexes.push_back(vecModels[i].strComment.isEmpty() ? (unsigned)-1 : InternString(vecModels[i].strComment, mapStrings, vecStrings));
+		vecIndexes.push_back(vecModels[i].mapParams.size());
+		for (iterParam = vecModels[i].mapParams.begin(); iterParam != vecModels[i].mapParams.end(); ++iterParam)
+		{
+			vecIndexes.push_back(InternString(iterParam->first, mapStrings, vecStrings));
+			vecIndexes.push_back(InternString(iterParam->second, mapStrings, vecStrings));
+		}
+	}
+
+	FILE * hFile = fopen(strFilename, "wb");
+	if (hFile == NULL)
+		return false;
+	setvbuf(hFile, NULL, _IOFBF, SCENARIOFILE_WRITE_BUFFER_SIZE);
+
+	WriteUInt(SCENARIOFILE_BINARY_MAGIC, hFile);
+	WriteUInt(SCENARIOFILE_BINARY_VERSION, hFile);
+	WriteUInt(vecStrings.size(), hFile);
+	for (i = 0; i < vecStrings.size(); i++)
+	{
+		strUtf8 = vecStrings[i].utf8();
+		WriteUInt(strUtf8.length(), hFile);
+		fwrite(strUtf8.data(), 1, strUtf8.length(), hFile);
+	}
+	WriteUInt(vecModels.size(), hFile);
+	for (j = 0; j < vecIndexes.size(); j++)
+		WriteUInt(vecIndexes[j], hFile);
+
+	bSuccess = !ferror(hFile);
+	return fclose(hFile) == 0 && bSuccess;
+}
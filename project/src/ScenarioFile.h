@@ -0,0 +1,71 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/* ScenarioFile.h -- reading and writing the model list of a simulation.
+ * Besides the text format (.sim) there is a binary one (.simb) holding the
+ * same models: a table of every distinct string in the file, followed by
+ * the models as indexes into that table, all in little-endian order.
+ * Loading it takes one pass over a mapped file with no text parsing, and
+ * each parameter name or repeated value is decoded once and shared by every
+ * model that uses it. The '%' comment lines before each model are kept in
+ * both formats; comments after the last model are dropped.
+ */
+
+#ifndef _SCENARIOFILE_H
+#define _SCENARIOFILE_H
+
+#include <qstring.h>
+
+#include <map>
+#include <vector>
+
+#define SCENARIOFILE_BINARY_MAGIC 0x424d5347 // "GSMB"
+#define SCENARIOFILE_BINARY_VERSION 2 // version 1 had no comments
+#define SCENARIOFILE_BINARY_EXTENSION "simb"
+
+typedef struct ScenarioModelStruct
+{
+	QString strName;
+	QString strType;
+	QString strDepends;
+	// the '%' lines before the model, without the '%', one per line
+	QString strComment;
+	// every parameter as read, TYPE and DEPENDS included, as passed to
+	// ModelMgr::AddModel
+	std::map<QString, QString> mapParams;
+} ScenarioModel;
+
+// read whichever format strFilename is in; false if the file is missing or
+// malformed
+bool ReadScenario(const QString & strFilename, std::vector<ScenarioModel> & vecModels);
+bool ReadTextScenario(const QString & strFilename, std::vector<ScenarioModel> & vecModels);
+bool ReadBinaryScenario(const QString & strFilename, std::vector<ScenarioModel> & vecModels);
+bool IsBinaryScenario(const QString & strFilename);
+
+// write the binary format if strFilename ends in .simb, otherwise text;
+// strComment goes at the top of a text file
+bool WriteScenario(const QString & strFilename, const std::vector<ScenarioModel> & vecModels, const QString & strComment = QString::null);
+bool WriteTextScenario(const QString & strFilename, const std::vector<ScenarioModel> & vecModels, const QString & strComment = QString::null);
+bool WriteBinaryScenario(const QString & strFilename, const std::vector<ScenarioModel> & vecModels);
+
+#endif
@@ -0,0 +1,271 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "ScenarioGenerator.h"
+#include "Simulator.h"
+#include "MapDB.h"
+#include "StringHelp.h"
+#include "ParamSchema.h"
+#include "SimModel.h"
+
+#include <qstringlist.h>
+
+ScenarioGenerator::ScenarioGenerator()
+: m_strVehicleType(SIMMODEL_NAME), m_ipFirst(0)
+{
+	std::vector<QString> vecModelTypes;
+	GetAllModelParams(m_mapModelParams, vecModelTypes);
+}
+
+ScenarioGenerator::~ScenarioGenerator()
+{
+}
+
+int ScenarioGenerator::SetVehicleType(const QString & strType)
+{
+	if (m_mapModelParams.find(strType) == m_mapModelParams.end())
+		return 1;
+	m_strVehicleType = strType;
+	return 0;
+}
+
+int ScenarioGenerator::SetRegion(const Rect & rRegion)
+{
+	m_rRegion = rRegion;
+	m_rRegion.normalize();
+	m_vecRecords.clear();
+	return g_pMapDB->GetRecordsInRegion(m_vecRecords, m_rRegion) ? 0 : 1;
+}
+
+void ScenarioGenerator::SetParameter(const QString & strParam, const QString & strSpec)
+{
+	m_mapSpecs[strParam] = strSpec;
+}
+
+void ScenarioGenerator::SetFirstAddress(in_addr_t ipAddress)
+{
+	m_ipFirst = ipAddress;
+}
+
+int ScenarioGenerator::Generate(const QString & strFilename, unsigned int iVehicles, unsigned int iSeed)
+{
+	std::vector<ScenarioModel> vecModels;
+	unsigned int i;
+	in_addr_t ipAddress = m_ipFirst;
+
+	// every random value comes from this seed, so the same options always
+	// produce the same file
+	SeedRandom(iSeed);
+	m_mapModelIndexes.clear();
+
+	for (i = 0; i < iVehicles; i++, ipAddress++)
+		AddModel(vecModels, m_strVehicleType, true, ipAddress);
+
+	return WriteScenario(strFilename, vecModels, QString("Created by GrooveNet Hybrid Simulator: %1 x %2, seed %3").arg(iVehicles).arg(m_strVehicleType).arg(iSeed)) ? 0 : 1;
+}
+
+QString ScenarioGenerator::GetRandomParameter(const QString & strValue, const ModelParameter & param, const std::vector<unsigned int> * pRecords, const Rect * pRegion)
+{
+	QString strRet;
+	QStringList listRandom = QStringList::split(';', strValue);
+	unsigned int iRandom = RandUInt(0, listRandom.size());
+	int iSep = strValue.find(':');
+	switch (param.eType & 0xF)
+	{
+	case ModelParameterTypeInt:
+		if (iSep > -1)
+			strRet = QString("%1").arg(RandInt((long)StringToNumber(strValue.left(iSep)), (long)StringToNumber(strValue.mid(iSep+1))));
+		else if (!listRandom.empty())
+			strRet = listRandom[iRandom];
+		break;
+	case ModelParameterTypeFloat:
+		if (iSep > -1)
+			strRet = QString("%1").arg(RandDouble(StringToNumber(strValue.left(iSep)), StringToNumber(strValue.mid(iSep+1))));
+		else if (!listRandom.empty())
+			strRet = listRandom[iRandom];
+		break;
+	case ModelParameterTypeAddress:
+		if (pRecords != NULL && pRegion != NULL)
+			strRet = GetRandomAddress(*pRecords, *pRegion);
+		break;
+	case ModelParameterTypeAddresses: // TODO: generate random address list
+		if (!listRandom.empty())
+			strRet = listRandom[iRandom];
+		break;
+	case ModelParameterTypeCoords:
+		if (iSep > -1)
+		{
+			Coords ptMin, ptMax;
+			ptMin.FromString(strValue.left(iSep));
+			ptMax.FromString(strValue.mid(iSep+1));
+			strRet = Coords(RandInt(ptMin.m_iLong, ptMax.m_iLong), RandInt(ptMin.m_iLat, ptMax.m_iLat)).ToString();
+		}
+		else if (!listRandom.empty())
+			strRet = listRandom[iRandom];
+		else if (pRegion != NULL)
+			strRet = GetRandomPosition(*pRegion);
+		break;
+	default:
+		if (!listRandom.empty())
+			strRet = listRandom[iRandom];
+		break;
+	}
+	return strRet;
+}
+
+QString ScenarioGenerator::GetRandomAddress(const std::vector<unsigned int> & vecRecords, const Rect & rRegion)
+{
+	QString strAddress;
+	Address sAddress;
+	unsigned int i, iMaxRetries = 3, iRecord, iShapePoint;
+	float fProgress;
+	MapRecord * pRecord;
+
+	// choose a random location in this region
+	if (vecRecords.empty())
+		return strAddress;
+
+	for (i = 0; i < iMaxRetries; i++)
+	{
+		iRecord = RandUInt(0, vecRecords.size());
+		pRecord = g_pMapDB->GetRecord(vecRecords[iRecord]);
+		if (pRecord->nShapePoints > 1)
+		{
+			iShapePoint = RandUInt(0, pRecord->nShapePoints - 1);
+			fProgress = (float)RandDouble(0., 1.);
+			if (g_pMapDB->AddressFromRecord(&sAddress, vecRecords[iRecord], iShapePoint, fProgress))
+			{
+				strAddress = AddressToString(&sAddress);
+				if (StringToAddress(strAddress, &sAddress) && sAddress.iRecord != (unsigned)-1 && rRegion.intersectRect(pRecord->rBounds))
+					break;
+			}
+		}
+	}
+	return strAddress;
+}
+
+QString ScenarioGenerator::GetRandomPosition(const Rect & rRegion)
+{
+	return Coords(RandInt(rRegion.m_iLeft, rRegion.m_iRight), RandInt(rRegion.m_iBottom, rRegion.m_iTop)).ToString();
+}
+
+QString ScenarioGenerator::AddModel(std::vector<ScenarioModel> & vecModels, const QString & strType, bool bVehicle, in_addr_t ipAddress)
+{
+	std::map<QString, std::map<QString, ModelParameter> >::iterator iterModelParams = m_mapModelParams.find(strType);
+	std::map<QString, ModelParameter>::iterator iterParam;
+	std::map<QString, QString>::iterator iterSpec;
+	std::map<QString, unsigned int>::iterator iterModelIndex;
+	ScenarioModel model;
+	std::set<QString> setDepends;
+	std::set<QString>::iterator iterSetDepend;
+	QStringList listDepends;
+	QStringList::iterator iterDepend;
+
+	if (iterModelParams == m_mapModelParams.end())
+		return "NULL";
+
+	for (iterParam = iterModelParams->second.begin(); iterParam != iterModelParams->second.end(); ++iterParam)
+	{
+		iterSpec = m_mapSpecs.find(iterParam->first);
+		if (iterParam->first.compare(PARAM_DEPENDS) == 0)
+		{
+			if (iterSpec != m_mapSpecs.end())
+			{
+				listDepends = QStringList::split(';', iterSpec->second);
+				for (iterDepend = listDepends.begin(); iterDepend != listDepends.end(); ++iterDepend)
+					setDepends.insert(*iterDepend);
+			}
+			continue;
+		}
+		switch (iterParam->second.eType & 0xF)
+		{
+		case ModelParameterTypeModel:
+			// each vehicle gets its own instance of an associated model,
+			// which has to come before the vehicle that uses it
+			if (iterSpec == m_mapSpecs.end())
+				model.mapParams[iterParam->first] = "NULL";
+			else
+				setDepends.insert(model.mapParams[iterParam->first] = AddModel(vecModels, iterSpec->second, false, ipAddress));
+			break;
+		case ModelParameterTypeIP:
+			if (bVehicle)
+			{
+				model.mapParams[iterParam->first] = IPAddressToString(ipAddress);
+				break;
+			}
+			// fall through
+		default:
+			model.mapParams[iterParam->first] = GetParameter(iterParam->first, iterParam->second);
+			break;
+		}
+	}
+
+	iterModelIndex = m_mapModelIndexes.insert(std::pair<QString, unsigned int>(strType, 0)).first;
+	model.strName = QString("%1%2").arg(strType).arg(iterModelIndex->second++);
+	model.strType = strType;
+	model.mapParams[PARAM_TYPE] = strType;
+
+	setDepends.erase("NULL");
+	for (iterSetDepend = setDepends.begin(); iterSetDepend != setDepends.end(); ++iterSetDepend)
+	{
+		if (model.strDepends.isEmpty())
+			model.strDepends = *iterSetDepend;
+		else
+			model.strDepends += (';' + *iterSetDepend);
+	}
+	if (!model.strDepends.isEmpty())
+		model.mapParams[PARAM_DEPENDS] = model.strDepends;
+
+	vecModels.push_back(model);
+	return model.strName;
+}
+
+QString ScenarioGenerator::GetParameter(const QString & strParam, const ModelParameter & param)
+{
+	std::map<QString, QString>::iterator iterSpec = m_mapSpecs.find(strParam);
+
+	if (iterSpec != m_mapSpecs.end())
+	{
+		// an address given on the command line is used as is; anything
+		// else may be a range or a list to choose from
+		if ((param.eType & 0xF) == ModelParameterTypeAddress)
+			return iterSpec->second;
+		return GetRandomParameter(iterSpec->second, param, &m_vecRecords, &m_rRegion);
+	}
+
+	// unless the model says otherwise, places are spread over the region
+	if ((param.eType & ModelParameterFixed) != ModelParameterFixed)
+	{
+		switch (param.eType & 0xF)
+		{
+		case ModelParameterTypeAddress:
+			return GetRandomAddress(m_vecRecords, m_rRegion);
+		case ModelParameterTypeCoords:
+			return GetRandomPosition(m_rRegion);
+		default:
+			break;
+		}
+	}
+	return param.strValue;
+}
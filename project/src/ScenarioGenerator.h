@@ -0,0 +1,81 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/* ScenarioGenerator.h -- builds simulation files with many vehicles without
+ * the GUI. It uses the same model parameter descriptions and map region
+ * sampling as the auto-generate dialog, draws every random value from one
+ * seeded generator, and writes the models in either scenario format, so
+ * the same seed and options always give the same file.
+ */
+
+#ifndef _SCENARIOGENERATOR_H
+#define _SCENARIOGENERATOR_H
+
+#include "Model.h"
+#include "Coords.h"
+#include "ScenarioFile.h"
+
+#include <vector>
+#include <set>
+#include <arpa/inet.h>
+
+#define SCENARIOGENERATOR_VEHICLES_DEFAULT "1000"
+#define SCENARIOGENERATOR_SEED_DEFAULT "1"
+
+class ScenarioGenerator
+{
+public:
+	ScenarioGenerator();
+	~ScenarioGenerator();
+
+	// all of these return 0 on success
+	int SetVehicleType(const QString & strType);
+	int SetRegion(const Rect & rRegion);
+	// strSpec uses the auto-generate dialog's syntax: "min:max" for a
+	// range, "a;b;c" to pick one of several values, or a single value; for
+	// a model parameter it names the model type to create for each vehicle
+	void SetParameter(const QString & strParam, const QString & strSpec);
+	void SetFirstAddress(in_addr_t ipAddress);
+	int Generate(const QString & strFilename, unsigned int iVehicles, unsigned int iSeed);
+
+	// random values as drawn by the auto-generate dialog
+	static QString GetRandomParameter(const QString & strValue, const ModelParameter & param, const std::vector<unsigned int> * pRecords, const Rect * pRegion);
+	static QString GetRandomAddress(const std::vector<unsigned int> & vecRecords, const Rect & rRegion);
+	static QString GetRandomPosition(const Rect & rRegion);
+
+protected:
+	// add a model of type strType and the models it needs to vecModels,
+	// returning its name
+	QString AddModel(std::vector<ScenarioModel> & vecModels, const QString & strType, bool bVehicle, in_addr_t ipAddress);
+	QString GetParameter(const QString & strParam, const ModelParameter & param);
+
+	std::map<QString, std::map<QString, ModelParameter> > m_mapModelParams;
+	std::map<QString, QString> m_mapSpecs;
+	std::map<QString, unsigned int> m_mapModelIndexes;
+	std::vector<unsigned int> m_vecRecords;
+	Rect m_rRegion;
+	QString m_strVehicleType;
+	in_addr_t m_ipFirst;
+};
+
+#endif
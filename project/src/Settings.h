@@ -187,6 +187,24 @@ const QString SETTINGS_HYBRIDNETWORK_MODE_LIST[SETTINGS_HYBRIDNETWORK_MODE_LIST_
 #define PARAMKEY_NETWORK_DEVNAME "--dev"
 #define PARAMKEY_NETWORK_IP "--ip"
 #define PARAMKEY_NETWORK_SUBNET "--subnet"
+#define PARAMKEY_CONVERT_STATE "--convert-state"
+#define PARAMKEY_CONVERT_OVERWRITE "--overwrite"
+#define PARAMKEY_SYNC_TICK "--sync-tick"
+#define PARAMKEY_SNAPSHOT_RATE "--snapshot-rate"
+#define PARAMKEY_CHECKPOINT "--checkpoint"
+#define PARAMKEY_CHECKPOINT_INTERVAL "--checkpoint-interval"
+#define PARAMKEY_RESUME "--resume"
+#define PARAMKEY_WARM_START "--warm-start"
+#define PARAMKEY_WARM_UP "--warm-up"
+#define PARAMKEY_CONVERT_SCENARIO "--convert-scenario"
+#define PARAMKEY_CONVERT_OUTPUT "--output"
+#define PARAMKEY_GENERATE "--generate"
+#define PARAMKEY_GENERATE_VEHICLES "--vehicles"
+#define PARAMKEY_GENERATE_SEED "--seed"
+#define PARAMKEY_GENERATE_TYPE "--vehicle-type"
+#define PARAMKEY_GENERATE_REGION "--region"
+#define PARAMKEY_GENERATE_MAPS "--maps"
+#define PARAMKEY_GENERATE_PARAMS "--set"
 
 class Setting
 {
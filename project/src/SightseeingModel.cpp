@@ -23,7 +23,9 @@
  ***************************************************************************/
 
 #include "SightseeingModel.h"
+#include "SimCheckpoint.h"
 #include "StringHelp.h"
+#include "Simulator.h"
 
 #define SIGHTSEEINGMODEL_MAXDISTANCE_PARAM "MAXDISTANCE"
 #define SIGHTSEEINGMODEL_MAXDISTANCE_PARAM_DEFAULT "1000"
@@ -55,125 +57,84 @@ SightseeingModel & SightseeingModel::operator = (const SightseeingModel & copy)
 	return *this;
 }
 
-bool SightseeingModel::SetProgress(float & fTime, short iSpeed, unsigned int & iNextRecord)
+bool SightseeingModel::SetProgress(struct timeval tCurrent, float & fTime, short iSpeed, unsigned int & iNextRecord)
 {
 	if (m_iCurrentRecord == (unsigned)-1 || m_iCRShapePoint == (unsigned)-1)
 		return false;
 
-	// find distance to next shape point
+	// move along the record, up to its end (or the end of the trip)
 	MapRecord * pRecord = g_pMapDB->GetRecord(m_iCurrentRecord);
-	float fRemaining = 0.f, fPart = 0.f, fDistance = (fTime * iSpeed) / SECSPERHOUR;
+	float fRemaining, fEnd, fDistance = (fTime * iSpeed) / SECSPERHOUR;
 
-	if ((signed)m_iCRShapePoint < pRecord->nShapePoints - 1)
-	{
-		Coords c0 = pRecord->pShapePoints[m_iCRShapePoint], c1 = pRecord->pShapePoints[m_iCRShapePoint + 1];
-
-		fPart = Distance(c0, c1);
-		if (m_listPathRecords.empty() && m_iCRShapePoint == m_iStartShapePoint)
-		{
-			if (m_bForwards)
-				fRemaining = fPart * (m_fStartProgress - m_fCRProgress);
-			else
-				fRemaining = fPart * (m_fCRProgress - m_fStartProgress);
-		}
-		else
-		{
-			if (m_bForwards)
-				fRemaining = fPart * (1 - m_fCRProgress);
-			else
-				fRemaining = fPart * m_fCRProgress;
-		}
-	}
+	if (m_listPathRecords.empty())
+		fEnd = g_pMapDB->DistanceAlongRecord(m_iCurrentRecord, m_iStartShapePoint, m_fStartProgress);
+	else
+		fEnd = m_bForwards ? g_pMapDB->GetRecordLength(m_iCurrentRecord) : 0.f;
+	fRemaining = AdvanceAlongRecord(fDistance, fEnd);
 
-	if (fDistance < fRemaining && fPart > 0.f)
+	if (fDistance < fRemaining)
 	{
-		// we're still on the same part of the record
-		if (m_bForwards)
-			m_fCRProgress += fDistance / fPart;
-		else
-			m_fCRProgress -= fDistance / fPart;
+		// we're still on the same record
 		fTime = 0.f;
 	}
 	else
 	{
-		// we've passed the end of this shape point
+		// we've passed the end of this record
 		if (iSpeed > 0)
 			fTime -= (fRemaining * SECSPERHOUR) / iSpeed;
 		else
 			fTime = 0.f;
 		if (m_bForwards) {
-			if ((signed)m_iCRShapePoint < (m_listPathRecords.empty() ? (signed)m_iStartShapePoint : (pRecord->nShapePoints - 1)))
-			{
-				m_iCRShapePoint++;
-				m_fCRProgress = 0.f;
-//				return SetProgress(fTime, iSpeed, iNextRecord);
-				return true;
-			}
-			else
+			// check to see if we're stopped for a traffic light
+			if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[pRecord->nVertices - 1]), m_iCurrentRecord, tCurrent))
 			{
-				// check to see if we're stopped for a traffic light
-				if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[pRecord->nVertices - 1]), m_iCurrentRecord))
+				// go to next record and return with the unused time
+				iNextRecord = GetNextRecord(pRecord->pVertices[pRecord->nVertices - 1], m_iCurrentRecord);
+				if (iNextRecord != (unsigned)-1)
 				{
-					// go to next record and return with the unused time
-					iNextRecord = GetNextRecord(pRecord->pVertices[pRecord->nVertices - 1], m_iCurrentRecord);
-					if (iNextRecord != (unsigned)-1)
-					{
-						m_iCurrentRecord = iNextRecord;
-						if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[pRecord->nVertices - 1]) {
-							m_bForwards = true;
-							m_iCRShapePoint = 0;
-							m_fCRProgress = 0.f;
-						} else {
-							m_bForwards = false;
-							m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
-							m_fCRProgress = 0.f;
-						}
-						return true;
+					m_iCurrentRecord = iNextRecord;
+					if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[pRecord->nVertices - 1]) {
+						m_bForwards = true;
+						m_iCRShapePoint = 0;
+						m_fCRProgress = 0.f;
+					} else {
+						m_bForwards = false;
+						m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
+						m_fCRProgress = 0.f;
 					}
-				}
-				else
-				{
-					// we're stopped here!
-					fTime = 0.f;
-					m_fCRProgress = 1.f;
+					return true;
 				}
 			}
-		} else {
-			if (m_iCRShapePoint > (m_listPathRecords.empty() ? m_iStartShapePoint : 0))
+			else
 			{
-				m_iCRShapePoint--;
-				m_fCRProgress = 1.f;
-//				return SetProgress(fTime, iSpeed, iNextRecord);
-				return true;
+				// we're stopped here!
+				fTime = 0.f;
 			}
-			else
+		} else {
+			// check to see if we're stopped for a traffic light
+			if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[0]), m_iCurrentRecord, tCurrent))
 			{
-				// check to see if we're stopped for a traffic light
-				if (!g_pMapDB->UseTrafficLights() || CanCarGoThrough(g_pMapDB->GetVertex(pRecord->pVertices[0]), m_iCurrentRecord))
+				// go to next record
+				iNextRecord = GetNextRecord(pRecord->pVertices[0], m_iCurrentRecord);
+				if (iNextRecord != (unsigned)-1)
 				{
-					// go to next record
-					iNextRecord = GetNextRecord(pRecord->pVertices[0], m_iCurrentRecord);
-					if (iNextRecord != (unsigned)-1)
-					{
-						m_iCurrentRecord = iNextRecord;
-						if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[0]) {
-							m_bForwards = true;
-							m_iCRShapePoint = 0;
-							m_fCRProgress = 0.f;
-						} else {
-							m_bForwards = false;
-							m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
-							m_fCRProgress = 0.f;
-						}
-						return true;
+					m_iCurrentRecord = iNextRecord;
+					if (g_pMapDB->GetRecord(m_iCurrentRecord)->pVertices[0] == pRecord->pVertices[0]) {
+						m_bForwards = true;
+						m_iCRShapePoint = 0;
+						m_fCRProgress = 0.f;
+					} else {
+						m_bForwards = false;
+						m_iCRShapePoint = g_pMapDB->GetRecord(m_iCurrentRecord)->nShapePoints - 1;
+						m_fCRProgress = 0.f;
 					}
+					return true;
 				}
-				else
-				{
-					// we're stopped here!
-					fTime = 0.f;
-					m_fCRProgress = 0.f;
-				}
+			}
+			else
+			{
+				// we're stopped here!
+				fTime = 0.f;
 			}
 		}
 	}
@@ -257,6 +218,38 @@ int SightseeingModel::Save(std::map<QString, QString> & mapParams)
 	return 0;
 }
 
+int SightseeingModel::SaveState(CheckpointWriter & writer)
+{
+	std::list<unsigned int>::iterator iterRecord;
+
+	if (RandomWalkModel::SaveState(writer))
+		return 1;
+
+	writer.WriteUInt(m_listPathRecords.size());
+	for (iterRecord = m_listPathRecords.begin(); iterRecord != m_listPathRecords.end(); ++iterRecord)
+		writer.WriteUInt(*iterRecord);
+	return 0;
+}
+
+int SightseeingModel::LoadState(CheckpointReader & reader)
+{
+	unsigned int i, numRecords, iRecord;
+
+	if (RandomWalkModel::LoadState(reader))
+		return 1;
+
+	m_listPathRecords.clear();
+	if (!reader.ReadUInt(numRecords))
+		return 2;
+	for (i = 0; i < numRecords; i++)
+	{
+		if (!reader.ReadUInt(iRecord))
+			return 2;
+		m_listPathRecords.push_back(iRecord);
+	}
+	return 0;
+}
+
 void SightseeingModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 {
 	RandomWalkModel::GetParams(mapParams);
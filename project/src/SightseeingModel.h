@@ -52,10 +52,12 @@ public:
 	virtual int Init(const std::map<QString, QString> & mapParams);
 	virtual int PreRun();
 	virtual int Save(std::map<QString, QString> & mapParams);
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
-	virtual bool SetProgress(float & fTime, short iSpeed, unsigned int & iNextRecord);
+	virtual bool SetProgress(struct timeval tCurrent, float & fTime, short iSpeed, unsigned int & iNextRecord);
 
 protected:
 	virtual unsigned int GetNextRecord(unsigned int iVertex, unsigned int iPrevRecord);
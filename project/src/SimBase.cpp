@@ -85,6 +85,25 @@ void SimEventQueue::ClearUntil(struct timeval tTimestamp)
 	m_mutexQueue.unlock();
 }
 
+void SimEventQueue::ClearEvents(unsigned int iEventID)
+{
+	unsigned int i, iKept = 0;
+	m_mutexQueue.lock();
+	for (i = 0; i < Count(); i++)
+	{
+		if (m_vecEvents[i].m_iEventID == iEventID)
+		{
+			if (m_vecEvents[i].m_pfnDestroy != NULL && m_vecEvents[i].GetEventData() != NULL)
+				(*m_vecEvents[i].m_pfnDestroy)(m_vecEvents[i].GetEventData());
+		}
+		else
+			m_vecEvents[iKept++] = m_vecEvents[i];
+	}
+	m_vecEvents.erase(m_vecEvents.begin() + iKept, m_vecEvents.end());
+	make_heap(m_vecEvents.begin(), m_vecEvents.end(), SimEventReverseCompare);
+	m_mutexQueue.unlock();
+}
+
 void SimEventQueue::Clear()
 {
 	unsigned int i;
@@ -147,7 +147,14 @@ public:
 	{
 		return m_vecEvents.size();
 	}
+	// events in no particular order, for looking through the whole queue
+	inline const SimEvent & GetEvent(unsigned int i) const
+	{
+		return m_vecEvents[i];
+	}
 	void ClearUntil(struct timeval tTimestamp);
+	// drop (and destroy the data of) every event with this ID
+	void ClearEvents(unsigned int iEventID);
 	void Clear();
 
 protected:
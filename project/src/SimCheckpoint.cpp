@@ -0,0 +1,372 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "SimCheckpoint.h"
+#include "Message.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+CheckpointWriter::CheckpointWriter(const struct timeval & tStart, unsigned int iMagic)
+: m_tStart(tStart), m_iMagic(iMagic)
+{
+	WriteUInt(iMagic);
+	WriteUInt(SIMCHECKPOINT_VERSION);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+}
+
+void CheckpointWriter::Write(const void * pData, unsigned int iLength)
+{
+	const unsigned char * pBytes = (const unsigned char *)pData;
+	m_vecData.insert(m_vecData.end(), pBytes, pBytes + iLength);
+}
+
+void CheckpointWriter::WriteUInt(unsigned int iValue)
+{
+	Write(&iValue, sizeof(unsigned int));
+}
+
+void CheckpointWriter::WriteInt(int iValue)
+{
+	Write(&iValue, sizeof(int));
+}
+
+void CheckpointWriter::WriteShort(short iValue)
+{
+	Write(&iValue, sizeof(short));
+}
+
+void CheckpointWriter::WriteBool(bool bValue)
+{
+	unsigned char iValue = bValue ? 1 : 0;
+	Write(&iValue, sizeof(unsigned char));
+}
+
+void CheckpointWriter::WriteFloat(float fValue)
+{
+	Write(&fValue, sizeof(float));
+}
+
+void CheckpointWriter::WriteDouble(double fValue)
+{
+	Write(&fValue, sizeof(double));
+}
+
+void CheckpointWriter::WriteString(const QString & strValue)
+{
+	QCString strUtf8 = strValue.utf8();
+	unsigned int iLength = strValue.isNull() ? (unsigned)-1 : strUtf8.length();
+
+	WriteUInt(iLength);
+	if (iLength != (unsigned)-1)
+		Write((const char *)strUtf8, iLength);
+}
+
+void CheckpointWriter::WriteCoords(const Coords & ptValue)
+{
+	WriteInt(ptValue.m_iLong);
+	WriteInt(ptValue.m_iLat);
+}
+
+void CheckpointWriter::WriteTime(const struct timeval & tValue)
+{
+	WriteBool(tValue == timeval0);
+	if (tValue != timeval0)
+		WriteDouble(ToDouble(tValue - m_tStart));
+}
+
+// the wire bytes keep times as they were, so the times are written again
+// relative to the start of the run
+void CheckpointWriter::WritePacket(const Packet & packet)
+{
+	unsigned char * pBytes;
+	int iBytes = 0;
+
+	WriteUInt(packet.m_ePacketType);
+	pBytes = packet.ToBytes(iBytes);
+	if (pBytes == NULL)
+		iBytes = 0;
+	WriteUInt(iBytes);
+	if (pBytes != NULL)
+	{
+		Write(pBytes, iBytes);
+		free(pBytes);
+	}
+	WriteTime(packet.m_tTX);
+	WriteTime(packet.m_tRX);
+	WriteUInt(packet.m_ID.iRXSeqNumber);
+	WriteInt(packet.m_iRSSI);
+	WriteInt(packet.m_iSNR);
+	if (packet.m_ePacketType == ptSafety)
+		WriteTime(((const SafetyPacket &)packet).m_tTime);
+	else if (packet.m_ePacketType == ptSquelch)
+		WriteTime(((const SquelchPacket &)packet).m_tTime);
+}
+
+unsigned int CheckpointWriter::BeginBlock()
+{
+	unsigned int iBlock = m_vecData.size();
+	WriteUInt(0);
+	return iBlock;
+}
+
+void CheckpointWriter::EndBlock(unsigned int iBlock)
+{
+	unsigned int iLength = m_vecData.size() - iBlock - sizeof(unsigned int);
+	memcpy(&m_vecData[iBlock], &iLength, sizeof(unsigned int));
+}
+
+bool CheckpointWriter::Save(const QString & strFilename) const
+{
+	QString strTemp = strFilename + ".tmp";
+	FILE * hFile = fopen(strTemp, "wb");
+	bool bSuccess;
+
+	if (hFile == NULL)
+		return false;
+	bSuccess = fwrite(&m_vecData[0], 1, m_vecData.size(), hFile) == m_vecData.size();
+	bSuccess = fclose(hFile) == 0 && bSuccess;
+	if (bSuccess)
+		bSuccess = rename(strTemp, strFilename) == 0;
+	if (!bSuccess)
+		remove(strTemp);
+	return bSuccess;
+}
+
+
+CheckpointReader::CheckpointReader()
+: m_iOffset(0), m_tStart(timeval0), m_iMagic(0)
+{
+}
+
+CheckpointReader::~CheckpointReader()
+{
+}
+
+bool CheckpointReader::Open(const QString & strFilename, unsigned int iMagic)
+{
+	FILE * hFile = fopen(strFilename, "rb");
+	unsigned int iValue;
+	long iLength;
+	bool bSuccess;
+
+	m_vecData.clear();
+	m_iOffset = 0;
+	if (hFile == NULL)
+		return false;
+	bSuccess = fseek(hFile, 0, SEEK_END) == 0 && (iLength = ftell(hFile)) > 0 && fseek(hFile, 0, SEEK_SET) == 0;
+	if (bSuccess) {
+		m_vecData.resize(iLength);
+		bSuccess = fread(&m_vecData[0], 1, iLength, hFile) == (unsigned long)iLength;
+	}
+	fclose(hFile);
+
+	if (!bSuccess || !ReadUInt(iValue) || iValue != iMagic || !ReadUInt(iValue) || iValue != SIMCHECKPOINT_VERSION)
+	{
+		m_vecData.clear();
+		m_iOffset = 0;
+		return false;
+	}
+	m_iMagic = iMagic;
+	return true;
+}
+
+bool CheckpointReader::Read(void * pData, unsigned int iLength)
+{
+	if (m_vecData.size() - m_iOffset < iLength)
+		return false;
+	memcpy(pData, &m_vecData[m_iOffset], iLength);
+	m_iOffset += iLength;
+	return true;
+}
+
+bool CheckpointReader::ReadUInt(unsigned int & iValue)
+{
+	return Read(&iValue, sizeof(unsigned int));
+}
+
+bool CheckpointReader::ReadInt(int & iValue)
+{
+	return Read(&iValue, sizeof(int));
+}
+
+bool CheckpointReader::ReadShort(short & iValue)
+{
+	return Read(&iValue, sizeof(short));
+}
+
+bool CheckpointReader::ReadBool(bool & bValue)
+{
+	unsigned char iValue;
+	if (!Read(&iValue, sizeof(unsigned char)))
+		return false;
+	bValue = iValue != 0;
+	return true;
+}
+
+bool CheckpointReader::ReadFloat(float & fValue)
+{
+	return Read(&fValue, sizeof(float));
+}
+
+bool CheckpointReader::ReadDouble(double & fValue)
+{
+	return Read(&fValue, sizeof(double));
+}
+
+bool CheckpointReader::ReadString(QString & strValue)
+{
+	unsigned int iLength;
+
+	if (!ReadUInt(iLength))
+		return false;
+	if (iLength == (unsigned)-1) {
+		strValue = QString::null;
+		return true;
+	}
+	if (m_vecData.size() - m_iOffset < iLength)
+		return false;
+	strValue = QString::fromUtf8((const char *)&m_vecData[m_iOffset], iLength);
+	m_iOffset += iLength;
+	return true;
+}
+
+bool CheckpointReader::ReadCoords(Coords & ptValue)
+{
+	int iLong, iLat;
+
+	if (!ReadInt(iLong) || !ReadInt(iLat))
+		return false;
+	ptValue.Set(iLong, iLat);
+	return true;
+}
+
+bool CheckpointReader::ReadTime(struct timeval & tValue)
+{
+	bool bZero;
+	double fValue;
+
+	if (!ReadBool(bZero))
+		return false;
+	if (bZero) {
+		tValue = timeval0;
+		return true;
+	}
+	if (!ReadDouble(fValue))
+		return false;
+	tValue = m_tStart + MakeTime(fValue);
+	return true;
+}
+
+Packet * CheckpointReader::ReadPacket()
+{
+	unsigned int iType;
+	Packet * pPacket;
+
+	if (!ReadUInt(iType))
+		return NULL;
+	switch (iType)
+	{
+	case ptGeneric:
+		pPacket = new Packet();
+		break;
+	case ptSafety:
+		pPacket = new SafetyPacket();
+		break;
+	case ptSquelch:
+		pPacket = new SquelchPacket();
+		break;
+	default:
+		return NULL;
+	}
+	if (!ReadPacketData(*pPacket))
+	{
+		delete pPacket;
+		return NULL;
+	}
+	return pPacket;
+}
+
+bool CheckpointReader::ReadPacket(Packet & packet)
+{
+	unsigned int iType;
+
+	return ReadUInt(iType) && iType == (unsigned)packet.m_ePacketType && ReadPacketData(packet);
+}
+
+bool CheckpointReader::ReadPacketData(Packet & packet)
+{
+	unsigned char * pBytes;
+	unsigned int iLength;
+	int iBytes, iRSSI, iSNR;
+
+	if (!ReadUInt(iLength) || iLength == 0 || m_vecData.size() - m_iOffset < iLength)
+		return false;
+	pBytes = &m_vecData[m_iOffset];
+	iBytes = iLength;
+	if (!packet.FromBytes(pBytes, iBytes))
+		return false;
+	m_iOffset += iLength;
+
+	if (!ReadTime(packet.m_tTX) || !ReadTime(packet.m_tRX) || !ReadUInt(packet.m_ID.iRXSeqNumber) || !ReadInt(iRSSI) || !ReadInt(iSNR))
+		return false;
+	packet.m_iRSSI = iRSSI;
+	packet.m_iSNR = iSNR;
+	if (packet.m_ePacketType == ptSafety)
+		return ReadTime(((SafetyPacket &)packet).m_tTime);
+	else if (packet.m_ePacketType == ptSquelch)
+		return ReadTime(((SquelchPacket &)packet).m_tTime);
+	return true;
+}
+
+bool CheckpointReader::BeginBlock(unsigned int & iEnd)
+{
+	unsigned int iLength;
+
+	if (!ReadUInt(iLength) || m_vecData.size() - m_iOffset < iLength)
+		return false;
+	iEnd = m_iOffset + iLength;
+	return true;
+}
+
+bool CheckpointReader::EndBlock(unsigned int iEnd)
+{
+	// a block read past its end is corrupt; one read short of it is skipped
+	if (m_iOffset > iEnd)
+		return false;
+	m_iOffset = iEnd;
+	return true;
+}
+
+bool CheckpointReader::Seek(unsigned int iOffset)
+{
+	if (iOffset > m_vecData.size())
+		return false;
+	m_iOffset = iOffset;
+	return true;
+}
@@ -0,0 +1,166 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/* SimCheckpoint.h -- the state of a running simulation, saved so that the
+ * run can carry on later from the same simulated time. A checkpoint file
+ * holds a header (magic number, version), the elapsed simulated time, the
+ * random number state, the pending event messages, the packets in flight,
+ * the Event1 log, and a block per model written by Model::SaveState. Every
+ * time in the file is relative to the start of the run, so a run resumed at
+ * a different wall clock time lines up with the original.
+ * A warm start file uses the same layout under its own magic number, and
+ * holds only the elapsed time and the model blocks: the vehicles as they
+ * were after a warm-up period, for later runs to start from. Models leave
+ * their network state (queued rebroadcasts, message histories, receptions
+ * in progress) out of a warm start, since no messages carry over into it.
+ */
+
+#ifndef _SIMCHECKPOINT_H
+#define _SIMCHECKPOINT_H
+
+#include "Global.h"
+#include "Coords.h"
+
+#include <qstring.h>
+
+#include <vector>
+
+#define SIMCHECKPOINT_MAGIC 0x4b434d47 // "GMCK"
+#define SIMCHECKPOINT_WARMSTART_MAGIC 0x534d5747 // "GWMS"
+#define SIMCHECKPOINT_VERSION 2
+#define SIMCHECKPOINT_EXTENSION "simc"
+
+class Packet;
+
+// a model's block in a checkpoint, found before any of them is loaded
+typedef struct CheckpointBlockStruct
+{
+	QString strModelName;
+	unsigned int iStart, iEnd;
+} CheckpointBlock;
+
+class CheckpointWriter
+{
+public:
+	CheckpointWriter(const struct timeval & tStart, unsigned int iMagic = SIMCHECKPOINT_MAGIC);
+	~CheckpointWriter();
+
+	inline bool IsWarmStart() const
+	{
+		return m_iMagic == SIMCHECKPOINT_WARMSTART_MAGIC;
+	}
+
+	void WriteUInt(unsigned int iValue);
+	void WriteInt(int iValue);
+	void WriteShort(short iValue);
+	void WriteBool(bool bValue);
+	void WriteFloat(float fValue);
+	void WriteDouble(double fValue);
+	void WriteString(const QString & strValue);
+	void WriteCoords(const Coords & ptValue);
+	// timeval0 is kept as is; anything else is written relative to the
+	// start of the run
+	void WriteTime(const struct timeval & tValue);
+	// the packet's wire bytes, then its times and the fields that are filled
+	// in on reception
+	void WritePacket(const Packet & packet);
+
+	// a block is prefixed with its length, so a reader can skip whatever
+	// it does not understand
+	unsigned int BeginBlock();
+	void EndBlock(unsigned int iBlock);
+
+	// write to a temporary file and rename it, so an interrupted save
+	// leaves the previous checkpoint in place
+	bool Save(const QString & strFilename) const;
+
+protected:
+	void Write(const void * pData, unsigned int iLength);
+
+	std::vector<unsigned char> m_vecData;
+	struct timeval m_tStart;
+	unsigned int m_iMagic;
+
+private:
+	inline CheckpointWriter(const CheckpointWriter & copy __attribute__ ((unused)) ) {}
+	inline CheckpointWriter & operator = (const CheckpointWriter & copy __attribute__ ((unused)) ) {return *this;}
+};
+
+class CheckpointReader
+{
+public:
+	CheckpointReader();
+	~CheckpointReader();
+
+	// false if the file is missing, has the wrong magic number or version
+	bool Open(const QString & strFilename, unsigned int iMagic = SIMCHECKPOINT_MAGIC);
+	// the start of the run being resumed, for ReadTime
+	inline void SetStart(const struct timeval & tStart)
+	{
+		m_tStart = tStart;
+	}
+	inline bool IsWarmStart() const
+	{
+		return m_iMagic == SIMCHECKPOINT_WARMSTART_MAGIC;
+	}
+
+	bool ReadUInt(unsigned int & iValue);
+	bool ReadInt(int & iValue);
+	bool ReadShort(short & iValue);
+	bool ReadBool(bool & bValue);
+	bool ReadFloat(float & fValue);
+	bool ReadDouble(double & fValue);
+	bool ReadString(QString & strValue);
+	bool ReadCoords(Coords & ptValue);
+	bool ReadTime(struct timeval & tValue);
+	// a new packet of the saved type, or NULL if it could not be read
+	Packet * ReadPacket();
+	// false if the saved packet is not of packet's type
+	bool ReadPacket(Packet & packet);
+
+	// iEnd is where the block finishes; pass it to EndBlock once done
+	bool BeginBlock(unsigned int & iEnd);
+	bool EndBlock(unsigned int iEnd);
+
+	// where the next read starts, to come back to a block later
+	inline unsigned int GetOffset() const
+	{
+		return m_iOffset;
+	}
+	bool Seek(unsigned int iOffset);
+
+protected:
+	bool Read(void * pData, unsigned int iLength);
+	bool ReadPacketData(Packet & packet);
+
+	std::vector<unsigned char> m_vecData;
+	unsigned int m_iOffset;
+	struct timeval m_tStart;
+	unsigned int m_iMagic;
+
+private:
+	inline CheckpointReader(const CheckpointReader & copy __attribute__ ((unused)) ) {}
+	inline CheckpointReader & operator = (const CheckpointReader & copy __attribute__ ((unused)) ) {return *this;}
+};
+
+#endif
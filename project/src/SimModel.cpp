@@ -23,16 +23,21 @@
  ***************************************************************************/
 
 #include "SimModel.h"
+#include "SimCheckpoint.h"
 #include "CarRegistry.h"
 #include "StringHelp.h"
 #include "Simulator.h"
 #include "Network.h"
 #include "Logger.h"
+#include "MobilityTick.h"
 
 #define SIMMOBILITYMODEL_MULTILANE_PARAM "MULTILANE"
 #define SIMMOBILITYMODEL_MULTILANE_PARAM_DEFAULT "N"
 #define SIMMOBILITYMODEL_MULTILANE_PARAM_DESC "MULTILANE (Yes/No) -- Specify \"Yes\" if you want this vehicle to use multiple lanes, \"No\" otherwise."
 
+// the clear distance (in miles) needed ahead and behind to move into another lane
+#define SIMMOBILITYMODEL_LANECHANGE_GAP 0.005f
+
 SimMobilityModel::SimMobilityModel(const QString & strModelName)
 : Model(strModelName), m_ipCar(0), m_bMultilane(false)
 {
@@ -58,13 +63,10 @@ SimMobilityModel & SimMobilityModel::operator =(const SimMobilityModel & copy)
 
 int SimMobilityModel::Init(const std::map<QString, QString> & mapParams)
 {
-	QString strValue;
-
 	if (Model::Init(mapParams))
 		return 1;
 
-	strValue = GetParam(mapParams, SIMMOBILITYMODEL_MULTILANE_PARAM, SIMMOBILITYMODEL_MULTILANE_PARAM_DEFAULT);
-	m_bMultilane = StringToBoolean(strValue);
+	m_bMultilane = GetBooleanParam(mapParams, SIMMOBILITYMODEL_MULTILANE_PARAM, SIMMOBILITYMODEL_MULTILANE_PARAM_DEFAULT);
 
 	return 0;
 }
@@ -107,9 +109,9 @@ void SimMobilityModel::SwitchLanes(unsigned int iRecord, unsigned short iShapePo
 	unsigned char i, iNewLane = iLane, iLanes = NumberOfLanes(g_pMapDB->GetRecord(iRecord));
 	// see what lanes to check (only adjacent lanes)
 	unsigned char iStart = iLane > 0 ? iLane - 1 : 0, iEnd = iLane < iLanes - 1 ? iLane + 1 : iLanes - 1;
-	unsigned int iCar;
-	std::vector<CarModel *> vecCars;
+	CarModel * pFollower;
 	std::vector<CarModel *> vecLanes(iLanes, NULL);
+	std::vector<bool> vecRoom(iLanes, true);
 
 	if (iLanes == 0)
 	{
@@ -117,40 +119,35 @@ void SimMobilityModel::SwitchLanes(unsigned int iRecord, unsigned short iShapePo
 		return;
 	}
 
+	// find the next car ahead in each lane we might use, and whether
+	// there's room to pull in beside us
 	g_pCarRegistry->acquireLock();
-	if (g_pCarRegistry->GetCarsOnRecord(iRecord, bForwards, vecCars))
+	for (i = iStart; i <= iEnd; i++)
 	{
-		for (iCar = 0; iCar < vecCars.size(); iCar++)
-		{
-			if (vecCars[iCar]->GetIPAddress() != m_ipCar && vecCars[iCar]->GetLane() < vecLanes.size())
-			{
-				if (vecLanes[vecCars[iCar]->GetLane()] == NULL)
-					vecLanes[vecCars[iCar]->GetLane()] = vecCars[iCar];
-				else
-				{
-					unsigned int iShapePointCurrent = vecLanes[vecCars[iCar]->GetLane()]->GetCRShapePoint(), iShapePointNew = vecCars[iCar]->GetCRShapePoint();
-					float fProgressCurrent = vecLanes[vecCars[iCar]->GetLane()]->GetCRProgress(), fProgressNew = vecCars[iCar]->GetCRProgress();
-					if (bForwards && (iShapePointCurrent > iShapePointNew || iShapePointCurrent == iShapePointNew && fProgressCurrent > fProgressNew))
-						vecLanes[vecCars[iCar]->GetLane()] = vecCars[iCar];
-					else if(!bForwards && (iShapePointCurrent < iShapePointNew || iShapePointCurrent == iShapePointNew && fProgressCurrent < fProgressNew))
-						vecLanes[vecCars[iCar]->GetLane()] = vecCars[iCar];
-				}
-			}
-		}
+		vecLanes[i] = g_pCarRegistry->GetLaneLeader(iRecord, bForwards, i, iShapePoint, fProgress, m_ipCar, true);
+		if (i == iLane)
+			continue;
+		if (vecLanes[i] != NULL && g_pMapDB->DistanceAlongRecord(iRecord, iShapePoint, fProgress, vecLanes[i]->GetCRShapePoint(), vecLanes[i]->GetCRProgress()) < SIMMOBILITYMODEL_LANECHANGE_GAP)
+			vecRoom[i] = false;
+		pFollower = g_pCarRegistry->GetLaneFollower(iRecord, bForwards, i, iShapePoint, fProgress, m_ipCar, true);
+		if (pFollower != NULL && g_pMapDB->DistanceAlongRecord(iRecord, iShapePoint, fProgress, pFollower->GetCRShapePoint(), pFollower->GetCRProgress()) < SIMMOBILITYMODEL_LANECHANGE_GAP)
+			vecRoom[i] = false;
 	}
 
 	if (vecLanes[iLane] != NULL && vecLanes[iLane]->GetCurrentSpeed() < iSpeed)
 	{
 		bool bCatchup = vecLanes[iLane] != NULL && vecLanes[iLane]->GetCurrentSpeed() < iSpeed;
 		short iMaxSpeed = vecLanes[iLane] != NULL ? vecLanes[iLane]->GetCurrentSpeed() : SHRT_MAX;
-		float fTime, fMaxTime = bCatchup ? DistanceAlongRecord(g_pMapDB->GetRecord(iRecord), iShapePoint, fProgress, vecLanes[iLane]->GetCRShapePoint(), vecLanes[iLane]->GetCRProgress()) / (iSpeed - vecLanes[iLane]->GetCurrentSpeed()) : 0.f;
+		float fTime, fMaxTime = bCatchup ? g_pMapDB->DistanceAlongRecord(iRecord, iShapePoint, fProgress, vecLanes[iLane]->GetCRShapePoint(), vecLanes[iLane]->GetCRProgress()) / (iSpeed - vecLanes[iLane]->GetCurrentSpeed()) : 0.f;
 		for (i = iStart; i <= iEnd; i++)
 		{
+			if (!vecRoom[i])
+				continue;
 			if (vecLanes[i] == NULL || vecLanes[i]->GetCurrentSpeed() >= iSpeed)
 				bCatchup = false;
 			if (bCatchup)
 			{
-				fTime = DistanceAlongRecord(g_pMapDB->GetRecord(iRecord), iShapePoint, fProgress, vecLanes[iLane]->GetCRShapePoint(), vecLanes[iLane]->GetCRProgress()) / (iSpeed - vecLanes[iLane]->GetCurrentSpeed());
+				fTime = g_pMapDB->DistanceAlongRecord(iRecord, iShapePoint, fProgress, vecLanes[i]->GetCRShapePoint(), vecLanes[i]->GetCRProgress()) / (iSpeed - vecLanes[i]->GetCurrentSpeed());
 				if (fTime > fMaxTime)
 				{
 					fMaxTime = fTime;
@@ -243,17 +240,6 @@ SimModel & SimModel::operator =(const SimModel & copy)
 	return *this;
 }
 
-QString SimModel::GetCarListColumnText(CarListColumn eColumn) const
-{
-	switch (eColumn)
-	{
-	case CarListColumnType:
-		return "Local/Simulated";
-	default:
-		return CarModel::GetCarListColumnText(eColumn);
-	}
-}
-
 int SimModel::Init(const std::map<QString, QString> & mapParams)
 {
 	QString strValue;
@@ -262,8 +248,7 @@ int SimModel::Init(const std::map<QString, QString> & mapParams)
 	if (CarModel::Init(mapParams))
 		return 1;
 
-	strValue = GetParam(mapParams, SIMMODEL_STARTTIME_PARAM, SIMMODEL_STARTTIME_PARAM_DEFAULT);
-	m_tStartTime = MakeTime(ValidateNumber(StringToNumber(strValue), 0, HUGE_VAL));
+	m_tStartTime = MakeTime(ValidateNumber(GetNumberParam(mapParams, SIMMODEL_STARTTIME_PARAM, SIMMODEL_STARTTIME_PARAM_DEFAULT), 0, HUGE_VAL));
 
 	strValue = GetParam(mapParams, SIMMODEL_MOBILITY_PARAM, SIMMODEL_MOBILITY_PARAM_DEFAULT);
 	if (!g_pSimulator->m_ModelMgr.GetModel(strValue, pModel))
@@ -313,6 +298,7 @@ int SimModel::PreRun()
 		m_iCRShapePoint = m_pTripModel->GetCRShapePoint();
 		m_fCRProgress = m_pTripModel->GetCRProgress();
 	}
+	PublishState();
 
 	m_tTimestamp = timeval0;
 	return 0;
@@ -327,35 +313,12 @@ int SimModel::ProcessEvent(SimEvent & event)
 	{
 	case EVENT_CARMODEL_UPDATE:
 	{
-		if (!m_pMobilityModel || !m_pTripModel)
-			return 2;
-
-		if (event.GetTimestamp() > g_pSimulator->m_tStart + m_tStartTime)
-		{
-			//It looks like this is where the default
-			//location update packets are being created -MH
-			Packet msg;
+		MobilityState state;
 
-			if (m_tTimestamp == timeval0)
-				m_tTimestamp = g_pSimulator->m_tStart + m_tStartTime;
-
-			m_bActive = m_pMobilityModel->DoIteration(ToFloat(event.GetTimestamp() - m_tTimestamp), m_iCurrentRecord, m_ptPosition, m_iSpeed, m_iHeading, m_iLane);
-
-			m_tTimestamp = event.GetTimestamp();
-			m_iCurrentRecord = m_pTripModel->GetCurrentRecord();
-			m_bForwards = m_pTripModel->IsGoingForwards();
-			m_iCRShapePoint = m_pTripModel->GetCRShapePoint();
-			m_fCRProgress = m_pTripModel->GetCRProgress();
-	
-			// send message to clients
-			CreateMessage(&msg);
-			if (m_bLogThisCar)
-				g_pLogger->WriteMessage(LOGFILE_MESSAGES, &msg);
-			if (m_pCommModel != NULL);
-				m_pCommModel->TransmitMessage(&msg);
-		}
-		else
-			m_bActive = false;
+		if (!LoadMobilityState(event.GetTimestamp(), state))
+			return 2;
+		AdvanceMobility(state);
+		StoreMobilityState(event.GetTimestamp(), state);
 		return 0;
 	}
 	default:
@@ -363,6 +326,79 @@ int SimModel::ProcessEvent(SimEvent & event)
 	}
 }
 
+bool SimModel::LoadMobilityState(struct timeval tCurrent, MobilityState & state)
+{
+	if (!m_pMobilityModel || !m_pTripModel)
+	{
+		state.bMoving = false;
+		return false;
+	}
+
+	state.tCurrent = tCurrent;
+	state.bMoving = tCurrent > g_pSimulator->m_tStart + m_tStartTime;
+	if (state.bMoving)
+	{
+		if (m_tTimestamp == timeval0)
+			m_tTimestamp = g_pSimulator->m_tStart + m_tStartTime;
+		state.fElapsed = ToFloat(tCurrent - m_tTimestamp);
+	}
+	else
+		state.fElapsed = 0.f;
+	state.iRecord = m_iCurrentRecord;
+	state.ptPosition = m_ptPosition;
+	state.iSpeed = m_iSpeed;
+	state.iHeading = m_iHeading;
+	state.iLane = m_iLane;
+	state.bActive = m_bActive;
+	return true;
+}
+
+void SimModel::StoreMobilityState(struct timeval tCurrent, const MobilityState & state)
+{
+	if (!m_pMobilityModel || !m_pTripModel)
+		return;
+
+	if (state.bMoving)
+	{
+		//It looks like this is where the default
+		//location update packets are being created -MH
+		Packet msg;
+
+		m_bActive = state.bActive;
+		m_iCurrentRecord = state.iRecord;
+		m_ptPosition = state.ptPosition;
+		m_iSpeed = state.iSpeed;
+		m_iHeading = state.iHeading;
+		m_iLane = state.iLane;
+
+		m_tTimestamp = tCurrent;
+		m_iCurrentRecord = m_pTripModel->GetCurrentRecord();
+		m_bForwards = m_pTripModel->IsGoingForwards();
+		m_iCRShapePoint = m_pTripModel->GetCRShapePoint();
+		m_fCRProgress = m_pTripModel->GetCRProgress();
+		PublishState();
+
+		// send message to clients
+		CreateMessage(&msg);
+		if (m_bLogThisCar)
+			g_pLogger->WriteMessage(LOGFILE_MESSAGES, &msg);
+		if (m_pCommModel != NULL)
+			m_pCommModel->TransmitMessage(&msg);
+	}
+	else
+		m_bActive = false;
+}
+
+// in synchronous-tick mode, cars are moved in batches by the simulator's
+// MobilityTicker instead of each scheduling its own update
+void SimModel::ScheduleUpdate()
+{
+	if (g_pSimulator->m_sSimSettings.bSyncTick && m_pMobilityModel != NULL && m_pTripModel != NULL && m_tDelay > timeval0)
+		g_pSimulator->m_pMobilityTicker->AddCar(this, m_tDelay);
+	else
+		CarModel::ScheduleUpdate();
+}
+
 /*
 int SimModel::Iteration(struct timeval tCurrent)
 {
@@ -420,6 +456,26 @@ int SimModel::Save(std::map<QString, QString> & mapParams)
 	return 0;
 }
 
+int SimModel::SaveState(CheckpointWriter & writer)
+{
+	if (CarModel::SaveState(writer))
+		return 1;
+
+	writer.WriteBool(m_bActive);
+	return 0;
+}
+
+int SimModel::LoadState(CheckpointReader & reader)
+{
+	if (CarModel::LoadState(reader))
+		return 1;
+
+	if (!reader.ReadBool(m_bActive))
+		return 2;
+	PublishState();
+	return 0;
+}
+
 void SimModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 {
 	CarModel::GetParams(mapParams);
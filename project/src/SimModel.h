@@ -52,7 +52,7 @@ public:
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
 	virtual bool GetInitialConditions(unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane) = 0;
-	virtual bool DoIteration(float fElapsed, unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane) = 0;
+	virtual bool DoIteration(struct timeval tCurrent, float fElapsed, unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane) = 0;
 	virtual void AssignLane(unsigned int iOldRecord, unsigned int iRecord, unsigned char & iLane);
 	virtual void SwitchLanes(unsigned int iRecord, unsigned short iShapePoint, float fProgress, short iSpeed, bool bForwards, unsigned char & iLane);
 	virtual short ChooseSpeed(unsigned int iRecord) const = 0;
@@ -101,7 +101,7 @@ public:
 	// current direction reported in centidegrees, clockwise from true North
 	virtual short GetCurrentDirection() const = 0;
 
-	virtual bool SetProgress(float & fTime, short iSpeed, unsigned int & iNextRecord) = 0;
+	virtual bool SetProgress(struct timeval tCurrent, float & fTime, short iSpeed, unsigned int & iNextRecord) = 0;
 
 	inline void SetCar(in_addr_t ipCar)
 	{
@@ -118,6 +118,21 @@ protected:
 
 #define SIMMODEL_NAME "SimModel"
 
+// a car's motion for one update, copied out of the car so that a batch of
+// cars can be moved together before any of them is changed
+typedef struct MobilityStateStruct
+{
+	struct timeval tCurrent; // the time of the update
+	float fElapsed;
+	unsigned int iRecord;
+	Coords ptPosition;
+	short iSpeed;
+	short iHeading;
+	unsigned char iLane;
+	bool bMoving; // the car has started, so its mobility model is run
+	bool bActive;
+} MobilityState;
+
 class SimModel : public CarModel
 {
 public:
@@ -141,16 +156,35 @@ public:
 	virtual int ProcessEvent(SimEvent & event);
 	virtual int PostRun();
 	virtual int Save(std::map<QString, QString> & mapParams);
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
-	virtual QString GetCarListColumnText(CarListColumn eColumn) const;
+	inline virtual const char * GetCarListType() const
+	{
+		return "Local/Simulated";
+	}
 	inline virtual bool IsActive() const
 	{
 		return m_bActive;
 	}
 
+	// an update is split into these three steps; only AdvanceMobility runs
+	// the mobility model, which also advances the trip model and may query
+	// the car registry for other cars
+	// returns false if the car has no mobility or trip model
+	bool LoadMobilityState(struct timeval tCurrent, MobilityState & state);
+	inline void AdvanceMobility(MobilityState & state)
+	{
+		if (state.bMoving)
+			state.bActive = m_pMobilityModel->DoIteration(state.tCurrent, state.fElapsed, state.iRecord, state.ptPosition, state.iSpeed, state.iHeading, state.iLane);
+	}
+	void StoreMobilityState(struct timeval tCurrent, const MobilityState & state);
+
 protected:
+	virtual void ScheduleUpdate();
+
 	SimMobilityModel * m_pMobilityModel;
 	SimTripModel * m_pTripModel;
 
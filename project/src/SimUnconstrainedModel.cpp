@@ -23,6 +23,7 @@
  ***************************************************************************/
 
 #include "SimUnconstrainedModel.h"
+#include "SimCheckpoint.h"
 #include "CarRegistry.h"
 #include "StringHelp.h"
 #include "Simulator.h"
@@ -90,17 +91,6 @@ SimUnconstrainedModel & SimUnconstrainedModel::operator =(const SimUnconstrained
 	return *this;
 }
 
-QString SimUnconstrainedModel::GetCarListColumnText(CarListColumn eColumn) const
-{
-	switch (eColumn)
-	{
-	case CarListColumnType:
-		return "Local/Simulated";
-	default:
-		return CarModel::GetCarListColumnText(eColumn);
-	}
-}
-
 int SimUnconstrainedModel::Init(const std::map<QString, QString> & mapParams)
 {
 	QString strValue;
@@ -109,8 +99,7 @@ int SimUnconstrainedModel::Init(const std::map<QString, QString> & mapParams)
 	if (CarModel::Init(mapParams))
 		return 1;
 
-	strValue = GetParam(mapParams, SIMUNCONSTRAINEDMODEL_STARTTIME_PARAM, SIMUNCONSTRAINEDMODEL_STARTTIME_PARAM_DEFAULT);
-	m_tStartTime = MakeTime(ValidateNumber(StringToNumber(strValue), 0, HUGE_VAL));
+	m_tStartTime = MakeTime(ValidateNumber(GetNumberParam(mapParams, SIMUNCONSTRAINEDMODEL_STARTTIME_PARAM, SIMUNCONSTRAINEDMODEL_STARTTIME_PARAM_DEFAULT), 0, HUGE_VAL));
 
 	strValue = GetParam(mapParams, SIMUNCONSTRAINEDMODEL_MOBILITY_PARAM, SIMUNCONSTRAINEDMODEL_MOBILITY_PARAM_DEFAULT);
 	if (!g_pSimulator->m_ModelMgr.GetModel(strValue, pModel))
@@ -141,6 +130,7 @@ int SimUnconstrainedModel::PreRun()
 	}
 	else
 		m_pMobilityModel->GetInitialConditions(m_ptPosition, m_iSpeed, m_iHeading);
+	PublishState();
 
 	m_tTimestamp = timeval0;
 	return 0;
@@ -168,6 +158,7 @@ int SimUnconstrainedModel::ProcessEvent(SimEvent & event)
 			m_bActive = m_pMobilityModel->DoIteration(ToFloat(event.GetTimestamp() - m_tTimestamp), m_ptPosition, m_iSpeed, m_iHeading);
 
 			m_tTimestamp = event.GetTimestamp();
+			PublishState();
 	
 			// send message to clients
 			CreateMessage(&msg);
@@ -206,6 +197,26 @@ int SimUnconstrainedModel::Save(std::map<QString, QString> & mapParams)
 	return 0;
 }
 
+int SimUnconstrainedModel::SaveState(CheckpointWriter & writer)
+{
+	if (CarModel::SaveState(writer))
+		return 1;
+
+	writer.WriteBool(m_bActive);
+	return 0;
+}
+
+int SimUnconstrainedModel::LoadState(CheckpointReader & reader)
+{
+	if (CarModel::LoadState(reader))
+		return 1;
+
+	if (!reader.ReadBool(m_bActive))
+		return 2;
+	PublishState();
+	return 0;
+}
+
 void SimUnconstrainedModel::GetParams(std::map<QString, ModelParameter> & mapParams)
 {
 	CarModel::GetParams(mapParams);
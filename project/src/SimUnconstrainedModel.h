@@ -92,10 +92,15 @@ public:
 	virtual int ProcessEvent(SimEvent & event);
 	virtual int PostRun();
 	virtual int Save(std::map<QString, QString> & mapParams);
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
-	virtual QString GetCarListColumnText(CarListColumn eColumn) const;
+	inline virtual const char * GetCarListType() const
+	{
+		return "Local/Simulated";
+	}
 	inline virtual bool IsActive() const
 	{
 		return m_bActive;
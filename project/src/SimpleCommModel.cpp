@@ -27,6 +27,7 @@
 #include "InfrastructureNodeRegistry.h"
 #include "StringHelp.h"
 #include "Simulator.h"
+#include "SimCheckpoint.h"
 
 #define SIMPLECOMMMODEL_REBROADCASTINTERVAL_PARAM "REBROADCASTINTERVAL"
 #define SIMPLECOMMMODEL_REBROADCASTINTERVAL_PARAM_DEFAULT "1"
@@ -45,12 +46,12 @@
 #define SIMPLECOMMMODEL_RBXJITTER_PARAM_DESC "RBXJITTER (Yes/No) -- Specify \"Yes\" to enable jittering of the rebroadcast event, \"No\" to disable it."
 
 SimpleCommModel::SimpleCommModel(const QString & strModelName)
-: CarCommModel(strModelName), m_bRebroadcast(true), m_bGateway(false), m_bJitter(true), m_tRebroadcastInterval(MakeTime(1, 0))
+: CarCommModel(strModelName), m_bRebroadcast(true), m_bGateway(false), m_bJitter(true), m_tRebroadcastInterval(MakeTime(1, 0)), m_pRebroadcastFree(NULL)
 {
 }
 
 SimpleCommModel::SimpleCommModel(const SimpleCommModel & copy)
-: CarCommModel(copy), m_bRebroadcast(copy.m_bRebroadcast), m_bGateway(copy.m_bGateway), m_bJitter(copy.m_bJitter), m_tRebroadcastInterval(copy.m_tRebroadcastInterval)
+: CarCommModel(copy), m_bRebroadcast(copy.m_bRebroadcast), m_bGateway(copy.m_bGateway), m_bJitter(copy.m_bJitter), m_tRebroadcastInterval(copy.m_tRebroadcastInterval), m_pRebroadcastFree(NULL)
 {
 }
 
@@ -71,19 +72,16 @@ SimpleCommModel & SimpleCommModel::operator = (const SimpleCommModel & copy)
 
 int SimpleCommModel::Init(const std::map<QString, QString> & mapParams)
 {
-	QString strValue;
-
 	if (CarCommModel::Init(mapParams))
 		return 1;
 
-	strValue = GetParam(mapParams, SIMPLECOMMMODEL_REBROADCASTINTERVAL_PARAM, SIMPLECOMMMODEL_REBROADCASTINTERVAL_PARAM_DEFAULT);
-	m_tRebroadcastInterval = MakeTime(ValidateNumber(StringToNumber(strValue), 0., HUGE_VAL));
+	m_tRebroadcastInterval = MakeTime(ValidateNumber(GetNumberParam(mapParams, SIMPLECOMMMODEL_REBROADCASTINTERVAL_PARAM, SIMPLECOMMMODEL_REBROADCASTINTERVAL_PARAM_DEFAULT), 0., HUGE_VAL));
 
-	m_bRebroadcast = StringToBoolean(GetParam(mapParams, SIMPLECOMMMODEL_DOREBROADCAST_PARAM, SIMPLECOMMMODEL_DOREBROADCAST_PARAM_DEFAULT));
+	m_bRebroadcast = GetBooleanParam(mapParams, SIMPLECOMMMODEL_DOREBROADCAST_PARAM, SIMPLECOMMMODEL_DOREBROADCAST_PARAM_DEFAULT);
 
-	m_bGateway = StringToBoolean(GetParam(mapParams, SIMPLECOMMMODEL_MOBILEGATEWAY_PARAM, SIMPLECOMMMODEL_MOBILEGATEWAY_PARAM_DEFAULT));
+	m_bGateway = GetBooleanParam(mapParams, SIMPLECOMMMODEL_MOBILEGATEWAY_PARAM, SIMPLECOMMMODEL_MOBILEGATEWAY_PARAM_DEFAULT);
 
-	m_bJitter = StringToBoolean(GetParam(mapParams, SIMPLECOMMMODEL_RBXJITTER_PARAM, SIMPLECOMMMODEL_RBXJITTER_PARAM_DEFAULT));
+	m_bJitter = GetBooleanParam(mapParams, SIMPLECOMMMODEL_RBXJITTER_PARAM, SIMPLECOMMMODEL_RBXJITTER_PARAM_DEFAULT);
 
 	return 0;
 }
@@ -93,6 +91,8 @@ int SimpleCommModel::PreRun()
 	if (CarCommModel::PreRun())
 		return 1;
 
+	// the event queue has been emptied, so no event refers to the slab
+	ClearRebroadcasts();
 	return 0;
 }
 
@@ -106,7 +106,9 @@ int SimpleCommModel::ProcessEvent(SimEvent & event)
 	case EVENT_CARCOMMMODEL_REBROADCAST:
 	{
 		RebroadcastMessage * pRBXMsg = (RebroadcastMessage *)event.GetEventData();
-		if (pRBXMsg != NULL)
+		if (pRBXMsg != NULL && pRBXMsg->bCancelled)
+			FreeRebroadcast(pRBXMsg);
+		else if (pRBXMsg != NULL)
 		{
 			struct timeval tNext = pRBXMsg->tIntervalHigh + (m_bJitter ? MakeTime(RandDouble(0., ToDouble(m_tRebroadcastInterval))) : m_tRebroadcastInterval);
 			pRBXMsg->msg.m_tTX = event.GetTimestamp();
@@ -114,9 +116,10 @@ int SimpleCommModel::ProcessEvent(SimEvent & event)
 			pRBXMsg->tIntervalLow = pRBXMsg->tIntervalHigh;
 			pRBXMsg->tIntervalHigh = pRBXMsg->tIntervalHigh + m_tRebroadcastInterval;
 			if (pRBXMsg->msg.m_tTime + pRBXMsg->msg.m_tLifetime <= tNext)
-				delete pRBXMsg;
+				FreeRebroadcast(pRBXMsg);
 			else
 			{
+				pRBXMsg->tNext = tNext;
 				event.SetTimestamp(tNext);
 				g_pSimulator->m_EventQueue.AddEvent(event);
 			}
@@ -266,11 +269,132 @@ void SimpleCommModel::AddMessageToRebroadcastQueue(const SafetyPacket & msg)
 
 	// check to see if this a message that should be rebroadcast
 
-	RebroadcastMessage * pRBXMsg = new RebroadcastMessage;
+	RebroadcastMessage * pRBXMsg = AllocRebroadcast(msg);
+	pRBXMsg->tIntervalHigh = pRBXMsg->tIntervalLow + m_tRebroadcastInterval;
+	ScheduleRebroadcast(pRBXMsg, pRBXMsg->tIntervalLow + (m_bJitter ? MakeTime(RandDouble(0., ToDouble(m_tRebroadcastInterval))) : m_tRebroadcastInterval));
+}
+
+SimpleCommModel::RebroadcastMessage * SimpleCommModel::AllocRebroadcast(const SafetyPacket & msg)
+{
+	RebroadcastMessage * pRBXMsg;
+
+	if (m_pRebroadcastFree != NULL)
+	{
+		pRBXMsg = m_pRebroadcastFree;
+		m_pRebroadcastFree = pRBXMsg->pNextFree;
+	}
+	else
+	{
+		m_deqRebroadcastSlab.resize(m_deqRebroadcastSlab.size() + 1);
+		pRBXMsg = &m_deqRebroadcastSlab.back();
+	}
 	pRBXMsg->msg = msg;
 	pRBXMsg->tIntervalLow = msg.m_tRX;
-	pRBXMsg->tIntervalHigh = pRBXMsg->tIntervalLow + m_tRebroadcastInterval;
-	g_pSimulator->m_EventQueue.AddEvent(SimEvent(pRBXMsg->tIntervalLow + (m_bJitter ? MakeTime(RandDouble(0., ToDouble(m_tRebroadcastInterval))) : m_tRebroadcastInterval), EVENT_PRIORITY_LOWEST, m_strModelName, m_strModelName, EVENT_CARCOMMMODEL_REBROADCAST, pRBXMsg, DestroyRebroadcastMessage));
+	pRBXMsg->bCancelled = false;
+	pRBXMsg->pNextFree = NULL;
+	m_mapRebroadcastHandles.insert(std::pair<PacketSequence, RebroadcastMessage *>(msg.m_ID.srcID, pRBXMsg));
+	return pRBXMsg;
+}
+
+void SimpleCommModel::FreeRebroadcast(RebroadcastMessage * pRBXMsg)
+{
+	std::pair<std::multimap<PacketSequence, RebroadcastMessage *>::iterator, std::multimap<PacketSequence, RebroadcastMessage *>::iterator> rangeHandles = m_mapRebroadcastHandles.equal_range(pRBXMsg->msg.m_ID.srcID);
+	for (; rangeHandles.first != rangeHandles.second; ++rangeHandles.first)
+	{
+		if (rangeHandles.first->second == pRBXMsg)
+		{
+			m_mapRebroadcastHandles.erase(rangeHandles.first);
+			break;
+		}
+	}
+	pRBXMsg->pNextFree = m_pRebroadcastFree;
+	m_pRebroadcastFree = pRBXMsg;
+}
+
+bool SimpleCommModel::CancelRebroadcast(const PacketSequence & ID)
+{
+	std::pair<std::multimap<PacketSequence, RebroadcastMessage *>::iterator, std::multimap<PacketSequence, RebroadcastMessage *>::iterator> rangeHandles = m_mapRebroadcastHandles.equal_range(ID);
+	bool bCancelled = false;
+
+	for (; rangeHandles.first != rangeHandles.second; ++rangeHandles.first)
+	{
+		if (!rangeHandles.first->second->bCancelled)
+		{
+			CancelRebroadcast(rangeHandles.first->second);
+			bCancelled = true;
+		}
+	}
+	return bCancelled;
+}
+
+void SimpleCommModel::ClearRebroadcasts()
+{
+	m_deqRebroadcastSlab.clear();
+	m_pRebroadcastFree = NULL;
+	m_mapRebroadcastHandles.clear();
+}
+
+// the slab owns the message, so the event is given no destroy function
+void SimpleCommModel::ScheduleRebroadcast(RebroadcastMessage * pRBXMsg, struct timeval tNext)
+{
+	pRBXMsg->tNext = tNext;
+	g_pSimulator->m_EventQueue.AddEvent(SimEvent(tNext, EVENT_PRIORITY_LOWEST, m_strModelName, m_strModelName, EVENT_CARCOMMMODEL_REBROADCAST, pRBXMsg));
+}
+
+// the rebroadcasts still to come; cancelled ones would only be freed
+int SimpleCommModel::SaveState(CheckpointWriter & writer)
+{
+	std::multimap<PacketSequence, RebroadcastMessage *>::iterator iterHandle;
+	unsigned int numPending = 0;
+
+	if (CarCommModel::SaveState(writer))
+		return 1;
+
+	if (writer.IsWarmStart())
+		return 0;
+	for (iterHandle = m_mapRebroadcastHandles.begin(); iterHandle != m_mapRebroadcastHandles.end(); ++iterHandle)
+		if (!iterHandle->second->bCancelled)
+			numPending++;
+	writer.WriteUInt(numPending);
+	for (iterHandle = m_mapRebroadcastHandles.begin(); iterHandle != m_mapRebroadcastHandles.end(); ++iterHandle)
+	{
+		if (iterHandle->second->bCancelled)
+			continue;
+		writer.WriteTime(iterHandle->second->tNext);
+		writer.WriteTime(iterHandle->second->tIntervalLow);
+		writer.WriteTime(iterHandle->second->tIntervalHigh);
+		writer.WritePacket(iterHandle->second->msg);
+	}
+	return 0;
+}
+
+// the simulator drops the rebroadcast events queued before a resume, so
+// the slab can start over
+int SimpleCommModel::LoadState(CheckpointReader & reader)
+{
+	RebroadcastMessage * pRBXMsg;
+	SafetyPacket msg;
+	struct timeval tNext, tIntervalLow, tIntervalHigh;
+	unsigned int i, numPending;
+
+	if (CarCommModel::LoadState(reader))
+		return 1;
+
+	if (reader.IsWarmStart())
+		return 0;
+	// the simulator has already cleared the slab along with the events
+	if (!reader.ReadUInt(numPending))
+		return 2;
+	for (i = 0; i < numPending; i++)
+	{
+		if (!reader.ReadTime(tNext) || !reader.ReadTime(tIntervalLow) || !reader.ReadTime(tIntervalHigh) || !reader.ReadPacket(msg))
+			return 2;
+		pRBXMsg = AllocRebroadcast(msg);
+		pRBXMsg->tIntervalLow = tIntervalLow;
+		pRBXMsg->tIntervalHigh = tIntervalHigh;
+		ScheduleRebroadcast(pRBXMsg, tNext);
+	}
+	return 0;
 }
 
 void SimpleCommModel::GetParams(std::map<QString, ModelParameter> & mapParams)
@@ -29,13 +29,21 @@
 
 #include "CarModel.h"
 
+#include <deque>
+
 class SimpleCommModel : public CarCommModel
 {
 public:
+	// pending rebroadcasts live in a per-model slab and are handed to the
+	// event queue by address; a cancelled one is returned to the slab when
+	// its event comes due
 	typedef struct RebroadcastMessageStruct
 	{
 		SafetyPacket msg;
 		struct timeval tIntervalLow, tIntervalHigh;
+		struct timeval tNext; // when its event comes due
+		bool bCancelled;
+		struct RebroadcastMessageStruct * pNextFree;
 	} RebroadcastMessage;
 
 	inline virtual QString GetModelType() const
@@ -57,11 +65,22 @@ public:
 	virtual int PreRun();
 	virtual int ProcessEvent(SimEvent & event);
 	virtual int Save(std::map<QString, QString> & mapParams);
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 
 	virtual bool DoUpdate(struct timeval tCurrent);
 
 	virtual bool TransmitMessage(Packet * msg);
 	virtual void AddMessageToRebroadcastQueue(const SafetyPacket & msg);
+	// stop a pending rebroadcast; pRBXMsg stays reserved until its event
+	inline void CancelRebroadcast(RebroadcastMessage * pRBXMsg)
+	{
+		pRBXMsg->bCancelled = true;
+	}
+	// stop every pending rebroadcast of the message with this origin ID;
+	// returns false if none were pending
+	bool CancelRebroadcast(const PacketSequence & ID);
+	virtual void ClearRebroadcasts();
 
 	inline virtual bool IsGateway() const
 	{
@@ -71,16 +90,20 @@ public:
 	static void GetParams(std::map<QString, ModelParameter> & mapParams);
 
 protected:
+	RebroadcastMessage * AllocRebroadcast(const SafetyPacket & msg);
+	void FreeRebroadcast(RebroadcastMessage * pRBXMsg);
+	void ScheduleRebroadcast(RebroadcastMessage * pRBXMsg, struct timeval tNext);
+
 //	std::vector<RebroadcastMessage> m_vecRebroadcast;
 	bool m_bRebroadcast, m_bGateway, m_bJitter;
 	struct timeval m_tRebroadcastInterval;
+	// a deque never moves its elements, so event data can point into it
+	std::deque<RebroadcastMessage> m_deqRebroadcastSlab;
+	RebroadcastMessage * m_pRebroadcastFree;
+	// the pending rebroadcasts of each message, by origin ID
+	std::multimap<PacketSequence, RebroadcastMessage *> m_mapRebroadcastHandles;
 };
 
-inline void DestroyRebroadcastMessage(void * ptr)
-{
-	delete (SimpleCommModel::RebroadcastMessage *)ptr;
-}
-
 inline Model * SimpleCommModelCreator(const QString & strModelName)
 {
 	return new SimpleCommModel(strModelName);
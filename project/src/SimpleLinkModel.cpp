@@ -77,7 +77,7 @@ bool SimpleLinkModel::BeginProcessPacket(Packet * packet)
 
 bool SimpleLinkModel::EndProcessPacket(Packet * packet)
 {
-	return m_mapPackets.find(packet->m_ID.srcID) == m_mapPackets.end();
+	return !HasReceivedPacket(packet->m_ID.srcID);
 }
 
 void SimpleLinkModel::GetParams(std::map<QString, ModelParameter> & mapParams)
@@ -27,6 +27,7 @@
 #include "InfrastructureNodeRegistry.h"
 #include "StringHelp.h"
 #include "Logger.h"
+#include "SimCheckpoint.h"
 
 #define SIMPLEPHYSMODEL_PARAM_DISTTHRESH "MAXDISTANCE"
 #define SIMPLEPHYSMODEL_PARAM_DISTTHRESH_DEFAULT "200"
@@ -62,15 +63,12 @@ SimplePhysModel & SimplePhysModel::operator = (const SimplePhysModel & copy)
 
 int SimplePhysModel::Init(const std::map<QString, QString> & mapParams)
 {
-	QString strValue;
-
 	if (CarPhysModel::Init(mapParams))
 		return 1;
 
-	strValue = GetParam(mapParams, SIMPLEPHYSMODEL_PARAM_DISTTHRESH, SIMPLEPHYSMODEL_PARAM_DISTTHRESH_DEFAULT);
-	m_fDistanceThreshold = ValidateNumber(StringToNumber(strValue), 0., HUGE_VAL);
+	m_fDistanceThreshold = ValidateNumber(GetNumberParam(mapParams, SIMPLEPHYSMODEL_PARAM_DISTTHRESH, SIMPLEPHYSMODEL_PARAM_DISTTHRESH_DEFAULT), 0., HUGE_VAL);
 
-	m_bMultichannel = StringToBoolean(GetParam(mapParams, SIMPLEPHYSMODEL_MULTICHANNEL_PARAM, SIMPLEPHYSMODEL_MULTICHANNEL_PARAM_DEFAULT));
+	m_bMultichannel = GetBooleanParam(mapParams, SIMPLEPHYSMODEL_MULTICHANNEL_PARAM, SIMPLEPHYSMODEL_MULTICHANNEL_PARAM_DEFAULT);
 	return 0;
 }
 
@@ -83,6 +81,26 @@ int SimplePhysModel::PreRun()
 	return 0;
 }
 
+int SimplePhysModel::SaveState(CheckpointWriter & writer)
+{
+	if (CarPhysModel::SaveState(writer))
+		return 1;
+
+	if (!writer.IsWarmStart())
+		writer.WriteUInt(m_iMessages);
+	return 0;
+}
+
+int SimplePhysModel::LoadState(CheckpointReader & reader)
+{
+	if (CarPhysModel::LoadState(reader))
+		return 1;
+
+	if (!reader.IsWarmStart() && !reader.ReadUInt(m_iMessages))
+		return 2;
+	return 0;
+}
+
 int SimplePhysModel::Save(std::map<QString, QString> & mapParams)
 {
 	if (CarPhysModel::Save(mapParams))
@@ -178,11 +196,16 @@ bool SimplePhysModel::ReceivePacket(Packet * packet)
 	return bValid;
 }
 
+// ranges are measured on a flat plane around the car, which is well within
+// the precision of the haversine over radio distances (see LocalFrame)
 bool SimplePhysModel::IsCarInRange(const Coords & ptCar, const Coords & ptPosition) const
 {
-	float f = Distance(ptCar, ptPosition) * METERSPERMILE;
-//	g_pLogger->LogInfo(QString("%1\n").arg(f));
-	return f < m_fDistanceThreshold;
+	return LocalFrame(ptCar).IsInRange(ptPosition, m_fDistanceThreshold);
+}
+
+unsigned int SimplePhysModel::AreCarsInRange(const Coords & ptCar, const Coords * pPositions, unsigned int iCount, unsigned char * pInRange) const
+{
+	return LocalFrame(ptCar).InRange(pPositions, iCount, m_fDistanceThreshold, pInRange);
 }
 
 void SimplePhysModel::GetParams(std::map<QString, ModelParameter> & mapParams)
@@ -48,6 +48,8 @@ public:
 	virtual int Init(const std::map<QString, QString> & mapParams);
 	virtual int PreRun();
 	virtual int Save(std::map<QString, QString> & mapParams);
+	virtual int SaveState(CheckpointWriter & writer);
+	virtual int LoadState(CheckpointReader & reader);
 
 	virtual SimplePhysModel & operator = (const SimplePhysModel & copy);
 
@@ -61,6 +63,7 @@ public:
 		return m_fDistanceThreshold;
 	}
 	virtual bool IsCarInRange(const Coords & ptCar, const Coords & ptPosition) const;
+	virtual unsigned int AreCarsInRange(const Coords & ptCar, const Coords * pPositions, unsigned int iCount, unsigned char * pInRange) const;
 	inline virtual unsigned int GetMessageCount() const
 	{
 		return m_iMessages;
@@ -30,21 +30,40 @@
 #include "Settings.h"
 #include "CarRegistry.h"
 #include "InfrastructureNodeRegistry.h"
+#include "MobilityTick.h"
+#include "SimCheckpoint.h"
 
 #include <qfile.h>
-#include <qtextstream.h>
 #include <qcursor.h>
 #include <qapplication.h>
 #include <qmessagebox.h>
 #include <qstatusbar.h>
 
+#define SIMULATOR_SNAPSHOT_RATE_DEFAULT 10.
+#define SIMULATOR_CHECKPOINT_INTERVAL_DEFAULT 600.
+
 Simulator::Simulator()
-: m_tCurrent(timeval0), m_tStart(timeval0), m_bLoaded(false), m_bCancelled(false), m_bNextTrial(false), m_iPaused(0), m_pMutexPause(new QMutex(true))
+: m_pMobilityTicker(new MobilityTicker()), m_tCurrent(timeval0), m_tStart(timeval0), m_bLoaded(false), m_bCancelled(false), m_bNextTrial(false), m_iPaused(0), m_pMutexPause(new QMutex(true))
 {
+	double fSnapshotRate, fCheckpointInterval, fWarmUp;
+
 	m_sSimSettings.tDuration = timeval0;
 	m_sSimSettings.tIncrement = timeval0;
 	m_sSimSettings.bSimulationTime = false;
 	m_sSimSettings.iTrials = 0;
+	m_sSimSettings.bSyncTick = g_pSettings != NULL && g_pSettings->GetParam(PARAMKEY_SYNC_TICK, "0", true) != "0";
+	// display snapshots per second; 0 refreshes on every pass of the event loop
+	fSnapshotRate = g_pSettings == NULL ? SIMULATOR_SNAPSHOT_RATE_DEFAULT : StringToNumber(g_pSettings->GetParam(PARAMKEY_SNAPSHOT_RATE, QString("%1").arg(SIMULATOR_SNAPSHOT_RATE_DEFAULT)));
+	m_sSimSettings.tSnapshotPeriod = fSnapshotRate > 0. ? MakeTime(1. / fSnapshotRate) : timeval0;
+	// simulated seconds between checkpoints; no file, no checkpoints
+	m_sSimSettings.strCheckpoint = g_pSettings == NULL ? QString::null : g_pSettings->GetParam(PARAMKEY_CHECKPOINT, QString::null, true);
+	fCheckpointInterval = g_pSettings == NULL ? SIMULATOR_CHECKPOINT_INTERVAL_DEFAULT : StringToNumber(g_pSettings->GetParam(PARAMKEY_CHECKPOINT_INTERVAL, QString("%1").arg(SIMULATOR_CHECKPOINT_INTERVAL_DEFAULT)));
+	m_sSimSettings.tCheckpointPeriod = fCheckpointInterval > 0. ? MakeTime(fCheckpointInterval) : timeval0;
+	m_sSimSettings.strResume = g_pSettings == NULL ? QString::null : g_pSettings->GetParam(PARAMKEY_RESUME, QString::null, true);
+	// simulated seconds of warm-up before the warm start file is saved
+	m_sSimSettings.strWarmStart = g_pSettings == NULL ? QString::null : g_pSettings->GetParam(PARAMKEY_WARM_START, QString::null, true);
+	fWarmUp = g_pSettings == NULL ? 0. : StringToNumber(g_pSettings->GetParam(PARAMKEY_WARM_UP, "0"));
+	m_sSimSettings.tWarmUp = fWarmUp > 0. ? MakeTime(fWarmUp) : timeval0;
 }
 
 Simulator::~Simulator()
@@ -53,6 +72,8 @@ Simulator::~Simulator()
 		Unload();
 	delete m_pMutexPause;
 	m_pMutexPause = NULL;
+	delete m_pMobilityTicker;
+	m_pMobilityTicker = NULL;
 }
 
 bool Simulator::New(const std::map<QString, std::map<QString, QString> > & mapModels)
@@ -97,9 +118,10 @@ bool Simulator::New(const std::map<QString, std::map<QString, QString> > & mapMo
 		bSuccess = m_ModelMgr.BuildModelTree(vecDepends) > 0;
 
 	qApp->processEvents();
-	if (bSuccess)
+	if (bSuccess) {
 		m_bLoaded = true;
-	else
+		PublishSnapshot();
+	} else
 		Unload();
 
 	if (g_pMainWindow != NULL) {
@@ -151,16 +173,12 @@ bool Simulator::internalAddNew(const std::map<QString, std::map<QString, QString
 
 int Simulator::Load(const QString & strFilename)
 {
-	QFile file(strFilename);
-	QTextStream reader;
-	QString line;
-	std::vector<std::pair<QString, QString> > vecPairs, vecDepends;
-	std::map<QString, QString> mapParams;
-	unsigned int i, fsm_state, iProgress = (unsigned)-1;
-	int model_index, type_index, depends_index;
+	std::vector<ScenarioModel> vecModels;
+	std::vector<std::pair<QString, QString> > vecDepends;
+	unsigned int i, iProgress = (unsigned)-1;
 	int result;
 
-	if (!file.open(IO_ReadOnly | IO_Translate))
+	if (!QFile::exists(strFilename))
 	{
 		errno = ENOENT;
 		return 0;
@@ -173,118 +191,37 @@ int Simulator::Load(const QString & strFilename)
 		g_pMainWindow->m_pLblStatus->setText("Loading simulation...");
 	qApp->processEvents();
 
-	reader.setDevice(&file);
-
-	while (!(line = reader.readLine()).isNull())
+	if (!ReadScenario(strFilename, vecModels))
 	{
-		if (line.isEmpty() || line[0] == '%')
-			continue;
-
-		/* extract each line's parameters */
-		if (!ExtractParams(line, vecPairs))
-		{
-			/* malformed file? */
-			reader.unsetDevice();
-			file.close();
-			errno = EINVAL;
-			return 0;
-		}
+		/* malformed file? */
+		errno = EINVAL;
+		return 0;
 	}
-
-	reader.unsetDevice();
-	file.close();
 	qApp->processEvents();
 
-	/* now we parse the parameters -- using a simple FSM */
-#define FSM_STATE_SEARCHMODEL 0
-#define FSM_STATE_GETPARAMSTYPE 1
-#define FSM_STATE_GETPARAMSNOTYPE 2
-
-	fsm_state = FSM_STATE_SEARCHMODEL;
-	model_index = depends_index = type_index = -1;
-	mapParams.clear();
-	for (i = 0; i < vecPairs.size(); i++)
+	vecDepends.reserve(vecModels.size());
+	for (i = 0; i < vecModels.size(); i++)
 	{
-		if (i*100/vecPairs.size() != iProgress && g_pMainWindow != NULL && g_pMainWindow->m_pLblStatus != NULL)
-			g_pMainWindow->m_pLblStatus->setText(QString("Loading simulation... (%1%)").arg(iProgress = i * 100 / vecPairs.size()));
-		qApp->processEvents();
-		switch (fsm_state)
+		// only let the GUI run when there is new progress to show
+		if (i*100/vecModels.size() != iProgress)
 		{
-			case FSM_STATE_SEARCHMODEL:
-				/* if searching for model */
-				if (!vecPairs[i].first.upper().compare(PARAM_MODEL))
-				{
-					mapParams.clear();
-					model_index = i;
-					depends_index = type_index = -1;
-					fsm_state = FSM_STATE_GETPARAMSTYPE;
-				}
-				break;
-			case FSM_STATE_GETPARAMSTYPE:
-				/* if searching for params, type */
-				if (!vecPairs[i].first.upper().compare(PARAM_MODEL))
-				{
-					mapParams.clear();
-					model_index = i;
-					depends_index = type_index = -1;
-				}
-				else if (!vecPairs[i].first.upper().compare(PARAM_TYPE))
-				{
-					type_index = i;
-					fsm_state = FSM_STATE_GETPARAMSNOTYPE;
-					mapParams[vecPairs[i].first] = vecPairs[i].second;
-				}
-				else if (!vecPairs[i].first.upper().compare(PARAM_DEPENDS)) {
-					depends_index = i;
-					mapParams[vecPairs[i].first] = vecPairs[i].second;
-				} else
-					mapParams[vecPairs[i].first] = vecPairs[i].second;
-				break;
-			case FSM_STATE_GETPARAMSNOTYPE:
-				/* if searching for params, type */
-				if (!vecPairs[i].first.upper().compare(PARAM_MODEL))
-				{
-					if (m_ModelMgr.AddModel(vecPairs[model_index].second, vecPairs[type_index].second, mapParams))
-					{
-						if (depends_index > -1)
-							vecDepends.push_back(std::pair<QString, QString>(vecPairs[model_index].second, vecPairs[depends_index].second));
-						else
-							vecDepends.push_back(std::pair<QString, QString>(vecPairs[model_index].second, ""));
-					}
-					mapParams.clear();
-					model_index = i;
-					depends_index = type_index = -1;
-					fsm_state = FSM_STATE_GETPARAMSTYPE;
-				}
-				else if (!vecPairs[i].first.upper().compare(PARAM_TYPE))
-				{
-				}
-				else if (!vecPairs[i].first.upper().compare(PARAM_DEPENDS)) {
-					depends_index = i;
-					mapParams[vecPairs[i].first] = vecPairs[i].second;
-				} else
-					mapParams[vecPairs[i].first] = vecPairs[i].second;
-				break;
+			iProgress = i*100/vecModels.size();
+			if (g_pMainWindow != NULL && g_pMainWindow->m_pLblStatus != NULL)
+				g_pMainWindow->m_pLblStatus->setText(QString("Loading simulation... (%1%)").arg(iProgress));
+			qApp->processEvents();
 		}
+		if (m_ModelMgr.AddModel(vecModels[i].strName, vecModels[i].strType, vecModels[i].mapParams))
+			vecDepends.push_back(std::pair<QString, QString>(vecModels[i].strName, vecModels[i].strDepends));
 	}
+	vecModels.clear();
 
 	if (g_pMainWindow != NULL && g_pMainWindow->m_pLblStatus != NULL)
 		g_pMainWindow->m_pLblStatus->setText("Loading simulation... (100%)");
 	qApp->processEvents();
-	/* take care of last model if there is one */
-	if (model_index > -1 && type_index > -1)
-	{
-		if (m_ModelMgr.AddModel(vecPairs[model_index].second, vecPairs[type_index].second, mapParams))
-		{
-			if (depends_index > -1)
-				vecDepends.push_back(std::pair<QString, QString>(vecPairs[model_index].second, vecPairs[depends_index].second));
-			else
-				vecDepends.push_back(std::pair<QString, QString>(vecPairs[model_index].second, ""));
-		}
-	}
-	if ((result = m_ModelMgr.BuildModelTree(vecDepends)) > 0)
+	if ((result = m_ModelMgr.BuildModelTree(vecDepends)) > 0) {
 		m_bLoaded = true;
-	else
+		PublishSnapshot();
+	} else
 		Unload();
 
 	if (g_pMainWindow != NULL) {
@@ -300,18 +237,9 @@ int Simulator::Load(const QString & strFilename)
 
 void Simulator::Save(const QString & strFilename)
 {
-	QFile file(strFilename);
-	QTextStream writer;
+	std::vector<ScenarioModel> vecModels;
 	unsigned int i;
 
-	if (!file.open(IO_WriteOnly | IO_Truncate))
-		return;
-
-	writer.setDevice(&file);
-
-	writer << "% Created by GrooveNet Hybrid Simulator on " << QDate::currentDate(Qt::LocalTime).toString("M/dd/yyyy") << endl;
-	writer << endl;
-
 	m_ModelMgr.m_modelsMutex.lock();
 	m_ModelMgr.MarkAllModelsDirty();
 
@@ -319,7 +247,7 @@ void Simulator::Save(const QString & strFilename)
 	{
 		if (MODELTREENODE_ISVALID(m_ModelMgr.m_pModelTreeNodes[i]) && !MODELTREENODE_ISERROR(m_ModelMgr.m_pModelTreeNodes[i]))
 		{
-			if (MODELTREENODE_ISDIRTY(m_ModelMgr.m_pModelTreeNodes[i]) && !internalSave(writer, &m_ModelMgr.m_pModelTreeNodes[i]))
+			if (MODELTREENODE_ISDIRTY(m_ModelMgr.m_pModelTreeNodes[i]) && !internalSave(vecModels, &m_ModelMgr.m_pModelTreeNodes[i]))
 				m_ModelMgr.m_pModelTreeNodes[i].iBits |= MODELTREEBITS_ERROR;
 			else
 				m_ModelMgr.m_pModelTreeNodes[i].iBits &= ~MODELTREEBITS_DIRTY;
@@ -328,11 +256,11 @@ void Simulator::Save(const QString & strFilename)
 	m_ModelMgr.ClearAllModelsError();
 
 	m_ModelMgr.m_modelsMutex.unlock();
-	writer.unsetDevice();
-	file.close();
+
+	WriteScenario(strFilename, vecModels, QString("Created by GrooveNet Hybrid Simulator on %1").arg(QDate::currentDate(Qt::LocalTime).toString("M/dd/yyyy")));
 }
 
-bool Simulator::internalSave(QTextStream & writer, ModelTreeNode * pModelNode)
+bool Simulator::internalSave(std::vector<ScenarioModel> & vecModels, ModelTreeNode * pModelNode)
 {
 	std::list<ModelTreeNode *>::iterator iterReqModel;
 	QString strDepends;
@@ -346,7 +274,7 @@ bool Simulator::internalSave(QTextStream & writer, ModelTreeNode * pModelNode)
 			strDepends += (';' + (*iterReqModel)->strModelName);
 		if (MODELTREENODE_ISVALID(**iterReqModel) && !MODELTREENODE_ISERROR(**iterReqModel))
 		{
-			if (MODELTREENODE_ISDIRTY(**iterReqModel) && !internalSave(writer, *iterReqModel)) {
+			if (MODELTREENODE_ISDIRTY(**iterReqModel) && !internalSave(vecModels, *iterReqModel)) {
 				(*iterReqModel)->iBits |= MODELTREEBITS_ERROR;
 				bSuccess = false;
 			} else
@@ -357,34 +285,20 @@ bool Simulator::internalSave(QTextStream & writer, ModelTreeNode * pModelNode)
 
 	// if we successfully saved the required models, save this model
 	if (pModelNode->pModel != NULL && bSuccess) {
-		std::map<QString, QString> mapParams;
-		std::map<QString, QString>::iterator iterParam;
+		ScenarioModel model;
 		pModelNode->pModel->m_mutexUpdate.lock();
-		bSuccess = (pModelNode->pModel->Save(mapParams) == 0);
+		bSuccess = (pModelNode->pModel->Save(model.mapParams) == 0);
 		pModelNode->pModel->m_mutexUpdate.unlock();
 		if (bSuccess)
 		{
-			QString strWrite;
-
-			// write model name, type, and dependencies
-			if (strDepends.isEmpty())
-				strWrite = QString("MODEL=\"%1\" TYPE=\"%2\"").arg(pModelNode->strModelName).arg(pModelNode->pModel->GetModelType());
-			else
-				strWrite = QString("MODEL=\"%1\" TYPE=\"%2\" DEPENDS=\"%3\"").arg(pModelNode->strModelName).arg(pModelNode->pModel->GetModelType()).arg(strDepends);
-			writer << strWrite << endl;
-
-			// write parameters
-			strWrite = QString::null;
-			for (iterParam = mapParams.begin(); iterParam != mapParams.end(); ++iterParam)
-			{
-				if (strWrite.isEmpty())
-					strWrite = QString("%1=\"%2\"").arg(iterParam->first).arg(iterParam->second);
-				else
-					strWrite += QString(" %1=\"%2\"").arg(iterParam->first).arg(iterParam->second);
-			}
-			if (!strWrite.isEmpty())
-				writer << strWrite << endl;
-			writer << endl;
+			// record name, type, and dependencies the way Load reads them
+			model.strName = pModelNode->strModelName;
+			model.strType = pModelNode->pModel->GetModelType();
+			model.strDepends = strDepends;
+			model.mapParams[PARAM_TYPE] = model.strType;
+			if (!strDepends.isEmpty())
+				model.mapParams[PARAM_DEPENDS] = strDepends;
+			vecModels.push_back(model);
 		}
 	}
 	return bSuccess;
@@ -401,6 +315,7 @@ void Simulator::Unload()
 	g_pLogger->CloseLogFiles();
 
 	m_EventQueue.Clear();
+	m_VehicleSnapshots.Clear();
 	m_msgCurrentTrack.iSeqNumber = (unsigned)-1;
 	m_msgCurrentTrack.ipCar = (unsigned)-1;
 
@@ -559,7 +474,8 @@ void Simulator::SendMessage(const EventMessage & event)
 void Simulator::run()
 {
 	unsigned int i, iTrial;
-	bool bMonteCarlo;
+	bool bMonteCarlo, bResumed, bSaveWarmStart;
+	struct timeval tNextSnapshot, tNextCheckpoint;
 
 	if (g_pMainWindow != NULL && g_pMainWindow->m_pLblStatus != NULL)
 		g_pMainWindow->m_pLblStatus->setText("Running...");
@@ -587,6 +503,7 @@ void Simulator::run()
 		}
 
 		// perform pre-run initialization of all models
+		m_pMobilityTicker->Clear();
 		m_ModelMgr.m_modelsMutex.lock();
 		m_ModelMgr.MarkAllModelsDirty();
 		for (i = 0; i < m_ModelMgr.m_nModelTreeNodes; i++)
@@ -596,13 +513,53 @@ void Simulator::run()
 	
 			if (MODELTREENODE_ISVALID(m_ModelMgr.m_pModelTreeNodes[i]) && !MODELTREENODE_ISERROR(m_ModelMgr.m_pModelTreeNodes[i]))
 			{
-				if (MODELTREENODE_ISDIRTY(m_ModelMgr.m_pModelTreeNodes[i]) && !prerun(&m_ModelMgr.m_pModelTreeNodes[i]))
+				if (MODELTREENODE_ISDIRTY(m_ModelMgr.m_pModelTreeNodes[i]) && !prerun(&m_ModelMgr.m_pModelTreeNodes[i], iTrial > 0))
 					m_ModelMgr.m_pModelTreeNodes[i].iBits |= MODELTREEBITS_ERROR;
 				else
 					m_ModelMgr.m_pModelTreeNodes[i].iBits &= ~MODELTREEBITS_DIRTY;
 			}
 		}
+
+		// keep the first trial's setup for the trials that follow
+		if (iTrial == 0 && m_sSimSettings.iTrials > 1)
+		{
+			for (i = 0; i < m_ModelMgr.m_nModelTreeNodes; i++)
+			{
+				if (MODELTREENODE_ISVALID(m_ModelMgr.m_pModelTreeNodes[i]) && !MODELTREENODE_ISERROR(m_ModelMgr.m_pModelTreeNodes[i]) && m_ModelMgr.m_pModelTreeNodes[i].pModel != NULL)
+				{
+					m_ModelMgr.m_pModelTreeNodes[i].pModel->m_mutexUpdate.lock();
+					m_ModelMgr.m_pModelTreeNodes[i].pModel->Checkpoint();
+					m_ModelMgr.m_pModelTreeNodes[i].pModel->m_mutexUpdate.unlock();
+				}
+			}
+		}
 		m_ModelMgr.m_modelsMutex.unlock();
+
+		// pick up where a saved run left off; only the first run resumes
+		bResumed = false;
+		if (iTrial == 0 && !m_sSimSettings.strResume.isEmpty())
+		{
+			if (!(bResumed = LoadCheckpoint(m_sSimSettings.strResume, iTrial)))
+				g_pLogger->LogInfo(QString("Could not resume from checkpoint %1; starting from the beginning.\n").arg(m_sSimSettings.strResume), WARNING_LEVEL_MAJOR);
+			m_sSimSettings.strResume = QString::null;
+		}
+
+		// otherwise start the vehicles from the warm-up state, or save it
+		// once this run has warmed up if there is none yet
+		bSaveWarmStart = false;
+		if (!bResumed && !m_sSimSettings.strWarmStart.isEmpty())
+		{
+			if (QFile::exists(m_sSimSettings.strWarmStart))
+			{
+				if (!LoadWarmStart(m_sSimSettings.strWarmStart))
+					g_pLogger->LogInfo(QString("Could not read warm start %1; starting cold.\n").arg(m_sSimSettings.strWarmStart), WARNING_LEVEL_MAJOR);
+			}
+			else
+				bSaveWarmStart = m_sSimSettings.tWarmUp > timeval0;
+		}
+		PublishSnapshot();
+		tNextSnapshot = m_tCurrent + m_sSimSettings.tSnapshotPeriod;
+		tNextCheckpoint = m_tCurrent + m_sSimSettings.tCheckpointPeriod;
 		qApp->wakeUpGuiThread();
 
 		if (bMonteCarlo)
@@ -636,7 +593,7 @@ void Simulator::run()
 			if (g_pMainWindow != NULL && g_pMainWindow->m_pLblStatus != NULL)
 				g_pMainWindow->m_pLblStatus->setText("Running... (" + FormatTime(ToDouble(m_tCurrent - m_tStart), 0) + ")");
 	
-			std::map<in_addr_t, CarModel *> * pCarRegistry = g_pCarRegistry->acquireLock();
+			std::map<in_addr_t, CarModel *> * pCarRegistry __attribute__((unused)) = g_pCarRegistry->acquireLock();
 			std::map<in_addr_t, InfrastructureNodeModel *> * pNodeRegistry __attribute__((unused)) = g_pInfrastructureNodeRegistry->acquireLock();
 	
 			while (!m_EventQueue.IsEmpty() && m_EventQueue.TopEvent().GetTimestamp() <= m_tCurrent)
@@ -657,6 +614,9 @@ void Simulator::run()
 						}
 						break;
 					}
+					case EVENT_MOBILITYTICK:
+						m_pMobilityTicker->ProcessEvent(event);
+						break;
 					default:
 						break;
 					}
@@ -667,12 +627,23 @@ void Simulator::run()
 						pDestModel->ProcessEvent(event);
 				}
 			}
+
+			if (m_tCurrent >= tNextSnapshot)
+			{
+				PublishSnapshot();
+				tNextSnapshot = m_tCurrent + m_sSimSettings.tSnapshotPeriod;
+			}
 	
 			// write events to log file
 			std::map<PacketSequence, Event1Message>::iterator iterMessage;
-			std::map<in_addr_t, CarModel *>::iterator iterCar;
+			VehicleStates states;
+			CarModel * pCar;
+			unsigned int iCar;
 			float fDistance;
 			m_mutexEvent1Log.lock();
+			// one consistent copy of every vehicle's state for the whole log pass
+			if (!m_mapEvent1Log.empty())
+				g_pCarRegistry->GetStateTable().GetSnapshot(states);
 			iterMessage = m_mapEvent1Log.begin();
 			while (iterMessage != m_mapEvent1Log.end())
 			{
@@ -692,18 +663,20 @@ void Simulator::run()
 				else
 				{
 					struct timeval tTemp = iterMessage->second.tMessage;
-					for (iterCar = pCarRegistry->begin(); iterCar != pCarRegistry->end(); ++iterCar)
+					LocalFrame frameOrigin(iterMessage->second.ptOrigin);
+					for (iCar = 0; iCar < states.GetCount(); iCar++)
 					{
-						if (iterCar->second != NULL && (iterCar->first == iterMessage->second.ID.ipCar || iterCar->second->HasMessage(iterMessage->second.ID)))
+						pCar = states.vecCars[iCar];
+						if (pCar != NULL && (pCar->GetIPAddress() == iterMessage->second.ID.ipCar || pCar->HasMessage(iterMessage->second.ID)))
 						{
-							fDistance = Distance(iterMessage->second.ptOrigin, iterCar->second->GetCurrentPosition()) * METERSPERMILE;
+							fDistance = frameOrigin.Distance(states.vecPositions[iCar]);
 							if (fDistance > iterMessage->second.fDistance)
 								iterMessage->second.fDistance = fDistance;
-							if (iterCar->first == iterMessage->second.ID.ipCar && fDistance > iterMessage->second.fOriginatorDistance)
+							if (pCar->GetIPAddress() == iterMessage->second.ID.ipCar && fDistance > iterMessage->second.fOriginatorDistance)
 								iterMessage->second.fOriginatorDistance = fDistance;
 							if (iterMessage->second.ptDest.m_iLong != 0 || iterMessage->second.ptDest.m_iLat != 0)
 							{
-								if (iterCar->second->IsActive() && iterCar->second->m_pPhysModel != NULL && iterCar->second->m_pPhysModel->IsCarInRange(iterCar->second->GetCurrentPosition(), iterMessage->second.ptDest))
+								if (pCar->IsActive() && pCar->m_pPhysModel != NULL && pCar->m_pPhysModel->IsCarInRange(states.vecPositions[iCar], iterMessage->second.ptDest))
 								{
 									iterMessage->second.ptDest.Set(0, 0);
 									g_pLogger->LogInfo(QString("[t = %1s] Message %2 from %3 reached its destination!\n").arg(ToDouble(m_tCurrent - iterMessage->second.tMessage), 0, 'f', 6).arg(iterMessage->second.ID.iSeqNumber).arg(IPAddressToString(iterMessage->second.ID.ipCar)), WARNING_LEVEL_NONE);
@@ -720,6 +693,21 @@ void Simulator::run()
 				}
 			}
 			m_mutexEvent1Log.unlock();
+
+			if (!m_sSimSettings.strCheckpoint.isEmpty() && m_sSimSettings.tCheckpointPeriod > timeval0 && m_tCurrent >= tNextCheckpoint)
+			{
+				if (!SaveCheckpoint(m_sSimSettings.strCheckpoint, iTrial))
+					g_pLogger->LogInfo(QString("Could not write checkpoint %1.\n").arg(m_sSimSettings.strCheckpoint), WARNING_LEVEL_MAJOR);
+				tNextCheckpoint = m_tCurrent + m_sSimSettings.tCheckpointPeriod;
+			}
+			if (bSaveWarmStart && m_tCurrent - m_tStart >= m_sSimSettings.tWarmUp)
+			{
+				if (SaveWarmStart(m_sSimSettings.strWarmStart))
+					g_pLogger->LogInfo(QString("Saved warm start %1 after %2 seconds.\n").arg(m_sSimSettings.strWarmStart).arg(ToDouble(m_tCurrent - m_tStart), 0, 'f', 1), WARNING_LEVEL_NONE);
+				else
+					g_pLogger->LogInfo(QString("Could not write warm start %1.\n").arg(m_sSimSettings.strWarmStart), WARNING_LEVEL_MAJOR);
+				bSaveWarmStart = false;
+			}
 			g_pInfrastructureNodeRegistry->releaseLock();
 			g_pCarRegistry->releaseLock();
 	
@@ -749,6 +737,7 @@ void Simulator::run()
 			}
 		}
 		m_ModelMgr.m_modelsMutex.unlock();
+		PublishSnapshot();
 
 		m_EventQueue.Clear();
 		m_bNextTrial = false;
@@ -763,7 +752,322 @@ void Simulator::run()
 	}
 }
 
-bool Simulator::prerun(ModelTreeNode * pModelNode)
+void Simulator::PublishSnapshot()
+{
+	m_VehicleSnapshots.Publish(g_pCarRegistry->GetStateTable(), m_tCurrent);
+}
+
+static void WriteEventMessage(CheckpointWriter & writer, const EventMessage & event)
+{
+	unsigned int i;
+
+	writer.WriteString(event.strMessage);
+	writer.WriteTime(event.tTransmit);
+	writer.WriteDouble(ToDouble(event.tLifetime));
+	writer.WriteUInt(event.ipSource);
+	writer.WriteUInt(event.sBoundingRegion.eRegionType);
+	for (i = 0; i <= BOUNDINGREGIONCOORDSMAX; i++)
+		writer.WriteCoords(event.sBoundingRegion.vecCoords[i]);
+	writer.WriteDouble(event.sBoundingRegion.fParam);
+	writer.WriteString(event.strDest);
+}
+
+static bool ReadEventMessage(CheckpointReader & reader, EventMessage & event)
+{
+	unsigned int i, iRegionType;
+	double fLifetime;
+
+	if (!reader.ReadString(event.strMessage) || !reader.ReadTime(event.tTransmit) || !reader.ReadDouble(fLifetime) || !reader.ReadUInt(event.ipSource) || !reader.ReadUInt(iRegionType))
+		return false;
+	event.tLifetime = MakeTime(fLifetime);
+	event.sBoundingRegion.eRegionType = (SafetyPacket::BoundingRegionType)iRegionType;
+	for (i = 0; i <= BOUNDINGREGIONCOORDSMAX; i++)
+		if (!reader.ReadCoords(event.sBoundingRegion.vecCoords[i]))
+			return false;
+	return reader.ReadDouble(event.sBoundingRegion.fParam) && reader.ReadString(event.strDest);
+}
+
+// packets scheduled for reception; the event owns its packet
+static inline bool IsPacketEvent(const SimEvent & event)
+{
+	return (event.GetEventID() == EVENT_CARMODEL_RXMESSAGEBEGIN || event.GetEventID() == EVENT_CARMODEL_RXMESSAGEEND) && event.GetEventData() != NULL;
+}
+
+// besides the event messages, the packets on their way to each receiver
+// are saved; the rebroadcasts and message histories they feed into are
+// saved by the comm models themselves
+bool Simulator::SaveCheckpoint(const QString & strFilename, unsigned int iTrial)
+{
+	CheckpointWriter writer(m_tStart);
+	std::map<PacketSequence, Event1Message>::iterator iterMessage;
+	unsigned int i, numEvents = 0, numPackets = 0;
+
+	writer.WriteUInt(iTrial);
+	writer.WriteTime(m_tCurrent);
+	writer.WriteUInt(GetRandomState());
+
+	// event messages that have not gone out yet
+	for (i = 0; i < m_EventQueue.Count(); i++)
+		if (m_EventQueue.GetEvent(i).GetEventID() == EVENT_EVENTMESSAGE_OCCUR && m_EventQueue.GetEvent(i).GetEventData() != NULL)
+			numEvents++;
+	writer.WriteUInt(numEvents);
+	for (i = 0; i < m_EventQueue.Count(); i++)
+		if (m_EventQueue.GetEvent(i).GetEventID() == EVENT_EVENTMESSAGE_OCCUR && m_EventQueue.GetEvent(i).GetEventData() != NULL)
+			WriteEventMessage(writer, *(const EventMessage *)m_EventQueue.GetEvent(i).GetEventData());
+
+	// packets still in the air or waiting for the end of their reception
+	for (i = 0; i < m_EventQueue.Count(); i++)
+		if (IsPacketEvent(m_EventQueue.GetEvent(i)))
+			numPackets++;
+	writer.WriteUInt(numPackets);
+	for (i = 0; i < m_EventQueue.Count(); i++)
+	{
+		const SimEvent & event = m_EventQueue.GetEvent(i);
+		if (!IsPacketEvent(event))
+			continue;
+		writer.WriteTime(event.GetTimestamp());
+		writer.WriteString(event.GetDestModel());
+		writer.WriteUInt(event.GetEventID());
+		writer.WritePacket(*(const Packet *)event.GetEventData());
+	}
+
+	m_mutexEvent1Log.lock();
+	writer.WriteUInt(m_msgCurrentTrack.iSeqNumber);
+	writer.WriteUInt(m_msgCurrentTrack.ipCar);
+	writer.WriteUInt(m_mapEvent1Log.size());
+	for (iterMessage = m_mapEvent1Log.begin(); iterMessage != m_mapEvent1Log.end(); ++iterMessage)
+	{
+		writer.WriteTime(iterMessage->second.tMessage);
+		writer.WriteDouble(ToDouble(iterMessage->second.tLifetime));
+		writer.WriteUInt(iterMessage->second.ID.iSeqNumber);
+		writer.WriteUInt(iterMessage->second.ID.ipCar);
+		writer.WriteFloat(iterMessage->second.fDistance);
+		writer.WriteFloat(iterMessage->second.fOriginatorDistance);
+		writer.WriteUInt(iterMessage->second.iCars);
+		writer.WriteCoords(iterMessage->second.ptOrigin);
+		writer.WriteCoords(iterMessage->second.ptDest);
+	}
+	m_mutexEvent1Log.unlock();
+
+	// one block per model, found again by name when resuming
+	SaveModelStates(writer);
+
+	return writer.Save(strFilename);
+}
+
+// the whole file is read before anything is changed, so a checkpoint that
+// turns out to be cut short or corrupt leaves this run as it was
+bool Simulator::LoadCheckpoint(const QString & strFilename, unsigned int & iTrial)
+{
+	CheckpointReader reader;
+	std::vector<EventMessage> vecEvents;
+	std::vector<SimEvent> vecPacketEvents;
+	std::map<PacketSequence, Event1Message> mapEvent1Log;
+	std::vector<CheckpointBlock> vecBlocks;
+	PacketSequence msgCurrentTrack;
+	Event1Message message;
+	EventMessage event;
+	QString strModelName;
+	Model * pModel;
+	Packet * pPacket = NULL;
+	struct timeval tElapsed, tStart, tEvent;
+	unsigned int i, iSavedTrial, iRandomState, iEventID, numEvents, numPackets, numMessages;
+	double fLifetime;
+	bool bSuccess;
+
+	if (!reader.Open(strFilename))
+		return false;
+
+	// times in the file are relative to the start of the saved run; the
+	// start moves back so that the same amount of time has gone by now
+	bSuccess = reader.ReadUInt(iSavedTrial) && reader.ReadTime(tElapsed) && reader.ReadUInt(iRandomState) && reader.ReadUInt(numEvents);
+	if (bSuccess)
+	{
+		tStart = m_tCurrent - tElapsed;
+		reader.SetStart(tStart);
+	}
+
+	for (i = 0; bSuccess && i < numEvents; i++)
+	{
+		bSuccess = ReadEventMessage(reader, event);
+		if (bSuccess)
+			vecEvents.push_back(event);
+	}
+
+	bSuccess = bSuccess && reader.ReadUInt(numPackets);
+	for (i = 0; bSuccess && i < numPackets; i++)
+	{
+		bSuccess = reader.ReadTime(tEvent) && reader.ReadString(strModelName) && reader.ReadUInt(iEventID) && (pPacket = reader.ReadPacket()) != NULL;
+		if (bSuccess)
+			vecPacketEvents.push_back(SimEvent(tEvent, EVENT_PRIORITY_HIGHEST, QString::null, strModelName, iEventID, pPacket, DestroyPacket));
+	}
+
+	bSuccess = bSuccess && reader.ReadUInt(msgCurrentTrack.iSeqNumber) && reader.ReadUInt(msgCurrentTrack.ipCar) && reader.ReadUInt(numMessages);
+	for (i = 0; bSuccess && i < numMessages; i++)
+	{
+		bSuccess = reader.ReadTime(message.tMessage) && reader.ReadDouble(fLifetime) && reader.ReadUInt(message.ID.iSeqNumber) && reader.ReadUInt(message.ID.ipCar) && reader.ReadFloat(message.fDistance) && reader.ReadFloat(message.fOriginatorDistance) && reader.ReadUInt(message.iCars) && reader.ReadCoords(message.ptOrigin) && reader.ReadCoords(message.ptDest);
+		if (bSuccess)
+		{
+			message.tLifetime = MakeTime(fLifetime);
+			mapEvent1Log[message.ID] = message;
+		}
+	}
+
+	bSuccess = bSuccess && ScanModelStates(reader, vecBlocks);
+	if (!bSuccess)
+	{
+		for (i = 0; i < vecPacketEvents.size(); i++)
+			DestroyPacket(vecPacketEvents[i].GetEventData());
+		return false;
+	}
+
+	iTrial = iSavedTrial;
+	m_tStart = tStart;
+	if (g_pMapDB->GetTrafficLightsStart() != timeval0)
+		g_pMapDB->RestartTrafficLights(m_tStart);
+	SetRandomState(iRandomState);
+
+	// the setup of this run queued the scenario's messages again; anything
+	// it has sent since is replaced by what was in flight when saved
+	m_EventQueue.ClearEvents(EVENT_EVENTMESSAGE_OCCUR);
+	m_EventQueue.ClearEvents(EVENT_CARMODEL_RXMESSAGEBEGIN);
+	m_EventQueue.ClearEvents(EVENT_CARMODEL_RXMESSAGEEND);
+	m_EventQueue.ClearEvents(EVENT_CARCOMMMODEL_REBROADCAST);
+	ClearRebroadcasts();
+	for (i = 0; i < vecEvents.size(); i++)
+		m_EventQueue.AddEvent(SimEvent(vecEvents[i].tTransmit, EVENT_PRIORITY_LOWEST, QString::null, QString::null, EVENT_EVENTMESSAGE_OCCUR, new EventMessage(vecEvents[i]), DestroyEventMessage));
+	for (i = 0; i < vecPacketEvents.size(); i++)
+	{
+		if (m_ModelMgr.GetModel(vecPacketEvents[i].GetDestModel(), pModel) && pModel != NULL)
+			m_EventQueue.AddEvent(vecPacketEvents[i]);
+		else
+			DestroyPacket(vecPacketEvents[i].GetEventData());
+	}
+
+	m_mutexEvent1Log.lock();
+	m_msgCurrentTrack = msgCurrentTrack;
+	m_mapEvent1Log.swap(mapEvent1Log);
+	m_mutexEvent1Log.unlock();
+
+	LoadModelStates(reader, vecBlocks);
+	return true;
+}
+
+void Simulator::SaveModelStates(CheckpointWriter & writer)
+{
+	unsigned int i, iBlock, numModels = 0;
+
+	m_ModelMgr.m_modelsMutex.lock();
+	for (i = 0; i < m_ModelMgr.m_nModelTreeNodes; i++)
+		if (MODELTREENODE_ISVALID(m_ModelMgr.m_pModelTreeNodes[i]) && m_ModelMgr.m_pModelTreeNodes[i].pModel != NULL)
+			numModels++;
+	writer.WriteUInt(numModels);
+	for (i = 0; i < m_ModelMgr.m_nModelTreeNodes; i++)
+	{
+		Model * pModel = m_ModelMgr.m_pModelTreeNodes[i].pModel;
+		if (!MODELTREENODE_ISVALID(m_ModelMgr.m_pModelTreeNodes[i]) || pModel == NULL)
+			continue;
+		writer.WriteString(pModel->GetModelName());
+		iBlock = writer.BeginBlock();
+		pModel->m_mutexUpdate.lock();
+		pModel->SaveState(writer);
+		pModel->m_mutexUpdate.unlock();
+		writer.EndBlock(iBlock);
+	}
+	m_ModelMgr.m_modelsMutex.unlock();
+}
+
+bool Simulator::ScanModelStates(CheckpointReader & reader, std::vector<CheckpointBlock> & vecBlocks)
+{
+	CheckpointBlock block;
+	unsigned int i, numModels;
+
+	if (!reader.ReadUInt(numModels))
+		return false;
+	for (i = 0; i < numModels; i++)
+	{
+		if (!reader.ReadString(block.strModelName) || !reader.BeginBlock(block.iEnd))
+			return false;
+		block.iStart = reader.GetOffset();
+		vecBlocks.push_back(block);
+		reader.EndBlock(block.iEnd);
+	}
+	return true;
+}
+
+// with their events gone, the comm models' pending rebroadcasts are freed
+// here, so that models missing from the checkpoint or failing to load it
+// do not keep them
+void Simulator::ClearRebroadcasts()
+{
+	Model * pModel;
+	unsigned int i;
+
+	m_ModelMgr.m_modelsMutex.lock();
+	for (i = 0; i < m_ModelMgr.m_nModelTreeNodes; i++)
+	{
+		pModel = m_ModelMgr.m_pModelTreeNodes[i].pModel;
+		if (!MODELTREENODE_ISVALID(m_ModelMgr.m_pModelTreeNodes[i]) || pModel == NULL || !pModel->IsModelTypeOf(CARCOMMMODEL_NAME))
+			continue;
+		pModel->m_mutexUpdate.lock();
+		((CarCommModel *)pModel)->ClearRebroadcasts();
+		pModel->m_mutexUpdate.unlock();
+	}
+	m_ModelMgr.m_modelsMutex.unlock();
+}
+
+// models missing from this scenario are skipped
+void Simulator::LoadModelStates(CheckpointReader & reader, const std::vector<CheckpointBlock> & vecBlocks)
+{
+	Model * pModel;
+	unsigned int i;
+
+	m_ModelMgr.m_modelsMutex.lock();
+	for (i = 0; i < vecBlocks.size(); i++)
+	{
+		if (!m_ModelMgr.GetModel(vecBlocks[i].strModelName, pModel) || pModel == NULL)
+			continue;
+		reader.Seek(vecBlocks[i].iStart);
+		pModel->m_mutexUpdate.lock();
+		if (pModel->LoadState(reader) || reader.GetOffset() > vecBlocks[i].iEnd)
+			g_pLogger->LogInfo(QString("Checkpoint state for model %1 could not be restored.\n").arg(vecBlocks[i].strModelName), WARNING_LEVEL_MINOR);
+		pModel->m_mutexUpdate.unlock();
+	}
+	m_ModelMgr.m_modelsMutex.unlock();
+}
+
+// a warm start is only the vehicles' state after the warm-up: no messages,
+// log or random state, since each trial sets those up for itself
+bool Simulator::SaveWarmStart(const QString & strFilename)
+{
+	CheckpointWriter writer(m_tStart, SIMCHECKPOINT_WARMSTART_MAGIC);
+
+	writer.WriteTime(m_tCurrent);
+	SaveModelStates(writer);
+	return writer.Save(strFilename);
+}
+
+bool Simulator::LoadWarmStart(const QString & strFilename)
+{
+	CheckpointReader reader;
+	std::vector<CheckpointBlock> vecBlocks;
+	struct timeval tElapsed;
+
+	if (!reader.Open(strFilename, SIMCHECKPOINT_WARMSTART_MAGIC) || !reader.ReadTime(tElapsed))
+		return false;
+
+	// the saved state is as it was tElapsed into the warm-up run; shift its
+	// times so that state holds at the start of this run instead
+	reader.SetStart(m_tStart - tElapsed);
+	if (!ScanModelStates(reader, vecBlocks))
+		return false;
+	if (g_pMapDB->GetTrafficLightsStart() != timeval0)
+		g_pMapDB->RestartTrafficLights(m_tStart - tElapsed);
+	LoadModelStates(reader, vecBlocks);
+	return true;
+}
+
+bool Simulator::prerun(ModelTreeNode * pModelNode, bool bRestore)
 {
 	std::list<ModelTreeNode *>::iterator iterReqModel;
 	bool bSuccess = true;
@@ -772,7 +1076,7 @@ bool Simulator::prerun(ModelTreeNode * pModelNode)
 	{
 		if (MODELTREENODE_ISVALID(**iterReqModel) && !MODELTREENODE_ISERROR(**iterReqModel))
 		{
-			if (MODELTREENODE_ISDIRTY(**iterReqModel) && !prerun(*iterReqModel)) {
+			if (MODELTREENODE_ISDIRTY(**iterReqModel) && !prerun(*iterReqModel, bRestore)) {
 				(*iterReqModel)->iBits |= MODELTREEBITS_ERROR;
 				bSuccess = false;
 			} else
@@ -784,7 +1088,7 @@ bool Simulator::prerun(ModelTreeNode * pModelNode)
 	// if we successfully pre-ran the required models, pre-run this model
 	if (pModelNode->pModel != NULL && bSuccess) {
 		pModelNode->pModel->m_mutexUpdate.lock();
-		bSuccess = (pModelNode->pModel->PreRun() == 0);
+		bSuccess = ((bRestore ? pModelNode->pModel->Restore() : pModelNode->pModel->PreRun()) == 0);
 		pModelNode->pModel->m_mutexUpdate.unlock();
 	}
 	return bSuccess;
@@ -28,6 +28,8 @@
 #include "ModelMgr.h"
 #include "Message.h"
 #include "SimBase.h"
+#include "VehicleSnapshot.h"
+#include "ScenarioFile.h"
 
 #include <qthread.h>
 #include <set>
@@ -40,7 +42,10 @@
 #define PARAM_TYPE "TYPE"
 #define PARAM_DEPENDS "DEPENDS"
 
-class QTextStream;
+class MobilityTicker;
+class CheckpointWriter;
+class CheckpointReader;
+struct CheckpointBlockStruct;
 
 #define EVENT_EVENTMESSAGE_OCCUR 348756
 
@@ -73,6 +78,13 @@ typedef struct SimulatorSettingsStruct
 	bool bSimulationTime;
 	struct timeval tIncrement;
 	bool bProfile;
+	bool bSyncTick; // move simulated cars in batches, see MobilityTick.h
+	struct timeval tSnapshotPeriod; // how often the display's vehicle snapshot is refreshed
+	QString strCheckpoint; // where the running simulation's state is saved, if anywhere
+	struct timeval tCheckpointPeriod; // how much simulated time passes between saves
+	QString strResume; // checkpoint to pick the first run up from
+	QString strWarmStart; // vehicle state every run starts from, saved after tWarmUp if it is not there yet
+	struct timeval tWarmUp;
 } SimulatorSettings;
 
 class Simulator : public QThread
@@ -102,6 +114,8 @@ public:
 	void SendMessage(const EventMessage & event);
 
 	SimEventQueue m_EventQueue;
+	MobilityTicker * m_pMobilityTicker;
+	VehicleSnapshotBuffer m_VehicleSnapshots;
 	ModelMgr m_ModelMgr;
 	SimulatorSettings m_sSimSettings;
 	struct timeval m_tCurrent, m_tStart, m_tProfileStart, m_tProfileEnd;
@@ -114,14 +128,29 @@ public:
 
 protected:
 	bool internalAddNew(const std::map<QString, std::map<QString, QString> > & mapModels, std::map<QString, std::map<QString, QString> >::const_iterator iterModel, std::set<QString> & setAdded, std::set<QString> & setAdding);
-	bool internalSave(QTextStream & writer, ModelTreeNode * pModelNode);
+	bool internalSave(std::vector<ScenarioModel> & vecModels, ModelTreeNode * pModelNode);
 
 	void run();
 
-	bool prerun(ModelTreeNode * pModelNode);
+	// bRestore restores each model's checkpoint instead of pre-running it
+	bool prerun(ModelTreeNode * pModelNode, bool bRestore = false);
 	bool iteration(ModelTreeNode * pModelNode, struct timeval tCurrent);
 	bool postiteration(ModelTreeNode * pModelNode);
 	bool postrun(ModelTreeNode * pModelNode);
+	// copy the vehicle state table for the display
+	void PublishSnapshot();
+	// save the state of the current run, or pick a run up from a saved one
+	// after its models have pre-run (see SimCheckpoint.h)
+	bool SaveCheckpoint(const QString & strFilename, unsigned int iTrial);
+	bool LoadCheckpoint(const QString & strFilename, unsigned int & iTrial);
+	void SaveModelStates(CheckpointWriter & writer);
+	// find each model's block, then load them once the whole file has read
+	bool ScanModelStates(CheckpointReader & reader, std::vector<struct CheckpointBlockStruct> & vecBlocks);
+	void LoadModelStates(CheckpointReader & reader, const std::vector<struct CheckpointBlockStruct> & vecBlocks);
+	void ClearRebroadcasts();
+	// the vehicles' state after a warm-up, for later runs to start from
+	bool SaveWarmStart(const QString & strFilename);
+	bool LoadWarmStart(const QString & strFilename);
 
 	bool m_bLoaded;
 	bool m_bCancelled, m_bNextTrial;
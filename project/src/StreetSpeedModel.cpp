@@ -111,7 +111,7 @@ bool StreetSpeedModel::GetInitialConditions(unsigned int & iRecord, Coords & ptP
 	return iRecord != (unsigned)-1;
 }
 
-bool StreetSpeedModel::DoIteration(float fElapsed, unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane)
+bool StreetSpeedModel::DoIteration(struct timeval tCurrent, float fElapsed, unsigned int & iRecord, Coords & ptPosition, short & iSpeed, short & iHeading, unsigned char & iLane)
 {
 	bool bMore = false;
 	bool bActive = false;
@@ -125,7 +125,7 @@ bool StreetSpeedModel::DoIteration(float fElapsed, unsigned int & iRecord, Coord
 	{
 		if (m_bMultilane)
 			SwitchLanes(iRecord, m_pTripModel->GetCRShapePoint(), m_pTripModel->GetCRProgress(), iSpeed, m_pTripModel->IsGoingForwards(), iLane);
-		bMore = m_pTripModel->SetProgress(fElapsed, iSpeed, iRecord);
+		bMore = m_pTripModel->SetProgress(tCurrent, fElapsed, iSpeed, iRecord);
 		bActive = (iRecord != (unsigned)-1);
 		iRecord = m_pTripModel->GetCurrentRecord();
 		if (iRecord != iOldRecord)
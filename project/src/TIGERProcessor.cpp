@@ -24,48 +24,51 @@
 
 #include "TIGERProcessor.h"
 
+#include "OSMParser.h"
 #include "Logger.h"
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <algorithm>
 #include <qfileinfo.h>
 #include <qdir.h>
 
 #define STREETNAME_SIZE 30
 #define STREETTYPE_SIZE 4
+#define MAP_WRITE_BUFFER_SIZE (1 << 20)
 
-void WriteMemory(const void * pMem, int fd, const unsigned int length)
+void WriteMemory(const void * pMem, FILE * hFile, const unsigned int length)
 {
-	write(fd, pMem, length);
+	fwrite(pMem, 1, length, hFile);
 }
 
-void WriteCoords(const Coords * src, int fd)
+void WriteCoords(const Coords * src, FILE * hFile)
 {
-	WriteMemory(&src->m_iLong, fd, sizeof(long));
-	WriteMemory(&src->m_iLat, fd, sizeof(long));
+	WriteMemory(&src->m_iLong, hFile, sizeof(long));
+	WriteMemory(&src->m_iLat, hFile, sizeof(long));
 }
 
-void WriteRect(const Rect * src, int fd)
+void WriteRect(const Rect * src, FILE * hFile)
 {
-	WriteMemory(&src->m_iLeft, fd, sizeof(long));
-	WriteMemory(&src->m_iTop, fd, sizeof(long));
-	WriteMemory(&src->m_iRight, fd, sizeof(long));
-	WriteMemory(&src->m_iBottom, fd, sizeof(long));
+	WriteMemory(&src->m_iLeft, hFile, sizeof(long));
+	WriteMemory(&src->m_iTop, hFile, sizeof(long));
+	WriteMemory(&src->m_iRight, hFile, sizeof(long));
+	WriteMemory(&src->m_iBottom, hFile, sizeof(long));
 }
 
-void WriteAddressRange(const AddressRange * src, int fd)
+void WriteAddressRange(const AddressRange * src, FILE * hFile)
 {
-	WriteMemory(&src->iFromAddr, fd, sizeof(unsigned short));
-	WriteMemory(&src->iToAddr, fd, sizeof(unsigned short));
+	WriteMemory(&src->iFromAddr, hFile, sizeof(unsigned short));
+	WriteMemory(&src->iToAddr, hFile, sizeof(unsigned short));
 	unsigned int tmpZip = ((unsigned int)src->iZip) & 0x7fffffff;
 	if (src->bOnLeft)
 		tmpZip |= 0x80000000;
-	WriteMemory(&tmpZip, fd, sizeof(unsigned int));
+	WriteMemory(&tmpZip, hFile, sizeof(unsigned int));
 }
 
-void WriteString(const char * src, int fd, const unsigned int length)
+void WriteString(const char * src, FILE * hFile, const unsigned int length)
 {
-	write(fd, src, (length + 1) * sizeof(char));
+	WriteMemory(src, hFile, (length + 1) * sizeof(char));
 }
 
 bool ReadMemory(void * pMem, int fd, const unsigned int length)
@@ -112,7 +115,6 @@ void ReadString(char * dest, int fd, const unsigned int destLength)
 TIGERProcessor::TIGERProcessor(){
 	m_nRecords = 0;
 	m_pRecords = NULL;
-	ProcessingWay = NULL;
 }
 
 TIGERProcessor::~TIGERProcessor(){
@@ -139,29 +141,14 @@ void TIGERProcessor::Cleanup()
 		m_pRecords = NULL;
 	}
 	printf("m_pRecords cleared\r\n");
-/*	if(ProcessingWay[0].pShapePoints != NULL) delete[] ProcessingWay[0].pShapePoints;
-	if(ProcessingWay[0].pAddressRanges != NULL) delete[] ProcessingWay[0].pAddressRanges;
-	if(ProcessingWay[0].pFeatureNames != NULL) delete[] ProcessingWay[0].pFeatureNames;
-	if(ProcessingWay[0].pFeatureTypes != NULL) delete[] ProcessingWay[0].pFeatureTypes;
-	if(ProcessingWay != NULL)
-	{
-		delete ProcessingWay;
-		ProcessingWay = NULL;
-	}
-	printf("ProcessingWay cleared\r\n");
-*/
-	m_osmWayIDtoRecord.clear();
-	m_mapCoordinateToVertex.clear();
+	std::vector<Coords>().swap(m_vecVertexCoords);
 	m_WaterPolygons.clear();
 	m_mapTLIDtoRecord.clear();
 	m_mapPolyIDtoRecords.clear();
 	m_mapAdditionalNameIDtoRecord.clear();
 	m_Strings.clear();
 	m_mapStringsToIndex.clear();
-	m_Vertices.clear();
-	vShapePoints.clear();
-	m_mapNodeIDandCoord.clear();
-	vAdditionalWays.clear();
+	std::vector<TIGERVertex>().swap(m_Vertices);
 	m_nRecords = 0;
 }
 
@@ -766,680 +753,215 @@ bool TIGERProcessor::LoadTypeP(const QString & strFilename)
 
 bool TIGERProcessor::LoadTypeOSM(const QString & strFilename)
 {
-	FILE * hFile;
-	char szLine[256];
-	unsigned long numRecords = 0;
-	unsigned long numNodes = 0;
-	MapRecord * psOldSegments = NULL;
+	OSMParser parser;
+	unsigned int iChunk, iWay, iRef, nNewRecords, nPoints, i;
+	unsigned long iNode;
+	MapRecord * psOldSegments = NULL, * psRec;
 
-	//printf("print sth");
-	hFile = fopen(strFilename, "rb");
-	if (!hFile)
+	if (parser.Load(strFilename))
 	{
-		g_pLogger->LogError("GrooveNet - Error", QString("Error opening %1 (type 1)!").arg(strFilename));
+		g_pLogger->LogError("GrooveNet - Error", QString("Error opening %1 (OSM)!").arg(strFilename));
 		return true;
 	}
-	fgets(szLine,sizeof(szLine),hFile);
-	while(!feof(hFile))
-	{
-	  if(strstr(szLine,"<node id")!=NULL)
-		  numNodes++;
-	  if(strstr(szLine,"</way>")!=NULL)
-		  numRecords++;
-	  fgets(szLine,sizeof(szLine),hFile);
-	//  printf("record Num :%ld\r\n",numRecords);
-	}
+
+	nNewRecords = 0;
+	for (iChunk = 0; iChunk < parser.GetChunkCount(); iChunk++)
+		nNewRecords += parser.GetChunk(iChunk)->GetWays().size();
+
 	if (m_nRecords)
 	{
 		psOldSegments = m_pRecords;
 	}
-	m_pRecords = new MapRecord[m_nRecords + numRecords];
+	m_pRecords = new MapRecord[m_nRecords + nNewRecords];
 	if (m_nRecords)
 	{
 		memcpy(m_pRecords, psOldSegments, sizeof(MapRecord) * m_nRecords);
-		delete psOldSegments;
+		delete[] psOldSegments;
 	}
-	
-
-	//printf("Osm count done\r\n");
-	m_pRecords = new MapRecord[numRecords];
-	fseek(hFile, 0, SEEK_SET);
-	char nodeID[11];
-	char latTemp[12];
-	char lonTemp[12];
-	char zipCode[5];
-	int iZipL, iZipR;
-	
-	AddressRange * psOldAddressZipRanges;
-
-	char wayID[11];
-	long wayIDnum;
-	//printf("osm init done");
 
-	
-	long numNode = 0;;
-	Coords  nodeCoord;
-	RecordTypes eRT;
-	bool bRail = false;
-	nodeCoord.m_iRefCnt = 0;
-	char tagValue[32];
-	int tagValueDigitCnt = 0;
-	fgets(szLine,sizeof(szLine),hFile);
-	while(!feof(hFile))
+	for (iChunk = 0; iChunk < parser.GetChunkCount(); iChunk++)
 	{
-		if(strstr(szLine,"<node id")!=NULL)
-		{
-			strcpy(nodeID,ExtractField(strstr(szLine,"<node id"),11,20));
-			strcpy(latTemp,ExtractField(strstr(szLine,"lat="),6,16));
-			strcpy(lonTemp,ExtractField(strstr(szLine,"lon="),6,16));
-			
-
-			nodeID[10] = '\0';
-			latTemp[11] = '\0';
-			lonTemp[11] = '\0';
-			nodeCoord.m_iLat = getCoord(latTemp,11)/10;
-			nodeCoord.m_iLong = getCoord(lonTemp,11)/10;
-			m_mapNodeIDandCoord.insert(std::pair<unsigned long,Coords>(atol(nodeID),nodeCoord));
-			numNode++;
-
-			fgets(szLine,sizeof(szLine),hFile);	
-		}
-		else if(strstr(szLine,"<nd ref")!= NULL)
+		const OSMChunk * pChunk = parser.GetChunk(iChunk);
+		const std::vector<unsigned long> & vecRefs = pChunk->GetRefs();
+		for (iWay = 0; iWay < pChunk->GetWays().size(); iWay++)
 		{
-			strcpy(nodeID,ExtractField(strstr(szLine,"<nd ref"),10,19));
-			nodeID[10] = '\0';
-			if(m_mapNodeIDandCoord.find(atol(nodeID))!= m_mapNodeIDandCoord.end())
-			{			
-				(*m_mapNodeIDandCoord.find(atol(nodeID))).second.m_iRefCnt++;				
+			const OSMWay & sWay = pChunk->GetWays()[iWay];
+
+			// ways whose nodes are all outside the extract have nothing to draw
+			nPoints = 0;
+			for (iRef = sWay.iFirstRef; iRef < sWay.iFirstRef + sWay.nRefs; iRef++)
+				if (vecRefs[iRef] != OSMPARSER_INVALID_REF)
+					nPoints++;
+			if (nPoints == 0)
+				continue;
+
+			psRec = m_pRecords + m_nRecords;
+			psRec->nShapePoints = nPoints;
+			psRec->pShapePoints = new Coords[nPoints];
+			nPoints = 0;
+			for (iRef = sWay.iFirstRef; iRef < sWay.iFirstRef + sWay.nRefs; iRef++)
+			{
+				iNode = vecRefs[iRef];
+				if (iNode == OSMPARSER_INVALID_REF)
+					continue;
+				psRec->pShapePoints[nPoints].Set(parser.GetNode(iNode).iLong, parser.GetNode(iNode).iLat);
+				psRec->pShapePoints[nPoints].m_iRefCnt = parser.GetRefCount(iNode);
+				nPoints++;
 			}
 
-			fgets(szLine,sizeof(szLine),hFile);
-		}
-		else
-			fgets(szLine,sizeof(szLine),hFile);
-	}
-	
-	
-	fseek(hFile, 0, SEEK_SET);
-	fgets(szLine,sizeof(szLine),hFile);
-	while(!feof(hFile))
-	{
-
-	/*  if(strstr(szLine,"<node id")!=NULL)
-	  {
-	    strcpy(nodeID,ExtractField(strstr(szLine,"<node id"),11,20));
-	    strcpy(latTemp,ExtractField(strstr(szLine,"lat="),6,16));
-	    strcpy(lonTemp,ExtractField(strstr(szLine,"lon="),6,16));
-	    
-
-	    nodeID[10] = '\0';
-	    latTemp[11] = '\0';
-	    lonTemp[11] = '\0';
-	    nodeCoord.m_iLat = getCoord(latTemp,11)/10;
-	    nodeCoord.m_iLong = getCoord(lonTemp,11)/10;
-	    m_mapNodeIDandCoord.insert(std::pair<unsigned long,Coords>(atol(nodeID),nodeCoord));
-	    numNode++;
-
-	    fgets(szLine,sizeof(szLine),hFile);
-	    
-	  }*/
-	  if(strstr(szLine,"<way id")!=NULL)
-	  {
-	   // printf("processing ways\r\n");
-	    strcpy(wayID,ExtractField(strstr(szLine,"<way id="),10,20));
-	    wayID[10] = '\0';
-	    wayIDnum = atol(wayID);
-	    eRT = RecordTypeDefault;
-	 //   printf("wayIDstr:%s\r\n",wayID);
-	  //  printf("wayIDnum:%ld\r\n",wayIDnum);
-	//    m_osmWayIDtoRecord.insert(std::pair<unsigned long, unsigned int>(wayIDnum,m_nRecords));
-	 //   printf("wayID to Record insert done\r\n");
-	    m_pRecords[m_nRecords].nShapePoints = 0;
-
-	 //   printf("wayID to Record done\r\n");
-	   
-	    fgets(szLine,sizeof(szLine),hFile);
-	    while(strstr(szLine,"</way>") == NULL)
-	    {
-
-	      
-
-	      if(strstr(szLine,"<nd ref")!= NULL)
-	      {
-		
-		strcpy(nodeID,ExtractField(strstr(szLine,"<nd ref"),10,19));
-		nodeID[10] = '\0';
-		if(m_mapNodeIDandCoord.find(atol(nodeID))!= m_mapNodeIDandCoord.end())
-		{
+			// names and types are paired up, so pad the shorter list with blanks
+			psRec->nFeatureNames = sWay.vecNames.size() > sWay.vecTypes.size() ? sWay.vecNames.size() : sWay.vecTypes.size();
+			if (psRec->nFeatureNames == 0)
+				psRec->nFeatureNames = 1;
+			psRec->pFeatureNames = new unsigned int[psRec->nFeatureNames];
+			psRec->pFeatureTypes = new unsigned int[psRec->nFeatureNames];
+			for (i = 0; i < psRec->nFeatureNames; i++)
+			{
+				psRec->pFeatureNames[i] = AddString(i < sWay.vecNames.size() ? QString(sWay.vecNames[i].c_str()).stripWhiteSpace() : QString(""));
+				psRec->pFeatureTypes[i] = AddString(i < sWay.vecTypes.size() ? QString(sWay.vecTypes[i].c_str()).stripWhiteSpace() : QString(""));
+			}
 
-			vShapePoints.push_back((*m_mapNodeIDandCoord.find(atol(nodeID))).second);
+			psRec->nAddressRanges = sWay.vecZips.size();
+			psRec->pAddressRanges = psRec->nAddressRanges ? new AddressRange[psRec->nAddressRanges] : NULL;
+			for (i = 0; i < psRec->nAddressRanges; i++)
+			{
+				// OSM carries no address ranges, so cover every street number
+				psRec->pAddressRanges[i].iFromAddr = 0;
+				psRec->pAddressRanges[i].iToAddr = 9999;
+				psRec->pAddressRanges[i].iZip = sWay.vecZips[i].first;
+				psRec->pAddressRanges[i].bOnLeft = sWay.vecZips[i].second;
+			}
 
+			psRec->eRecordType = sWay.eRecordType;
+			if (!IsRoad(psRec) && sWay.bRail)
+				psRec->eRecordType = RecordTypeRailroad;
+
+			psRec->pVertices = NULL;
+			psRec->nVertices = 0;
+			psRec->fCost = 0;
+			psRec->bWaterL = false;
+			psRec->bWaterR = false;
+			psRec->ptWaterL.Set(0, 0);
+			psRec->ptWaterR.Set(0, 0);
+
+			if (psRec->eRecordType == RecordTypeInvisibleLandBoundary) { // update county lines
+				for (i = 0; i < psRec->nShapePoints; i++) {
+					if (!areaLeft)
+						areaLeft = new Coords(psRec->pShapePoints[i]);
+					else if (areaLeft->m_iLong > psRec->pShapePoints[i].m_iLong)
+						*areaLeft = psRec->pShapePoints[i];
+					if (!areaRight)
+						areaRight = new Coords(psRec->pShapePoints[i]);
+					else if (areaRight->m_iLong < psRec->pShapePoints[i].m_iLong)
+						*areaRight = psRec->pShapePoints[i];
+					if (!areaTop)
+						areaTop = new Coords(psRec->pShapePoints[i]);
+					else if (areaTop->m_iLat < psRec->pShapePoints[i].m_iLat)
+						*areaTop = psRec->pShapePoints[i];
+					if (!areaBottom)
+						areaBottom = new Coords(psRec->pShapePoints[i]);
+					else if (areaBottom->m_iLat > psRec->pShapePoints[i].m_iLat)
+						*areaBottom = psRec->pShapePoints[i];
+				}
+			}
 
+			m_nRecords++;
 		}
-		m_pRecords[m_nRecords].nShapePoints = vShapePoints.size();
-		fgets(szLine,sizeof(szLine),hFile);
-	      }
-	      else if(strstr(szLine,"tiger:name_base"))//OSM feature name and feature type
-	      {
-		      strcpy(tagValue,ExtractField(strstr(szLine,"v="),4,32));
-			
-		 //     m_pRecords[m_nRecords].pFeatureNames = new unsigned int[1];
-		      vFeatureNames.push_back(AddString(QString(tagValue).stripWhiteSpace().remove("\"/>")));
-		//	m_pRecords[m_nRecords].pFeatureNames[0] = AddString(QString(tagValue).stripWhiteSpace().remove("\"/>"));
-		//	m_pRecords[m_nRecords].nFeatureNames = 1;
-		      for(int i = 0; i < 32; i++)
-			      tagValue[i] = ' ';
-		      fgets(szLine,sizeof(szLine),hFile);	       
-		
-	      }
-	      else if(strstr(szLine,"tiger:name_type"))
-	      {
-		      strcpy(tagValue,ExtractField(strstr(szLine,"v="),4,32));
-		//      m_pRecords[m_nRecords].pFeatureTypes = new unsigned int[1];
-		      vFeatureTypes.push_back(AddString(QString(tagValue).stripWhiteSpace().remove("\"/>")));
-		      
-		 //     m_pRecords[m_nRecords].pFeatureTypes[0] = AddString(QString(tagValue).stripWhiteSpace().remove("\"/>"));
-		      for(int i = 0; i < 32; i++)
-			      tagValue[i] = ' ';
-		      fgets(szLine,sizeof(szLine),hFile);
-	      }
-	      else if(strstr(szLine,"tiger:zip_left"))
-	      {
-		      int i;
-		      strcpy(tagValue,ExtractField(strstr(szLine,"v="),4,8));
-		      iZipL = atoi(tagValue);
-		      psOldAddressZipRanges = m_pRecords[m_nRecords].pAddressRanges;
-		      m_pRecords[m_nRecords].pAddressRanges = new AddressRange[m_pRecords[m_nRecords].nAddressRanges + 1];
-		      for (i = 0; i < m_pRecords[m_nRecords].nAddressRanges; i++)
-			      m_pRecords[m_nRecords].pAddressRanges[i] = psOldAddressZipRanges[i];
-		
-		      m_pRecords[m_nRecords].pAddressRanges[i].iZip = iZipL;
-		      m_pRecords[m_nRecords].pAddressRanges[i].iFromAddr = 0000;
-		      m_pRecords[m_nRecords].pAddressRanges[i].iToAddr = 9999;
-		      if (m_pRecords[m_nRecords].nAddressRanges)
-			      delete psOldAddressZipRanges;
-
-		      m_pRecords[m_nRecords].nAddressRanges++;
-
-		      fgets(szLine,sizeof(szLine),hFile);
-	      }
-	      else if(strstr(szLine,"tiger:zip_right"))
-	      {
-		      int i;
-		      strcpy(tagValue,ExtractField(strstr(szLine,"v="),4,8));
-		      iZipR = atoi(tagValue);
-		      psOldAddressZipRanges = m_pRecords[m_nRecords].pAddressRanges;
-		      m_pRecords[m_nRecords].pAddressRanges = new AddressRange[m_pRecords[m_nRecords].nAddressRanges + 1];
-		      for (i = 0; i < m_pRecords[m_nRecords].nAddressRanges; i++)
-			      m_pRecords[m_nRecords].pAddressRanges[i] = psOldAddressZipRanges[i];
-		
-		      m_pRecords[m_nRecords].pAddressRanges[i].iZip = iZipL;
-		      m_pRecords[m_nRecords].pAddressRanges[i].iFromAddr = 0000;
-		      m_pRecords[m_nRecords].pAddressRanges[i].iToAddr = 9999;
-		      if (m_pRecords[m_nRecords].nAddressRanges)
-			      delete psOldAddressZipRanges;
-
-		      m_pRecords[m_nRecords].nAddressRanges++;
-
-	//	      printf("zipcode R: %d\r\n",iZipR);
-		      fgets(szLine,sizeof(szLine),hFile);
-	      }	    
-	      /*OSM road type*/
-	      else if(strstr(szLine,"k=\"highway"))
-	      {
-		eRT = RecordTypeTwoWaySmallRoad;
-		if(strstr(szLine,"residential")||strstr(szLine,"trunk")||strstr(szLine,"service")||strstr(szLine,"tertiary"))
-		{
-			eRT = RecordTypeTwoWaySmallRoad;
-		}
-		else if(strstr(szLine,"motorway"))
-		{
-			eRT = RecordTypeTwoWayHighway;
-		}
-		else if(strstr(szLine,"primary"))
-		{
-			eRT = RecordTypeTwoWayPrimary;
-		}
-		else if (strstr(szLine,"secondary"))
-		{
-			eRT = RecordTypeTwoWayLargeRoad;
-		}	
-		else if (strstr(szLine,"pedestrian") || strstr(szLine,"living_street") || strstr(szLine,"footway") )
-		{
-			eRT = RecordTypePedestrian;
-		}
-				
-		fgets(szLine,sizeof(szLine),hFile);
-	      }
-	      
-		 
-	      else if(strstr(szLine,"k=\"oneway\" v=\"yes\""))
-	      {
-	//	printf("2 or 1 way tags\r\n");
-		switch(eRT)
-		{
-		  case RecordTypeTwoWaySmallRoad:
-		    eRT = RecordTypeOneWaySmallRoad;
-		    break;
-		  case RecordTypeTwoWayHighway:
-		    eRT = RecordTypeOneWayHighway;
-		    break;
-		  case RecordTypeTwoWayPrimary:
-		    eRT = RecordTypeOneWayPrimary;
-		    break;
-		  case RecordTypeTwoWayLargeRoad:
-		    eRT = RecordTypeOneWayLargeRoad;
-		    break;
-		  default:
-			  break;
-		}
-		fgets(szLine,sizeof(szLine),hFile);		
-	      }
-	      else if(strstr(szLine,"k=\"waterway"))
-	      {
-		eRT = RecordTypeWater;
-		fgets(szLine,sizeof(szLine),hFile);
-	      }
-	      else if(strstr(szLine,"k=\"railway"))
-	      {		
-		//eRT = RecordTypeRailroad;
-		bRail = true;
-		fgets(szLine,sizeof(szLine),hFile);
-	      }
-	      else if(strstr(szLine,"k=\"boundary"))
-	      {
-		//printf("processing boundary\r\n");
-		
-		eRT = RecordTypeInvisibleLandBoundary;
-		fgets(szLine,sizeof(szLine),hFile);
-	      }
-	      else
-		fgets(szLine,sizeof(szLine),hFile);
-	     
-	      
-	    }
-	    while(vFeatureNames.size() != vFeatureTypes.size())
-	    {
-		if(vFeatureNames.size() > vFeatureTypes.size())
-		{
-			vFeatureTypes.push_back(AddString(QString("    ").stripWhiteSpace()));
-		}
-		else if(vFeatureNames.size() < vFeatureTypes.size())
-		{
-			vFeatureNames.push_back(AddString(QString("    ").stripWhiteSpace()));
-		}
-		    
-	    }
-	    if(vFeatureNames.size()>0)
-	    {
-		    m_pRecords[m_nRecords].pFeatureNames = new unsigned int[vFeatureNames.size()];
-		    m_pRecords[m_nRecords].pFeatureTypes = new unsigned int[vFeatureTypes.size()];
-		    for(int iFN = 0; iFN < vFeatureNames.size(); iFN ++)
-		    {
-			    m_pRecords[m_nRecords].pFeatureNames[iFN] = vFeatureNames[iFN];
-			    m_pRecords[m_nRecords].pFeatureTypes[iFN] = vFeatureTypes[iFN];
-		    }
-		    m_pRecords[m_nRecords].nFeatureNames = vFeatureNames.size();
-			
-            }
-
-
-	    if(m_pRecords[m_nRecords].pFeatureNames == NULL)
-	    {
-		    m_pRecords[m_nRecords].pFeatureNames = new unsigned int[1];
-		    m_pRecords[m_nRecords].pFeatureNames[0] = AddString(QString("    ").stripWhiteSpace());
-		    m_pRecords[m_nRecords].nFeatureNames = 1;
-	    }
-	    if(m_pRecords[m_nRecords].pFeatureTypes == NULL)
-	    {
-		    m_pRecords[m_nRecords].pFeatureTypes = new unsigned int[1];
-		    m_pRecords[m_nRecords].pFeatureTypes[0] = AddString(QString("    ").stripWhiteSpace());
-            }
-            
-	    m_pRecords[m_nRecords].eRecordType = eRT;
-	    if(!IsRoad(m_pRecords + m_nRecords) && bRail)
-	    {
-		m_pRecords[m_nRecords].eRecordType = RecordTypeRailroad;    
-	    }
-	    bRail = FALSE;
-	
-	    m_pRecords[m_nRecords].pShapePoints = new Coords[m_pRecords[m_nRecords].nShapePoints];
-	    for(unsigned int i = 0 ; i < m_pRecords[m_nRecords].nShapePoints; i++)
-	    {
-	   //   m_pRecords[m_nRecords].pShapePoints[i] = vShapePoints[m_pRecords[m_nRecords].nShapePoints - i -1];
-	      m_pRecords[m_nRecords].pShapePoints[i] = vShapePoints[i];
-	    }
-	    vShapePoints.clear();
-	  
-	    m_pRecords[m_nRecords].pVertices = NULL;
-	    m_pRecords[m_nRecords].nVertices = 0;
-	    if(m_pRecords[m_nRecords].eRecordType == RecordTypeInvisibleLandBoundary)
-	    //if(eRT == RecordTypeInvisibleLandBoundary)
-	    {
-		 
-		    
-		for(unsigned int i = 0; i < m_pRecords[m_nRecords].nShapePoints; i++)
-		{
-			//printf("processing boundingRect\r\n");  
-			if(!areaLeft)
-				areaLeft = new Coords(m_pRecords[m_nRecords].pShapePoints[i]);
-			else if(areaLeft->m_iLong > m_pRecords[m_nRecords].pShapePoints[i].m_iLong)
-				*areaLeft = m_pRecords[m_nRecords].pShapePoints[i];
-			if(!areaRight)
-				areaRight = new Coords(m_pRecords[m_nRecords].pShapePoints[i]);
-			else if(areaRight->m_iLong < m_pRecords[m_nRecords].pShapePoints[i].m_iLong)
-				*areaRight= m_pRecords[m_nRecords].pShapePoints[i];
-			if(!areaTop)
-				areaTop = new Coords(m_pRecords[m_nRecords].pShapePoints[i]);
-			else if(areaTop->m_iLat < m_pRecords[m_nRecords].pShapePoints[i].m_iLat)
-				*areaTop = m_pRecords[m_nRecords].pShapePoints[i];
-			if(!areaBottom)
-				areaBottom = new Coords(m_pRecords[m_nRecords].pShapePoints[i]);
-			else if(areaBottom->m_iLat > m_pRecords[m_nRecords].pShapePoints[i].m_iLat)
-				*areaBottom = m_pRecords[m_nRecords].pShapePoints[i];		  
-		//	printf("areaLeft long: %ld\r\n",areaLeft->m_iLong);
-		//	printf("mapRec :%ld, shapePoint long: %ld\r\n",m_nRecords,m_pRecords[m_nRecords].vShapePoints[i].m_iLong);
-			
-		}
-	    }
-	    vFeatureNames.clear();
-	    vFeatureTypes.clear();
-
-	    m_nRecords++ ;
-	  
-	    
-	  }
-	
-	  else
-	    fgets(szLine,sizeof(szLine),hFile);
-	  
-	  
 	}
-	
-	long typeLandBoundCnt = 0;
-	long typeWayCnt = 0;
-	long typeDefaultCnt = 0;
-/*	for(int i = 0; i < m_nRecords; i++)
-	{
-	  switch(m_pRecords[m_nRecords].eRecordType)
-	  {
-	    case RecordTypeInvisibleLandBoundary:
-	      typeLandBoundCnt++;
-	      break;
-	    case RecordTypeTwoWayHighway:
-	      typeWayCnt++;
-	      break;
-	    case RecordTypeTwoWayLargeRoad:
-	      typeWayCnt++;
-	      break;
-	    case RecordTypeTwoWayPrimary:
-	      typeWayCnt++;
-	      break;
-	    case RecordTypeTwoWaySmallRoad:
-	      typeWayCnt++;
-	      break;
-	    case RecordTypeOneWayHighway:
-	      typeWayCnt++;
-	      break;
-	    case RecordTypeOneWayLargeRoad:
-	      typeWayCnt++;
-	      break;
-	    case RecordTypeOneWayPrimary:
-	      typeWayCnt++;
-	      break;
-	    case RecordTypeOneWaySmallRoad:
-	      typeWayCnt++;
-	      break;
-	    case RecordTypeDefault:
-	      typeDefaultCnt++;
-	      break;
-	  }   
-	  
-	}*/
-	//printf("\r\ntotal record: %ld\r\n",m_nRecords);
-	//printf("Land Bound: %ld  Default Record: %ld  highways: %ld\r\n",typeLandBoundCnt,typeDefaultCnt,typeWayCnt);
-	//printf("boundingrect areaLeft: %ld %ld\r\n:",areaLeft->m_iLat,areaLeft->m_iLong);
-/*	std::map<unsigned long, Coords>::iterator nodeItr;
-	nodeItr = m_mapNodeID.find(1558356649);
-	printf("node %ld\r\n",(*nodeItr).first);
-	printf("->>");
-	printf("Lat :%ld, Long :%ld\r\n",(*nodeItr).second.m_iLat,(*nodeItr).second.m_iLong);
-*/
-/*	unsigned int offset = 81371;
-	std::map<unsigned long, unsigned int>::iterator wayIDItr;
-	wayIDItr = m_osmWayIDtoRecord.begin();
-	for(unsigned int i = 0; i < offset;i++)
-		wayIDItr.operator++();
-*/	
-
-	//printf("numNodes: %ld\r\n",numNode);
-	//printf("numWays: %d\r\n",m_nRecords);
-/*	for(int i = 0; i < m_pRecords[549].nShapePoints; i ++)
-	{
-		printf("Coords No.%d: %ld  %ld\r\n",i,m_pRecords[549].pShapePoints[i].m_iLat,m_pRecords[549].pShapePoints[i].m_iLong);
-	}*/
-	//printf("Rec No 26614 nShapePoints:%d\r\n",m_pRecords[26614].nShapePoints);
 
-	BreakWays();
+	// release the node table before the ways are split up
+	parser.Clear();
 
-
-	fclose(hFile);
+	BreakWays();
 	return false;
-
-
 }
 
+// copy nShapePoints shape points of psSrc starting at iFirstShapePoint into
+// a new record, along with the names, address ranges and type
+static void CopyWaySegment(MapRecord * psDest, const MapRecord * psSrc, unsigned short iFirstShapePoint, unsigned short nShapePoints)
+{
+	unsigned int i;
 
+	psDest->nFeatureNames = psSrc->nFeatureNames;
+	psDest->pFeatureNames = new unsigned int[psDest->nFeatureNames];
+	psDest->pFeatureTypes = new unsigned int[psDest->nFeatureNames];
+	for (i = 0; i < psDest->nFeatureNames; i++)
+	{
+		psDest->pFeatureNames[i] = psSrc->pFeatureNames[i];
+		psDest->pFeatureTypes[i] = psSrc->pFeatureTypes[i];
+	}
+	psDest->nAddressRanges = psSrc->nAddressRanges;
+	psDest->pAddressRanges = psDest->nAddressRanges ? new AddressRange[psDest->nAddressRanges] : NULL;
+	for (i = 0; i < psDest->nAddressRanges; i++)
+		psDest->pAddressRanges[i] = psSrc->pAddressRanges[i];
+	psDest->nShapePoints = nShapePoints;
+	psDest->pShapePoints = new Coords[nShapePoints];
+	for (i = 0; i < nShapePoints; i++)
+		psDest->pShapePoints[i].Set(psSrc->pShapePoints[iFirstShapePoint + i].m_iLong, psSrc->pShapePoints[iFirstShapePoint + i].m_iLat);
+	psDest->eRecordType = psSrc->eRecordType;
+	psDest->fCost = 0;
+	psDest->bWaterL = false;
+	psDest->bWaterR = false;
+	psDest->ptWaterL.Set(0, 0);
+	psDest->ptWaterR.Set(0, 0);
+	psDest->nVertices = 0;
+	psDest->pVertices = NULL;
+}
 
-
-// new breakway
+// split roads at every interior shape point shared with another way, so that
+// each record runs between two intersections
 bool TIGERProcessor::BreakWays()
 {
+	std::vector<MapRecord> vecWays;
+	std::vector<unsigned short> vecBreakPoints;
+	MapRecord * psRec;
+	unsigned int iRec, i;
 
-	int numBreakPoints = 0;
-	std::vector<unsigned int> vBreakPoints;
-	std::vector<unsigned int>::iterator bpItr;
-
-	MapRecord * psOldSegments = NULL;
-	ProcessingWay = new MapRecord[1];
-	unsigned int numShapePnts = 0;
-	if (m_nRecords)
-	{
-		psOldSegments = new MapRecord[m_nRecords];
-		memcpy(psOldSegments, m_pRecords, sizeof(MapRecord) * m_nRecords);
-	}
-	for(unsigned int iRec = 0; iRec < m_nRecords; iRec++)
+	vecWays.reserve(m_nRecords);
+	for (iRec = 0; iRec < m_nRecords; iRec++)
 	{
-// 		//clear ProcessingWay
-// 		if(ProcessingWay[0].pShapePoints != NULL) delete[] ProcessingWay[0].pShapePoints;
-// 		if(ProcessingWay[0].pAddressRanges != NULL) delete[] ProcessingWay[0].pAddressRanges;
-// 		if(ProcessingWay[0].pFeatureNames != NULL) delete[] ProcessingWay[0].pFeatureNames;
-// 		if(ProcessingWay[0].pFeatureTypes != NULL) delete[] ProcessingWay[0].pFeatureTypes;
-// 		if(ProcessingWay != NULL)
-// 		{
-// 			delete[] ProcessingWay;
-// 			ProcessingWay = NULL;
-// 		}
-// 		printf("ProcessingWay cleared\r\n");
-
-		numShapePnts = m_pRecords[iRec].nShapePoints;
-		ProcessingWay[0].nFeatureNames = m_pRecords[iRec].nFeatureNames;
-		ProcessingWay[0].eRecordType = m_pRecords[iRec].eRecordType;
-		ProcessingWay[0].pFeatureNames = new unsigned int[ProcessingWay[0].nFeatureNames];
-		ProcessingWay[0].pFeatureTypes = new unsigned int[ProcessingWay[0].nFeatureNames];
-		for(unsigned int i = 0; i < ProcessingWay[0].nFeatureNames; i++)
-		{
-			ProcessingWay[0].pFeatureNames[i] = m_pRecords[iRec].pFeatureNames[i];
-			ProcessingWay[0].pFeatureTypes[i] = m_pRecords[iRec].pFeatureTypes[i];			
-		}
-		ProcessingWay[0].nAddressRanges = m_pRecords[iRec].nAddressRanges;
-		ProcessingWay[0].pAddressRanges = new AddressRange[ProcessingWay[0].nAddressRanges];
-		for(unsigned int i = 0; i < ProcessingWay[0].nAddressRanges; i++)
+		psRec = m_pRecords + iRec;
+
+		vecBreakPoints.clear();
+		vecBreakPoints.push_back(0);
+		if (IsRoad(psRec) && psRec->nShapePoints > 2)
 		{
-			ProcessingWay[0].pAddressRanges[i].bOnLeft = m_pRecords[iRec].pAddressRanges[i].bOnLeft;				
-			ProcessingWay[0].pAddressRanges[i].iFromAddr = m_pRecords[iRec].pAddressRanges[i].iFromAddr;
-			ProcessingWay[0].pAddressRanges[i].iToAddr = m_pRecords[iRec].pAddressRanges[i].iToAddr;
-			ProcessingWay[0].pAddressRanges[i].iZip = m_pRecords[iRec].pAddressRanges[i].iZip;				
-		
-		
-		
+			for (i = 1; i < (unsigned)psRec->nShapePoints - 1; i++)
+				if (psRec->pShapePoints[i].m_iRefCnt > 1)
+					vecBreakPoints.push_back(i);
 		}
-	
+		vecBreakPoints.push_back(psRec->nShapePoints > 0 ? psRec->nShapePoints - 1 : 0);
 
-		if(IsRoad(m_pRecords + iRec) && (numShapePnts >2))
+		if (psRec->nShapePoints < 2)
 		{
-		//	printf("this is rec No.%d\r\n",iRec);
-			for(unsigned int iShape = 1; iShape < m_pRecords[iRec].nShapePoints-1 ; iShape++)
-			{
-				if((m_pRecords[iRec].pShapePoints[iShape].m_iRefCnt > 1) )
-				{
-					bpItr = vBreakPoints.end();
-					vBreakPoints.insert(bpItr,iShape);
-
-				}
-			}
-
-			if(vBreakPoints.size() > 0)
-			{
-
-				/*Processing the first break point*/
-				ProcessingWay[0].nShapePoints = vBreakPoints[0] + 1;
-		//		printf("ProcessingWay nShapePoints:%d\r\n",ProcessingWay[0].nShapePoints);
-				ProcessingWay[0].pShapePoints = new Coords[ProcessingWay[0].nShapePoints];
-		//		printf("buf created\r\n");
-			//	memcpy(ProcessingWay[0].pShapePoints, m_pRecords[iRec].pShapePoints,sizeof(Coords) * ProcessingWay[0].nShapePoints);
-		  		for(int iCopyShape = 0; iCopyShape < ProcessingWay[0].nShapePoints; iCopyShape++)
-				{
-					ProcessingWay[0].pShapePoints[iCopyShape].m_iLat = m_pRecords[iRec].pShapePoints[iCopyShape].m_iLat;
-					ProcessingWay[0].pShapePoints[iCopyShape].m_iLong = m_pRecords[iRec].pShapePoints[iCopyShape].m_iLong;
-				//	printf("copied Coords: %ld	%ld\r\n",ProcessingWay[0].pShapePoints[iCopyShape].m_iLat,ProcessingWay[0].pShapePoints[iCopyShape].m_iLong);
-				//	printf("Orig Coords: %ld %ld\r\n",m_pRecords[iRec].pShapePoints[iCopyShape].m_iLat,m_pRecords[iRec].pShapePoints[iCopyShape].m_iLong);
-
-				}
-
-				vAdditionalWays.insert(vAdditionalWays.end(), ProcessingWay[0]);
-
-				/*Processing the other break points except the 1st one*/
-				for(int i = 1; i < vBreakPoints.size() ; i++)
-				{
-					ProcessingWay[0].nShapePoints = vBreakPoints[i] - vBreakPoints[i-1] + 1;
-					ProcessingWay[0].pShapePoints = new Coords[ProcessingWay[0].nShapePoints];
-				//	memcpy(ProcessingWay[0].pShapePoints, m_pRecords[iRec].pShapePoints + vBreakPoints[i-1], sizeof(Coords) * ProcessingWay[0].nShapePoints);
-					
-					for(int iCopyShape = 0; iCopyShape < ProcessingWay[0].nShapePoints; iCopyShape++)
-					{
-						ProcessingWay[0].pShapePoints[iCopyShape].m_iLat = m_pRecords[iRec].pShapePoints[iCopyShape + vBreakPoints[i-1]].m_iLat;
-						ProcessingWay[0].pShapePoints[iCopyShape].m_iLong = m_pRecords[iRec].pShapePoints[iCopyShape + vBreakPoints[i-1]].m_iLong;
-					//	printf("copied Coords: %ld	%ld\r\n",ProcessingWay[0].pShapePoints[iCopyShape].m_iLat,ProcessingWay[0].pShapePoints[iCopyShape].m_iLong);
-						
-					}
-					vAdditionalWays.insert(vAdditionalWays.end(), ProcessingWay[0]);
-
-
-
-
-				}
-
-			
-				ProcessingWay[0].nShapePoints = m_pRecords[iRec].nShapePoints  - vBreakPoints[vBreakPoints.size() - 1] ;
-				ProcessingWay[0].pShapePoints = new Coords[ProcessingWay[0].nShapePoints];
-			//	memcpy(ProcessingWay[0].pShapePoints, m_pRecords[iRec].pShapePoints + vBreakPoints[vBreakPoints.size()-1], sizeof(Coords) * ProcessingWay[0].nShapePoints);
-				for(int iCopyShape = 0; iCopyShape < ProcessingWay[0].nShapePoints; iCopyShape++)
-				{
-					ProcessingWay[0].pShapePoints[iCopyShape].m_iLat = m_pRecords[iRec].pShapePoints[iCopyShape + vBreakPoints[vBreakPoints.size() - 1]].m_iLat;
-					ProcessingWay[0].pShapePoints[iCopyShape].m_iLong = m_pRecords[iRec].pShapePoints[iCopyShape + vBreakPoints[vBreakPoints.size() - 1]].m_iLong;
-				//	printf("copied Coords: %ld	%ld\r\n",ProcessingWay[0].pShapePoints[iCopyShape].m_iLat,ProcessingWay[0].pShapePoints[iCopyShape].m_iLong);
-
-				}
-
-				vAdditionalWays.insert(vAdditionalWays.end(), ProcessingWay[0]);
-				
-
-				vBreakPoints.clear();
-				
-			}
-			else
-			{
-				ProcessingWay[0].nShapePoints = m_pRecords[iRec].nShapePoints;
-				ProcessingWay[0].pShapePoints = new Coords[ProcessingWay[0].nShapePoints];
-				for(int iCopyShape = 0; iCopyShape < ProcessingWay[0].nShapePoints; iCopyShape++)
-				{
-					ProcessingWay[0].pShapePoints[iCopyShape].m_iLat = m_pRecords[iRec].pShapePoints[iCopyShape].m_iLat;
-					ProcessingWay[0].pShapePoints[iCopyShape].m_iLong = m_pRecords[iRec].pShapePoints[iCopyShape].m_iLong;
-				}
-				vAdditionalWays.insert(vAdditionalWays.end(),ProcessingWay[0]);				
-			}
-		//	numBreakPoints = 0;
-
-			
-			
-			
+			vecWays.push_back(MapRecord());
+			CopyWaySegment(&vecWays.back(), psRec, 0, psRec->nShapePoints);
 		}
 		else
 		{
-			ProcessingWay[0].nShapePoints = m_pRecords[iRec].nShapePoints;
-			ProcessingWay[0].pShapePoints = new Coords[ProcessingWay[0].nShapePoints];
-			for(int iCopyShape = 0; iCopyShape < ProcessingWay[0].nShapePoints; iCopyShape++)
+			for (i = 1; i < vecBreakPoints.size(); i++)
 			{
-				ProcessingWay[0].pShapePoints[iCopyShape].m_iLat = m_pRecords[iRec].pShapePoints[iCopyShape].m_iLat;
-				ProcessingWay[0].pShapePoints[iCopyShape].m_iLong = m_pRecords[iRec].pShapePoints[iCopyShape].m_iLong;
+				vecWays.push_back(MapRecord());
+				CopyWaySegment(&vecWays.back(), psRec, vecBreakPoints[i - 1], vecBreakPoints[i] - vecBreakPoints[i - 1] + 1);
 			}
-			vAdditionalWays.insert(vAdditionalWays.end(),ProcessingWay[0]);
 		}
 
-		
-	}
-
-
-	for (unsigned int iRec = 0; iRec < m_nRecords; iRec++)
-	{
-		if (m_pRecords[iRec].pAddressRanges != NULL) delete[] m_pRecords[iRec].pAddressRanges;
-		if (m_pRecords[iRec].pFeatureNames != NULL) delete[] m_pRecords[iRec].pFeatureNames;
-		if (m_pRecords[iRec].pFeatureTypes != NULL) delete[] m_pRecords[iRec].pFeatureTypes;
-		if (m_pRecords[iRec].pShapePoints != NULL) delete[] m_pRecords[iRec].pShapePoints;
-		if (m_pRecords[iRec].pVertices != NULL) delete[] m_pRecords[iRec].pVertices;
+		// free the original as soon as it is split to keep the peak down
+		if (psRec->pAddressRanges != NULL) delete[] psRec->pAddressRanges;
+		if (psRec->pFeatureNames != NULL) delete[] psRec->pFeatureNames;
+		if (psRec->pFeatureTypes != NULL) delete[] psRec->pFeatureTypes;
+		if (psRec->pShapePoints != NULL) delete[] psRec->pShapePoints;
+		if (psRec->pVertices != NULL) delete[] psRec->pVertices;
 	}
 
-
-	if (m_pRecords != NULL) {
+	if (m_pRecords != NULL)
 		delete[] m_pRecords;
-		m_pRecords = NULL;
-	}
 
-	m_nRecords = vAdditionalWays.size();
-	m_pRecords = new MapRecord[vAdditionalWays.size()];
-	for(int iRec = 0; iRec < m_nRecords; iRec++)
-	{
-		m_pRecords[iRec].nFeatureNames =vAdditionalWays[iRec].nFeatureNames;
-		m_pRecords[iRec].pFeatureNames = new unsigned int[m_pRecords[iRec].nFeatureNames];
-		m_pRecords[iRec].pFeatureTypes = new unsigned int[m_pRecords[iRec].nFeatureNames];
-		for(int i = 0; i < m_pRecords[iRec].nFeatureNames; i++)
-		{
-			m_pRecords[iRec].pFeatureNames[i] = vAdditionalWays[iRec].pFeatureNames[i];
-			m_pRecords[iRec].pFeatureTypes[i] = vAdditionalWays[iRec].pFeatureTypes[i];
-		}
-		m_pRecords[iRec].nAddressRanges = vAdditionalWays[iRec].nAddressRanges;
-		m_pRecords[iRec].pAddressRanges = new AddressRange[m_pRecords[iRec].nAddressRanges];
-		for(int i = 0; i < m_pRecords[iRec].nAddressRanges; i++)
-		{
-			m_pRecords[iRec].pAddressRanges[i].iFromAddr = vAdditionalWays[iRec].pAddressRanges[i].iFromAddr;	
-			m_pRecords[iRec].pAddressRanges[i].iToAddr = vAdditionalWays[iRec].pAddressRanges[i].iToAddr;
-			m_pRecords[iRec].pAddressRanges[i].iZip = vAdditionalWays[iRec].pAddressRanges[i].iZip;
-			m_pRecords[iRec].pAddressRanges[i].bOnLeft = vAdditionalWays[iRec].pAddressRanges[i].bOnLeft;
-		}
-		m_pRecords[iRec].nShapePoints = vAdditionalWays[iRec].nShapePoints;
-		m_pRecords[iRec].pShapePoints = new Coords[m_pRecords[iRec].nShapePoints];
-		for(int i = 0; i < m_pRecords[iRec].nShapePoints; i++)
-		{
-			m_pRecords[iRec].pShapePoints[i].m_iLat = vAdditionalWays[iRec].pShapePoints[i].m_iLat;
-			m_pRecords[iRec].pShapePoints[i].m_iLong = vAdditionalWays[iRec].pShapePoints[i].m_iLong;
-		}
-		m_pRecords[iRec].eRecordType = vAdditionalWays[iRec].eRecordType;
-		m_pRecords[iRec].nVertices = 0;
-		m_pRecords[iRec].pVertices = NULL;
-	}
-	
-	
+	m_nRecords = vecWays.size();
+	m_pRecords = new MapRecord[m_nRecords];
+	if (m_nRecords)
+		memcpy(m_pRecords, &vecWays[0], sizeof(MapRecord) * m_nRecords);
+	return false;
 }
 
 
@@ -1460,8 +982,7 @@ bool TIGERProcessor::LoadSet(const QString & strBaseName)
 	LoadType6(dir.absFilePath(strBase + ".RT6"));
 	LoadTypeI(dir.absFilePath(strBase + ".RTI"));
 	LoadTypeP(dir.absFilePath(strBase + ".RTP"));*/
-	LoadTypeOSM(dir.absFilePath(strBaseName));
-
+	bool bError = LoadTypeOSM(dir.absFilePath(strBaseName));
 
 	if (areaLeft && areaTop && areaRight && areaBottom)
 		boundingRect = Rect(areaLeft->m_iLong, areaTop->m_iLat, areaRight->m_iLong, areaBottom->m_iLat);
@@ -1472,6 +993,8 @@ bool TIGERProcessor::LoadSet(const QString & strBaseName)
 	if (areaRight != 0) delete areaRight;
 	if (areaTop != 0) delete areaTop;
 	if (areaBottom != 0) delete areaBottom;
+	if (bError)
+		return true;
 	unsigned int verCnt = 0;
 	EnumerateVertices();
 	for(int i = 0; i < m_nRecords; i++)
@@ -1485,7 +1008,8 @@ bool TIGERProcessor::LoadSet(const QString & strBaseName)
 	QString codeString;
 	codeString.sprintf("%05d", iCode);
 	//printf("start writing\r\n");
-	if (!WriteMap(dir.absFilePath(QString("%1.MAP").arg(codeString)))) {
+	bError = WriteMap(dir.absFilePath(QString("%1.MAP").arg(codeString)));
+	if (!bError) {
 		printf("in if !writeMap\r\n");
 		QStringList files = dir.entryList(QString("TGR%1.*").arg(codeString), QDir::Files|QDir::Readable);
 		QStringList::iterator filesIterator = files.begin();
@@ -1498,25 +1022,23 @@ bool TIGERProcessor::LoadSet(const QString & strBaseName)
 
 	Cleanup();
 
-	return false;
+	return bError;
 }
 
 bool TIGERProcessor::WriteMap(const QString & fileName)
 {
-	int hFile = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
-	if (hFile == -1) return true;
+	FILE * hFile = fopen(fileName, "wb");
+	if (hFile == NULL) return true;
+	// the map is written field by field, so give stdio a large buffer
+	setvbuf(hFile, NULL, _IOFBF, MAP_WRITE_BUFFER_SIZE);
 
 	unsigned int i, j, numVertices, numStrings, numPolys, numPoints;
 	unsigned char recordFlags;
 	unsigned short numNeighbors;
-	std::vector<Coords> coords;
-	std::map<Coords, unsigned int>::iterator iterCoords;
+	bool bError;
 	std::map<unsigned int, unsigned int>::iterator iterEdges;
 	std::list<std::pair<Rect, std::list<Coords> > >::iterator poly;
 	std::list<Coords>::iterator polyPoint;
-	coords.resize(m_Vertices.size());
-	for (iterCoords = m_mapCoordinateToVertex.begin(); iterCoords != m_mapCoordinateToVertex.end(); ++iterCoords)
-		coords[iterCoords->second] = iterCoords->first;
 
 	WriteMemory(&countyCode, hFile, sizeof(int));
 	WriteRect(&boundingRect, hFile);
@@ -1528,7 +1050,7 @@ bool TIGERProcessor::WriteMap(const QString & fileName)
 	numVertices = m_Vertices.size();
 	WriteMemory(&numVertices, hFile, sizeof(unsigned int));
 	for (i = 0; i < numVertices; i++) {
-		WriteCoords(&coords[i], hFile);
+		WriteCoords(&m_vecVertexCoords[i], hFile);
 		numNeighbors = m_Vertices[i].mapEdges.size();
 		WriteMemory(&numNeighbors, hFile, sizeof(unsigned short));
 		for (iterEdges = m_Vertices[i].mapEdges.begin(); iterEdges != m_Vertices[i].mapEdges.end(); ++iterEdges)
@@ -1541,10 +1063,8 @@ bool TIGERProcessor::WriteMap(const QString & fileName)
 		for (j = 0; j < numNeighbors; j++)
 			WriteMemory(&m_Vertices[i].vecRoads[j], hFile, sizeof(unsigned int));
 	}
-//	printf("start writing m_pRecords\r\n");
 	WriteMemory(&m_nRecords, hFile, sizeof(unsigned int));
 	for (i = 0; i < m_nRecords; i++) {
-		//printf("writing the %dth Rec\r\n",i);
 		WriteMemory(&m_pRecords[i].nFeatureNames, hFile, sizeof(unsigned short));
 		for (j = 0; j < m_pRecords[i].nFeatureNames; j++) {
 			WriteMemory(m_pRecords[i].pFeatureNames + j, hFile, sizeof(unsigned int));
@@ -1568,10 +1088,7 @@ bool TIGERProcessor::WriteMap(const QString & fileName)
 		for (j = 0; j < m_pRecords[i].nVertices; j++)
 			WriteMemory(m_pRecords[i].pVertices + j, hFile, sizeof(unsigned int));
 	}
-//	printf("finish writing m_pRecords\r\n");
 
-	
-//	printf("printf sth\r\n");
 	numPolys = m_WaterPolygons.size();
 	WriteMemory(&numPolys, hFile, sizeof(unsigned int));
 	for (poly = m_WaterPolygons.begin(); poly != m_WaterPolygons.end(); ++poly) {
@@ -1581,89 +1098,73 @@ bool TIGERProcessor::WriteMap(const QString & fileName)
 		for (polyPoint = poly->second.begin(); polyPoint != poly->second.end(); ++polyPoint)
 			WriteCoords(&(*polyPoint), hFile);
 	}
-	//printf("writing finished\r\n");
-	//printf("the Last Rec\r\n ");
-//	for(int i = 0; i < m_pRecords[168784].nShapePoints;i++)
-//	{
-//		printf("Coords: %ld	%ld\r\n",m_pRecords[168784].pShapePoints[i].m_iLat,m_pRecords[168784].pShapePoints[i].m_iLong);
-//	}
-
-	close(hFile);
-		printf("write map Finished\r\n");
+
+	bError = ferror(hFile) != 0;
+	if (fclose(hFile) != 0)
+		bError = true;
+	if (bError) {
+		// don't leave a truncated map behind for MapDB to load
+		unlink(fileName);
+		return true;
+	}
+	printf("write map Finished\r\n");
 	return false;
 }
 
+unsigned int TIGERProcessor::FindVertex(const Coords & pt) const
+{
+	std::vector<Coords>::const_iterator iterVertex = std::lower_bound(m_vecVertexCoords.begin(), m_vecVertexCoords.end(), pt);
+	if (iterVertex == m_vecVertexCoords.end() || *iterVertex != pt)
+		return (unsigned)-1;
+	return iterVertex - m_vecVertexCoords.begin();
+}
+
 void TIGERProcessor::EnumerateVertices()
 {
-	// enumerate the vertices
-	unsigned int iRec, iPreviousVertex, iVertex, iAdj;
-	Coords * ptPrevious, * pt;
+	unsigned int iRec, iPreviousVertex, iVertex;
 	MapRecord * psRec;
-	std::map<Coords, unsigned int>::iterator vertexFromCoords;
-	unsigned int * newAdjVertices;
+
+	// collect the endpoints of every road first; a vertex number is then the
+	// position of its coordinates in the sorted list, which takes far less
+	// memory than a map from coordinates to vertex numbers
+	m_vecVertexCoords.clear();
 	for (iRec = 0; iRec < m_nRecords; iRec++)
 	{
 		psRec = m_pRecords + iRec;
 		psRec->rBounds = Rect::BoundingRect(psRec->pShapePoints, psRec->nShapePoints);
 
 		// can't drive on rivers or railroad tracks
-		if (IsRoad(psRec)/* || (psRec->eRecordType == RecordTypePedestrian && psRec->pFeatureNames[0] != AddString(QString("    ").stripWhiteSpace())   )*/)
+		if (IsRoad(psRec) && psRec->nShapePoints > 0)
 		{
-			iPreviousVertex = 0;
-			pt = psRec->pShapePoints;
-			vertexFromCoords = m_mapCoordinateToVertex.find(*pt);
-			if (vertexFromCoords == m_mapCoordinateToVertex.end())
-			{
-				iVertex = m_Vertices.size();
-				m_Vertices.push_back(Vertex());
-				m_mapCoordinateToVertex.insert(std::pair<Coords, unsigned int>(*pt, iVertex));
-			}
-			else
-				iVertex = vertexFromCoords->second;
-			newAdjVertices = new unsigned int[m_pRecords[iRec].nVertices + 1];
-			for (iAdj = 0; iAdj < m_pRecords[iRec].nVertices; iAdj++)
-				newAdjVertices[iAdj] = m_pRecords[iRec].pVertices[iAdj];
-			newAdjVertices[iAdj] = iVertex;
-			if (m_pRecords[iRec].nVertices > 0) delete[] m_pRecords[iRec].pVertices;
-			m_pRecords[iRec].pVertices = newAdjVertices;
-			m_pRecords[iRec].nVertices++;
-			iPreviousVertex = iVertex;
-			ptPrevious = pt;
-			if (psRec->nShapePoints > 0) {
-				if (psRec->nShapePoints > 1) {
-					pt = psRec->pShapePoints + psRec->nShapePoints - 1;
-					vertexFromCoords = m_mapCoordinateToVertex.find(*pt);
-					if (vertexFromCoords == m_mapCoordinateToVertex.end())
-					{
-						iVertex = m_Vertices.size();
-						m_Vertices.push_back(Vertex());
-						m_mapCoordinateToVertex.insert(std::pair<Coords, unsigned int>(*pt, iVertex));
-					}
-					else
-						iVertex = vertexFromCoords->second;
-					newAdjVertices = new unsigned int[m_pRecords[iRec].nVertices + 1];
-					for (iAdj = 0; iAdj < m_pRecords[iRec].nVertices; iAdj++)
-						newAdjVertices[iAdj] = m_pRecords[iRec].pVertices[iAdj];
-					newAdjVertices[iAdj] = iVertex;
-					if (m_pRecords[iRec].nVertices > 0) delete[] m_pRecords[iRec].pVertices;
-					m_pRecords[iRec].pVertices = newAdjVertices;
-					m_pRecords[iRec].nVertices++;
-				}
-				m_pRecords[iRec].fCost = RecordDistance(&m_pRecords[iRec]) * CostFactor(psRec);
-				AddRecordToVertex(&m_Vertices[iPreviousVertex], m_pRecords, iRec, iVertex);
-//				m_Vertices[iPreviousVertex].mapEdges.insert(std::pair<unsigned int, unsigned int>(iRec, iVertex));
-				if (!IsOneWay(psRec))
-				{
-					AddRecordToVertex(&m_Vertices[iVertex], m_pRecords, iRec, iPreviousVertex);
-//					m_Vertices[iVertex].mapEdges.insert(std::pair<unsigned int, unsigned>(iRec, iPreviousVertex));
-				}
-			/*	else
-				{
-					AddRecordToVertex(&m_Vertices[iVertex], m_pRecords, iRec, iVertex);
-					
-				}*/
-			}
+			m_vecVertexCoords.push_back(psRec->pShapePoints[0]);
+			m_vecVertexCoords.push_back(psRec->pShapePoints[psRec->nShapePoints - 1]);
+		}
+	}
+	std::sort(m_vecVertexCoords.begin(), m_vecVertexCoords.end());
+	m_vecVertexCoords.erase(std::unique(m_vecVertexCoords.begin(), m_vecVertexCoords.end()), m_vecVertexCoords.end());
+	std::vector<Coords>(m_vecVertexCoords).swap(m_vecVertexCoords);
+	m_Vertices.resize(m_vecVertexCoords.size());
+
+	for (iRec = 0; iRec < m_nRecords; iRec++)
+	{
+		psRec = m_pRecords + iRec;
+		if (!IsRoad(psRec) || psRec->nShapePoints == 0)
+			continue;
+
+		if (psRec->pVertices != NULL) delete[] psRec->pVertices;
+		psRec->nVertices = psRec->nShapePoints > 1 ? 2 : 1;
+		psRec->pVertices = new unsigned int[psRec->nVertices];
+
+		iPreviousVertex = iVertex = FindVertex(psRec->pShapePoints[0]);
+		psRec->pVertices[0] = iVertex;
+		if (psRec->nShapePoints > 1) {
+			iVertex = FindVertex(psRec->pShapePoints[psRec->nShapePoints - 1]);
+			psRec->pVertices[1] = iVertex;
 		}
+		psRec->fCost = RecordDistance(psRec) * CostFactor(psRec);
+		AddRecordToVertex(&m_Vertices[iPreviousVertex], m_pRecords, iRec, iVertex);
+		if (!IsOneWay(psRec))
+			AddRecordToVertex(&m_Vertices[iVertex], m_pRecords, iRec, iPreviousVertex);
 	}
 }
 
@@ -1675,7 +1176,6 @@ void TIGERProcessor::FixZipCodes()
 	MapRecord * psRec, * psRecEntry, * psNewRec;
 	bool bDone;
 	std::vector<unsigned int> vRecords, vVertices, vNewRecords;
-	std::map<Coords, unsigned int>::iterator vertexIter;
 	std::map<unsigned int, unsigned int>::iterator iPeer;
 	Coords * pt;
 	AddressRange * psOldAddressZipRanges;
@@ -1697,13 +1197,11 @@ void TIGERProcessor::FixZipCodes()
 					psRecEntry = m_pRecords + vRecords[iRecEntry];
 					if (psRecEntry->nShapePoints > 0) {
 						pt = psRecEntry->pShapePoints;
-						vertexIter = m_mapCoordinateToVertex.find(*pt);
-						if (vertexIter != m_mapCoordinateToVertex.end())
-							vVertices.push_back(vertexIter->second);
+						if ((iVertex = FindVertex(*pt)) != (unsigned)-1)
+							vVertices.push_back(iVertex);
 						pt = psRecEntry->pShapePoints + psRecEntry->nShapePoints - 1;
-						vertexIter = m_mapCoordinateToVertex.find(*pt);
-						if (vertexIter != m_mapCoordinateToVertex.end())
-							vVertices.push_back(vertexIter->second);
+						if ((iVertex = FindVertex(*pt)) != (unsigned)-1)
+							vVertices.push_back(iVertex);
 					}
 				}
 				for (iVertexNumber = 0; iVertexNumber < vVertices.size(); iVertexNumber++)
@@ -1755,47 +1253,35 @@ unsigned int TIGERProcessor::AddString(const QString & str)
 	m_Strings.push_back(str);
 	return ret;
 }
-long TIGERProcessor::getCoord(char* str, int strLen)
+
+bool ConvertStateMaps(unsigned short iStateCode, bool bOverwrite)
 {
-	int i = 0;
-  int cnt = 0;
-  if(str[0] == '-')
-  {
-    char newStr[strLen];
-    memset(newStr,'0',strLen);
-    newStr[strLen-1] = '\0';
-    newStr[cnt] = '-';
-    cnt++;
-    i++;
-    for (i; i < strLen;i++)
-    {
-      if(str[i] >= '0' && str[i] <= '9')   
-      {
-	newStr[cnt] = str[i];
-	cnt++;
-	
-      }
-    }
-    //printf("str = %s\r\n",newStr);
-   // printf("strNum = %ld\r\n",atol(newStr));
-    return atol(newStr);  
-  }
-  else
-  {
-    char newStr[strLen-1];
-    memset(newStr,'0',strLen-1);
-    newStr[strLen-2] = '\0';
-    for (i; i < strLen;i++)
-    {
-      if(str[i] >= '0' && str[i] <= '9')   
-      {
-	newStr[cnt] = str[i];
-	cnt++;
-      }    
-    }
-   // printf("str = %s\r\n",newStr);
-    //printf("strNum = %ld\r\n",atol(newStr));
-    return atol(newStr);
-  }
-
-}
\ No newline at end of file
+	std::map<unsigned short, QString>::iterator iterCounty;
+	QString strCode, strOSMFile, strProcessedFile;
+	unsigned int nConverted = 0, nFailed = 0;
+
+	// counties are converted one at a time, each with a fresh processor, so
+	// peak memory is bounded by the largest county rather than the state
+	for (iterCounty = g_mapCodeToCountyName.lower_bound(iStateCode * 1000); iterCounty != g_mapCodeToCountyName.end() && iterCounty->first / 1000 == iStateCode; ++iterCounty)
+	{
+		strCode.sprintf("%05d", iterCounty->first);
+		strOSMFile = GetDataPath(QString("%1.osm").arg(strCode));
+		if (strOSMFile.isEmpty() || !QFileInfo(strOSMFile).isReadable())
+			continue;
+		strProcessedFile = GetDataPath(QString("%1.MAP").arg(strCode));
+		if (!bOverwrite && !strProcessedFile.isEmpty())
+			continue;
+
+		g_pLogger->LogInfo(QString("Converting %1 (%2)...").arg(strOSMFile).arg(iterCounty->second));
+		TIGERProcessor processor;
+		if (processor.LoadSet(strOSMFile)) {
+			g_pLogger->LogInfo("Failed\n");
+			nFailed++;
+		} else {
+			g_pLogger->LogInfo("Successful\n");
+			nConverted++;
+		}
+	}
+	g_pLogger->LogInfo(QString("%1 counties converted, %2 failed\n").arg(nConverted).arg(nFailed));
+	return nFailed > 0;
+}
@@ -26,6 +26,7 @@
 #define _TIGERPROCESSOR_H
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <vector>
 #include <map>
 
@@ -101,9 +102,11 @@ public:
 	bool LoadTypeI(const QString & strFilename);	
 	/*	Load type P TIGER data */
 	bool LoadTypeP(const QString & strFilename);	
-	/*	Load TIGER data set */
+	/*	Load OpenStreetMap XML data */
 	bool LoadTypeOSM(const QString & strFilename);
+	/*	Load TIGER data set */
 	bool LoadSet(const QString & strBaseName);	
+	/*	Split roads at shape points shared with other ways */
 	bool BreakWays();
 
 	/*	Write TIGER data */
@@ -115,7 +118,8 @@ public:
 	void FixZipCodes();
 	/*	Add string to string list, return index of string in list */
 	unsigned int AddString(const QString & str);
-	long getCoord(char * str, int strLen);
+	/*	Return vertex # at coordinates, or (unsigned)-1 if there is none */
+	unsigned int FindVertex(const Coords & pt) const;
 
 
 
@@ -128,16 +132,15 @@ protected:
 	// bounding rectangle
 	Rect boundingRect;
 
-	// coordinates -> vertex #
-	std::map<Coords, unsigned int> m_mapCoordinateToVertex;	
+	// vertex # -> coordinates, sorted so that FindVertex can binary search
+	std::vector<Coords> m_vecVertexCoords;
 
-	std::vector<Vertex> m_Vertices; // contains vertex pairs (edges) and record indexes
+	std::vector<TIGERVertex> m_Vertices; // contains vertex pairs (edges) and record indexes
 
 	std::list<std::pair<Rect, std::list<Coords> > > m_WaterPolygons;
 
 	// the records themselves
 	MapRecord * m_pRecords;
-	MapRecord * ProcessingWay;
 
 	// the number of records
 	unsigned int m_nRecords;
@@ -147,27 +150,24 @@ protected:
 	std::map<unsigned int, std::list<std::pair<unsigned int, bool> > > m_mapPolyIDtoRecords;
 	std::map<unsigned int, std::vector<unsigned int> > m_mapAdditionalNameIDtoRecord;	
 	std::map<QString, unsigned int> m_mapStringsToIndex; // temporary variable
-	std::map<unsigned long,unsigned int> m_osmWayIDtoRecord;
-	std::vector<Coords> vShapePoints;
-	std::vector<unsigned int> vFeatureNames;
-	std::vector<unsigned int> vFeatureTypes;;
-	std::map<unsigned long, unsigned int> nodeRefCount;
-	std::map<unsigned long, Coords> m_mapNodeIDandCoord;
-	
-	std::vector<MapRecord> vAdditionalWays;
+
 	Coords * areaLeft, * areaRight, * areaTop, * areaBottom;
 };
 
+/*	Convert every county of a state that has an OSM file in the data
+	directory, one county at a time; return true if any county failed */
+bool ConvertStateMaps(unsigned short iStateCode, bool bOverwrite = false);
+
 /*	Write memory buffer to file */
-void WriteMemory(const void * pMem, int fd, const unsigned int length);
+void WriteMemory(const void * pMem, FILE * hFile, const unsigned int length);
 /*	Write coordinates to file */
-void WriteCoords(const Coords * src, int fd);
+void WriteCoords(const Coords * src, FILE * hFile);
 /*	Write rectangle to file */
-void WriteRect(const Rect * src, int fd);
+void WriteRect(const Rect * src, FILE * hFile);
 /*	Write address range and zip to file */
-void WriteAddressRange(const AddressRange * src, int fd);
+void WriteAddressRange(const AddressRange * src, FILE * hFile);
 /*	Write string to file */
-void WriteString(const char * src, int fd, const unsigned int length);
+void WriteString(const char * src, FILE * hFile, const unsigned int length);
 
 /*	Read memory buffer from file */
 bool ReadMemory(void * pMem, int fd, const unsigned int length);
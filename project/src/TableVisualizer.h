@@ -59,6 +59,9 @@ public:
 	inline virtual void tableValueChanged(int row __attribute__ ((unused)) , int col __attribute__ ((unused)) ) {}
 	inline virtual void tableContextMenuRequested(int row __attribute__ ((unused)) , int col __attribute__ ((unused)) , const QPoint & pos __attribute__ ((unused)) ) {}
 	inline virtual void tableDropped(QDropEvent * e __attribute__ ((unused)) ) {}
+	// supply the text of a cell when it is painted, instead of keeping it in
+	// a table item; return false to let the table paint its own item
+	inline virtual bool tableCellText(int row __attribute__ ((unused)) , int col __attribute__ ((unused)) , QString & strText __attribute__ ((unused)) ) {return false;}
 
 protected:
 	virtual QWidget * CreateWidget();
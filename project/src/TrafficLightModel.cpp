@@ -31,16 +31,16 @@
 #define TRAFFICLIGHTMODEL_PARAM_GREENLIGHT_DEFAULT "30"
 #define TRAFFICLIGHTMODEL_PARAM_GREENLIGHT_DESC "GREENLIGHTTIME (seconds) -- The duration of a single green light."
 
-// divide total group into 100 vertex groups
+// stagger the lights over 100 vertex groups
 #define VERTEX_COUNT_MAX 100
 
 TrafficLightModel::TrafficLightModel(const QString & strModelName)
-: Model(strModelName), m_tGreenLightTime(timeval0)
+: Model(strModelName), m_tGreenLightTime(timeval0), m_bCheckpoint(false)
 {
 }
 
 TrafficLightModel::TrafficLightModel(const TrafficLightModel & copy)
-: Model(copy), m_tGreenLightTime(copy.m_tGreenLightTime)
+: Model(copy), m_tGreenLightTime(copy.m_tGreenLightTime), m_bCheckpoint(copy.m_bCheckpoint)
 {
 }
 
@@ -53,61 +53,59 @@ TrafficLightModel & TrafficLightModel::operator = (const TrafficLightModel & cop
 	Model::operator = (copy);
 
 	m_tGreenLightTime = copy.m_tGreenLightTime;
+	m_bCheckpoint = copy.m_bCheckpoint;
 	return *this;
 }
 
 int TrafficLightModel::Init(const std::map<QString, QString> & mapParams)
 {
-	QString strValue;
-
 	if (Model::Init(mapParams))
 		return 1;
 
-	strValue = GetParam(mapParams, TRAFFICLIGHTMODEL_PARAM_GREENLIGHT, TRAFFICLIGHTMODEL_PARAM_GREENLIGHT_DEFAULT);
-	m_tGreenLightTime = MakeTime(ValidateNumber(StringToNumber(strValue), 0., HUGE_VAL));
+	m_tGreenLightTime = MakeTime(ValidateNumber(GetNumberParam(mapParams, TRAFFICLIGHTMODEL_PARAM_GREENLIGHT, TRAFFICLIGHTMODEL_PARAM_GREENLIGHT_DEFAULT), 0., HUGE_VAL));
 	g_pMapDB->UseTrafficLights(true);
+	m_bCheckpoint = false;
 
 	return 0; // successful
 }
 
+// the lights need no events: each vertex works out which road has the green
+// light from the simulation time whenever a car asks (see GetPermittedRoad)
 int TrafficLightModel::PreRun()
 {
 	if (Model::PreRun())
 		return 1;
 
-	double fDelay = ToDouble(m_tGreenLightTime) / VERTEX_COUNT_MAX, fStart = ToDouble(g_pSimulator->m_tCurrent);
+	if (m_tGreenLightTime > timeval0)
+		g_pMapDB->SetTrafficLights(g_pSimulator->m_tCurrent, m_tGreenLightTime, VERTEX_COUNT_MAX);
+	else
+		g_pMapDB->ResetTrafficLights();
 
-	for (unsigned int i = 0; i < VERTEX_COUNT_MAX; i++, fStart += fDelay)
-		g_pSimulator->m_EventQueue.AddEvent(SimEvent(MakeTime(fStart), EVENT_PRIORITY_HIGHEST, m_strModelName, m_strModelName, EVENT_TRAFFICLIGHTMODEL_SIGNAL, (void *)i));
+	return 0;
+}
 
-	g_pMapDB->ResetTrafficLights();
+int TrafficLightModel::Checkpoint()
+{
+	if (Model::Checkpoint())
+		return 1;
 
+	m_bCheckpoint = true;
 	return 0;
 }
 
-int TrafficLightModel::ProcessEvent(SimEvent & event)
+// the vertex groups set up by PreRun are still in place, so later trials
+// only move the start of the signal plan to the new simulation time
+int TrafficLightModel::Restore()
 {
-	unsigned int i;
-	
-	if (Model::ProcessEvent(event))
+	if (!m_bCheckpoint)
+		return PreRun();
+
+	if (Model::PreRun())
 		return 1;
 
-	switch (event.GetEventID())
-	{
-	case EVENT_TRAFFICLIGHTMODEL_SIGNAL:
-		for (i = (unsigned int)event.GetEventData(); i < g_pMapDB->GetVertexCount(); i += VERTEX_COUNT_MAX)
-		{
-			Vertex & vertex = g_pMapDB->GetVertex(i);
-			vertex.iRoadPermitted++;
-			if (vertex.iRoadPermitted >= vertex.vecRoads.size())
-				vertex.iRoadPermitted = 0;
-		}
-		event.SetTimestamp(event.GetTimestamp() + m_tGreenLightTime);
-		g_pSimulator->m_EventQueue.AddEvent(event);
-		break;
-	default:
-		break;
-	}
+	if (m_tGreenLightTime > timeval0)
+		g_pMapDB->RestartTrafficLights(g_pSimulator->m_tCurrent);
+
 	return 0;
 }
 
@@ -29,8 +29,6 @@
 
 #define TRAFFICLIGHTMODEL_NAME "TrafficLightModel"
 
-#define EVENT_TRAFFICLIGHTMODEL_SIGNAL 412401
-
 class TrafficLightModel : public Model
 {
 public:
@@ -51,7 +49,8 @@ public:
 
 	virtual int Init(const std::map<QString, QString> & mapParams);
 	virtual int PreRun();
-	virtual int ProcessEvent(SimEvent & event);
+	virtual int Checkpoint();
+	virtual int Restore();
 	virtual int Save(std::map<QString, QString> & mapParams);
 	virtual int Cleanup();
 	
@@ -60,6 +59,7 @@ public:
 protected:
 	struct timeval m_tGreenLightTime;
 	unsigned int m_iVertexCounter;
+	bool m_bCheckpoint;
 };
 
 inline Model * TrafficLightModelCreator(const QString & strModelName)
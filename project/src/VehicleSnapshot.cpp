@@ -0,0 +1,118 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "VehicleSnapshot.h"
+#include "CarModel.h"
+
+bool VehicleSnapshot::GetPose(const CarModel * pCar, Coords & ptPosition, short & iHeading) const
+{
+	unsigned int iSlot = pCar->GetStateSlot();
+
+	if (iSlot >= states.GetCount() || states.vecCars[iSlot] != pCar)
+		return false;
+	ptPosition = states.vecPositions[iSlot];
+	iHeading = states.vecHeadings[iSlot];
+	return true;
+}
+
+VehicleSnapshotBuffer::VehicleSnapshotBuffer()
+: m_pCurrent(NULL)
+{
+}
+
+VehicleSnapshotBuffer::~VehicleSnapshotBuffer()
+{
+	unsigned int i;
+
+	for (i = 0; i < m_vecSnapshots.size(); i++)
+		delete m_vecSnapshots[i];
+}
+
+void VehicleSnapshotBuffer::Publish(VehicleStateTable & table, const struct timeval & tSnapshot)
+{
+	VehicleSnapshot * pSpare = NULL;
+	unsigned int i;
+
+	// a spare is neither current nor being read, so nobody can reach it
+	// while it is filled
+	m_mutexCurrent.lock();
+	for (i = 0; i < m_vecSnapshots.size(); i++)
+	{
+		if (m_vecSnapshots[i] != m_pCurrent && m_vecSnapshots[i]->iReaders == 0)
+		{
+			pSpare = m_vecSnapshots[i];
+			break;
+		}
+	}
+	if (pSpare == NULL)
+	{
+		pSpare = new VehicleSnapshot;
+		pSpare->iReaders = 0;
+		m_vecSnapshots.push_back(pSpare);
+	}
+	m_mutexCurrent.unlock();
+
+	table.GetSnapshot(pSpare->states);
+	pSpare->tSnapshot = tSnapshot;
+
+	m_mutexCurrent.lock();
+	m_pCurrent = pSpare;
+	m_mutexCurrent.unlock();
+}
+
+const VehicleSnapshot * VehicleSnapshotBuffer::Acquire()
+{
+	VehicleSnapshot * pSnapshot;
+
+	m_mutexCurrent.lock();
+	pSnapshot = m_pCurrent;
+	if (pSnapshot != NULL)
+		pSnapshot->iReaders++;
+	m_mutexCurrent.unlock();
+	return pSnapshot;
+}
+
+void VehicleSnapshotBuffer::Release(const VehicleSnapshot * pSnapshot)
+{
+	if (pSnapshot == NULL)
+		return;
+
+	m_mutexCurrent.lock();
+	((VehicleSnapshot *)pSnapshot)->iReaders--;
+	m_mutexCurrent.unlock();
+}
+
+void VehicleSnapshotBuffer::Clear()
+{
+	unsigned int i;
+
+	m_mutexCurrent.lock();
+	m_pCurrent = NULL;
+	for (i = 0; i < m_vecSnapshots.size(); i++)
+	{
+		if (m_vecSnapshots[i]->iReaders == 0)
+			m_vecSnapshots[i]->states.Resize(0);
+	}
+	m_mutexCurrent.unlock();
+}
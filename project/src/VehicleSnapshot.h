@@ -0,0 +1,75 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/* VehicleSnapshot.h -- read-only copies of the vehicle state table for the
+ * display. The simulator fills a spare copy from the table at a fixed rate
+ * and then makes it current by swapping a pointer; visualizers hold the
+ * current copy while they draw and never touch the table, the registry or
+ * the car models, so a slow repaint cannot stall the simulation. A copy
+ * stays alive while anyone is still reading it, so normally there are two,
+ * one being read and one being filled.
+ */
+
+#ifndef _VEHICLESNAPSHOT_H
+#define _VEHICLESNAPSHOT_H
+
+#include "VehicleStateTable.h"
+#include "Global.h"
+
+struct VehicleSnapshot
+{
+	VehicleStates states;
+	struct timeval tSnapshot;
+	unsigned int iReaders;
+
+	// position and heading of pCar when the snapshot was taken; false if
+	// pCar was not registered then
+	bool GetPose(const CarModel * pCar, Coords & ptPosition, short & iHeading) const;
+};
+
+class VehicleSnapshotBuffer
+{
+public:
+	VehicleSnapshotBuffer();
+	~VehicleSnapshotBuffer();
+
+	// copy the table into a spare snapshot and make it current; only one
+	// thread may publish at a time
+	void Publish(VehicleStateTable & table, const struct timeval & tSnapshot);
+	// the current snapshot, or NULL if there is none yet; every snapshot
+	// acquired must be released
+	const VehicleSnapshot * Acquire();
+	void Release(const VehicleSnapshot * pSnapshot);
+	void Clear();
+
+protected:
+	std::vector<VehicleSnapshot *> m_vecSnapshots;
+	VehicleSnapshot * m_pCurrent;
+	QMutex m_mutexCurrent;
+
+private:
+	inline VehicleSnapshotBuffer(const VehicleSnapshotBuffer & copy __attribute__ ((unused)) ) {}
+	inline VehicleSnapshotBuffer & operator = (const VehicleSnapshotBuffer & copy __attribute__ ((unused)) ) {return *this;}
+};
+
+#endif
@@ -0,0 +1,142 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "VehicleStateTable.h"
+#include "CarModel.h"
+
+void VehicleStates::Resize(unsigned int iCount)
+{
+	vecCars.resize(iCount, NULL);
+	vecRecords.resize(iCount, (unsigned)-1);
+	vecForwards.resize(iCount, true);
+	vecShapePoints.resize(iCount, (unsigned short)-1);
+	vecProgress.resize(iCount, 0.f);
+	vecPositions.resize(iCount);
+	vecSpeeds.resize(iCount, 0);
+	vecHeadings.resize(iCount, 0);
+	vecLanes.resize(iCount, 0);
+	vecStamps.resize(iCount, 0);
+	vecIPs.resize(iCount, 0);
+	vecMapObjectIDs.resize(iCount, -1);
+	vecTypes.resize(iCount, NULL);
+}
+
+VehicleStateTable::VehicleStateTable()
+{
+}
+
+unsigned int VehicleStateTable::Add(CarModel * pCar)
+{
+	unsigned int iSlot;
+
+	m_mutexStates.lock();
+	if (m_vecFreeSlots.empty())
+	{
+		iSlot = m_states.GetCount();
+		m_states.Resize(iSlot + 1);
+	}
+	else
+	{
+		iSlot = m_vecFreeSlots.back();
+		m_vecFreeSlots.pop_back();
+	}
+	m_states.vecCars[iSlot] = pCar;
+	m_states.vecStamps[iSlot]++;
+	m_states.vecIPs[iSlot] = pCar->GetIPAddress();
+	m_states.vecMapObjectIDs[iSlot] = pCar->GetMapObjectID();
+	m_states.vecTypes[iSlot] = pCar->GetCarListType();
+	m_mutexStates.unlock();
+
+	Store(iSlot, pCar);
+	return iSlot;
+}
+
+void VehicleStateTable::Remove(unsigned int iSlot)
+{
+	m_mutexStates.lock();
+	if (iSlot < m_states.GetCount() && m_states.vecCars[iSlot] != NULL)
+	{
+		if (m_states.vecRecords[iSlot] != (unsigned)-1)
+			m_laneOccupancy.Erase(LaneKey(m_states.vecRecords[iSlot], m_states.vecForwards[iSlot], m_states.vecLanes[iSlot]), LanePosition(m_states.vecShapePoints[iSlot], m_states.vecProgress[iSlot], iSlot));
+		m_states.vecCars[iSlot] = NULL;
+		m_states.vecRecords[iSlot] = (unsigned)-1;
+		m_states.vecMapObjectIDs[iSlot] = -1;
+		m_states.vecTypes[iSlot] = NULL;
+		m_vecFreeSlots.push_back(iSlot);
+	}
+	m_mutexStates.unlock();
+}
+
+void VehicleStateTable::Clear()
+{
+	m_mutexStates.lock();
+	m_states.Resize(0);
+	m_vecFreeSlots.clear();
+	m_laneOccupancy.Clear();
+	m_mutexStates.unlock();
+}
+
+void VehicleStateTable::Store(unsigned int iSlot, const CarModel * pCar)
+{
+	m_mutexStates.lock();
+	if (iSlot < m_states.GetCount() && m_states.vecCars[iSlot] == pCar)
+	{
+		Coords ptPosition = pCar->GetCurrentPosition();
+		short iSpeed = pCar->GetCurrentSpeed(), iHeading = pCar->GetCurrentDirection();
+		unsigned int iRecord = pCar->GetCurrentRecord();
+		bool bForwards = pCar->IsGoingForwards();
+		unsigned short iShapePoint = pCar->GetCRShapePoint();
+		float fProgress = pCar->GetCRProgress();
+		unsigned char iLane = pCar->GetLane();
+
+		if (ptPosition != m_states.vecPositions[iSlot] || iSpeed != m_states.vecSpeeds[iSlot] || iHeading != m_states.vecHeadings[iSlot])
+			m_states.vecStamps[iSlot]++;
+
+		// move the car's lane entry only if it's somewhere new
+		if (iRecord != m_states.vecRecords[iSlot] || bForwards != m_states.vecForwards[iSlot] || iLane != m_states.vecLanes[iSlot] || iShapePoint != m_states.vecShapePoints[iSlot] || fProgress != m_states.vecProgress[iSlot])
+		{
+			if (m_states.vecRecords[iSlot] != (unsigned)-1)
+				m_laneOccupancy.Erase(LaneKey(m_states.vecRecords[iSlot], m_states.vecForwards[iSlot], m_states.vecLanes[iSlot]), LanePosition(m_states.vecShapePoints[iSlot], m_states.vecProgress[iSlot], iSlot));
+			if (iRecord != (unsigned)-1)
+				m_laneOccupancy.Insert(LaneKey(iRecord, bForwards, iLane), LanePosition(iShapePoint, fProgress, iSlot));
+		}
+
+		m_states.vecRecords[iSlot] = iRecord;
+		m_states.vecForwards[iSlot] = bForwards;
+		m_states.vecShapePoints[iSlot] = iShapePoint;
+		m_states.vecProgress[iSlot] = fProgress;
+		m_states.vecPositions[iSlot] = ptPosition;
+		m_states.vecSpeeds[iSlot] = iSpeed;
+		m_states.vecHeadings[iSlot] = iHeading;
+		m_states.vecLanes[iSlot] = iLane;
+	}
+	m_mutexStates.unlock();
+}
+
+void VehicleStateTable::GetSnapshot(VehicleStates & states)
+{
+	m_mutexStates.lock();
+	states = m_states;
+	m_mutexStates.unlock();
+}
@@ -0,0 +1,116 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+/* VehicleStateTable.h -- the kinematic state of every registered vehicle,
+ * kept as one array per field and indexed by a slot that a vehicle holds
+ * for as long as it is registered. Vehicle models publish their state here
+ * whenever it changes; the registry queries and the event log read it from
+ * here, behind a single lock, instead of visiting every model object in
+ * turn, and the display reads copies of it (see VehicleSnapshot.h). The
+ * table also keeps the vehicles on each lane in order (see LaneOccupancy.h).
+ */
+
+#ifndef _VEHICLESTATETABLE_H
+#define _VEHICLESTATETABLE_H
+
+#include "Coords.h"
+#include "LaneOccupancy.h"
+
+#include <qmutex.h>
+#include <arpa/inet.h>
+#include <vector>
+
+class CarModel;
+
+#define VEHICLESTATE_NONE ((unsigned)-1)
+
+// the table contents, one entry per slot in every array; free slots have a
+// NULL car
+struct VehicleStates
+{
+	std::vector<CarModel *> vecCars;
+	std::vector<unsigned int> vecRecords;
+	std::vector<bool> vecForwards;
+	std::vector<unsigned short> vecShapePoints;
+	std::vector<float> vecProgress;
+	std::vector<Coords> vecPositions;
+	std::vector<short> vecSpeeds;
+	std::vector<short> vecHeadings;
+	std::vector<unsigned char> vecLanes;
+	// bumped whenever the position, speed or heading in a slot changes, or
+	// the slot goes to another car, so the display can skip unchanged rows
+	std::vector<unsigned int> vecStamps;
+	// display fields, fixed when the car is registered
+	std::vector<in_addr_t> vecIPs;
+	std::vector<int> vecMapObjectIDs;
+	std::vector<const char *> vecTypes; // CarModel::GetCarListType
+
+	inline unsigned int GetCount() const
+	{
+		return vecCars.size();
+	}
+	void Resize(unsigned int iCount);
+};
+
+class VehicleStateTable
+{
+public:
+	VehicleStateTable();
+
+	// give pCar a slot, reusing a free one if there is one
+	unsigned int Add(CarModel * pCar);
+	void Remove(unsigned int iSlot);
+	void Clear();
+
+	// copy the current state of pCar into its slot
+	void Store(unsigned int iSlot, const CarModel * pCar);
+	// copy the whole table under a single lock
+	void GetSnapshot(VehicleStates & states);
+
+	inline const VehicleStates * acquireLock()
+	{
+		m_mutexStates.lock();
+		return &m_states;
+	}
+	inline void releaseLock()
+	{
+		m_mutexStates.unlock();
+	}
+	// only valid while the lock is held
+	inline const LaneOccupancy & GetLaneOccupancy() const
+	{
+		return m_laneOccupancy;
+	}
+
+protected:
+	VehicleStates m_states;
+	std::vector<unsigned int> m_vecFreeSlots;
+	LaneOccupancy m_laneOccupancy;
+	QMutex m_mutexStates;
+
+private:
+	inline VehicleStateTable(const VehicleStateTable & copy __attribute__ ((unused)) ) {}
+	inline VehicleStateTable & operator = (const VehicleStateTable & copy __attribute__ ((unused)) ) {return *this;}
+};
+
+#endif
@@ -36,6 +36,10 @@
 #include "MapObjects.h"
 #include "CarRegistry.h"
 #include "InfrastructureNodeRegistry.h"
+#include "TIGERProcessor.h"
+#include "ScenarioFile.h"
+#include "ScenarioGenerator.h"
+#include "StringHelp.h"
 
 Settings * g_pSettings = NULL;
 Simulator * g_pSimulator = NULL;
@@ -47,15 +51,144 @@ MainWindow * g_pMainWindow = NULL;
 Logger * g_pLogger = NULL;
 QMessageList * m_pMessageList = NULL;
 
+// true if the given batch job was requested on the command line; batch jobs
+// run without a display
+static bool IsBatchJob(int argc, char ** argv, const char * strKey)
+{
+	int i;
+	for (i = 1; i < argc; i++)
+		if (strncmp(argv[i], strKey, strlen(strKey)) == 0)
+			return true;
+	return false;
+}
+
+// convert the OSM files of every county in the state given on the command
+// line (e.g. --convert-state=PA) to map files, then exit
+static int RunBatchConversion()
+{
+	QString strState = g_pSettings->GetParam(PARAMKEY_CONVERT_STATE, "");
+	bool bOverwrite = g_pSettings->GetParam(PARAMKEY_CONVERT_OVERWRITE, "0", true) != "0";
+	unsigned short iStateCode;
+	int ret;
+
+	g_pLogger = new Logger();
+	InitMapDB();
+	iStateCode = StateCodeByName(strState);
+	if (iStateCode == (unsigned short)-1) {
+		g_pLogger->LogInfo(QString("Unknown state \"%1\"\n").arg(strState));
+		ret = 1;
+	} else
+		ret = ConvertStateMaps(iStateCode, bOverwrite) ? 1 : 0;
+	delete g_pLogger;
+	g_pLogger = NULL;
+	return ret;
+}
+
+// convert a simulation file between the text and binary formats, e.g.
+// --convert-scenario=big.sim --output=big.simb, then exit; the output
+// format follows the output file's extension
+static int RunScenarioConversion()
+{
+	QString strInput = g_pSettings->GetParam(PARAMKEY_CONVERT_SCENARIO, "");
+	QString strOutput = g_pSettings->GetParam(PARAMKEY_CONVERT_OUTPUT, "");
+	std::vector<ScenarioModel> vecModels;
+	int ret = 1;
+
+	g_pLogger = new Logger();
+	g_pLogger->LogInfo(QString("Converting \"%1\" to \"%2\"...").arg(strInput).arg(strOutput));
+	if (strOutput.isEmpty() || !ReadScenario(strInput, vecModels))
+		g_pLogger->LogInfo("Failed\n");
+	else if (!WriteScenario(strOutput, vecModels, QString("Converted by GrooveNet Hybrid Simulator from %1").arg(strInput)))
+		g_pLogger->LogInfo("Failed\n");
+	else {
+		g_pLogger->LogInfo(QString("Successful (%1 models)\n").arg(vecModels.size()));
+		ret = 0;
+	}
+	delete g_pLogger;
+	g_pLogger = NULL;
+	return ret;
+}
+
+// write a simulation file with many vehicles spread over a map region, e.g.
+// --generate=big.sim --vehicles=10000 --seed=7
+// --region="-79990000,40450000:-79940000,40420000"
+// --set="TRIP=DjikstraTripModel|STARTTIME=0:60", then exit
+static int RunBatchGeneration()
+{
+	QString strFilename = g_pSettings->GetParam(PARAMKEY_GENERATE, "");
+	QString strRegion = g_pSettings->GetParam(PARAMKEY_GENERATE_REGION, "");
+	QString strType = g_pSettings->GetParam(PARAMKEY_GENERATE_TYPE, "");
+	QStringList listMaps = QStringList::split(';', g_pSettings->GetParam(PARAMKEY_GENERATE_MAPS, "", true));
+	QStringList listParams = QStringList::split('|', g_pSettings->GetParam(PARAMKEY_GENERATE_PARAMS, "", true));
+	QStringList::iterator iterItem;
+	std::set<QString> setMaps;
+	ScenarioGenerator * pGenerator;
+	Coords ptMin, ptMax;
+	in_addr_t ipAddress;
+	int iSep, ret = 1;
+
+	g_pLogger = new Logger();
+	g_pMapDB = new MapDB();
+	InitMapDB();
+	if (listMaps.empty())
+		g_pMapDB->LoadAll(GetDataPath());
+	else {
+		for (iterItem = listMaps.begin(); iterItem != listMaps.end(); ++iterItem)
+			setMaps.insert(*iterItem);
+		g_pMapDB->LoadAll(GetDataPath(), setMaps);
+	}
+
+	pGenerator = new ScenarioGenerator();
+	iSep = strRegion.find(':');
+	if (iSep < 0 || !ptMin.FromString(strRegion.left(iSep)) || !ptMax.FromString(strRegion.mid(iSep+1)))
+		g_pLogger->LogInfo(QString("Bad region \"%1\"\n").arg(strRegion));
+	else if (pGenerator->SetRegion(Rect(ptMin, ptMax)))
+		g_pLogger->LogInfo(QString("No roads in region \"%1\"\n").arg(strRegion));
+	else if (!strType.isEmpty() && pGenerator->SetVehicleType(strType))
+		g_pLogger->LogInfo(QString("Unknown vehicle type \"%1\"\n").arg(strType));
+	else {
+		for (iterItem = listParams.begin(); iterItem != listParams.end(); ++iterItem)
+		{
+			if ((iSep = (*iterItem).find('=')) > 0)
+				pGenerator->SetParameter((*iterItem).left(iSep).stripWhiteSpace(), (*iterItem).mid(iSep+1).stripWhiteSpace());
+		}
+		// number vehicles from this host's address, as the simulation editor does
+		if (StringToIPAddress(g_pSettings->GetParam(PARAMKEY_NETWORK_IP, g_pSettings->m_sSettings[SETTINGS_NETWORK_IPADDRESS_NUM].GetValue().strValue), ipAddress))
+			pGenerator->SetFirstAddress(ipAddress);
+		g_pLogger->LogInfo(QString("Generating \"%1\"...").arg(strFilename));
+		if (pGenerator->Generate(strFilename, (unsigned int)StringToNumber(g_pSettings->GetParam(PARAMKEY_GENERATE_VEHICLES, SCENARIOGENERATOR_VEHICLES_DEFAULT)), (unsigned int)StringToNumber(g_pSettings->GetParam(PARAMKEY_GENERATE_SEED, SCENARIOGENERATOR_SEED_DEFAULT))) == 0) {
+			g_pLogger->LogInfo("Successful\n");
+			ret = 0;
+		} else
+			g_pLogger->LogInfo("Failed\n");
+	}
+	delete pGenerator;
+	delete g_pMapDB;
+	g_pMapDB = NULL;
+	delete g_pLogger;
+	g_pLogger = NULL;
+	return ret;
+}
+
 int main( int argc, char ** argv )
 {
-	QApplication a( argc, argv );
+	bool bConvert = IsBatchJob(argc, argv, PARAMKEY_CONVERT_STATE);
+	bool bConvertScenario = IsBatchJob(argc, argv, PARAMKEY_CONVERT_SCENARIO);
+	bool bGenerate = IsBatchJob(argc, argv, PARAMKEY_GENERATE);
+	QApplication a( argc, argv, !bConvert && !bConvertScenario && !bGenerate );
 	QSettings appSettings;
 	QString simFile;
-	QPixmap bmpSplash(QDir(a.applicationDirPath()).absFilePath("splash.jpg"));
 
 	g_pSettings = new Settings(argc, argv, &appSettings);
 	g_pSettings->ReadSettings();
+	if (bConvert || bConvertScenario || bGenerate) {
+		int ret = bConvert ? RunBatchConversion() : (bConvertScenario ? RunScenarioConversion() : RunBatchGeneration());
+		delete g_pSettings;
+		g_pSettings = NULL;
+		return ret;
+	}
+
+	QPixmap bmpSplash(QDir(a.applicationDirPath()).absFilePath("splash.jpg"));
 	QSplashScreen * pSplash = new QSplashScreen(bmpSplash, Qt::WDestructiveClose);
 	int ret = 0;
 	qApp->setOverrideCursor(QCursor(Qt::WaitCursor));
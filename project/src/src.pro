@@ -72,7 +72,19 @@ HEADERS += Global.h \
            RandomWaypointModel.h \
            queue.h \
            unpifi.h \
-           QMessageList.h 
+           QMessageList.h \
+           OSMParser.h \
+           RecordTree.h \
+           PacketExpiryWheel.h \
+           PacketHistory.h \
+           MobilityTick.h \
+           VehicleStateTable.h \
+           VehicleSnapshot.h \
+           ScenarioGenerator.h \
+           ScenarioFile.h \
+           ParamSchema.h \
+           SimCheckpoint.h \
+           LaneOccupancy.h 
 SOURCES += main.cpp \
            StringHelp.cpp \
            Coords.cpp \
@@ -142,12 +154,30 @@ SOURCES += main.cpp \
            RandomWaypointModel.cpp \
            get_ifi_info.cpp \
            queue.cpp \
-           QMessageList.cpp 
+           QMessageList.cpp \
+           OSMParser.cpp \
+           RecordTree.cpp \
+           PacketExpiryWheel.cpp \
+           PacketHistory.cpp \
+           MobilityTick.cpp \
+           VehicleStateTable.cpp \
+           VehicleSnapshot.cpp \
+           ScenarioGenerator.cpp \
+           ScenarioFile.cpp \
+           ParamSchema.cpp \
+           SimCheckpoint.cpp \
+           LaneOccupancy.cpp 
 LIBS += -lpcap
 QMAKE_CXXFLAGS_RELEASE += -Wno-non-virtual-dtor \
 -O3
 QMAKE_CXXFLAGS_DEBUG += -DDEBUG
 TARGET = ../bin/groovenet
+# make check-osm: build tests/osm/osmdump and compare what it prints for the
+# sample extract with the expected output
+check_osm.target = check-osm
+check_osm.depends = OSMParser.o
+check_osm.commands = $(CXX) $(CXXFLAGS) $(INCPATH) -o ../bin/osmdump ../../tests/osm/osmdump.cpp OSMParser.o $(LFLAGS) $(LIBS) && ../bin/osmdump ../../tests/osm/small.osm | diff -u ../../tests/osm/small.expected -
+QMAKE_EXTRA_UNIX_TARGETS += check_osm
 CONFIG += debug \
 warn_on \
 qt \
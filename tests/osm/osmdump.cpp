@@ -0,0 +1,85 @@
+/***************************************************************************
+ *   Copyright (C) 2005, Carnegie Mellon University.                       *
+ *   Maintained by: Daniel Weller                                          *
+ *                  Rahul Mangharam                                        *
+ *                  and the rest of the GrooveNet Team                     *
+ *                                                                         *
+ *   Email: dweller@ece.cmu.edu or rahulm@ece.cmu.edu                      *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* osmdump.cpp -- prints what OSMParser reads from an OSM extract, one line
+ * per node and per way, so its output can be compared with a .expected file.
+ * "make check-osm" in project/src builds it and checks small.osm.
+ *
+ * Way node references print as node IDs; a '*' marks an interior node shared
+ * with another way, where TIGERProcessor::BreakWays will split a road, and
+ * '?' a reference to a node missing from the extract.
+ */
+
+#include "OSMParser.h"
+
+#include <stdio.h>
+
+int main(int argc, char * argv[])
+{
+	OSMParser parser;
+	unsigned int iChunk, iWay, iRef, i;
+	unsigned long iNode;
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s file.osm\n", argv[0]);
+		return 1;
+	}
+	if (parser.Load(argv[1])) {
+		fprintf(stderr, "%s: could not open %s\n", argv[0], argv[1]);
+		return 1;
+	}
+
+	for (iNode = 0; iNode < parser.GetNodeCount(); iNode++)
+	{
+		const OSMNode & sNode = parser.GetNode(iNode);
+		printf("node %lu %ld %ld refs %u\n", sNode.iID, sNode.iLong, sNode.iLat, parser.GetRefCount(iNode));
+	}
+
+	for (iChunk = 0; iChunk < parser.GetChunkCount(); iChunk++)
+	{
+		const OSMChunk * pChunk = parser.GetChunk(iChunk);
+		const std::vector<unsigned long> & vecRefs = pChunk->GetRefs();
+		for (iWay = 0; iWay < pChunk->GetWays().size(); iWay++)
+		{
+			const OSMWay & sWay = pChunk->GetWays()[iWay];
+			printf("way type %d rail %d nodes", (int)sWay.eRecordType, sWay.bRail ? 1 : 0);
+			for (iRef = sWay.iFirstRef; iRef < sWay.iFirstRef + sWay.nRefs; iRef++)
+			{
+				iNode = vecRefs[iRef];
+				if (iNode == OSMPARSER_INVALID_REF)
+					printf(" ?");
+				else
+					printf(" %lu%s", parser.GetNode(iNode).iID, iRef > sWay.iFirstRef && iRef < sWay.iFirstRef + sWay.nRefs - 1 && parser.GetRefCount(iNode) > 1 ? "*" : "");
+			}
+			printf("\n");
+			for (i = 0; i < sWay.vecNames.size(); i++)
+				printf("\tname \"%s\"\n", sWay.vecNames[i].c_str());
+			for (i = 0; i < sWay.vecTypes.size(); i++)
+				printf("\ttype \"%s\"\n", sWay.vecTypes[i].c_str());
+			for (i = 0; i < sWay.vecZips.size(); i++)
+				printf("\tzip %05d %s\n", sWay.vecZips[i].first, sWay.vecZips[i].second ? "left" : "right");
+		}
+	}
+	return 0;
+}